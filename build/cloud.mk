@@ -6,6 +6,7 @@ CLOUD_SERVER_SOURCES = \
 	$(SRC)/Cloud/Thermal.cpp \
 	$(SRC)/Cloud/Data.cpp \
 	$(SRC)/Cloud/OGNAprs.cpp \
+	$(SRC)/Cloud/OGNAreaFilter.cpp \
 	$(SRC)/Cloud/OGNTraffic.cpp \
 	$(SRC)/Cloud/OGNClient.cpp \
 	$(SRC)/Cloud/Sender.cpp \
@@ -24,6 +25,12 @@ CLOUD_TO_KML_SOURCES = \
 CLOUD_TO_KML_DEPENDS = ASYNC LIBNET IO OS GEO MATH UTIL
 $(eval $(call link-program,xcsoar-cloud-to-kml,CLOUD_TO_KML))
 
+CLOUD_LOAD_SOURCES = \
+	$(SRC)/Tracking/SkyLines/Assemble.cpp \
+	$(SRC)/Cloud/LoadGenerator.cpp
+CLOUD_LOAD_DEPENDS = ASYNC LIBNET IO OS GEO MATH UTIL
+$(eval $(call link-program,xcsoar-cloud-load,CLOUD_LOAD))
+
 ifeq ($(TARGET),UNIX)
-OPTIONAL_OUTPUTS += $(CLOUD_SERVER_BIN) $(CLOUD_TO_KML_BIN)
+OPTIONAL_OUTPUTS += $(CLOUD_SERVER_BIN) $(CLOUD_TO_KML_BIN) $(CLOUD_LOAD_BIN)
 endif
@@ -1,12 +1,14 @@
 TERRAIN_SOURCES = \
 	$(SRC)/Terrain/AsyncLoader.cpp \
 	$(SRC)/Terrain/RasterBuffer.cpp \
+	$(SRC)/Terrain/CompressedRasterBuffer.cpp \
 	$(SRC)/Terrain/RasterProjection.cpp \
 	$(SRC)/Terrain/RasterMap.cpp \
 	$(SRC)/Terrain/RasterTile.cpp \
 	$(SRC)/Terrain/RasterTileCache.cpp \
 	$(SRC)/Terrain/ZzipStream.cpp \
 	$(SRC)/Terrain/Loader.cpp \
+	$(SRC)/Terrain/Pack.cpp \
 	$(SRC)/Terrain/WorldFile.cpp \
 	$(SRC)/Terrain/Intersection.cpp \
 	$(SRC)/Terrain/ScanLine.cpp \
@@ -20,6 +22,6 @@ TERRAIN_SOURCES = \
 TERRAIN_CXXFLAGS_INTERNAL = -Wno-shift-negative-value
 TERRAIN_CPPFLAGS_INTERNAL = $(SCREEN_CPPFLAGS)
 
-TERRAIN_DEPENDS = JASPER ZZIP GEO UTIL
+TERRAIN_DEPENDS = JASPER ZZIP GEO THREAD TRACING UTIL
 
 $(eval $(call link-library,libterrain,TERRAIN))
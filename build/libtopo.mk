@@ -7,11 +7,12 @@ TOPO_SOURCES = \
 	$(SRC)/Topography/Thread.cpp \
 	$(SRC)/Topography/TopographyGlue.cpp \
 	$(SRC)/Topography/XShape.cpp \
+	$(SRC)/Topography/Pack.cpp \
 	$(SRC)/Topography/Index.cpp \
 	$(SRC)/Topography/CachedTopographyRenderer.cpp
 
 TOPO_CPPFLAGS_INTERNAL = $(SCREEN_CPPFLAGS)
 
-TOPO_DEPENDS = SHAPELIB
+TOPO_DEPENDS = SHAPELIB THREAD TRACING
 
 $(eval $(call link-library,libtopo,TOPO))
@@ -0,0 +1,8 @@
+# Build rules for the hot path tracing library
+
+TRACING_SOURCES = \
+	$(SRC)/Tracing/Tracing.cpp
+
+TRACING_DEPENDS = IO UTIL
+
+$(eval $(call link-library,libtracing,TRACING))
@@ -102,6 +102,7 @@ DIALOG_SOURCES = \
 	$(SRC)/Dialogs/StatusPanels/TaskStatusPanel.cpp \
 	$(SRC)/Dialogs/StatusPanels/RulesStatusPanel.cpp \
 	$(SRC)/Dialogs/StatusPanels/TimesStatusPanel.cpp \
+	$(SRC)/Dialogs/StatusPanels/TimingStatusPanel.cpp \
 	\
 	$(SRC)/Dialogs/Waypoint/WaypointInfoWidget.cpp \
 	$(SRC)/Dialogs/Waypoint/WaypointCommandsWidget.cpp \
@@ -275,6 +276,7 @@ XCSOAR_SOURCES := \
 	$(SRC)/IGC/IGCWriter.cpp \
 	$(SRC)/IGC/IGCString.cpp \
 	$(SRC)/IGC/Generator.cpp \
+	$(SRC)/io/AsyncFileOutputStream.cpp \
 	$(SRC)/util/MD5.cpp \
 	$(SRC)/system/OpenLink.cpp \
 	$(SRC)/util/MarkdownParser.cpp \
@@ -814,7 +816,7 @@ XCSOAR_DEPENDS = \
 	ZZIP \
 	OPERATION \
 	JSON \
-	LIBNET TIME OS THREAD \
+	LIBNET TIME OS THREAD TRACING \
 	UTIL GEO MATH
 
 ifeq ($(HAVE_HTTP),y)
@@ -34,6 +34,12 @@ LIBMAPWINDOW_SOURCES = \
 
 LIBMAPWINDOW_DEPENDS = SCREEN
 
+ifneq ($(OPENGL),y)
+LIBMAPWINDOW_SOURCES += \
+	$(SRC)/MapWindow/BaseMapTileGrid.cpp \
+	$(SRC)/MapWindow/BaseMapTileCache.cpp
+endif
+
 ifeq ($(OPENGL),y)
 LIBMAPWINDOW_SOURCES += \
 	$(SRC)/MapWindow/OverlayBitmap.cpp
@@ -41,6 +47,7 @@ LIBMAPWINDOW_SOURCES += \
 ifeq ($(SQLITE),y)
 LIBMAPWINDOW_SOURCES += \
 	$(SRC)/MapWindow/MbTilesDatabase.cpp \
+	$(SRC)/MapWindow/MbTilesLoader.cpp \
 	$(SRC)/MapWindow/MbTilesOverlay.cpp
 
 LIBMAPWINDOW_DEPENDS += IO SQLITE
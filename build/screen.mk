@@ -271,7 +271,8 @@ SCREEN_SOURCES += \
 	$(CANVAS_SRC_DIR)/memory/RawBitmap.cpp \
 	$(CANVAS_SRC_DIR)/memory/VirtualCanvas.cpp \
 	$(CANVAS_SRC_DIR)/memory/SubCanvas.cpp \
-	$(CANVAS_SRC_DIR)/memory/Canvas.cpp
+	$(CANVAS_SRC_DIR)/memory/Canvas.cpp \
+	$(CANVAS_SRC_DIR)/memory/RasterBands.cpp
 MEMORY_CANVAS_CPPFLAGS = -DUSE_MEMORY_CANVAS
 endif
 
@@ -303,6 +304,11 @@ ifeq ($(LIBPNG),y)
 SCREEN_DEPENDS += IO
 endif
 
+ifeq ($(USE_MEMORY_CANVAS),y)
+# RasterBands.cpp uses class ThreadPool
+SCREEN_DEPENDS += THREAD
+endif
+
 $(eval $(call link-library,screen,SCREEN))
 
 ifeq ($(USE_FB)$(VFB),yy)
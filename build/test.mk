@@ -89,24 +89,29 @@ TEST_NAMES = \
 	TestUnits TestEarth TestSunEphemeris \
 	TestValidity TestUTM \
 	TestAllocatedGrid \
-	TestRadixTree TestGeoBounds TestGeoClip \
-	TestLogger TestGRecord TestClimbAvCalc TestFilteredVarioComputer \
+	TestRadixTree TestMortonIndex TestShapePointCodec TestShapeProjection TestTopographyPack \
+	TestScrollBuffer \
+	TestCompressedRasterBuffer TestRasterTileCache TestRasterRenderer TestThreadPool TestTracing \
+	TestGeoBounds TestGeoClip \
+	TestLogger TestAsyncFileOutputStream TestGRecord TestClimbAvCalc TestFilteredVarioComputer \
 	TestVarioSynthesiser TestAudioVario \
 	TestWaypointReader TestThermalBase \
-	TestFlarmNet TestFlarmMessaging \
+	TestFlarmNet TestFlarmMessaging TestTrafficList TestFlarmCalculations \
 	TestColorRamp TestXCThermBandQuery TestGeoPoint TestDiffFilter \
 	TestFileUtil TestRepository TestFileType TestPath TestPolars TestCSVLine TestGlidePolar \
-	test_replay_task TestProjection TestFlatPoint TestFlatLine TestFlatGeoPoint \
+	test_replay_task TestProjection TestBaseMapTileGrid TestFlatPoint TestFlatLine TestFlatGeoPoint \
 	TestMacCready TestOrderedTask TestAATPoint TestTaskSave \
 	TestTaskFileSeeYouParsing \
 	TestPlanes \
 	TestTaskPoint \
+	TestTaskDijkstra \
 	TestTaskWaypoint \
 	TestTeamCode \
 	TestZeroFinder \
 	TestAirspaceWarningManager \
 	TestAirspaceParser \
 	TestOGNAprsParser \
+	TestGeoGrid \
 	TestMETARParser \
 	TestIGCParser \
 	TestTraceBounds \
@@ -352,12 +357,19 @@ $(eval $(call link-program,TestAirspaceWarningManager,TEST_AIRSPACE_WARNING_MANA
 
 TEST_OGN_APRS_PARSER_SOURCES = \
 	$(SRC)/Cloud/OGNAprs.cpp \
+	$(SRC)/Cloud/OGNAreaFilter.cpp \
 	$(SRC)/Cloud/OGNTraffic.cpp \
 	$(TEST_SRC_DIR)/tap.c \
 	$(TEST_SRC_DIR)/TestOGNAprsParser.cpp
 TEST_OGN_APRS_PARSER_DEPENDS = GEO MATH UTIL UNITS
 $(eval $(call link-program,TestOGNAprsParser,TEST_OGN_APRS_PARSER))
 
+TEST_GEO_GRID_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestGeoGrid.cpp
+TEST_GEO_GRID_DEPENDS = GEO MATH UTIL
+$(eval $(call link-program,TestGeoGrid,TEST_GEO_GRID))
+
 TEST_DATE_TIME_SOURCES = \
 	$(TEST_SRC_DIR)/tap.c \
 	$(TEST_SRC_DIR)/TestDateTime.cpp
@@ -493,6 +505,12 @@ TEST_TASKPOINT_SOURCES = \
 TEST_TASKPOINT_DEPENDS = IO OS TASK GEO MATH
 $(eval $(call link-program,TestTaskPoint,TEST_TASKPOINT))
 
+TEST_TASK_DIJKSTRA_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestTaskDijkstra.cpp
+TEST_TASK_DIJKSTRA_DEPENDS = IO OS TASK GEO MATH
+$(eval $(call link-program,TestTaskDijkstra,TEST_TASK_DIJKSTRA))
+
 TEST_TASKWAYPOINT_SOURCES = \
 	$(ENGINE_SRC_DIR)/Waypoint/Waypoint.cpp \
 	$(TEST_SRC_DIR)/tap.c \
@@ -616,6 +634,21 @@ TEST_FLARM_NET_SOURCES = \
 TEST_FLARM_NET_DEPENDS = IO OS MATH UTIL
 $(eval $(call link-program,TestFlarmNet,TEST_FLARM_NET))
 
+TEST_TRAFFIC_LIST_SOURCES = \
+	$(SRC)/FLARM/List.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestTrafficList.cpp
+TEST_TRAFFIC_LIST_DEPENDS = MATH UTIL
+$(eval $(call link-program,TestTrafficList,TEST_TRAFFIC_LIST))
+
+TEST_FLARM_CALCULATIONS_SOURCES = \
+	$(SRC)/FLARM/Calculations.cpp \
+	$(SRC)/Computer/ClimbAverageCalculator.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestFlarmCalculations.cpp
+TEST_FLARM_CALCULATIONS_DEPENDS = MATH UTIL
+$(eval $(call link-program,TestFlarmCalculations,TEST_FLARM_CALCULATIONS))
+
 TEST_FLARM_MESSAGING_SOURCES = \
 	$(SRC)/FLARM/Id.cpp \
 	$(SRC)/FLARM/MessagingRecord.cpp \
@@ -663,6 +696,17 @@ TEST_PROJECTION_DEPENDS = MATH
 TEST_PROJECTION_CPPFLAGS = $(SCREEN_CPPFLAGS)
 $(eval $(call link-program,TestProjection,TEST_PROJECTION))
 
+TEST_BASE_MAP_TILE_GRID_SOURCES = \
+	$(SRC)/MapWindow/BaseMapTileGrid.cpp \
+	$(SRC)/Projection/Projection.cpp \
+	$(SRC)/Projection/WindowProjection.cpp \
+	$(SRC)/Terrain/TerrainSettings.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestBaseMapTileGrid.cpp
+TEST_BASE_MAP_TILE_GRID_DEPENDS = GEO MATH
+TEST_BASE_MAP_TILE_GRID_CPPFLAGS = $(SCREEN_CPPFLAGS)
+$(eval $(call link-program,TestBaseMapTileGrid,TEST_BASE_MAP_TILE_GRID))
+
 TEST_UNITS_SOURCES = \
 	$(SRC)/Units/Units.cpp \
 	$(SRC)/Units/Settings.cpp \
@@ -809,6 +853,7 @@ $(eval $(call link-program,TestPolars,TEST_POLARS))
 TEST_GLIDE_POLAR_SOURCES = \
 	$(ENGINE_SRC_DIR)/GlideSolvers/GlidePolar.cpp \
 	$(ENGINE_SRC_DIR)/GlideSolvers/GlideResult.cpp \
+	$(ENGINE_SRC_DIR)/GlideSolvers/GlideSpeedTable.cpp \
 	$(ENGINE_SRC_DIR)/GlideSolvers/GlideState.cpp \
 	$(ENGINE_SRC_DIR)/GlideSolvers/MacCready.cpp \
 	$(TEST_SRC_DIR)/tap.c \
@@ -1000,11 +1045,96 @@ TEST_RADIX_TREE_SOURCES = \
 TEST_RADIX_TREE_DEPENDS = UTIL
 $(eval $(call link-program,TestRadixTree,TEST_RADIX_TREE))
 
+TEST_MORTON_INDEX_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestMortonIndex.cpp
+TEST_MORTON_INDEX_DEPENDS = UTIL
+$(eval $(call link-program,TestMortonIndex,TEST_MORTON_INDEX))
+
+TEST_SHAPE_POINT_CODEC_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestShapePointCodec.cpp
+TEST_SHAPE_POINT_CODEC_DEPENDS = UTIL
+$(eval $(call link-program,TestShapePointCodec,TEST_SHAPE_POINT_CODEC))
+
+TEST_SHAPE_PROJECTION_SOURCES = \
+	$(SRC)/Projection/Projection.cpp \
+	$(SRC)/Projection/WindowProjection.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestShapeProjection.cpp
+TEST_SHAPE_PROJECTION_DEPENDS = GEO MATH UTIL
+$(eval $(call link-program,TestShapeProjection,TEST_SHAPE_PROJECTION))
+
+TEST_TOPOGRAPHY_PACK_SOURCES = \
+	$(SRC)/Topography/Pack.cpp \
+	$(SRC)/Topography/XShape.cpp \
+	$(SRC)/Topography/TopographyFile.cpp \
+	$(SRC)/Topography/ShapeFile.cpp \
+	$(SRC)/Projection/Projection.cpp \
+	$(SRC)/Projection/WindowProjection.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestTopographyPack.cpp
+ifeq ($(OPENGL),y)
+TEST_TOPOGRAPHY_PACK_SOURCES += \
+	$(CANVAS_SRC_DIR)/opengl/Triangulate.cpp
+endif
+TEST_TOPOGRAPHY_PACK_CPPFLAGS = $(SCREEN_CPPFLAGS)
+TEST_TOPOGRAPHY_PACK_DEPENDS = SHAPELIB GEO MATH TRACING IO SYSTEM UTIL ZZIP
+$(eval $(call link-program,TestTopographyPack,TEST_TOPOGRAPHY_PACK))
+
+TEST_SCROLL_BUFFER_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestScrollBuffer.cpp
+TEST_SCROLL_BUFFER_DEPENDS = UTIL
+$(eval $(call link-program,TestScrollBuffer,TEST_SCROLL_BUFFER))
+
+TEST_COMPRESSED_RASTER_BUFFER_SOURCES = \
+	$(SRC)/Terrain/RasterBuffer.cpp \
+	$(SRC)/Terrain/CompressedRasterBuffer.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestCompressedRasterBuffer.cpp
+TEST_COMPRESSED_RASTER_BUFFER_DEPENDS = IO UTIL
+$(eval $(call link-program,TestCompressedRasterBuffer,TEST_COMPRESSED_RASTER_BUFFER))
+
+TEST_RASTER_TILE_CACHE_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestRasterTileCache.cpp
+TEST_RASTER_TILE_CACHE_CPPFLAGS = $(SCREEN_CPPFLAGS)
+TEST_RASTER_TILE_CACHE_DEPENDS = TERRAIN GEO MATH IO UTIL
+$(eval $(call link-program,TestRasterTileCache,TEST_RASTER_TILE_CACHE))
+
+TEST_RASTER_RENDERER_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/FakeLogFile.cpp \
+	$(SRC)/Projection/Projection.cpp \
+	$(SRC)/Projection/WindowProjection.cpp \
+	$(SRC)/ui/canvas/Ramp.cpp \
+	$(TEST_SRC_DIR)/TestRasterRenderer.cpp
+TEST_RASTER_RENDERER_CPPFLAGS = $(SCREEN_CPPFLAGS)
+TEST_RASTER_RENDERER_DEPENDS = TERRAIN GEO MATH JASPER THREAD TRACING IO UTIL
+ifeq ($(OPENGL),y)
+TEST_RASTER_RENDERER_LDLIBS = $(OPENGL_LDLIBS)
+endif
+$(eval $(call link-program,TestRasterRenderer,TEST_RASTER_RENDERER))
+
+TEST_THREAD_POOL_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestThreadPool.cpp
+TEST_THREAD_POOL_DEPENDS = THREAD UTIL
+$(eval $(call link-program,TestThreadPool,TEST_THREAD_POOL))
+
+TEST_TRACING_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestTracing.cpp
+TEST_TRACING_DEPENDS = TRACING IO UTIL
+$(eval $(call link-program,TestTracing,TEST_TRACING))
+
 TEST_LOGGER_SOURCES = \
 	$(SRC)/IGC/IGCFix.cpp \
 	$(SRC)/IGC/IGCWriter.cpp \
 	$(SRC)/IGC/IGCString.cpp \
 	$(SRC)/IGC/Generator.cpp \
+	$(SRC)/io/AsyncFileOutputStream.cpp \
 	$(SRC)/Logger/LoggerFRecord.cpp \
 	$(SRC)/Logger/GRecord.cpp \
 	$(SRC)/Logger/LoggerEPE.cpp \
@@ -1013,9 +1143,16 @@ TEST_LOGGER_SOURCES = \
 	$(SRC)/Atmosphere/Pressure.cpp \
 	$(TEST_SRC_DIR)/tap.c \
 	$(TEST_SRC_DIR)/TestLogger.cpp
-TEST_LOGGER_DEPENDS = IO OS GEO MATH UTIL UNITS
+TEST_LOGGER_DEPENDS = IO OS THREAD GEO MATH UTIL UNITS
 $(eval $(call link-program,TestLogger,TEST_LOGGER))
 
+TEST_ASYNC_FILE_OUTPUT_STREAM_SOURCES = \
+	$(SRC)/io/AsyncFileOutputStream.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestAsyncFileOutputStream.cpp
+TEST_ASYNC_FILE_OUTPUT_STREAM_DEPENDS = IO OS THREAD UTIL
+$(eval $(call link-program,TestAsyncFileOutputStream,TEST_ASYNC_FILE_OUTPUT_STREAM))
+
 TEST_GRECORD_SOURCES = \
 	$(SRC)/Logger/GRecord.cpp \
 	$(SRC)/util/MD5.cpp \
@@ -1126,6 +1263,8 @@ DEBUG_PROGRAM_NAMES = \
 	FlightTable \
 	BenchmarkProjection \
 	BenchmarkFAITriangleSector \
+	BenchmarkWaypointIndex \
+	BenchmarkCloudIndex \
 	DumpTextInflate \
 	DumpHexColor \
 	RunXMLParser \
@@ -1133,7 +1272,7 @@ DEBUG_PROGRAM_NAMES = \
 	RunMD5 RunSHA256 \
 	ReadGRecord VerifyGRecord AppendGRecord FixGRecord \
 	AddChecksum \
-	LoadTopography LoadTerrain \
+	LoadTopography PackTopography LoadTerrain PackTerrain \
 	RunHeightMatrix \
 	RunInputParser \
 	RunWaypointParser RunAirspaceParser \
@@ -1301,6 +1440,22 @@ BENCHMARK_FAI_TRIANGLE_SECTOR_SOURCES = \
 BENCHMARK_FAI_TRIANGLE_SECTOR_DEPENDS = GEO MATH
 $(eval $(call link-program,BenchmarkFAITriangleSector,BENCHMARK_FAI_TRIANGLE_SECTOR))
 
+BENCHMARK_WAYPOINT_INDEX_SOURCES = \
+	$(SRC)/Waypoint/Factory.cpp \
+	$(SRC)/Compatibility/fmode.c \
+	$(SRC)/RadioFrequency.cpp \
+	$(SRC)/Operation/ConsoleOperationEnvironment.cpp \
+	$(TEST_SRC_DIR)/FakeTerrain.cpp \
+	$(TEST_SRC_DIR)/BenchmarkWaypointIndex.cpp
+BENCHMARK_WAYPOINT_INDEX_LDADD = $(FAKE_LIBS)
+BENCHMARK_WAYPOINT_INDEX_DEPENDS = WAYPOINTFILE OPERATION IO OS THREAD ZZIP GEO MATH UTIL
+$(eval $(call link-program,BenchmarkWaypointIndex,BENCHMARK_WAYPOINT_INDEX))
+
+BENCHMARK_CLOUD_INDEX_SOURCES = \
+	$(TEST_SRC_DIR)/BenchmarkCloudIndex.cpp
+BENCHMARK_CLOUD_INDEX_DEPENDS = GEO MATH UTIL
+$(eval $(call link-program,BenchmarkCloudIndex,BENCHMARK_CLOUD_INDEX))
+
 DUMP_TEXT_FILE_SOURCES = \
 	$(TEST_SRC_DIR)/DumpTextFile.cpp
 DUMP_TEXT_FILE_DEPENDS = IO OS ZZIP UTIL
@@ -1528,6 +1683,14 @@ LOAD_TOPOGRAPHY_DEPENDS = TOPO RESOURCE GEO MATH THREAD IO SYSTEM UTIL ZZIP
 LOAD_TOPOGRAPHY_CPPFLAGS = $(SCREEN_CPPFLAGS)
 $(eval $(call link-program,LoadTopography,LOAD_TOPOGRAPHY))
 
+PACK_TOPOGRAPHY_SOURCES = \
+	$(SRC)/system/Path.cpp \
+	$(TEST_SRC_DIR)/FakeLogFile.cpp \
+	$(TEST_SRC_DIR)/PackTopography.cpp
+PACK_TOPOGRAPHY_DEPENDS = TOPO RESOURCE GEO MATH THREAD IO SYSTEM UTIL ZZIP
+PACK_TOPOGRAPHY_CPPFLAGS = $(SCREEN_CPPFLAGS)
+$(eval $(call link-program,PackTopography,PACK_TOPOGRAPHY))
+
 LOAD_TERRAIN_SOURCES = \
 	$(TEST_SRC_DIR)/FakeLogFile.cpp \
 	$(SRC)/Operation/ConsoleOperationEnvironment.cpp \
@@ -1536,6 +1699,14 @@ LOAD_TERRAIN_CPPFLAGS = $(SCREEN_CPPFLAGS)
 LOAD_TERRAIN_DEPENDS = TERRAIN OPERATION GEO MATH OS IO ZZIP UTIL
 $(eval $(call link-program,LoadTerrain,LOAD_TERRAIN))
 
+PACK_TERRAIN_SOURCES = \
+	$(TEST_SRC_DIR)/FakeLogFile.cpp \
+	$(SRC)/Operation/ConsoleOperationEnvironment.cpp \
+	$(TEST_SRC_DIR)/PackTerrain.cpp
+PACK_TERRAIN_CPPFLAGS = $(SCREEN_CPPFLAGS)
+PACK_TERRAIN_DEPENDS = TERRAIN OPERATION GEO MATH OS IO ZZIP UTIL
+$(eval $(call link-program,PackTerrain,PACK_TERRAIN))
+
 RUN_HEIGHT_MATRIX_SOURCES = \
 	$(TEST_SRC_DIR)/FakeLogFile.cpp \
 	$(SRC)/Projection/Projection.cpp \
@@ -1861,6 +2032,7 @@ RUN_IGC_WRITER_SOURCES = \
 	$(SRC)/IGC/IGCWriter.cpp \
 	$(SRC)/IGC/IGCString.cpp \
 	$(SRC)/IGC/Generator.cpp \
+	$(SRC)/io/AsyncFileOutputStream.cpp \
 	$(SRC)/Logger/LoggerFRecord.cpp \
 	$(SRC)/Logger/GRecord.cpp \
 	$(SRC)/Logger/LoggerEPE.cpp \
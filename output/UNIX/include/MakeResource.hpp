@@ -0,0 +1,291 @@
+MAKE_RESOURCE(IDB_ABORT, mode_abort_96, 100);
+MAKE_RESOURCE(IDB_ABORT_HD, mode_abort_160, 101);
+MAKE_RESOURCE(IDB_ABORT_UHD, mode_abort_300, 102);
+#define IDB_ABORT_ALL IDB_ABORT, IDB_ABORT_HD, IDB_ABORT_UHD
+MAKE_RESOURCE(IDB_AIRPORT_REACHABLE, alt_reachable_airport_96, 103);
+MAKE_RESOURCE(IDB_AIRPORT_REACHABLE_HD, alt_reachable_airport_160, 104);
+MAKE_RESOURCE(IDB_AIRPORT_REACHABLE_UHD, alt_reachable_airport_300, 105);
+#define IDB_AIRPORT_REACHABLE_ALL IDB_AIRPORT_REACHABLE, IDB_AIRPORT_REACHABLE_HD, IDB_AIRPORT_REACHABLE_UHD
+MAKE_RESOURCE(IDB_AIRPORT_MARGINAL, alt_marginal_airport_96, 106);
+MAKE_RESOURCE(IDB_AIRPORT_MARGINAL_HD, alt_marginal_airport_160, 107);
+MAKE_RESOURCE(IDB_AIRPORT_MARGINAL_UHD, alt_marginal_airport_300, 108);
+#define IDB_AIRPORT_MARGINAL_ALL IDB_AIRPORT_MARGINAL, IDB_AIRPORT_MARGINAL_HD, IDB_AIRPORT_MARGINAL_UHD
+MAKE_RESOURCE(IDB_AIRPORT_UNREACHABLE, alt_landable_airport_96, 109);
+MAKE_RESOURCE(IDB_AIRPORT_UNREACHABLE_HD, alt_landable_airport_160, 110);
+MAKE_RESOURCE(IDB_AIRPORT_UNREACHABLE_UHD, alt_landable_airport_300, 111);
+#define IDB_AIRPORT_UNREACHABLE_ALL IDB_AIRPORT_UNREACHABLE, IDB_AIRPORT_UNREACHABLE_HD, IDB_AIRPORT_UNREACHABLE_UHD
+MAKE_RESOURCE(IDB_AIRPORT_MARGINAL2, alt2_marginal_airport_96, 112);
+MAKE_RESOURCE(IDB_AIRPORT_MARGINAL2_HD, alt2_marginal_airport_160, 113);
+MAKE_RESOURCE(IDB_AIRPORT_MARGINAL2_UHD, alt2_marginal_airport_300, 114);
+#define IDB_AIRPORT_MARGINAL2_ALL IDB_AIRPORT_MARGINAL2, IDB_AIRPORT_MARGINAL2_HD, IDB_AIRPORT_MARGINAL2_UHD
+MAKE_RESOURCE(IDB_AIRPORT_UNREACHABLE2, alt2_landable_airport_96, 115);
+MAKE_RESOURCE(IDB_AIRPORT_UNREACHABLE2_HD, alt2_landable_airport_160, 116);
+MAKE_RESOURCE(IDB_AIRPORT_UNREACHABLE2_UHD, alt2_landable_airport_300, 117);
+#define IDB_AIRPORT_UNREACHABLE2_ALL IDB_AIRPORT_UNREACHABLE2, IDB_AIRPORT_UNREACHABLE2_HD, IDB_AIRPORT_UNREACHABLE2_UHD
+MAKE_RESOURCE(IDB_AIRSPACEI, airspace_intercept_96, 118);
+MAKE_RESOURCE(IDB_AIRSPACEI_HD, airspace_intercept_160, 119);
+MAKE_RESOURCE(IDB_AIRSPACEI_UHD, airspace_intercept_300, 120);
+#define IDB_AIRSPACEI_ALL IDB_AIRSPACEI, IDB_AIRSPACEI_HD, IDB_AIRSPACEI_UHD
+MAKE_RESOURCE(IDB_CRUISE, mode_cruise_96, 121);
+MAKE_RESOURCE(IDB_CRUISE_HD, mode_cruise_160, 122);
+MAKE_RESOURCE(IDB_CRUISE_UHD, mode_cruise_300, 123);
+#define IDB_CRUISE_ALL IDB_CRUISE, IDB_CRUISE_HD, IDB_CRUISE_UHD
+MAKE_RESOURCE(IDB_CLIMB, mode_climb_96, 124);
+MAKE_RESOURCE(IDB_CLIMB_HD, mode_climb_160, 125);
+MAKE_RESOURCE(IDB_CLIMB_UHD, mode_climb_300, 126);
+#define IDB_CLIMB_ALL IDB_CLIMB, IDB_CLIMB_HD, IDB_CLIMB_UHD
+MAKE_RESOURCE(IDB_CLIMBSMALL, climb_12, 127);
+MAKE_RESOURCE(IDB_CLIMBSMALLINV, climb_12inv, 128);
+MAKE_RESOURCE(IDB_FOLDER, folder_96, 129);
+MAKE_RESOURCE(IDB_FOLDER_HD, folder_160, 130);
+MAKE_RESOURCE(IDB_FOLDER_UHD, folder_300, 131);
+#define IDB_FOLDER_ALL IDB_FOLDER, IDB_FOLDER_HD, IDB_FOLDER_UHD
+MAKE_RESOURCE(IDB_SETTINGS, settings_96, 132);
+MAKE_RESOURCE(IDB_SETTINGS_HD, settings_160, 133);
+MAKE_RESOURCE(IDB_SETTINGS_UHD, settings_300, 134);
+#define IDB_SETTINGS_ALL IDB_SETTINGS, IDB_SETTINGS_HD, IDB_SETTINGS_UHD
+MAKE_RESOURCE(IDB_TASK, task_96, 135);
+MAKE_RESOURCE(IDB_TASK_HD, task_160, 136);
+MAKE_RESOURCE(IDB_TASK_UHD, task_300, 137);
+#define IDB_TASK_ALL IDB_TASK, IDB_TASK_HD, IDB_TASK_UHD
+MAKE_RESOURCE(IDB_CALCULATOR, calculator_96, 138);
+MAKE_RESOURCE(IDB_CALCULATOR_HD, calculator_160, 139);
+MAKE_RESOURCE(IDB_CALCULATOR_UHD, calculator_300, 140);
+#define IDB_CALCULATOR_ALL IDB_CALCULATOR, IDB_CALCULATOR_HD, IDB_CALCULATOR_UHD
+MAKE_RESOURCE(IDB_WRENCH, wrench_96, 141);
+MAKE_RESOURCE(IDB_WRENCH_HD, wrench_160, 142);
+MAKE_RESOURCE(IDB_WRENCH_UHD, wrench_300, 143);
+#define IDB_WRENCH_ALL IDB_WRENCH, IDB_WRENCH_HD, IDB_WRENCH_UHD
+MAKE_RESOURCE(IDB_GLOBE, globe_96, 144);
+MAKE_RESOURCE(IDB_GLOBE_HD, globe_160, 145);
+MAKE_RESOURCE(IDB_GLOBE_UHD, globe_300, 146);
+#define IDB_GLOBE_ALL IDB_GLOBE, IDB_GLOBE_HD, IDB_GLOBE_UHD
+MAKE_RESOURCE(IDB_DEVICE, device_96, 147);
+MAKE_RESOURCE(IDB_DEVICE_HD, device_160, 148);
+MAKE_RESOURCE(IDB_DEVICE_UHD, device_300, 149);
+#define IDB_DEVICE_ALL IDB_DEVICE, IDB_DEVICE_HD, IDB_DEVICE_UHD
+MAKE_RESOURCE(IDB_RULES, rules_96, 150);
+MAKE_RESOURCE(IDB_RULES_HD, rules_160, 151);
+MAKE_RESOURCE(IDB_RULES_UHD, rules_300, 152);
+#define IDB_RULES_ALL IDB_RULES, IDB_RULES_HD, IDB_RULES_UHD
+MAKE_RESOURCE(IDB_CLOCK, clock_96, 153);
+MAKE_RESOURCE(IDB_CLOCK_HD, clock_160, 154);
+MAKE_RESOURCE(IDB_CLOCK_UHD, clock_300, 155);
+#define IDB_CLOCK_ALL IDB_CLOCK, IDB_CLOCK_HD, IDB_CLOCK_UHD
+MAKE_RESOURCE(IDB_STOPWATCH, stopwatch_96, 156);
+MAKE_RESOURCE(IDB_STOPWATCH_HD, stopwatch_160, 157);
+MAKE_RESOURCE(IDB_STOPWATCH_UHD, stopwatch_300, 158);
+#define IDB_STOPWATCH_ALL IDB_STOPWATCH, IDB_STOPWATCH_HD, IDB_STOPWATCH_UHD
+MAKE_RESOURCE(IDB_LOCATION_PIN, location_pin, 159);
+MAKE_RESOURCE(IDB_NOTIFICATION_BELL, notification_bell, 160);
+MAKE_RESOURCE(IDB_BLUETOOTH, bluetooth, 161);
+MAKE_RESOURCE(IDB_WARNING_TRIANGLE, warning_triangle, 162);
+MAKE_RESOURCE(IDB_ROTATE, rotate, 163);
+MAKE_RESOURCE(IDB_DIALOGTITLE, dialog_title, 164);
+MAKE_RESOURCE(IDB_FINALGLIDE, mode_finalglide_96, 165);
+MAKE_RESOURCE(IDB_FINALGLIDE_HD, mode_finalglide_160, 166);
+MAKE_RESOURCE(IDB_FINALGLIDE_UHD, mode_finalglide_300, 167);
+#define IDB_FINALGLIDE_ALL IDB_FINALGLIDE, IDB_FINALGLIDE_HD, IDB_FINALGLIDE_UHD
+MAKE_RESOURCE(IDB_TRAFFIC_SAFE, flarm_traffic_96, 168);
+MAKE_RESOURCE(IDB_TRAFFIC_SAFE_HD, flarm_traffic_160, 169);
+MAKE_RESOURCE(IDB_TRAFFIC_SAFE_UHD, flarm_traffic_300, 170);
+#define IDB_TRAFFIC_SAFE_ALL IDB_TRAFFIC_SAFE, IDB_TRAFFIC_SAFE_HD, IDB_TRAFFIC_SAFE_UHD
+MAKE_RESOURCE(IDB_TRAFFIC_WARNING, flarm_warning_96, 171);
+MAKE_RESOURCE(IDB_TRAFFIC_WARNING_HD, flarm_warning_160, 172);
+MAKE_RESOURCE(IDB_TRAFFIC_WARNING_UHD, flarm_warning_300, 173);
+#define IDB_TRAFFIC_WARNING_ALL IDB_TRAFFIC_WARNING, IDB_TRAFFIC_WARNING_HD, IDB_TRAFFIC_WARNING_UHD
+MAKE_RESOURCE(IDB_TRAFFIC_ALARM, flarm_alarm_96, 174);
+MAKE_RESOURCE(IDB_TRAFFIC_ALARM_HD, flarm_alarm_160, 175);
+MAKE_RESOURCE(IDB_TRAFFIC_ALARM_UHD, flarm_alarm_300, 176);
+#define IDB_TRAFFIC_ALARM_ALL IDB_TRAFFIC_ALARM, IDB_TRAFFIC_ALARM_HD, IDB_TRAFFIC_ALARM_UHD
+MAKE_RESOURCE(IDB_GPSSTATUS1, gps_acquiring_96, 177);
+MAKE_RESOURCE(IDB_GPSSTATUS1_HD, gps_acquiring_160, 178);
+MAKE_RESOURCE(IDB_GPSSTATUS1_UHD, gps_acquiring_300, 179);
+#define IDB_GPSSTATUS1_ALL IDB_GPSSTATUS1, IDB_GPSSTATUS1_HD, IDB_GPSSTATUS1_UHD
+MAKE_RESOURCE(IDB_GPSSTATUS2, gps_disconnected_96, 180);
+MAKE_RESOURCE(IDB_GPSSTATUS2_HD, gps_disconnected_160, 181);
+MAKE_RESOURCE(IDB_GPSSTATUS2_UHD, gps_disconnected_300, 182);
+#define IDB_GPSSTATUS2_ALL IDB_GPSSTATUS2, IDB_GPSSTATUS2_HD, IDB_GPSSTATUS2_UHD
+MAKE_RESOURCE(IDB_LANDABLE, winpilot_landable_96, 183);
+MAKE_RESOURCE(IDB_LANDABLE_HD, winpilot_landable_160, 184);
+MAKE_RESOURCE(IDB_LANDABLE_UHD, winpilot_landable_300, 185);
+#define IDB_LANDABLE_ALL IDB_LANDABLE, IDB_LANDABLE_HD, IDB_LANDABLE_UHD
+MAKE_RESOURCE(IDB_LAUNCHER1, launcher_640_1, 186);
+MAKE_RESOURCE(IDB_LAUNCHER2, launcher_640_2, 187);
+MAKE_RESOURCE(IDB_LAUNCHER1_RGBA, launcher_640_rgba_1, 188);
+MAKE_RESOURCE(IDB_LAUNCHER2_RGBA, launcher_640_rgba_2, 189);
+MAKE_RESOURCE(IDB_MAPSCALE_LEFT, scalearrow_left_96, 190);
+MAKE_RESOURCE(IDB_MAPSCALE_LEFT_HD, scalearrow_left_160, 191);
+MAKE_RESOURCE(IDB_MAPSCALE_LEFT_UHD, scalearrow_left_300, 192);
+#define IDB_MAPSCALE_LEFT_ALL IDB_MAPSCALE_LEFT, IDB_MAPSCALE_LEFT_HD, IDB_MAPSCALE_LEFT_UHD
+MAKE_RESOURCE(IDB_MAPSCALE_RIGHT, scalearrow_right_96, 193);
+MAKE_RESOURCE(IDB_MAPSCALE_RIGHT_HD, scalearrow_right_160, 194);
+MAKE_RESOURCE(IDB_MAPSCALE_RIGHT_UHD, scalearrow_right_300, 195);
+#define IDB_MAPSCALE_RIGHT_ALL IDB_MAPSCALE_RIGHT, IDB_MAPSCALE_RIGHT_HD, IDB_MAPSCALE_RIGHT_UHD
+MAKE_RESOURCE(IDB_CONTOUR_SPACING, contour_spacing_icon_96, 196);
+MAKE_RESOURCE(IDB_CONTOUR_SPACING_HD, contour_spacing_icon_160, 197);
+MAKE_RESOURCE(IDB_CONTOUR_SPACING_UHD, contour_spacing_icon_300, 198);
+#define IDB_CONTOUR_SPACING_ALL IDB_CONTOUR_SPACING, IDB_CONTOUR_SPACING_HD, IDB_CONTOUR_SPACING_UHD
+MAKE_RESOURCE(IDB_MARK, map_flag_96, 199);
+MAKE_RESOURCE(IDB_MARK_HD, map_flag_160, 200);
+MAKE_RESOURCE(IDB_MARK_UHD, map_flag_300, 201);
+#define IDB_MARK_ALL IDB_MARK, IDB_MARK_HD, IDB_MARK_UHD
+MAKE_RESOURCE(IDB_OBSTACLE, map_obstacle_96, 202);
+MAKE_RESOURCE(IDB_OBSTACLE_HD, map_obstacle_160, 203);
+MAKE_RESOURCE(IDB_OBSTACLE_UHD, map_obstacle_300, 204);
+#define IDB_OBSTACLE_ALL IDB_OBSTACLE, IDB_OBSTACLE_HD, IDB_OBSTACLE_UHD
+MAKE_RESOURCE(IDB_OUTFIELD_REACHABLE, alt_reachable_field_96, 205);
+MAKE_RESOURCE(IDB_OUTFIELD_REACHABLE_HD, alt_reachable_field_160, 206);
+MAKE_RESOURCE(IDB_OUTFIELD_REACHABLE_UHD, alt_reachable_field_300, 207);
+#define IDB_OUTFIELD_REACHABLE_ALL IDB_OUTFIELD_REACHABLE, IDB_OUTFIELD_REACHABLE_HD, IDB_OUTFIELD_REACHABLE_UHD
+MAKE_RESOURCE(IDB_OUTFIELD_MARGINAL, alt_marginal_field_96, 208);
+MAKE_RESOURCE(IDB_OUTFIELD_MARGINAL_HD, alt_marginal_field_160, 209);
+MAKE_RESOURCE(IDB_OUTFIELD_MARGINAL_UHD, alt_marginal_field_300, 210);
+#define IDB_OUTFIELD_MARGINAL_ALL IDB_OUTFIELD_MARGINAL, IDB_OUTFIELD_MARGINAL_HD, IDB_OUTFIELD_MARGINAL_UHD
+MAKE_RESOURCE(IDB_OUTFIELD_UNREACHABLE, alt_landable_field_96, 211);
+MAKE_RESOURCE(IDB_OUTFIELD_UNREACHABLE_HD, alt_landable_field_160, 212);
+MAKE_RESOURCE(IDB_OUTFIELD_UNREACHABLE_UHD, alt_landable_field_300, 213);
+#define IDB_OUTFIELD_UNREACHABLE_ALL IDB_OUTFIELD_UNREACHABLE, IDB_OUTFIELD_UNREACHABLE_HD, IDB_OUTFIELD_UNREACHABLE_UHD
+MAKE_RESOURCE(IDB_OUTFIELD_MARGINAL2, alt2_marginal_field_96, 214);
+MAKE_RESOURCE(IDB_OUTFIELD_MARGINAL2_HD, alt2_marginal_field_160, 215);
+MAKE_RESOURCE(IDB_OUTFIELD_MARGINAL2_UHD, alt2_marginal_field_300, 216);
+#define IDB_OUTFIELD_MARGINAL2_ALL IDB_OUTFIELD_MARGINAL2, IDB_OUTFIELD_MARGINAL2_HD, IDB_OUTFIELD_MARGINAL2_UHD
+MAKE_RESOURCE(IDB_OUTFIELD_UNREACHABLE2, alt2_landable_field_96, 217);
+MAKE_RESOURCE(IDB_OUTFIELD_UNREACHABLE2_HD, alt2_landable_field_160, 218);
+MAKE_RESOURCE(IDB_OUTFIELD_UNREACHABLE2_UHD, alt2_landable_field_300, 219);
+#define IDB_OUTFIELD_UNREACHABLE2_ALL IDB_OUTFIELD_UNREACHABLE2, IDB_OUTFIELD_UNREACHABLE2_HD, IDB_OUTFIELD_UNREACHABLE2_UHD
+MAKE_RESOURCE(IDB_MOUNTAIN_PASS, map_pass_96, 220);
+MAKE_RESOURCE(IDB_MOUNTAIN_PASS_HD, map_pass_160, 221);
+MAKE_RESOURCE(IDB_MOUNTAIN_PASS_UHD, map_pass_300, 222);
+#define IDB_MOUNTAIN_PASS_ALL IDB_MOUNTAIN_PASS, IDB_MOUNTAIN_PASS_HD, IDB_MOUNTAIN_PASS_UHD
+MAKE_RESOURCE(IDB_PROGRESSBORDER, progress_border, 223);
+MAKE_RESOURCE(IDB_REACHABLE, winpilot_reachable_96, 224);
+MAKE_RESOURCE(IDB_REACHABLE_HD, winpilot_reachable_160, 225);
+MAKE_RESOURCE(IDB_REACHABLE_UHD, winpilot_reachable_300, 226);
+#define IDB_REACHABLE_ALL IDB_REACHABLE, IDB_REACHABLE_HD, IDB_REACHABLE_UHD
+MAKE_RESOURCE(IDB_MARGINAL, winpilot_marginal_96, 227);
+MAKE_RESOURCE(IDB_MARGINAL_HD, winpilot_marginal_160, 228);
+MAKE_RESOURCE(IDB_MARGINAL_UHD, winpilot_marginal_300, 229);
+#define IDB_MARGINAL_ALL IDB_MARGINAL, IDB_MARGINAL_HD, IDB_MARGINAL_UHD
+MAKE_RESOURCE(IDB_SMALL, map_small_96, 230);
+MAKE_RESOURCE(IDB_SMALL_HD, map_small_160, 231);
+MAKE_RESOURCE(IDB_SMALL_UHD, map_small_300, 232);
+#define IDB_SMALL_ALL IDB_SMALL, IDB_SMALL_HD, IDB_SMALL_UHD
+MAKE_RESOURCE(IDB_LOGO_UHD, logo_320, 233);
+MAKE_RESOURCE(IDB_LOGO_HD, logo_160, 234);
+MAKE_RESOURCE(IDB_LOGO, logo_80, 235);
+MAKE_RESOURCE(IDB_LOGO_UHD_RGBA, logo_320_rgba, 236);
+MAKE_RESOURCE(IDB_LOGO_HD_RGBA, logo_160_rgba, 237);
+MAKE_RESOURCE(IDB_LOGO_RGBA, logo_80_rgba, 238);
+MAKE_RESOURCE(IDB_TARGET, map_target_96, 239);
+MAKE_RESOURCE(IDB_TARGET_HD, map_target_160, 240);
+MAKE_RESOURCE(IDB_TARGET_UHD, map_target_300, 241);
+#define IDB_TARGET_ALL IDB_TARGET, IDB_TARGET_HD, IDB_TARGET_UHD
+MAKE_RESOURCE(IDB_TEAMMATE_POS, map_teammate_96, 242);
+MAKE_RESOURCE(IDB_TEAMMATE_POS_HD, map_teammate_160, 243);
+MAKE_RESOURCE(IDB_TEAMMATE_POS_UHD, map_teammate_300, 244);
+#define IDB_TEAMMATE_POS_ALL IDB_TEAMMATE_POS, IDB_TEAMMATE_POS_HD, IDB_TEAMMATE_POS_UHD
+MAKE_RESOURCE(IDB_TERRAINWARNING, map_terrainw_96, 245);
+MAKE_RESOURCE(IDB_TERRAINWARNING_HD, map_terrainw_160, 246);
+MAKE_RESOURCE(IDB_TERRAINWARNING_UHD, map_terrainw_300, 247);
+#define IDB_TERRAINWARNING_ALL IDB_TERRAINWARNING, IDB_TERRAINWARNING_HD, IDB_TERRAINWARNING_UHD
+MAKE_RESOURCE(IDB_THERMALSOURCE, map_thermal_source_96, 248);
+MAKE_RESOURCE(IDB_THERMALSOURCE_HD, map_thermal_source_160, 249);
+MAKE_RESOURCE(IDB_THERMALSOURCE_UHD, map_thermal_source_300, 250);
+#define IDB_THERMALSOURCE_ALL IDB_THERMALSOURCE, IDB_THERMALSOURCE_HD, IDB_THERMALSOURCE_UHD
+MAKE_RESOURCE(IDB_TOWN, map_town_96, 251);
+MAKE_RESOURCE(IDB_TOWN_HD, map_town_160, 252);
+MAKE_RESOURCE(IDB_TOWN_UHD, map_town_300, 253);
+#define IDB_TOWN_ALL IDB_TOWN, IDB_TOWN_HD, IDB_TOWN_UHD
+MAKE_RESOURCE(IDB_TURNPOINT, map_turnpoint_96, 254);
+MAKE_RESOURCE(IDB_TURNPOINT_HD, map_turnpoint_160, 255);
+MAKE_RESOURCE(IDB_TURNPOINT_UHD, map_turnpoint_300, 256);
+#define IDB_TURNPOINT_ALL IDB_TURNPOINT, IDB_TURNPOINT_HD, IDB_TURNPOINT_UHD
+MAKE_RESOURCE(IDB_TASKTURNPOINT, map_taskturnpoint_96, 257);
+MAKE_RESOURCE(IDB_TASKTURNPOINT_HD, map_taskturnpoint_160, 258);
+MAKE_RESOURCE(IDB_TASKTURNPOINT_UHD, map_taskturnpoint_300, 259);
+#define IDB_TASKTURNPOINT_ALL IDB_TASKTURNPOINT, IDB_TASKTURNPOINT_HD, IDB_TASKTURNPOINT_UHD
+MAKE_RESOURCE(IDB_MOUNTAIN_TOP, map_mountain_top_96, 260);
+MAKE_RESOURCE(IDB_MOUNTAIN_TOP_HD, map_mountain_top_160, 261);
+MAKE_RESOURCE(IDB_MOUNTAIN_TOP_UHD, map_mountain_top_300, 262);
+#define IDB_MOUNTAIN_TOP_ALL IDB_MOUNTAIN_TOP, IDB_MOUNTAIN_TOP_HD, IDB_MOUNTAIN_TOP_UHD
+MAKE_RESOURCE(IDB_BRIDGE, map_bridge_96, 263);
+MAKE_RESOURCE(IDB_BRIDGE_HD, map_bridge_160, 264);
+MAKE_RESOURCE(IDB_BRIDGE_UHD, map_bridge_300, 265);
+#define IDB_BRIDGE_ALL IDB_BRIDGE, IDB_BRIDGE_HD, IDB_BRIDGE_UHD
+MAKE_RESOURCE(IDB_TUNNEL, map_tunnel_96, 266);
+MAKE_RESOURCE(IDB_TUNNEL_HD, map_tunnel_160, 267);
+MAKE_RESOURCE(IDB_TUNNEL_UHD, map_tunnel_300, 268);
+#define IDB_TUNNEL_ALL IDB_TUNNEL, IDB_TUNNEL_HD, IDB_TUNNEL_UHD
+MAKE_RESOURCE(IDB_TOWER, map_tower_96, 269);
+MAKE_RESOURCE(IDB_TOWER_HD, map_tower_160, 270);
+MAKE_RESOURCE(IDB_TOWER_UHD, map_tower_300, 271);
+#define IDB_TOWER_ALL IDB_TOWER, IDB_TOWER_HD, IDB_TOWER_UHD
+MAKE_RESOURCE(IDB_POWER_PLANT, map_power_plant_96, 272);
+MAKE_RESOURCE(IDB_POWER_PLANT_HD, map_power_plant_160, 273);
+MAKE_RESOURCE(IDB_POWER_PLANT_UHD, map_power_plant_300, 274);
+#define IDB_POWER_PLANT_ALL IDB_POWER_PLANT, IDB_POWER_PLANT_HD, IDB_POWER_PLANT_UHD
+MAKE_RESOURCE(IDB_THERMAL_HOTSPOT, map_thermal_hotspot_96, 275);
+MAKE_RESOURCE(IDB_THERMAL_HOTSPOT_HD, map_thermal_hotspot_160, 276);
+MAKE_RESOURCE(IDB_THERMAL_HOTSPOT_UHD, map_thermal_hotspot_300, 277);
+#define IDB_THERMAL_HOTSPOT_ALL IDB_THERMAL_HOTSPOT, IDB_THERMAL_HOTSPOT_HD, IDB_THERMAL_HOTSPOT_UHD
+MAKE_RESOURCE(IDB_VOR, map_vor_96, 278);
+MAKE_RESOURCE(IDB_VOR_HD, map_vor_160, 279);
+MAKE_RESOURCE(IDB_VOR_UHD, map_vor_300, 280);
+#define IDB_VOR_ALL IDB_VOR, IDB_VOR_HD, IDB_VOR_UHD
+MAKE_RESOURCE(IDB_NDB, map_ndb_96, 281);
+MAKE_RESOURCE(IDB_NDB_HD, map_ndb_160, 282);
+MAKE_RESOURCE(IDB_NDB_UHD, map_ndb_300, 283);
+#define IDB_NDB_ALL IDB_NDB, IDB_NDB_HD, IDB_NDB_UHD
+MAKE_RESOURCE(IDB_DAM, map_dam_96, 284);
+MAKE_RESOURCE(IDB_DAM_HD, map_dam_160, 285);
+MAKE_RESOURCE(IDB_DAM_UHD, map_dam_300, 286);
+#define IDB_DAM_ALL IDB_DAM, IDB_DAM_HD, IDB_DAM_UHD
+MAKE_RESOURCE(IDB_CASTLE, map_castle_96, 287);
+MAKE_RESOURCE(IDB_CASTLE_HD, map_castle_160, 288);
+MAKE_RESOURCE(IDB_CASTLE_UHD, map_castle_300, 289);
+#define IDB_CASTLE_ALL IDB_CASTLE, IDB_CASTLE_HD, IDB_CASTLE_UHD
+MAKE_RESOURCE(IDB_INTERSECTION, map_intersection_96, 290);
+MAKE_RESOURCE(IDB_INTERSECTION_HD, map_intersection_160, 291);
+MAKE_RESOURCE(IDB_INTERSECTION_UHD, map_intersection_300, 292);
+#define IDB_INTERSECTION_ALL IDB_INTERSECTION, IDB_INTERSECTION_HD, IDB_INTERSECTION_UHD
+MAKE_RESOURCE(IDB_REPORTING_POINT, map_reporting_point_96, 293);
+MAKE_RESOURCE(IDB_REPORTING_POINT_HD, map_reporting_point_160, 294);
+MAKE_RESOURCE(IDB_REPORTING_POINT_UHD, map_reporting_point_300, 295);
+#define IDB_REPORTING_POINT_ALL IDB_REPORTING_POINT, IDB_REPORTING_POINT_HD, IDB_REPORTING_POINT_UHD
+MAKE_RESOURCE(IDB_PGTAKEOFF, map_pgtakeoff_96, 296);
+MAKE_RESOURCE(IDB_PGTAKEOFF_HD, map_pgtakeoff_160, 297);
+MAKE_RESOURCE(IDB_PGTAKEOFF_UHD, map_pgtakeoff_300, 298);
+#define IDB_PGTAKEOFF_ALL IDB_PGTAKEOFF, IDB_PGTAKEOFF_HD, IDB_PGTAKEOFF_UHD
+MAKE_RESOURCE(IDB_PGLANDING, map_pglanding_96, 299);
+MAKE_RESOURCE(IDB_PGLANDING_HD, map_pglanding_160, 300);
+MAKE_RESOURCE(IDB_PGLANDING_UHD, map_pglanding_300, 301);
+#define IDB_PGLANDING_ALL IDB_PGLANDING, IDB_PGLANDING_HD, IDB_PGLANDING_UHD
+MAKE_RESOURCE(IDB_GESTURE_DOWN, gesture_down, 302);
+MAKE_RESOURCE(IDB_GESTURE_DL, gesture_dl, 303);
+MAKE_RESOURCE(IDB_GESTURE_DR, gesture_dr, 304);
+MAKE_RESOURCE(IDB_GESTURE_DU, gesture_du, 305);
+MAKE_RESOURCE(IDB_GESTURE_LEFT, gesture_left, 306);
+MAKE_RESOURCE(IDB_GESTURE_LDR, gesture_ldr, 307);
+MAKE_RESOURCE(IDB_GESTURE_LDRDL, gesture_ldrdl, 308);
+MAKE_RESOURCE(IDB_GESTURE_LU, gesture_lu, 309);
+MAKE_RESOURCE(IDB_GESTURE_RIGHT, gesture_right, 310);
+MAKE_RESOURCE(IDB_GESTURE_RD, gesture_rd, 311);
+MAKE_RESOURCE(IDB_GESTURE_RL, gesture_rl, 312);
+MAKE_RESOURCE(IDB_GESTURE_UP, gesture_up, 313);
+MAKE_RESOURCE(IDB_GESTURE_UD, gesture_ud, 314);
+MAKE_RESOURCE(IDB_GESTURE_ULDR, gesture_uldr, 315);
+MAKE_RESOURCE(IDB_GESTURE_URD, gesture_urd, 316);
+MAKE_RESOURCE(IDB_GESTURE_URDL, gesture_urdl, 317);
+MAKE_RESOURCE(IDB_TITLE, title_110, 318);
+MAKE_RESOURCE(IDB_TITLE_HD, title_320, 319);
+MAKE_RESOURCE(IDB_TITLE_UHD, title_640, 320);
+MAKE_RESOURCE(IDB_TITLE_RGBA, title_110_rgba, 321);
+MAKE_RESOURCE(IDB_TITLE_HD_RGBA, title_320_rgba, 322);
+MAKE_RESOURCE(IDB_TITLE_UHD_RGBA, title_640_rgba, 323);
+MAKE_RESOURCE(IDB_TITLE_HD_WHITE, title_white_320_rgba, 324);
+MAKE_RESOURCE(IDB_TITLE_UHD_WHITE, title_white_640_rgba, 325);
+MAKE_RESOURCE(IDB_WEATHER_STATION, map_weather_station_96, 326);
+MAKE_RESOURCE(IDB_WEATHER_STATION_HD, map_weather_station_160, 327);
+MAKE_RESOURCE(IDB_WEATHER_STATION_UHD, map_weather_station_300, 328);
+#define IDB_WEATHER_STATION_ALL IDB_WEATHER_STATION, IDB_WEATHER_STATION_HD, IDB_WEATHER_STATION_UHD
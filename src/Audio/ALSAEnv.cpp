@@ -9,6 +9,7 @@
 
 #include <cassert>
 #include <stdlib.h>
+#include <string.h>
 
 
 namespace ALSAEnv
@@ -17,9 +18,11 @@ namespace ALSAEnv
 
 static constexpr char ALSA_DEVICE_ENV[] = "ALSA_DEVICE";
 static constexpr char ALSA_LATENCY_ENV[] = "ALSA_LATENCY";
+static constexpr char ALSA_SMALL_BUFFER_ENV[] = "ALSA_SMALL_BUFFER";
 
 static constexpr char DEFAULT_ALSA_DEVICE[] = "default";
 static constexpr unsigned DEFAULT_ALSA_LATENCY = 100000;
+static constexpr unsigned DEFAULT_ALSA_SMALL_BUFFER_LATENCY = 20000;
 
 
 static const char *InitALSADeviceName()
@@ -33,12 +36,26 @@ static const char *InitALSADeviceName()
   return alsa_device;
 }
 
+static bool InitALSASmallBuffer()
+{
+  const char *small_buffer_env_value = getenv(ALSA_SMALL_BUFFER_ENV);
+  const bool small_buffer = (nullptr != small_buffer_env_value) &&
+    ('\0' != *small_buffer_env_value) &&
+    (0 != strcmp(small_buffer_env_value, "0"));
+  if (small_buffer)
+    LogFormat("Using ALSA PCM small buffer mode (%s is set)",
+              ALSA_SMALL_BUFFER_ENV);
+  return small_buffer;
+}
+
 static unsigned InitALSALatency()
 {
   unsigned latency;
   const char *latency_env_value = getenv(ALSA_LATENCY_ENV);
   if ((nullptr == latency_env_value) || ('\0' == *latency_env_value)) {
-    latency = DEFAULT_ALSA_LATENCY;
+    latency = IsALSASmallBuffer()
+      ? DEFAULT_ALSA_SMALL_BUFFER_LATENCY
+      : DEFAULT_ALSA_LATENCY;
   } else {
     char *p;
     latency = ParseUnsigned(latency_env_value, &p);
@@ -65,4 +82,15 @@ unsigned GetALSALatency()
   return alsa_latency;
 }
 
+bool IsALSASmallBuffer()
+{
+  static bool alsa_small_buffer = InitALSASmallBuffer();
+  return alsa_small_buffer;
+}
+
+unsigned GetALSAPeriods()
+{
+  return IsALSASmallBuffer() ? 2 : 4;
+}
+
 }
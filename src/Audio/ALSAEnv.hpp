@@ -26,7 +26,26 @@ namespace ALSAEnv
    * underruns.
    *
    * @return Value of the environment variable "ALSA_LATENCY", parsed as
-   * unsigned, or 10000 if not set, or unparsable. The unit is μs.
+   * unsigned, or 10000 if not set, or unparsable (20000 in small buffer
+   * mode). The unit is μs.
    */
   unsigned GetALSALatency();
+
+  /**
+   * Is the small buffer mode enabled?  In this mode, the ALSA PCM buffer
+   * is split into only two periods, and the default latency is reduced,
+   * so that vario tone changes become audible sooner.  This costs more
+   * wakeups and may cause buffer underruns on slow devices.
+   *
+   * @return true if the environment variable "ALSA_SMALL_BUFFER" is set
+   * to a value other than "0"
+   */
+  bool IsALSASmallBuffer();
+
+  /**
+   * Get the number of periods the ALSA PCM buffer is split into.
+   *
+   * @return 2 in small buffer mode, 4 otherwise
+   */
+  unsigned GetALSAPeriods();
 }
@@ -132,7 +132,7 @@ ALSAPCMPlayer::OnSocketReady(unsigned) noexcept
 bool
 ALSAPCMPlayer::SetParameters(snd_pcm_t &alsa_handle, unsigned sample_rate,
                              bool big_endian_source, unsigned latency,
-                             unsigned &channels) {
+                             unsigned periods, unsigned &channels) {
   /* adoption of alsa-libs's snd_pcm_set_params() function, which is not
    * available on SALSA, with a few detail enhancements. */
 
@@ -221,7 +221,7 @@ ALSAPCMPlayer::SetParameters(snd_pcm_t &alsa_handle, unsigned sample_rate,
                                                       &latency,
                                                       nullptr);
   if (0 != alsa_error) {
-    unsigned period_time = latency / 4;
+    unsigned period_time = latency / periods;
     alsa_error = snd_pcm_hw_params_set_period_time_near(&alsa_handle,
                                                         hw_params,
                                                         &period_time,
@@ -250,7 +250,7 @@ ALSAPCMPlayer::SetParameters(snd_pcm_t &alsa_handle, unsigned sample_rate,
       return false;
     }
 
-    buffer_size = period_size * 4;
+    buffer_size = period_size * periods;
     alsa_error = snd_pcm_hw_params_set_buffer_size_near(&alsa_handle,
                                                         hw_params,
                                                         &buffer_size);
@@ -300,7 +300,7 @@ ALSAPCMPlayer::SetParameters(snd_pcm_t &alsa_handle, unsigned sample_rate,
       return false;
     }
 
-    unsigned period_time = latency / 4;
+    unsigned period_time = latency / periods;
     alsa_error = snd_pcm_hw_params_set_period_time_near(&alsa_handle,
                                                         hw_params,
                                                         &period_time,
@@ -492,11 +492,12 @@ ALSAPCMPlayer::Start(PCMDataSource &_source)
   }
 
   unsigned latency = ALSAEnv::GetALSALatency();
+  unsigned periods = ALSAEnv::GetALSAPeriods();
 
   channels = 1;
   bool big_endian_source = _source.IsBigEndian();
   if (!SetParameters(*new_alsa_handle, new_sample_rate, big_endian_source,
-                     latency, channels))
+                     latency, periods, channels))
     return false;
 
   snd_pcm_sframes_t n_available = snd_pcm_avail(new_alsa_handle.get());
@@ -6,33 +6,57 @@
 
 #include <cassert>
 
+/**
+ * The number of #ISINETABLE index bits in the 32 bit phase.
+ */
+static constexpr unsigned TABLE_BITS = 12;
+static_assert(ISINETABLE.size() == 1u << TABLE_BITS);
+
 void
 ToneSynthesiser::SetTone(unsigned tone_hz)
 {
-  increment = ISINETABLE.size() * tone_hz / sample_rate;
+  target_increment = uint32_t((uint64_t(tone_hz) << 32) / sample_rate);
+
+  const unsigned ramp_samples = GetRampSamples();
+  if (increment == 0 || ramp_samples == 0) {
+    /* nothing is playing yet; start with the new frequency */
+    increment = target_increment;
+    ramp_remaining = 0;
+    return;
+  }
+
+  ramp_step = int32_t((int64_t(target_increment) - int64_t(increment))
+                      / ramp_samples);
+  ramp_remaining = ramp_samples;
 }
 
 void
 ToneSynthesiser::Synthesise(int16_t *buffer, size_t n)
 {
-  assert(angle < ISINETABLE.size());
-  const auto current_volume = volume.load();
+  const auto current_volume = volume.load(std::memory_order_relaxed);
 
   for (int16_t *end = buffer + n; buffer != end; ++buffer) {
-    *buffer = ISINETABLE[angle] * (32767 / 1024) *
+    *buffer = ISINETABLE[phase >> (32 - TABLE_BITS)] * (32767 / 1024) *
       (int)current_volume / 100;
-    angle = (angle + increment) & (ISINETABLE.size() - 1);
+
+    if (ramp_remaining > 0) {
+      /* the last step lands exactly on the target, regardless of
+         rounding errors in #ramp_step */
+      increment = --ramp_remaining > 0
+        ? increment + ramp_step
+        : target_increment;
+    }
+
+    phase += increment;
   }
 }
 
 unsigned
 ToneSynthesiser::ToZero() const
 {
-  assert(angle < ISINETABLE.size());
-
-  if (angle < increment)
+  if (increment == 0 || phase < increment)
     /* close enough */
     return 0;
 
-  return (ISINETABLE.size() - angle) / increment;
+  return (0u - phase) / increment;
 }
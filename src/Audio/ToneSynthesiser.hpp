@@ -6,15 +6,43 @@
 #include "PCMSynthesiser.hpp"
 
 #include <atomic>
+#include <cstdint>
 
 /**
  * This class generates tones with a sine wave.
+ *
+ * The phase is a 32 bit fixed point value (one full turn wraps
+ * around to zero), and frequency changes are ramped linearly over
+ * #RAMP_MS milliseconds, one step per sample, to avoid audible
+ * jumps.
  */
 class ToneSynthesiser : public PCMSynthesiser {
   std::atomic<unsigned> volume{100};
-  unsigned angle = 0, increment = 0;
+
+  uint32_t phase = 0, increment = 0;
+
+  /**
+   * The #increment which is being ramped to.
+   */
+  uint32_t target_increment = 0;
+
+  /**
+   * The value added to #increment for each sample while ramping.
+   */
+  int32_t ramp_step = 0;
+
+  /**
+   * The number of samples remaining until #target_increment is
+   * reached.
+   */
+  unsigned ramp_remaining = 0;
 
 public:
+  /**
+   * The duration of a frequency ramp.
+   */
+  static constexpr unsigned RAMP_MS = 5;
+
   explicit ToneSynthesiser(unsigned _sample_rate) : sample_rate(_sample_rate) {
   }
 
@@ -22,6 +50,13 @@ public:
     return sample_rate;
   }
 
+  /**
+   * Returns the number of samples of a frequency ramp.
+   */
+  unsigned GetRampSamples() const {
+    return sample_rate * RAMP_MS / 1000;
+  }
+
   /**
    * Set the (software) volume of the generated tone.
    *
@@ -32,6 +67,12 @@ public:
     volume = _volume;
   }
 
+  /**
+   * Change the tone frequency.  If a tone is already being played,
+   * the frequency is ramped to the new value during the following
+   * samples.  Must only be called from the thread which calls
+   * Synthesise().
+   */
   void SetTone(unsigned tone_hz);
 
   /* methods from class PCMSynthesiser */
@@ -51,6 +92,6 @@ protected:
    * Start a new period.
    */
   void Restart() {
-    angle = 0;
+    phase = 0;
   }
 };
@@ -30,67 +30,88 @@ VarioSynthesiser::SetVario(double vario)
 
   if (dead_band_enabled && InDeadBand(ivario)) {
     /* inside the "dead band" */
-    UnsafeSetSilence();
+    parameters.store(PackParameters(0, 0, 1), std::memory_order_relaxed);
     return;
   }
 
-  /* update the ToneSynthesiser base class */
-  SetTone(VarioToFrequency(ivario));
+  const unsigned frequency = std::min(VarioToFrequency(ivario), 0xffffu);
 
   if (ivario > 0) {
     /* while climbing, the vario sound gets interrupted by silence
        periodically */
 
-    const unsigned period_ms = sample_rate
+    const size_t period = std::min<uint_least64_t>(uint_least64_t(sample_rate)
       * (min_period_ms + (max_vario - ivario)
          * (max_period_ms - min_period_ms) / max_vario)
-      / 1000;
-
-    silence_count = period_ms / 3;
-    audible_count = period_ms - silence_count;
-
-    /* preserve the old "_remaining" values as much as possible, to
-       avoid chopping off the previous tone */
+      / 1000, COUNT_MASK);
 
-    if (audible_remaining > audible_count)
-      audible_remaining = audible_count;
+    const size_t silence = period / 3;
+    const size_t audible = std::max<size_t>(period - silence, 1);
 
-    if (silence_remaining > silence_count)
-      silence_remaining = silence_count;
+    parameters.store(PackParameters(frequency, audible, silence),
+                     std::memory_order_relaxed);
   } else {
     /* continuous tone while sinking */
-    audible_count = 1;
-    silence_count = 0;
+    parameters.store(PackParameters(frequency, 1, 0),
+                     std::memory_order_relaxed);
   }
 }
 
 void
 VarioSynthesiser::SetSilence()
 {
-  const std::lock_guard lock{mutex};
-  UnsafeSetSilence();
+  parameters.store(PackParameters(0, 0, 1), std::memory_order_relaxed);
 }
 
 void
-VarioSynthesiser::UnsafeSetSilence()
+VarioSynthesiser::ApplyParameters(uint_least64_t p)
 {
-  audible_count = 0;
-  silence_count = 1;
+  applied_parameters = p;
 
-  if (audible_remaining > 0)
-    /* quit the current period as early as possible; the method
-       Synthesise() will take care for finishing the current sine
-       wave to avoid clicking noise */
-    audible_remaining = 1;
+  const size_t new_audible_count = (p >> COUNT_BITS) & COUNT_MASK;
+  const size_t new_silence_count = p & COUNT_MASK;
 
-  silence_remaining = 0;
-}
+  if (new_audible_count == 0) {
+    /* silence */
+    audible_count = 0;
+    silence_count = 1;
+
+    if (audible_remaining > 0)
+      /* quit the current period as early as possible; the
+         Synthesise() loop will take care for finishing the current
+         sine wave to avoid clicking noise */
+      audible_remaining = 1;
+
+    silence_remaining = 0;
+    return;
+  }
 
+  /* update the ToneSynthesiser base class */
+  SetTone(unsigned(p >> (2 * COUNT_BITS)));
+
+  audible_count = new_audible_count;
+  silence_count = new_silence_count;
+
+  if (silence_count > 0) {
+    /* preserve the old "_remaining" values as much as possible, to
+       avoid chopping off the previous tone */
+
+    if (audible_remaining > audible_count)
+      audible_remaining = audible_count;
+
+    if (silence_remaining > silence_count)
+      silence_remaining = silence_count;
+  }
+}
 
 void
 VarioSynthesiser::Synthesise(int16_t *buffer, size_t n)
 {
-  const std::lock_guard lock{mutex};
+  /* pick up new parameters once per buffer; the frequency change is
+     ramped sample by sample in the ToneSynthesiser base class */
+  if (const auto p = parameters.load(std::memory_order_relaxed);
+      p != applied_parameters)
+    ApplyParameters(p);
 
   assert(audible_count > 0 || silence_count > 0);
 
@@ -99,7 +120,6 @@ VarioSynthesiser::Synthesise(int16_t *buffer, size_t n)
     ToneSynthesiser::Synthesise(buffer, n);
     return;
   }
-
   while (n > 0) {
     if (audible_remaining > 0) {
       /* generate a period of audible tone */
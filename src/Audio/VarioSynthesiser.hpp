@@ -6,34 +6,25 @@
 #include "ToneSynthesiser.hpp"
 #include "thread/Mutex.hxx"
 
+#include <atomic>
+#include <cstdint>
+
 /**
  * This class generates vario sound.
+ *
+ * The tone parameters calculated by SetVario() are published as one
+ * packed atomic word, which Synthesise() picks up at the beginning
+ * of each buffer.  The audio thread never blocks on the thread
+ * which feeds vario values.
  */
 class VarioSynthesiser final : public ToneSynthesiser {
   /**
-   * This mutex protects all atttributes below.  It is locked
-   * automatically by all public methods.
+   * This mutex protects the settings below.  It is only locked by
+   * the producer methods (SetVario() and the setters), never by
+   * Synthesise().
    */
   Mutex mutex;
 
-  /**
-   * The number of audible samples in each period.
-   */
-  size_t audible_count;
-
-  /**
-   * The number of silent samples in each period.  If this is zero,
-   * then no silence will be generated (continuous tone).
-   */
-  size_t silence_count;
-
-  /**
-   * The number of audible/silence samples remaining in the current
-   * period.  These two attributes will be reset to the according
-   * _count value when both reach zero.
-   */
-  size_t audible_remaining, silence_remaining;
-
   bool dead_band_enabled;
 
   /**
@@ -67,15 +58,49 @@ class VarioSynthesiser final : public ToneSynthesiser {
    */
   int min_dead, max_dead;
 
+  /**
+   * The tone parameters for Synthesise(), see PackParameters().
+   */
+  std::atomic<uint_least64_t> parameters;
+
+  static_assert(std::atomic<uint_least64_t>::is_always_lock_free,
+                "the audio thread must not wait for a lock in std::atomic");
+
+  /**
+   * The #parameters value which was last applied by Synthesise().
+   * Only accessed by the audio thread, like all attributes below.
+   */
+  uint_least64_t applied_parameters;
+
+  /**
+   * The number of audible samples in each period.
+   */
+  size_t audible_count;
+
+  /**
+   * The number of silent samples in each period.  If this is zero,
+   * then no silence will be generated (continuous tone).
+   */
+  size_t silence_count;
+
+  /**
+   * The number of audible/silence samples remaining in the current
+   * period.  These two attributes will be reset to the according
+   * _count value when both reach zero.
+   */
+  size_t audible_remaining, silence_remaining;
+
 public:
   explicit VarioSynthesiser(unsigned sample_rate)
     :ToneSynthesiser(sample_rate),
-     audible_count(0), silence_count(1),
-     audible_remaining(0), silence_remaining(0),
      dead_band_enabled(false),
      min_frequency(200), zero_frequency(500), max_frequency(1500),
      min_period_ms(150), max_period_ms(600),
-     min_dead(-30), max_dead(10) {}
+     min_dead(-30), max_dead(10),
+     parameters(PackParameters(0, 0, 1)),
+     applied_parameters(PackParameters(0, 0, 1)),
+     audible_count(0), silence_count(1),
+     audible_remaining(0), silence_remaining(0) {}
 
   /**
    * Update the vario value.  This calculates a new tone frequency and
@@ -130,17 +155,34 @@ public:
   virtual void Synthesise(int16_t *buffer, size_t n);
 
 private:
+  static constexpr unsigned COUNT_BITS = 24;
+  static constexpr uint_least64_t COUNT_MASK = (1u << COUNT_BITS) - 1;
+
+  /**
+   * Pack the tone frequency [Hz] and the audible/silence sample
+   * counts into one word which can be published atomically.  An
+   * audible count of zero means silence, a silence count of zero
+   * means continuous tone.
+   */
+  static constexpr uint_least64_t PackParameters(unsigned frequency,
+                                                 size_t audible,
+                                                 size_t silence) noexcept {
+    return (uint_least64_t(frequency & 0xffff) << (2 * COUNT_BITS)) |
+      (uint_least64_t(audible & COUNT_MASK) << COUNT_BITS) |
+      (silence & COUNT_MASK);
+  }
+
   /**
-   * Same as SetSilence(), but doesn't lock the mutex.
+   * Apply a #parameters value which was published by the producer.
    */
-  void UnsafeSetSilence();
+  void ApplyParameters(uint_least64_t p);
 
   /**
    * Convert a vario value to a tone frequency.
    *
    * @param ivario the current vario value [cm/s]
    */
-  [[gnu::const]]
+  [[gnu::pure]]
   unsigned VarioToFrequency(int ivario);
 
   bool InDeadBand(int ivario) {
@@ -6,6 +6,7 @@
 #include "Protection.hpp"
 #include "Blackboard/DeviceBlackboard.hpp"
 #include "Hardware/CPU.hpp"
+#include "Tracing/Tracing.hpp"
 
 /**
  * Constructor of the CalculationThread class
@@ -59,6 +60,8 @@ CalculationThread::Tick() noexcept
   const ScopeLockCPU cpu;
 #endif
 
+  const Tracing::Scope trace{Tracing::Point::CALCULATION_TICK};
+
   bool gps_updated;
 
   // update and transfer master info to glide computer
@@ -88,9 +91,11 @@ CalculationThread::Tick() noexcept
 
   bool do_idle = false;
 
-  if (gps_updated || force)
+  if (gps_updated || force) {
+    const Tracing::Scope trace_gps{Tracing::Point::CALCULATION_GPS};
     // perform idle call if time advanced and slow calculations need to be updated
     do_idle |= glide_computer.ProcessGPS(force);
+  }
 
   // values changed, so copy them back now: ONLY CALCULATED INFO
   // should be changed in DoCalculations, so we only need to write
@@ -107,6 +112,7 @@ CalculationThread::Tick() noexcept
 
   if (do_idle) {
     // do slow calculations last, to minimise latency
+    const Tracing::Scope trace_idle{Tracing::Point::CALCULATION_IDLE};
     glide_computer.ProcessIdle();
   }
 }
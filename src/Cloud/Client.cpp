@@ -3,7 +3,6 @@
 
 #include "Client.hpp"
 #include "Serialiser.hpp"
-#include "Geo/Boost/RangeBox.hpp"
 #include "Tracking/SkyLines/Protocol.hpp"
 #include "Tracking/SkyLines/Assemble.hpp"
 #include "Tracking/SkyLines/Import.hpp"
@@ -11,10 +10,6 @@
 #include "net/Resolver.hxx"
 #include "util/ByteOrder.hxx"
 
-#include <boost/geometry/algorithms/distance.hpp>
-#include <boost/geometry/algorithms/intersection.hpp>
-#include <boost/geometry/strategies/strategies.hpp>
-
 CloudClientContainer::CloudClientContainer()
   :key_set(typename KeySet::bucket_traits(key_buckets, N_KEY_BUCKETS)) {}
 
@@ -49,8 +44,8 @@ CloudClientContainer::Make(SocketAddress address,
   auto result = key_set.insert_check(key, key_set.hash_function(),
                                      key_set.key_eq(), hint);
   if (result.second) {
-    auto client = std::make_shared<CloudClient>(address, key, next_id++,
-                                                location, altitude);
+    auto client = new CloudClient(address, key, next_id++,
+                                  location, altitude);
     client->track_deg = track_deg;
     client->track_valid = track_valid;
     Insert(*client);
@@ -81,10 +76,8 @@ CloudClientContainer::Refresh(CloudClient &client,
   Refresh(client, address);
 
   if (location != client.location) {
-    auto ptr = client.shared_from_this();
-    rtree.remove(ptr);
     client.location = location;
-    rtree.insert(ptr);
+    grid.Move(client);
   }
 
   client.altitude = altitude;
@@ -99,7 +92,7 @@ CloudClientContainer::Insert(CloudClient &client)
   list.push_front(client);
   key_set.insert(client);
   id_set.push_back(client);
-  rtree.insert(client.shared_from_this());
+  grid.insert(client);
 }
 
 void
@@ -108,7 +101,8 @@ CloudClientContainer::Remove(CloudClient &client)
   list.erase(list.iterator_to(client));
   key_set.erase(key_set.iterator_to(client));
   id_set.erase(id_set.iterator_to(client));
-  rtree.remove(client.shared_from_this());
+  grid.remove(client);
+  delete &client;
 }
 
 void
@@ -121,8 +115,7 @@ CloudClientContainer::Expire(std::chrono::steady_clock::time_point before)
 CloudClientContainer::query_iterator_range
 CloudClientContainer::QueryWithinRange(GeoPoint location, double range) const
 {
-  const auto q = boost::geometry::index::intersects(BoostRangeBox(location, range));
-  return {rtree.qbegin(q), rtree.qend()};
+  return grid.QueryWithinRange(location, range);
 }
 
 inline Serialiser &
@@ -225,8 +218,7 @@ CloudClientContainer::Load(Deserialiser &s)
   next_id = s.Read32();
 
   while (s.Read8() != 0) {
-    auto client = std::make_shared<CloudClient>(CloudClient::Load(s));
-    Insert(*client);
+    Insert(*new CloudClient(CloudClient::Load(s)));
   }
 
   s.Read8();
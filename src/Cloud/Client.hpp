@@ -3,15 +3,13 @@
 
 #pragma once
 
-#include "Geo/Boost/GeoPoint.hpp"
+#include "GeoGrid.hpp"
+#include "Geo/GeoPoint.hpp"
 #include "net/AllocatedSocketAddress.hxx"
 
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive/set.hpp>
 #include <boost/intrusive/unordered_set.hpp>
-#include <boost/geometry/index/rtree.hpp>
-#include <boost/range/iterator_range_core.hpp>
-#include <memory>
 #include <chrono>
 
 class Serialiser;
@@ -20,11 +18,22 @@ class Deserialiser;
 /** FLARM aircraft type for glider (#FlarmTraffic::AircraftType::GLIDER). */
 static constexpr unsigned CLOUD_DEFAULT_AIRCRAFT_TYPE = 1;
 
+struct CloudClientPushTag;
+
+/**
+ * Links a #CloudClient into the server's list of pending traffic
+ * pushes; it unlinks itself when the client is deleted.
+ */
+using CloudClientPushHook =
+  boost::intrusive::list_base_hook<boost::intrusive::tag<CloudClientPushTag>,
+                                   boost::intrusive::link_mode<boost::intrusive::auto_unlink>>;
+
 /**
  * A client which has submitted data to us recently.
  */
 struct CloudClient
-  : std::enable_shared_from_this<CloudClient>,
+  : GeoGridHook,
+    CloudClientPushHook,
     boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>>,
     boost::intrusive::set_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>>,
     boost::intrusive::unordered_set_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>>
@@ -58,6 +67,12 @@ struct CloudClient
   std::chrono::steady_clock::time_point last_traffic_push =
     std::chrono::steady_clock::time_point::min();
 
+  /**
+   * Why the pending traffic push (see #CloudClientPushHook) was
+   * scheduled; for logging.
+   */
+  const char *traffic_push_reason = nullptr;
+
   /**
    * The client wishes to receive thermal information until this time
    * stamp.
@@ -137,23 +152,21 @@ struct CloudClient
   static CloudClient Load(Deserialiser &s);
 };
 
-using CloudClientPtr = std::shared_ptr<CloudClient>;
-
 /**
- * Helper for boost::geometry::index::rtree.
+ * Helper for #GeoGrid.
  */
-struct CloudClientIndexable {
-  typedef GeoPoint result_type;
-
+struct CloudClientLocation {
   [[gnu::pure]]
-  result_type operator()(const CloudClientPtr &client) const {
-    return client->location;
+  GeoPoint operator()(const CloudClient &client) const noexcept {
+    return client.location;
   }
 };
 
+/**
+ * Owns all #CloudClient instances.
+ */
 class CloudClientContainer {
-  typedef boost::geometry::index::rtree<CloudClientPtr, boost::geometry::index::rstar<16>,
-                                        CloudClientIndexable> Tree;
+  typedef GeoGrid<CloudClient, CloudClientLocation> Grid;
 
   typedef boost::intrusive::list<CloudClient,
                                  boost::intrusive::constant_time_size<false>> List;
@@ -169,9 +182,10 @@ class CloudClientContainer {
 
   /**
    * A geospatial container of all clients, for fast geographic
-   * lookups.
+   * lookups.  Clients move all the time, and moving an item in the
+   * grid is cheap.
    */
-  Tree rtree;
+  Grid grid;
 
   /**
    * A linked list of clients, sorted by last fix, with fresh items at
@@ -241,22 +255,36 @@ public:
                const GeoPoint &location, int altitude,
                unsigned track_deg, bool track_valid);
 
+  /**
+   * Add a #CloudClient which was allocated with "new"; the container
+   * takes over ownership.
+   */
   void Insert(CloudClient &client);
 
   /**
-   * Remove a #CloudClient and its data.  Be careful - the given reference
-   * is invalidated, unless the caller holds another #CloudClientPtr.
+   * Remove a #CloudClient and delete it.  Be careful - the given
+   * reference is invalidated.
    */
   void Remove(CloudClient &client);
 
   void Expire(std::chrono::steady_clock::time_point before);
 
-  typedef Tree::const_query_iterator query_iterator;
-  typedef boost::iterator_range<query_iterator> query_iterator_range;
+  typedef Grid::const_iterator query_iterator;
+  typedef Grid::Range query_iterator_range;
 
   [[gnu::pure]]
   query_iterator_range QueryWithinRange(GeoPoint location, double range) const;
 
+  /**
+   * Returns all clients within the given range of any location in
+   * the grid cell (see GeoGridHook::geo_grid_cell).
+   */
+  [[gnu::pure]]
+  query_iterator_range QueryCellWithinRange(unsigned cell,
+                                            double range) const noexcept {
+    return grid.QueryCellWithinRange(cell, range);
+  }
+
   void Save(Serialiser &s) const;
   void Load(Deserialiser &s);
 };
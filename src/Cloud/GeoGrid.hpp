@@ -0,0 +1,333 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "Geo/GeoPoint.hpp"
+#include "Geo/FAISphere.hpp"
+
+#include <boost/intrusive/list.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+
+struct GeoGridTag;
+
+using GeoGridListHook =
+  boost::intrusive::list_base_hook<
+    boost::intrusive::tag<GeoGridTag>,
+    boost::intrusive::link_mode<boost::intrusive::normal_link>>;
+
+/**
+ * Base class for items in a #GeoGrid.
+ */
+struct GeoGridHook : GeoGridListHook {
+  /**
+   * The index of the #GeoGrid cell this item is linked into.
+   */
+  unsigned geo_grid_cell = 0;
+};
+
+/**
+ * A uniform grid of latitude/longitude cells, each one an intrusive
+ * list of the items located inside it.  Unlike an rtree, moving an
+ * item costs O(1) (nothing at all if it stays in its cell), which
+ * suits containers whose items report new positions all the time.
+ *
+ * Range queries visit all cells which intersect the bounding box of
+ * the range and return the items inside that box, like an rtree
+ * "intersects" query with BoostRangeBox().
+ *
+ * The grid does not own the items.
+ *
+ * @param T the item type; must derive from #GeoGridHook
+ * @param GetLocation a function object returning the location of an
+ * item
+ */
+template<typename T, typename GetLocation>
+class GeoGrid {
+  /**
+   * The cell size.  Typical query ranges (50 km) span 2-4 cells in
+   * each direction.
+   */
+  static constexpr double CELL_DEGREES = 0.5;
+
+  static constexpr unsigned N_LONGITUDE = unsigned(360 / CELL_DEGREES);
+  static constexpr unsigned N_LATITUDE = unsigned(180 / CELL_DEGREES);
+
+  using Cell = boost::intrusive::list<
+    T, boost::intrusive::base_hook<GeoGridListHook>,
+    boost::intrusive::constant_time_size<false>>;
+
+  const std::unique_ptr<Cell[]> cells;
+
+public:
+  GeoGrid() noexcept
+    :cells(new Cell[N_LONGITUDE * N_LATITUDE]) {}
+
+  ~GeoGrid() noexcept {
+    clear();
+  }
+
+  GeoGrid(const GeoGrid &) = delete;
+  GeoGrid &operator=(const GeoGrid &) = delete;
+
+  /**
+   * Unlink all items.
+   */
+  void clear() noexcept {
+    for (std::size_t i = 0; i < N_LONGITUDE * N_LATITUDE; ++i)
+      cells[i].clear();
+  }
+
+  void insert(T &item) noexcept {
+    const unsigned cell = ToCell(GetLocation()(item));
+    item.geo_grid_cell = cell;
+    cells[cell].push_front(item);
+  }
+
+  void remove(T &item) noexcept {
+    auto &cell = cells[item.geo_grid_cell];
+    cell.erase(cell.iterator_to(item));
+  }
+
+  /**
+   * Call this after the location of the item has changed.
+   */
+  void Move(T &item) noexcept {
+    const unsigned cell = ToCell(GetLocation()(item));
+    if (cell == item.geo_grid_cell)
+      return;
+
+    remove(item);
+    item.geo_grid_cell = cell;
+    cells[cell].push_front(item);
+  }
+
+  /**
+   * The box of a range query [degrees].  #west may be larger than
+   * #east if the box crosses the antimeridian.
+   */
+  struct Box {
+    double south, north, west, east;
+
+    [[gnu::pure]]
+    bool Contains(GeoPoint p) const noexcept {
+      const double latitude = p.latitude.Degrees();
+      if (latitude < south || latitude > north)
+        return false;
+
+      const double longitude = p.longitude.Degrees();
+      return west <= east
+        ? longitude >= west && longitude <= east
+        : longitude >= west || longitude <= east;
+    }
+  };
+
+  /**
+   * Iterates over the items in a #Box.  Dereferencing yields a
+   * pointer to the item.
+   */
+  class const_iterator {
+    friend class GeoGrid;
+
+    const GeoGrid *grid = nullptr;
+    Box box;
+
+    /* the current row and the last row */
+    unsigned y, y_last;
+
+    /* the first column and the number of columns */
+    unsigned x_first, n_x;
+
+    /* the current column, relative to #x_first */
+    unsigned i;
+
+    typename Cell::iterator item;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T *;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T **;
+    using reference = T *;
+
+    const_iterator() noexcept = default;
+
+    T *operator*() const noexcept {
+      return &*item;
+    }
+
+    const_iterator &operator++() noexcept {
+      ++item;
+      Settle();
+      return *this;
+    }
+
+    const_iterator operator++(int) noexcept {
+      auto old = *this;
+      ++*this;
+      return old;
+    }
+
+    bool operator==(const const_iterator &other) const noexcept {
+      if (grid == nullptr || other.grid == nullptr)
+        return grid == other.grid;
+
+      return item == other.item;
+    }
+
+    bool operator!=(const const_iterator &other) const noexcept {
+      return !(*this == other);
+    }
+
+  private:
+    Cell &GetCell() const noexcept {
+      return grid->cells[ToIndex((x_first + i) % N_LONGITUDE, y)];
+    }
+
+    /**
+     * Advance to the next matching item (including the current
+     * one); becomes the end iterator when there is none.
+     */
+    void Settle() noexcept {
+      while (true) {
+        for (auto end = GetCell().end(); item != end; ++item)
+          if (box.Contains(GetLocation()(*item)))
+            return;
+
+        if (++i == n_x) {
+          i = 0;
+          if (y++ == y_last) {
+            grid = nullptr;
+            return;
+          }
+        }
+
+        item = GetCell().begin();
+      }
+    }
+  };
+
+  struct Range {
+    const_iterator first, last;
+
+    const_iterator begin() const noexcept {
+      return first;
+    }
+
+    const_iterator end() const noexcept {
+      return last;
+    }
+  };
+
+  /**
+   * Returns all items inside the bounding box of the circle around
+   * #location.  The items may be modified, but the grid must not
+   * be, while iterating.
+   *
+   * @param range the radius [m]
+   */
+  [[gnu::pure]]
+  Range QueryWithinRange(GeoPoint location, double range) const noexcept {
+    const double latitude = location.latitude.Degrees();
+    const double longitude = location.longitude.Degrees();
+    return Query(MakeBox(latitude, latitude, longitude, longitude, range));
+  }
+
+  /**
+   * Returns all items within the given range of any location inside
+   * the specified cell (see GeoGridHook::geo_grid_cell), i.e. a
+   * superset of QueryWithinRange() for each of those locations.
+   * This allows sharing one query among the items of a cell.
+   *
+   * @param range the radius [m]
+   */
+  [[gnu::pure]]
+  Range QueryCellWithinRange(unsigned cell, double range) const noexcept {
+    const double west = (cell % N_LONGITUDE) * CELL_DEGREES - 180;
+    const double south = (cell / N_LONGITUDE) * CELL_DEGREES - 90;
+    return Query(MakeBox(south, south + CELL_DEGREES,
+                         west, west + CELL_DEGREES, range));
+  }
+
+private:
+  Range Query(const Box &box) const noexcept {
+    const_iterator i;
+    i.grid = this;
+    i.box = box;
+
+    i.y = LatitudeCell(box.south);
+    i.y_last = LatitudeCell(box.north);
+
+    const double west = box.west;
+    const double east = box.west <= box.east
+      ? box.east
+      : box.east + 360;
+    i.x_first = LongitudeCell(west);
+    i.n_x = std::min(unsigned(std::floor(east / CELL_DEGREES) -
+                              std::floor(west / CELL_DEGREES)) + 1,
+                     N_LONGITUDE);
+    i.i = 0;
+    i.item = i.GetCell().begin();
+    i.Settle();
+
+    return {i, const_iterator{}};
+  }
+
+  static constexpr unsigned ToIndex(unsigned x, unsigned y) noexcept {
+    return y * N_LONGITUDE + x;
+  }
+
+  [[gnu::const]]
+  static unsigned LongitudeCell(double degrees) noexcept {
+    const int x = (int)std::floor((degrees + 180) / CELL_DEGREES);
+    return unsigned(((x % int(N_LONGITUDE)) + int(N_LONGITUDE))
+                    % int(N_LONGITUDE));
+  }
+
+  [[gnu::const]]
+  static unsigned LatitudeCell(double degrees) noexcept {
+    const int y = (int)std::floor((degrees + 90) / CELL_DEGREES);
+    return y < 0
+      ? 0u
+      : std::min(unsigned(y), N_LATITUDE - 1);
+  }
+
+  [[gnu::const]]
+  static unsigned ToCell(GeoPoint location) noexcept {
+    return ToIndex(LongitudeCell(location.longitude.Degrees()),
+                   LatitudeCell(location.latitude.Degrees()));
+  }
+
+  /**
+   * Like BoostRangeBox(), but for a rectangle [degrees] extended by
+   * the range in all directions.  The longitude range is calculated
+   * at the poleward edge, and boxes touching a pole span all
+   * longitudes, so the box never misses items within the range.
+   */
+  [[gnu::const]]
+  static Box MakeBox(double south, double north, double west, double east,
+                     double range) noexcept {
+    const double latitude_delta =
+      FAISphere::EarthDistanceToAngle(range).Degrees();
+
+    south = std::max(south - latitude_delta, -90.);
+    north = std::min(north + latitude_delta, 90.);
+
+    const auto c = std::min(Angle::Degrees(north).cos(),
+                            Angle::Degrees(south).cos());
+    if (c < 0.01 || latitude_delta / c >= 180 - (east - west) / 2)
+      return {south, north, -180, 180};
+
+    const double longitude_delta = latitude_delta / c;
+    return {
+      south, north,
+      Angle::Degrees(west - longitude_delta).AsDelta().Degrees(),
+      Angle::Degrees(east + longitude_delta).AsDelta().Degrees(),
+    };
+  }
+};
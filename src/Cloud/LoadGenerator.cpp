@@ -0,0 +1,646 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+/*
+ * Load generator for xcsoar-cloud-server: simulates many gliders
+ * which send SkyLines tracking fixes, pings, traffic and thermal
+ * requests, and reports the response latency percentiles and the
+ * packet rates.
+ */
+
+#include "Tracking/SkyLines/Assemble.hpp"
+#include "Tracking/SkyLines/Protocol.hpp"
+#include "Tracking/SkyLines/Server.hpp"
+#include "Geo/GeoPoint.hpp"
+#include "Geo/GeoVector.hpp"
+#include "event/Loop.hxx"
+#include "event/CoarseTimerEvent.hxx"
+#include "event/FineTimerEvent.hxx"
+#include "event/SocketEvent.hxx"
+#include "event/SignalMonitor.hxx"
+#include "net/AllocatedSocketAddress.hxx"
+#include "net/AddressInfo.hxx"
+#include "net/Resolver.hxx"
+#include "net/SocketError.hxx"
+#include "net/UniqueSocketDescriptor.hxx"
+#include "system/Args.hpp"
+#include "util/ByteOrder.hxx"
+#include "util/CRC16CCITT.hpp"
+#include "util/EnvParser.hpp"
+#include "util/PrintException.hxx"
+#include "util/ScopeExit.hxx"
+#include "util/SpanCast.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <signal.h>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+using namespace SkyLinesTracking;
+
+/**
+ * The simulated clients use the keys KEY_BASE+1 .. KEY_BASE+n.
+ */
+static constexpr uint64_t KEY_BASE = 0x4c4f414400000000ULL;
+
+/* how often the other packets are sent, in number of fixes */
+static constexpr unsigned PING_EVERY = 5;
+static constexpr unsigned TRAFFIC_REQUEST_EVERY = 10;
+static constexpr unsigned THERMAL_REQUEST_EVERY = 30;
+
+static constexpr std::chrono::milliseconds TICK_INTERVAL{10};
+static constexpr std::chrono::seconds REPORT_INTERVAL{10};
+
+static uint32_t
+MsUtcMidnight() noexcept
+{
+  using namespace std::chrono;
+  const auto ms = duration_cast<milliseconds>(
+                    system_clock::now().time_since_epoch())
+                    .count();
+  constexpr auto day_ms = 24LL * 60 * 60 * 1000;
+  return uint32_t(ms % day_ms);
+}
+
+/**
+ * Collects round trip times and calculates percentiles.
+ */
+class LatencyStats {
+  std::vector<double> samples;
+
+public:
+  void Add(std::chrono::steady_clock::duration d) noexcept {
+    samples.push_back(std::chrono::duration<double, std::milli>(d).count());
+  }
+
+  void Append(const LatencyStats &other) {
+    samples.insert(samples.end(),
+                   other.samples.begin(), other.samples.end());
+  }
+
+  void Clear() noexcept {
+    samples.clear();
+  }
+
+  /**
+   * Print "NAME=n/p50/p90/p99/max" (milliseconds).  Sorts the
+   * samples.
+   */
+  void Print(std::ostream &os, const char *name) noexcept {
+    os << '\t' << name << '=' << samples.size();
+    if (samples.empty())
+      return;
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [this](double p){
+      return samples[std::min(std::size_t(p * samples.size()),
+                              samples.size() - 1)];
+    };
+
+    os << '/' << percentile(0.5)
+       << '/' << percentile(0.9)
+       << '/' << percentile(0.99)
+       << '/' << samples.back() << "ms";
+  }
+};
+
+struct Counters {
+  uint64_t sent_packets = 0, sent_bytes = 0, send_errors = 0;
+  uint64_t received_packets = 0, received_bytes = 0, bad_packets = 0;
+  uint64_t traffic_records = 0, thermal_records = 0;
+  /**
+   * Pings which were not answered before the next one was sent.
+   */
+  uint64_t missed_pings = 0;
+
+  void Print(std::ostream &os, double seconds) const noexcept {
+    os << "\tsent=" << unsigned(sent_packets / seconds) << "/s"
+       << "\treceived=" << unsigned(received_packets / seconds) << "/s"
+       << "\tin=" << unsigned(received_bytes / seconds / 1024) << "kB/s"
+       << "\tout=" << unsigned(sent_bytes / seconds / 1024) << "kB/s"
+       << "\ttraffic_records=" << traffic_records
+       << "\tthermal_records=" << thermal_records
+       << "\tmissed_pings=" << missed_pings
+       << "\tsend_errors=" << send_errors
+       << "\tbad=" << bad_packets;
+  }
+};
+
+/**
+ * A simulated glider: it cruises in a slowly changing direction while
+ * sinking, and every now and then it circles in a thermal.  Leaving
+ * a thermal submits it to the server.
+ */
+struct SimulatedClient {
+  uint64_t key;
+
+  unsigned socket;
+
+  ::GeoPoint location;
+  double altitude;
+  Angle track;
+  double ground_speed;
+  double vario;
+
+  bool circling = false;
+
+  /**
+   * Seconds until the next cruise/circling switch.
+   */
+  double remaining;
+
+  ::GeoPoint thermal_bottom;
+  double thermal_bottom_altitude;
+  double thermal_duration;
+
+  unsigned n_fixes = 0;
+
+  std::chrono::steady_clock::time_point ping_sent, traffic_sent,
+    thermal_sent;
+  uint16_t ping_id = 0;
+  bool ping_pending = false, traffic_pending = false,
+    thermal_pending = false;
+
+  /**
+   * Advance the simulation by @p dt seconds.
+   *
+   * @return true if a thermal was just left
+   */
+  template<typename R>
+  bool Move(double dt, R &rng) noexcept;
+};
+
+template<typename R>
+bool
+SimulatedClient::Move(double dt, R &rng) noexcept
+{
+  bool left_thermal = false;
+
+  remaining -= dt;
+  if (circling) {
+    thermal_duration += dt;
+    if (remaining <= 0 || altitude > 3000) {
+      circling = false;
+      left_thermal = true;
+      remaining = std::uniform_real_distribution<double>(60, 600)(rng);
+    }
+  } else if (remaining <= 0 || altitude < 600) {
+    circling = true;
+    remaining = std::uniform_real_distribution<double>(60, 300)(rng);
+    thermal_bottom = location;
+    thermal_bottom_altitude = altitude;
+    thermal_duration = 0;
+  }
+
+  if (circling) {
+    /* a full circle takes 25 seconds */
+    ground_speed = 22;
+    vario = std::normal_distribution<double>(2, 0.5)(rng);
+    track += Angle::Degrees(360. / 25 * dt);
+  } else {
+    ground_speed = 30;
+    vario = std::normal_distribution<double>(-1, 0.3)(rng);
+    track += Angle::Degrees(std::normal_distribution<double>(0, 5)(rng) * dt);
+  }
+
+  track = track.AsBearing();
+  location = GeoVector(ground_speed * dt, track).EndPoint(location);
+  altitude = std::clamp(altitude + vario * dt, 300., 3500.);
+
+  return left_thermal;
+}
+
+class LoadGenerator {
+  /**
+   * The clients are spread over a few sockets; the server tells them
+   * apart by their key.
+   */
+  struct Socket {
+    LoadGenerator &parent;
+    SocketEvent event;
+
+    Socket(LoadGenerator &_parent, SocketDescriptor fd) noexcept
+      :parent(_parent),
+       event(parent.event_loop, BIND_THIS_METHOD(OnSocketReady), fd) {
+      event.ScheduleRead();
+    }
+
+    ~Socket() noexcept {
+      event.Close();
+    }
+
+    void OnSocketReady(unsigned) noexcept {
+      parent.OnSocketReady(event.GetSocket());
+    }
+  };
+
+  EventLoop &event_loop;
+
+  const std::chrono::steady_clock::duration fix_interval;
+
+  std::mt19937 rng{1};
+
+  std::vector<SimulatedClient> clients;
+  std::vector<std::unique_ptr<Socket>> sockets;
+
+  FineTimerEvent tick_timer{event_loop, BIND_THIS_METHOD(OnTick)};
+  CoarseTimerEvent report_timer{event_loop, BIND_THIS_METHOD(OnReport)};
+  CoarseTimerEvent stop_timer{event_loop, BIND_THIS_METHOD(OnStop)};
+
+  std::chrono::steady_clock::time_point start_time, report_time;
+
+  /**
+   * The number of fixes sent since #start_time.
+   */
+  uint64_t n_sent_fixes = 0;
+
+  Counters counters, total_counters;
+
+  LatencyStats ping_latency, traffic_latency, thermal_latency;
+  LatencyStats total_ping_latency, total_traffic_latency,
+    total_thermal_latency;
+
+public:
+  LoadGenerator(EventLoop &_event_loop, SocketAddress server,
+                unsigned n_clients, unsigned n_sockets,
+                std::chrono::steady_clock::duration _fix_interval);
+
+  void Start(std::chrono::steady_clock::duration duration) noexcept;
+
+  void PrintSummary() noexcept;
+
+  void OnQuitSignal() noexcept {
+    event_loop.Break();
+  }
+
+private:
+  void Send(const SimulatedClient &client,
+            std::span<const std::byte> packet) noexcept;
+
+  template<typename P>
+  void SendPacket(const SimulatedClient &client, const P &packet) noexcept {
+    Send(client, ReferenceAsBytes(packet));
+  }
+
+  void Step(SimulatedClient &client) noexcept;
+
+  void OnTick() noexcept;
+  void OnReport() noexcept;
+  void OnStop() noexcept {
+    event_loop.Break();
+  }
+
+  void OnSocketReady(SocketDescriptor fd) noexcept;
+  void OnDatagramReceived(std::byte *data, std::size_t length) noexcept;
+};
+
+LoadGenerator::LoadGenerator(EventLoop &_event_loop, SocketAddress server,
+                             unsigned n_clients, unsigned n_sockets,
+                             std::chrono::steady_clock::duration _fix_interval)
+  :event_loop(_event_loop), fix_interval(_fix_interval)
+{
+  n_sockets = std::clamp(n_sockets, 1U, n_clients);
+  sockets.reserve(n_sockets);
+  for (unsigned i = 0; i < n_sockets; ++i) {
+    UniqueSocketDescriptor fd;
+    if (!fd.CreateNonBlock(server.GetFamily(), SOCK_DGRAM, 0))
+      throw MakeSocketError("Failed to create socket");
+
+    if (!fd.Connect(server))
+      throw MakeSocketError("Failed to connect");
+
+    /* the server pushes traffic in bursts */
+    fd.SetIntOption(SOL_SOCKET, SO_RCVBUF, 1024 * 1024);
+
+    sockets.emplace_back(std::make_unique<Socket>(*this, fd.Release()));
+  }
+
+  /* gliders gather around a few hotspots in the Alps, so there is
+     traffic to query */
+  std::uniform_real_distribution<double> latitude(45, 48), longitude(6, 14);
+  std::vector<::GeoPoint> hotspots(std::max(n_clients / 100, 1U));
+  for (auto &i : hotspots)
+    i = ::GeoPoint(Angle::Degrees(longitude(rng)),
+                 Angle::Degrees(latitude(rng)));
+
+  std::uniform_int_distribution<std::size_t> hotspot(0, hotspots.size() - 1);
+  std::uniform_real_distribution<double> bearing(0, 360), distance(0, 30000),
+    altitude(800, 2500), remaining(0, 300);
+  std::bernoulli_distribution circling(0.3);
+
+  clients.resize(n_clients);
+  for (unsigned i = 0; i < n_clients; ++i) {
+    auto &c = clients[i];
+    c.key = KEY_BASE + i + 1;
+    c.socket = i % n_sockets;
+    c.location = GeoVector(distance(rng), Angle::Degrees(bearing(rng)))
+      .EndPoint(hotspots[hotspot(rng)]);
+    c.altitude = altitude(rng);
+    c.track = Angle::Degrees(bearing(rng));
+    c.remaining = remaining(rng);
+
+    c.circling = circling(rng);
+    c.thermal_bottom = c.location;
+    c.thermal_bottom_altitude = c.altitude;
+    c.thermal_duration = 0;
+  }
+}
+
+void
+LoadGenerator::Start(std::chrono::steady_clock::duration duration) noexcept
+{
+  start_time = report_time = std::chrono::steady_clock::now();
+  tick_timer.Schedule(std::chrono::milliseconds(0));
+  report_timer.Schedule(REPORT_INTERVAL);
+  if (duration > duration.zero())
+    stop_timer.Schedule(duration);
+
+  cout << "START\tclients=" << clients.size()
+       << "\tsockets=" << sockets.size()
+       << "\tfix_interval="
+       << std::chrono::duration_cast<std::chrono::milliseconds>(fix_interval).count()
+       << "ms" << endl;
+}
+
+void
+LoadGenerator::Send(const SimulatedClient &client,
+                    std::span<const std::byte> packet) noexcept
+{
+  const auto nbytes = sockets[client.socket]->event.GetSocket()
+    .Send(packet, MSG_DONTWAIT);
+  if (nbytes < 0) {
+    ++counters.send_errors;
+    return;
+  }
+
+  ++counters.sent_packets;
+  counters.sent_bytes += nbytes;
+}
+
+void
+LoadGenerator::Step(SimulatedClient &client) noexcept
+{
+  /* the server does not respond to traffic and thermal requests when
+     there is nothing to report, and it pushes both without being
+     asked; a response which arrives after the client's next fix is
+     not attributed to the request (pings are always answered) */
+  client.traffic_pending = client.thermal_pending = false;
+
+  const double dt = std::chrono::duration<double>(fix_interval).count();
+  const bool left_thermal = client.Move(dt, rng);
+
+  const auto now = std::chrono::steady_clock::now();
+  const uint32_t time = MsUtcMidnight();
+
+  SendPacket(client,
+             MakeFix(client.key,
+                     FixPacket::FLAG_LOCATION | FixPacket::FLAG_TRACK |
+                     FixPacket::FLAG_GROUND_SPEED | FixPacket::FLAG_ALTITUDE |
+                     FixPacket::FLAG_VARIO,
+                     time, client.location, client.track,
+                     client.ground_speed, client.ground_speed,
+                     int(client.altitude), client.vario, 0));
+
+  if (left_thermal && client.thermal_duration > 0)
+    SendPacket(client,
+               MakeThermalSubmit(client.key, time,
+                                 client.thermal_bottom,
+                                 int(client.thermal_bottom_altitude),
+                                 client.location, int(client.altitude),
+                                 (client.altitude - client.thermal_bottom_altitude)
+                                 / client.thermal_duration));
+
+  /* offset the requests of consecutive clients so they don't all
+     come in the same tick */
+  const unsigned n = client.n_fixes++ + unsigned(client.key);
+
+  if (n % PING_EVERY == 0) {
+    if (client.ping_pending)
+      ++counters.missed_pings;
+
+    ++client.ping_id;
+    client.ping_pending = true;
+    client.ping_sent = now;
+    SendPacket(client, MakePing(client.key, client.ping_id));
+  }
+
+  if (n % TRAFFIC_REQUEST_EVERY == 0) {
+    client.traffic_pending = true;
+    client.traffic_sent = now;
+    SendPacket(client, MakeTrafficRequest(client.key, false, false, true));
+  }
+
+  if (n % THERMAL_REQUEST_EVERY == 0) {
+    client.thermal_pending = true;
+    client.thermal_sent = now;
+    SendPacket(client, MakeThermalRequest(client.key));
+  }
+}
+
+void
+LoadGenerator::OnTick() noexcept
+{
+  /* send the fixes evenly spread over the fix interval */
+  const auto elapsed = std::chrono::steady_clock::now() - start_time;
+  const uint64_t due = uint64_t(elapsed / fix_interval * clients.size()) +
+    uint64_t((elapsed % fix_interval) * clients.size() / fix_interval);
+
+  for (; n_sent_fixes < due; ++n_sent_fixes)
+    Step(clients[n_sent_fixes % clients.size()]);
+
+  tick_timer.Schedule(TICK_INTERVAL);
+}
+
+void
+LoadGenerator::OnReport() noexcept
+{
+  const auto now = std::chrono::steady_clock::now();
+  const double seconds =
+    std::chrono::duration<double>(now - report_time).count();
+  report_time = now;
+
+  cout << "LOAD\tt="
+       << unsigned(std::chrono::duration<double>(now - start_time).count())
+       << 's' << std::fixed << std::setprecision(2);
+  counters.Print(cout, seconds);
+  ping_latency.Print(cout, "ping");
+  traffic_latency.Print(cout, "traffic");
+  thermal_latency.Print(cout, "thermal");
+  cout << std::defaultfloat << endl;
+
+  total_counters.sent_packets += counters.sent_packets;
+  total_counters.sent_bytes += counters.sent_bytes;
+  total_counters.send_errors += counters.send_errors;
+  total_counters.received_packets += counters.received_packets;
+  total_counters.received_bytes += counters.received_bytes;
+  total_counters.bad_packets += counters.bad_packets;
+  total_counters.traffic_records += counters.traffic_records;
+  total_counters.thermal_records += counters.thermal_records;
+  total_counters.missed_pings += counters.missed_pings;
+  counters = {};
+
+  total_ping_latency.Append(ping_latency);
+  total_traffic_latency.Append(traffic_latency);
+  total_thermal_latency.Append(thermal_latency);
+  ping_latency.Clear();
+  traffic_latency.Clear();
+  thermal_latency.Clear();
+
+  report_timer.Schedule(REPORT_INTERVAL);
+}
+
+void
+LoadGenerator::PrintSummary() noexcept
+{
+  /* account for the samples since the last report */
+  if (counters.sent_packets > 0 || counters.received_packets > 0)
+    OnReport();
+
+  const double seconds = std::chrono::duration<double>(report_time -
+                                                       start_time).count();
+  if (seconds <= 0)
+    return;
+
+  cout << "SUMMARY\tt=" << unsigned(seconds) << 's'
+       << "\tclients=" << clients.size()
+       << std::fixed << std::setprecision(2);
+  total_counters.Print(cout, seconds);
+  total_ping_latency.Print(cout, "ping");
+  total_traffic_latency.Print(cout, "traffic");
+  total_thermal_latency.Print(cout, "thermal");
+  cout << std::defaultfloat << endl;
+}
+
+void
+LoadGenerator::OnSocketReady(SocketDescriptor fd) noexcept
+{
+  std::byte buffer[4096];
+  ssize_t nbytes;
+
+  while ((nbytes = fd.Receive(std::span{buffer}, MSG_DONTWAIT)) > 0)
+    OnDatagramReceived(buffer, nbytes);
+}
+
+inline void
+LoadGenerator::OnDatagramReceived(std::byte *data, std::size_t length) noexcept
+{
+  const auto now = std::chrono::steady_clock::now();
+
+  ++counters.received_packets;
+  counters.received_bytes += length;
+
+  Header &header = *(Header *)data;
+  if (length < sizeof(header) || FromBE32(header.magic) != MAGIC) {
+    ++counters.bad_packets;
+    return;
+  }
+
+  const uint16_t received_crc = FromBE16(header.crc);
+  header.crc = 0;
+  if (received_crc != UpdateCRC16CCITT(data, length, 0)) {
+    ++counters.bad_packets;
+    return;
+  }
+
+  const uint64_t index = FromBE64(header.key) - KEY_BASE - 1;
+  if (index >= clients.size()) {
+    ++counters.bad_packets;
+    return;
+  }
+
+  auto &client = clients[index];
+
+  switch ((Type)FromBE16(header.type)) {
+  case ACK:
+    if (length >= sizeof(ACKPacket) && client.ping_pending &&
+        FromBE16(((const ACKPacket *)data)->id) == client.ping_id) {
+      client.ping_pending = false;
+      ping_latency.Add(now - client.ping_sent);
+    }
+    break;
+
+  case TRAFFIC_RESPONSE:
+    if (length >= sizeof(TrafficResponsePacket))
+      counters.traffic_records +=
+        ((const TrafficResponsePacket *)data)->traffic_count;
+
+    /* the server pushes traffic after fixes, too; count the first
+       response after a request */
+    if (client.traffic_pending) {
+      client.traffic_pending = false;
+      traffic_latency.Add(now - client.traffic_sent);
+    }
+    break;
+
+  case THERMAL_RESPONSE:
+    if (length >= sizeof(ThermalResponsePacket))
+      counters.thermal_records +=
+        ((const ThermalResponsePacket *)data)->thermal_count;
+
+    if (client.thermal_pending) {
+      client.thermal_pending = false;
+      thermal_latency.Add(now - client.thermal_sent);
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+int
+main(int argc, char **argv)
+try {
+  Args args(argc, argv, "HOST [CLIENTS] [SECONDS]\n\n"
+            "CLIENTS is the number of simulated clients (default 1000).\n"
+            "SECONDS is the test duration (default: until interrupted).\n"
+            "Optional env: XCS_CLOUD_LOAD_FIX_INTERVAL (ms, 10..60000,\n"
+            "default 1000), XCS_CLOUD_LOAD_SOCKETS (1..1024, default 64)");
+  const char *host = args.ExpectNext();
+  const int n_clients = args.IsEmpty() ? 1000 : args.ExpectNextInt();
+  const int duration = args.IsEmpty() ? 0 : args.ExpectNextInt();
+  args.ExpectEnd();
+
+  if (n_clients <= 0 || duration < 0)
+    args.UsageError();
+
+  /* out-of-range values fall back to the default */
+  const std::chrono::milliseconds fix_interval{
+    GetEnvInt("XCS_CLOUD_LOAD_FIX_INTERVAL", 1000, 10, 60000)};
+  const unsigned n_sockets = GetEnvInt("XCS_CLOUD_LOAD_SOCKETS", 64, 1, 1024);
+
+  const auto address_list = Resolve(host, Server::GetDefaultPort(),
+                                    0, SOCK_DGRAM);
+
+  EventLoop event_loop;
+  SignalMonitorInit(event_loop);
+  AtScopeExit() { SignalMonitorFinish(); };
+
+  LoadGenerator generator(event_loop, address_list.GetBest(),
+                          n_clients, n_sockets, fix_interval);
+
+  SignalMonitorRegister(SIGINT, BIND_METHOD(generator,
+                                            &LoadGenerator::OnQuitSignal));
+  SignalMonitorRegister(SIGTERM, BIND_METHOD(generator,
+                                             &LoadGenerator::OnQuitSignal));
+
+  generator.Start(std::chrono::seconds(duration));
+  event_loop.Run();
+
+  generator.PrintSummary();
+
+  return EXIT_SUCCESS;
+} catch (...) {
+  PrintException(std::current_exception());
+  return EXIT_FAILURE;
+}
@@ -4,6 +4,7 @@
 #include "Data.hpp"
 #include "Dump.hpp"
 #include "OGNAprs.hpp"
+#include "OGNAreaFilter.hpp"
 #include "OGNClient.hpp"
 #include "Sender.hpp"
 #include "Serialiser.hpp"
@@ -12,6 +13,7 @@
 #include "util/ByteOrder.hxx"
 #include "event/Loop.hxx"
 #include "event/CoarseTimerEvent.hxx"
+#include "event/FineTimerEvent.hxx"
 #include "event/SignalMonitor.hxx"
 #include "event/net/cares/Channel.hxx"
 #include "net/IPv4Address.hxx"
@@ -25,6 +27,7 @@
 #include "util/ScopeExit.hxx"
 #include "util/EnvParser.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -33,6 +36,7 @@
 #include <iterator>
 #include <memory>
 #include <optional>
+#include <vector>
 
 #include <signal.h>
 
@@ -56,6 +60,12 @@ static constexpr std::chrono::steady_clock::duration REQUEST_EXPIRY =
 static constexpr std::chrono::steady_clock::duration TRAFFIC_PUSH_INTERVAL =
   std::chrono::seconds(15);
 
+/**
+ * Traffic pushes are collected and sent in batches this often.
+ */
+static constexpr std::chrono::steady_clock::duration TRAFFIC_PUSH_TICK =
+  std::chrono::milliseconds(500);
+
 static constexpr unsigned MAX_TRAFFIC_TARGETS_PER_RESPONSE = 64;
 
 using std::cout;
@@ -106,6 +116,29 @@ IsTrafficRelevantToClient(const GeoPoint &client_location,
     separation >= -MAX_TRAFFIC_ALTITUDE_SEPARATION;
 }
 
+/**
+ * A traffic target which may be relevant to the clients of one grid
+ * cell, serialised once for all of them.
+ */
+struct TrafficCandidate {
+  /**
+   * The client described by this record (to be skipped in its own
+   * snapshot), or nullptr for OGN traffic.
+   */
+  const CloudClient *client;
+
+  /**
+   * The OGN entry whose callsign is sent along, or nullptr.
+   */
+  const OGNTrafficEntry *ogn;
+
+  GeoPoint location;
+  int altitude;
+  bool altitude_valid;
+
+  SkyLinesTracking::TrafficResponsePacket::Traffic record;
+};
+
 class CloudServer final
   : public SkyLinesTracking::Server,
     CloudData,
@@ -119,6 +152,36 @@ class CloudServer final
 
   std::unique_ptr<OGNClient> ogn_client;
 
+  /**
+   * OGN positions outside this area are dropped by the APRS parser.
+   * It covers the #TRAFFIC_RANGE around all known clients.
+   */
+  OGNAreaFilter ogn_area;
+
+  /**
+   * OGN ingest counters since the last ReportOgnIngest() call.
+   */
+  struct {
+    unsigned lines, outside_area, ignored, ground_station, traffic;
+  } ogn_ingest{};
+
+  std::chrono::steady_clock::time_point ogn_ingest_since;
+
+  /**
+   * Clients which are due for a traffic snapshot.  They are served
+   * in one batch by #traffic_push_timer, grouped by grid cell, so
+   * the clients of a cell share one neighbour query.
+   */
+  boost::intrusive::list<CloudClient,
+                         boost::intrusive::base_hook<CloudClientPushHook>,
+                         boost::intrusive::constant_time_size<false>> pending_traffic_pushes;
+
+  FineTimerEvent traffic_push_timer;
+
+  /* buffers for OnTrafficPushTimer(), reused to avoid allocations */
+  std::vector<CloudClient *> traffic_push_batch;
+  std::vector<TrafficCandidate> traffic_candidates;
+
 public:
   CloudServer(AllocatedPath &&_db_path, EventLoop &event_loop,
               SocketAddress bind_address, bool enable_ogn)
@@ -127,7 +190,8 @@ public:
      cares_channel(event_loop),
      save_timer(event_loop, BIND_THIS_METHOD(OnSaveTimer)),
      expire_timer(event_loop, BIND_THIS_METHOD(OnExpireTimer)),
-     ogn_expire_timer(event_loop, BIND_THIS_METHOD(OnOgnExpireTimer))
+     ogn_expire_timer(event_loop, BIND_THIS_METHOD(OnOgnExpireTimer)),
+     traffic_push_timer(event_loop, BIND_THIS_METHOD(OnTrafficPushTimer))
   {
 #ifndef _WIN32
     SignalMonitorRegister(SIGINT, BIND_THIS_METHOD(OnQuitSignal));
@@ -153,6 +217,13 @@ public:
            << "\tuser=" << (user_configured ? "configured" : "default")
            << endl;
 
+      if (GetEnvBool("XCS_CLOUD_OGN_AREA", true))
+        RebuildOgnArea();
+      else
+        cout << "OGN\tarea-filter\tdisabled" << endl;
+
+      ogn_ingest_since = event_loop.SteadyNow();
+
       ogn_client = std::make_unique<OGNClient>(
         event_loop, cares_channel, *this,
         std::move(host), port, std::move(user), std::move(pass));
@@ -202,9 +273,23 @@ private:
 
   void OnOgnExpireTimer() noexcept {
     ogn_traffic.Expire(GetEventLoop().SteadyNow() - MAX_OGN_TRAFFIC_AGE);
+
+    /* forget the areas of clients which have gone away */
+    if (ogn_area.IsEnabled())
+      RebuildOgnArea();
+
+    ReportOgnIngest();
     ScheduleOgnExpire();
   }
 
+  void RebuildOgnArea() noexcept {
+    ogn_area.Clear();
+    for (const auto &client : clients)
+      ogn_area.Add(client.location, TRAFFIC_RANGE);
+  }
+
+  void ReportOgnIngest() noexcept;
+
   void ScheduleOgnExpire() noexcept {
     ogn_expire_timer.Schedule(std::chrono::minutes(1));
   }
@@ -213,14 +298,30 @@ private:
 
   void SendTrafficCallsign(SocketAddress address, uint64_t key,
                            uint32_t pilot_id,
-                           const std::string &callsign) noexcept;
-
-  void SendNearTrafficSnapshot(CloudClient &client,
-                               const char *reason) noexcept;
-
-  void MaybeSendNearTrafficSnapshot(CloudClient &client,
-                                    const char *reason,
-                                    bool force = false) noexcept;
+                           std::string_view callsign) noexcept;
+
+  /**
+   * Schedule a traffic snapshot for the client with the next
+   * #TRAFFIC_PUSH_TICK.
+   *
+   * @param force ignore #TRAFFIC_PUSH_INTERVAL
+   */
+  void ScheduleTrafficPush(CloudClient &client, const char *reason,
+                           bool force = false) noexcept;
+
+  void OnTrafficPushTimer() noexcept;
+
+  /**
+   * Fill #traffic_candidates with the traffic within #TRAFFIC_RANGE
+   * of the given grid cell.
+   */
+  void CollectTrafficCandidates(unsigned cell) noexcept;
+
+  /**
+   * Send the #traffic_candidates (collected for the client's grid
+   * cell) which are relevant to the client.
+   */
+  void SendTrafficSnapshot(CloudClient &client, const char *reason) noexcept;
 
   template<typename F>
   void ForEachClientNearTraffic(
@@ -305,14 +406,23 @@ protected:
 void
 CloudServer::OnAprsLine(std::string_view line) noexcept
 {
-  const OGNAprsParseResult p = ParseOGNAprsLine(line);
+  ++ogn_ingest.lines;
+
+  const OGNAprsParseResult p = ParseOGNAprsLine(line, &ogn_area);
+  if (p.outside_area) {
+    ++ogn_ingest.outside_area;
+    return;
+  }
+
   if (!p.valid) {
+    ++ogn_ingest.ignored;
     if (GetEnvBool("XCS_CLOUD_DEBUG"))
       cerr << "OGN\tignore\t" << line << endl;
     return;
   }
 
   if (!IsForwardableOgnTraffic(p, line)) {
+    ++ogn_ingest.ground_station;
     if (GetEnvBool("XCS_CLOUD_DEBUG"))
       cerr << "OGN\tground-station\t" << p.station_id << endl;
     return;
@@ -325,6 +435,7 @@ CloudServer::OnAprsLine(std::string_view line) noexcept
                          p.track_deg, p.track_valid,
                          p.flarm_id, p.flarm_valid,
                          p.aircraft_type, p.address_type, p.callsign);
+    ++ogn_ingest.traffic;
 
     if (GetEnvBool("XCS_CLOUD_DEBUG")) {
       cout << "OGN\ttraffic\t" << p.station_id << '\t'
@@ -335,7 +446,7 @@ CloudServer::OnAprsLine(std::string_view line) noexcept
       if (p.track_valid)
         cout << "\ttrack=" << p.track_deg;
       if (!t.callsign.empty())
-        cout << "\tcallsign=" << t.callsign;
+        cout << "\tcallsign=" << t.callsign.c_str();
       cout << endl;
     }
 
@@ -345,10 +456,30 @@ CloudServer::OnAprsLine(std::string_view line) noexcept
   }
 }
 
+void
+CloudServer::ReportOgnIngest() noexcept
+{
+  const auto now = GetEventLoop().SteadyNow();
+  const double seconds =
+    std::chrono::duration<double>(now - ogn_ingest_since).count();
+  ogn_ingest_since = now;
+
+  cout << "OGN\tingest\tlines=" << ogn_ingest.lines
+       << "\trate=" << unsigned(seconds > 0 ? ogn_ingest.lines / seconds : 0)
+       << "/s\toutside_area=" << ogn_ingest.outside_area
+       << "\tignored=" << ogn_ingest.ignored
+       << "\tground=" << ogn_ingest.ground_station
+       << "\ttraffic=" << ogn_ingest.traffic
+       << "\tentries=" << ogn_traffic.size()
+       << "\tpool=" << ogn_traffic.GetPoolSize() << endl;
+
+  ogn_ingest = {};
+}
+
 void
 CloudServer::SendTrafficCallsign(SocketAddress address, uint64_t key,
                                  uint32_t pilot_id,
-                                 const std::string &callsign) noexcept
+                                 std::string_view callsign) noexcept
 {
   if (callsign.empty())
     return;
@@ -370,88 +501,141 @@ CloudServer::PushOgnTraffic(const OGNTrafficEntry &t) noexcept
 
   ForEachClientNearTraffic(t.location, t.altitude, t.altitude_valid, {},
                            [&](CloudClient &i) {
-                             MaybeSendNearTrafficSnapshot(i, "TRAFFIC_OGN");
+                             ScheduleTrafficPush(i, "TRAFFIC_OGN");
                            });
 }
 
 void
-CloudServer::MaybeSendNearTrafficSnapshot(CloudClient &client,
-                                          const char *reason,
-                                          bool force) noexcept
+CloudServer::ScheduleTrafficPush(CloudClient &client, const char *reason,
+                                 bool force) noexcept
 {
+  if (client.CloudClientPushHook::is_linked()) {
+    if (force)
+      client.traffic_push_reason = reason;
+    return;
+  }
+
   const auto now = std::chrono::steady_clock::now();
   if (!force && now < client.last_traffic_push + TRAFFIC_PUSH_INTERVAL)
     return;
 
-  client.last_traffic_push = now;
-  SendNearTrafficSnapshot(client, reason);
+  client.traffic_push_reason = reason;
+  pending_traffic_pushes.push_back(client);
+
+  if (!traffic_push_timer.IsPending())
+    traffic_push_timer.Schedule(TRAFFIC_PUSH_TICK);
 }
 
 void
-CloudServer::SendNearTrafficSnapshot(CloudClient &client,
-                                       const char *reason) noexcept
+CloudServer::OnTrafficPushTimer() noexcept
+{
+  auto &batch = traffic_push_batch;
+  batch.clear();
+  pending_traffic_pushes.clear_and_dispose([&batch](CloudClient *client){
+    batch.push_back(client);
+  });
+
+  std::sort(batch.begin(), batch.end(),
+            [](const CloudClient *a, const CloudClient *b){
+              return a->geo_grid_cell < b->geo_grid_cell;
+            });
+
+  unsigned n_cells = 0;
+  for (auto i = batch.begin(); i != batch.end(); ++n_cells) {
+    const unsigned cell = (*i)->geo_grid_cell;
+    CollectTrafficCandidates(cell);
+
+    for (; i != batch.end() && (*i)->geo_grid_cell == cell; ++i)
+      SendTrafficSnapshot(**i, (*i)->traffic_push_reason);
+  }
+
+  if (GetEnvBool("XCS_CLOUD_DEBUG"))
+    cerr << "TRAFFIC_PUSH\tclients=" << batch.size()
+         << "\tcells=" << n_cells << endl;
+}
+
+void
+CloudServer::CollectTrafficCandidates(unsigned cell) noexcept
 {
   const auto now = std::chrono::steady_clock::now();
   const auto min_stamp = now - MAX_TRAFFIC_AGE;
   const auto min_ogn_stamp = now - MAX_OGN_TRAFFIC_AGE;
 
+  auto &candidates = traffic_candidates;
+  candidates.clear();
+
+  for (const auto &traffic : clients.QueryCellWithinRange(cell,
+                                                          TRAFFIC_RANGE)) {
+    if (traffic->stamp < min_stamp)
+      continue;
+
+    candidates.push_back({
+        traffic, nullptr,
+        traffic->location, traffic->altitude, traffic->altitude >= 0,
+        TrafficResponseSender::MakeRecord(traffic->id, 0, //TODO: time?
+                                          traffic->location, traffic->altitude,
+                                          TrafficRecordExtensions::FromOgn(traffic->track_deg,
+                                                                           traffic->track_valid,
+                                                                           traffic->aircraft_type,
+                                                                           0, false,
+                                                                           traffic->altitude >= 0)),
+      });
+  }
+
+  const uint32_t time_ms = MsUtcMidnight();
+  for (const auto &og : ogn_traffic.QueryCellWithinRange(cell,
+                                                         TRAFFIC_RANGE)) {
+    if (og->stamp < min_ogn_stamp)
+      continue;
+
+    if (!IsForwardableOgnTraffic(*og))
+      continue;
+
+    candidates.push_back({
+        nullptr, og,
+        og->location, og->altitude, og->altitude_valid,
+        TrafficResponseSender::MakeRecord(og->pilot_id, time_ms,
+                                          og->location, og->altitude,
+                                          TrafficRecordExtensions::FromOgn(*og)),
+      });
+  }
+}
+
+void
+CloudServer::SendTrafficSnapshot(CloudClient &client,
+                                 const char *reason) noexcept
+{
+  client.last_traffic_push = std::chrono::steady_clock::now();
+
   TrafficResponseSender s(*this, client.address, client.key);
 
+  /* cloud clients come first in #traffic_candidates, so they are
+     preferred when there are too many */
   unsigned n = 0;
   unsigned n_cloud = 0;
   unsigned n_ogn = 0;
-  for (const auto &traffic : clients.QueryWithinRange(client.location,
-                                                      TRAFFIC_RANGE)) {
-    if (traffic.get() == &client)
-      continue;
-
-    if (traffic->stamp < min_stamp)
+  for (const auto &t : traffic_candidates) {
+    if (t.client == &client)
       continue;
 
     if (!IsTrafficRelevantToClient(client.location, client.altitude,
-                                   traffic->location, traffic->altitude,
-                                   traffic->altitude >= 0))
+                                   t.location, t.altitude,
+                                   t.altitude_valid))
       continue;
 
     if (n >= MAX_TRAFFIC_TARGETS_PER_RESPONSE)
       break;
 
-    s.Add(traffic->id, 0, //TODO: time?
-          traffic->location, traffic->altitude,
-          TrafficRecordExtensions::FromOgn(traffic->track_deg,
-                                           traffic->track_valid,
-                                           traffic->aircraft_type,
-                                           0, false,
-                                           traffic->altitude >= 0));
-    ++n_cloud;
-    ++n;
-  }
-
-  if (n < MAX_TRAFFIC_TARGETS_PER_RESPONSE) {
-    const uint32_t time_ms = MsUtcMidnight();
-    for (const auto &og :
-         ogn_traffic.QueryWithinRange(client.location, TRAFFIC_RANGE)) {
-      if (og->stamp < min_ogn_stamp)
-        continue;
-
-      if (!IsForwardableOgnTraffic(*og))
-        continue;
-
-      if (!IsTrafficRelevantToClient(client.location, client.altitude,
-                                     og->location, og->altitude,
-                                     og->altitude_valid))
-        continue;
-
-      if (n >= MAX_TRAFFIC_TARGETS_PER_RESPONSE)
-        break;
+    s.Add(t.record);
 
-      s.Add(og->pilot_id, time_ms, og->location, og->altitude,
-            TrafficRecordExtensions::FromOgn(*og));
+    if (t.ogn != nullptr) {
       SendTrafficCallsign(client.address, client.key,
-                          og->pilot_id, og->callsign);
+                          t.ogn->pilot_id, t.ogn->callsign);
       ++n_ogn;
-      ++n;
-    }
+    } else
+      ++n_cloud;
+
+    ++n;
   }
 
   s.Flush();
@@ -481,6 +665,9 @@ CloudServer::OnFix(const Client &c,
     client = &clients.Make(c.address, c.key, location, altitude,
                            track_deg, track_valid);
 
+    if (ogn_area.IsEnabled())
+      ogn_area.Add(location, TRAFFIC_RANGE);
+
     cout << "FIX\t"
          << client->address << '\t'
          << std::hex << client->key << std::dec << '\t'
@@ -503,12 +690,12 @@ CloudServer::OnFix(const Client &c,
     return;
 
   /* Always push a full nearby snapshot to the client that sent the FIX. */
-  MaybeSendNearTrafficSnapshot(*client, "TRAFFIC_FIX", true);
+  ScheduleTrafficPush(*client, "TRAFFIC_FIX", true);
 
   /* Push full snapshots to other nearby clients (same as OGN updates). */
   ForEachClientNearTraffic(location, altitude, altitude >= 0, c.key,
                            [&](CloudClient &i) {
-                             MaybeSendNearTrafficSnapshot(i, "TRAFFIC_FIX", true);
+                             ScheduleTrafficPush(i, "TRAFFIC_FIX", true);
                            });
 }
 
@@ -530,7 +717,11 @@ CloudServer::OnTrafficRequest(const Client &c, bool near)
     return;
   }
 
-  MaybeSendNearTrafficSnapshot(*client, "TRAFFIC_REQUEST", true);
+  /* an explicit request is answered right away; this replaces a
+     pending push */
+  client->CloudClientPushHook::unlink();
+  CollectTrafficCandidates(client->geo_grid_cell);
+  SendTrafficSnapshot(*client, "TRAFFIC_REQUEST");
 }
 
 void
@@ -668,6 +859,9 @@ CloudServer::Load()
   Deserialiser s(fr);
   CloudData::Load(s);
 
+  if (ogn_area.IsEnabled())
+    RebuildOgnArea();
+
   cout << "DB\tloaded\tclients="
        << std::distance(clients.begin(), clients.end())
        << "\tthermals="
@@ -2,6 +2,7 @@
 // Copyright The XCSoar Project
 
 #include "OGNAprs.hpp"
+#include "OGNAreaFilter.hpp"
 
 #include "Math/Angle.hpp"
 #include "Math/Util.hpp"
@@ -10,8 +11,6 @@
 #include "util/NumberParser.hxx"
 #include "util/StringStrip.hxx"
 
-#include <cstdio>
-
 using std::string_view;
 
 /**
@@ -240,18 +239,16 @@ IsForwardableOgnTraffic(const OGNAprsParseResult &r,
 
 /**
  * Extract a whitespace-delimited field prefixed by @p tag (e.g. "reg",
- * "fn").
+ * "fn").  Returns an empty string if there is no such field.
  */
-static bool
-ExtractTaggedField(string_view line, string_view tag, std::string &dest) noexcept
+static string_view
+ExtractTaggedField(string_view line, string_view tag) noexcept
 {
-  dest.clear();
-
   std::size_t pos = 0;
   while (pos < line.size()) {
     pos = line.find(tag, pos);
     if (pos == string_view::npos)
-      return false;
+      return {};
 
     if (pos > 0 && line[pos - 1] != ' ' && line[pos - 1] != '\t') {
       ++pos;
@@ -260,50 +257,29 @@ ExtractTaggedField(string_view line, string_view tag, std::string &dest) noexcep
 
     pos += tag.size();
     if (pos >= line.size())
-      return false;
+      return {};
 
     const std::size_t end = line.find_first_of(" \t", pos);
     const std::size_t len = (end == string_view::npos)
       ? line.size() - pos
       : end - pos;
-    if (len == 0)
-      return false;
-
-    dest.assign(line.data() + pos, len);
-    return true;
+    return line.substr(pos, len);
   }
 
-  return false;
+  return {};
 }
 
-static void
-ResolveOgnCallsign(string_view line, const OGNAprsParseResult &r,
-                   std::string &callsign) noexcept
+static string_view
+ResolveOgnCallsign(string_view line) noexcept
 {
-  callsign.clear();
+  if (const auto reg = ExtractTaggedField(line, "reg"); !reg.empty())
+    return reg;
 
-  std::string field;
-  if (ExtractTaggedField(line, "reg", field)) {
-    callsign = std::move(field);
-    return;
-  }
-
-  if (ExtractTaggedField(line, "fn", field)) {
-    callsign = std::move(field);
-    return;
-  }
-
-  if (r.flarm_valid) {
-    char buf[16];
-    const int n = std::snprintf(buf, sizeof(buf), "%06X",
-                                unsigned(r.flarm_id & 0xffffffu));
-    if (n > 0 && unsigned(n) < sizeof(buf))
-      callsign.assign(buf, unsigned(n));
-  }
+  return ExtractTaggedField(line, "fn");
 }
 
 OGNAprsParseResult
-ParseOGNAprsLine(string_view line) noexcept
+ParseOGNAprsLine(string_view line, const OGNAreaFilter *area) noexcept
 {
   OGNAprsParseResult r;
 
@@ -320,7 +296,6 @@ ParseOGNAprsLine(string_view line) noexcept
   if (colon == string_view::npos || colon + 1 >= line.size())
     return r;
 
-  r.station_id = std::string(line.substr(0, gt));
   const string_view payload = line.substr(colon + 1);
 
   GeoPoint loc;
@@ -328,6 +303,14 @@ ParseOGNAprsLine(string_view line) noexcept
   if (!ParseAprsLatLon(payload, loc, &pos_end))
     return r;
 
+  if (area != nullptr && !area->Contains(loc)) {
+    /* most of the world-wide feed ends here */
+    r.outside_area = true;
+    return r;
+  }
+
+  r.station_id = line.substr(0, gt);
+
   int alt_m = 0;
   const bool altitude_valid = ParseAltitudeFeet(payload, alt_m);
 
@@ -347,6 +330,6 @@ ParseOGNAprsLine(string_view line) noexcept
   r.flarm_valid = fid_ok;
   r.aircraft_type = aircraft_type;
   r.address_type = address_type;
-  ResolveOgnCallsign(line, r, r.callsign);
+  r.callsign = ResolveOgnCallsign(line);
   return r;
 }
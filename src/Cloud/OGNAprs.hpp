@@ -6,19 +6,29 @@
 #include "Geo/GeoPoint.hpp"
 
 #include <cstdint>
-#include <string>
 #include <string_view>
 
+class OGNAreaFilter;
+
 /**
  * Parsed subset of an APRS position line from OGN / glidernet-style feeds.
+ *
+ * The string attributes point into the parsed line; nothing is
+ * copied, and they are only valid as long as the line is.
  */
 struct OGNAprsParseResult {
   bool valid = false;
 
+  /**
+   * The position was decoded, but it is outside the #OGNAreaFilter;
+   * the rest of the line was not parsed and #valid is false.
+   */
+  bool outside_area = false;
+
   /**
    * APRS source address (before '>').
    */
-  std::string station_id;
+  std::string_view station_id;
 
   GeoPoint location = GeoPoint::Invalid();
 
@@ -44,9 +54,9 @@ struct OGNAprsParseResult {
 
   /**
    * Registration or callsign when present in the APRS comment (e.g. ADSB
-   * "regHB-XXX" / "fnA...") or derived from the FLARM address.
+   * "regHB-XXX" / "fnA..."); empty if there is none.
    */
-  std::string callsign;
+  std::string_view callsign;
 };
 
 /** OGN id-field address type: OGN tracker / ground receiver. */
@@ -63,7 +73,11 @@ IsForwardableOgnTraffic(const OGNAprsParseResult &r,
 /**
  * Parse one APRS-IS text line.  Invalid or irrelevant lines yield
  * result.valid == false.
+ *
+ * @param area if not nullptr, then positions outside of this area
+ * are rejected before parsing the rest of the line
  */
 [[gnu::pure]]
 OGNAprsParseResult
-ParseOGNAprsLine(std::string_view line) noexcept;
+ParseOGNAprsLine(std::string_view line,
+                 const OGNAreaFilter *area=nullptr) noexcept;
@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "OGNAreaFilter.hpp"
+#include "Geo/FAISphere.hpp"
+
+#include <algorithm>
+
+void
+OGNAreaFilter::Add(GeoPoint center, double range) noexcept
+{
+  enabled = true;
+
+  const double latitude_delta =
+    FAISphere::EarthDistanceToAngle(range).Degrees();
+
+  const double north = std::min(center.latitude.Degrees() + latitude_delta,
+                                90.);
+  const double south = std::max(center.latitude.Degrees() - latitude_delta,
+                                -90.);
+
+  /* the circle is widest at its poleward edge */
+  const double c =
+    Angle::Degrees(std::max(std::fabs(north), std::fabs(south))).cos();
+
+  const unsigned y_min = LatitudeCell(south), y_max = LatitudeCell(north);
+
+  if (c < 0.01 || latitude_delta / c >= 180) {
+    /* near a pole: all longitudes */
+    for (unsigned y = y_min; y <= y_max; ++y)
+      for (unsigned x = 0; x < N_LONGITUDE; ++x)
+        cells.set(ToIndex(x, y));
+    return;
+  }
+
+  const double longitude_delta = latitude_delta / c;
+  const double west = center.longitude.Degrees() - longitude_delta;
+  const double east = center.longitude.Degrees() + longitude_delta;
+
+  /* the number of cells spanned; wrapping around the antimeridian is
+     handled by LongitudeCell() */
+  const unsigned n_x = std::min(unsigned(std::floor(east) - std::floor(west)) + 1,
+                                N_LONGITUDE);
+  const unsigned x_min = LongitudeCell(west);
+
+  for (unsigned y = y_min; y <= y_max; ++y)
+    for (unsigned i = 0; i < n_x; ++i)
+      cells.set(ToIndex((x_min + i) % N_LONGITUDE, y));
+}
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "Geo/GeoPoint.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+
+/**
+ * A coarse grid of 1x1 degree cells which marks the areas where OGN
+ * traffic is of interest, i.e. around connected cloud clients.  It is
+ * consulted by the APRS parser right after decoding the position, so
+ * out-of-area lines are dropped before anything else is parsed or
+ * stored.
+ *
+ * A default-constructed filter passes everything.
+ */
+class OGNAreaFilter {
+  static constexpr unsigned N_LONGITUDE = 360, N_LATITUDE = 180;
+
+  std::bitset<N_LONGITUDE * N_LATITUDE> cells;
+
+  /**
+   * If false, Contains() always returns true.
+   */
+  bool enabled = false;
+
+public:
+  bool IsEnabled() const noexcept {
+    return enabled;
+  }
+
+  /**
+   * Forget all areas; from now on, all positions are rejected until
+   * Add() is called.
+   */
+  void Clear() noexcept {
+    cells.reset();
+    enabled = true;
+  }
+
+  /**
+   * Pass all positions.
+   */
+  void Disable() noexcept {
+    cells.reset();
+    enabled = false;
+  }
+
+  /**
+   * Mark all cells which intersect the given circle.
+   *
+   * @param range the radius [m]
+   */
+  void Add(GeoPoint center, double range) noexcept;
+
+  [[gnu::pure]]
+  bool Contains(GeoPoint location) const noexcept {
+    return !enabled ||
+      cells.test(ToIndex(LongitudeCell(location.longitude.Degrees()),
+                         LatitudeCell(location.latitude.Degrees())));
+  }
+
+private:
+  static constexpr unsigned ToIndex(unsigned x, unsigned y) noexcept {
+    return y * N_LONGITUDE + x;
+  }
+
+  [[gnu::const]]
+  static unsigned LongitudeCell(double degrees) noexcept {
+    const int x = (int)std::floor(degrees) + 180;
+    return unsigned(((x % int(N_LONGITUDE)) + int(N_LONGITUDE))
+                    % int(N_LONGITUDE));
+  }
+
+  [[gnu::const]]
+  static unsigned LatitudeCell(double degrees) noexcept {
+    const int y = (int)std::floor(degrees) + 90;
+    return y < 0
+      ? 0u
+      : std::min(unsigned(y), N_LATITUDE - 1);
+  }
+};
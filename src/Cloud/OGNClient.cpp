@@ -12,7 +12,6 @@
 #include "util/Exception.hxx"
 #include "util/EnvParser.hpp"
 
-#include <array>
 #include <chrono>
 #include <cstdio>
 #include <iostream>
@@ -20,7 +19,6 @@
 namespace {
 constexpr auto CONNECT_TIMEOUT = std::chrono::seconds(15);
 constexpr auto RECONNECT_DELAY = std::chrono::seconds(25);
-constexpr std::size_t RX_BUFFER_CAPACITY = 16384;
 } // namespace
 
 OGNClient::OGNClient(EventLoop &_loop, Cares::Channel &_cares,
@@ -86,14 +84,7 @@ OGNClient::OnSocketConnectSuccess(UniqueSocketDescriptor fd) noexcept
 
   read_event.Open(fd.Release());
   read_event.ScheduleRead();
-  rx_buffer.clear();
-  try {
-    rx_buffer.reserve(RX_BUFFER_CAPACITY);
-  } catch (...) {
-    std::cerr << "OGN\talloc-error\t" << host << ':' << port << std::endl;
-    ScheduleReconnect();
-    return;
-  }
+  rx_buffer.Clear();
   SendLogin();
 }
 
@@ -159,9 +150,16 @@ OGNClient::OnReadReady(unsigned events) noexcept
     return;
   }
 
-  std::array<std::byte, 4096> buf{};
+  auto w = rx_buffer.Write();
+  if (w.empty()) {
+    /* a line longer than the buffer; discard it */
+    std::cerr << "OGN\toverlong-line\t" << host << ':' << port << std::endl;
+    rx_buffer.Clear();
+    w = rx_buffer.Write();
+  }
+
   const ssize_t nbytes =
-    read_event.GetSocket().Read(std::span<std::byte>{buf.data(), buf.size()});
+    read_event.GetSocket().Read(std::as_writable_bytes(w));
   if (nbytes <= 0) {
     std::cerr << "OGN\teof\t" << host << ':' << port << std::endl;
     ScheduleReconnect();
@@ -171,26 +169,23 @@ OGNClient::OnReadReady(unsigned events) noexcept
   if (GetEnvBool("XCS_CLOUD_DEBUG"))
     std::cerr << "OGN\trx\t" << nbytes << " bytes" << std::endl;
 
-  try {
-    ConsumeInput({(const char *)buf.data(), (std::size_t)nbytes});
-  } catch (...) {
-    std::cerr << "OGN\talloc-error\t" << host << ':' << port << std::endl;
-    ScheduleReconnect();
-  }
+  rx_buffer.Append(std::size_t(nbytes));
+  ConsumeInput();
 }
 
 void
-OGNClient::ConsumeInput(std::string_view chunk)
+OGNClient::ConsumeInput() noexcept
 {
-  rx_buffer.append(chunk.data(), chunk.size());
+  const auto r = rx_buffer.Read();
+  const std::string_view src(r.data(), r.size());
 
   std::size_t cut = 0;
   while (true) {
-    const auto nl = rx_buffer.find('\n', cut);
-    if (nl == std::string::npos)
+    const auto nl = src.find('\n', cut);
+    if (nl == std::string_view::npos)
       break;
 
-    std::string_view line(rx_buffer.data() + cut, nl - cut);
+    std::string_view line = src.substr(cut, nl - cut);
     while (!line.empty() && line.back() == '\r')
       line.remove_suffix(1);
 
@@ -198,10 +193,7 @@ OGNClient::ConsumeInput(std::string_view chunk)
     cut = nl + 1;
   }
 
-  if (cut > 0)
-    rx_buffer.erase(0, cut);
-
-  static constexpr std::size_t MAX_ACCUM = 256 * 1024;
-  if (rx_buffer.size() > MAX_ACCUM)
-    rx_buffer.clear();
+  /* the incomplete last line stays in the buffer; Write() moves it
+     to the front when the end of the buffer is reached */
+  rx_buffer.Consume(cut);
 }
@@ -9,6 +9,7 @@
 #include "event/net/cares/SimpleResolver.hxx"
 #include "net/AllocatedSocketAddress.hxx"
 #include "net/UniqueSocketDescriptor.hxx"
+#include "util/StaticFifoBuffer.hxx"
 
 #include <forward_list>
 #include <memory>
@@ -29,6 +30,9 @@ public:
 /**
  * Maintains a TCP connection to an APRS-IS server (OGN / glidernet full feed),
  * forwarding text lines to #OGNAprsHandler.
+ *
+ * Data is received directly into a fixed buffer, and the lines passed
+ * to the handler point into that buffer; nothing is copied.
  */
 class OGNClient final : ConnectSocketHandler {
   class ResolverHandler final : public Cares::SimpleHandler {
@@ -68,7 +72,12 @@ class OGNClient final : ConnectSocketHandler {
   SocketEvent read_event;
   CoarseTimerEvent reconnect_timer;
 
-  std::string rx_buffer;
+  /**
+   * Longer lines are discarded.
+   */
+  static constexpr std::size_t RX_BUFFER_CAPACITY = 16384;
+
+  StaticFifoBuffer<char, RX_BUFFER_CAPACITY> rx_buffer;
 
 public:
   OGNClient(EventLoop &_loop, Cares::Channel &_cares,
@@ -92,5 +101,5 @@ private:
   void SendLogin() noexcept;
   void CloseConnection() noexcept;
   void ScheduleReconnect() noexcept;
-  void ConsumeInput(std::string_view chunk);
+  void ConsumeInput() noexcept;
 };
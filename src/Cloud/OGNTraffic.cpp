@@ -5,14 +5,9 @@
 
 #include "OGNAprs.hpp"
 #include "Tracking/SkyLines/TrafficExtensions.hpp"
-#include "Geo/Boost/RangeBox.hpp"
 
 using SkyLinesTracking::OGN_PILOT_ID_MASK;
 
-#include <boost/geometry/algorithms/distance.hpp>
-#include <boost/geometry/algorithms/intersection.hpp>
-#include <boost/geometry/strategies/strategies.hpp>
-
 uint32_t
 OGNPilotIdFromStation(std::string_view station_id) noexcept
 {
@@ -28,16 +23,66 @@ OGNPilotIdFromFlarm(uint32_t flarm_id) noexcept
   return OGN_PILOT_ID_MASK | (flarm_id & 0xffffffu);
 }
 
+/**
+ * Returns the 6 bit code of a station id character, or 0 if it
+ * cannot be packed.
+ */
+static constexpr unsigned
+StationCharCode(char ch) noexcept
+{
+  if (ch >= '0' && ch <= '9')
+    return 1 + unsigned(ch - '0');
+  if (ch >= 'A' && ch <= 'Z')
+    return 11 + unsigned(ch - 'A');
+  if (ch >= 'a' && ch <= 'z')
+    return 37 + unsigned(ch - 'a');
+  if (ch == '-')
+    return 63;
+  return 0;
+}
+
+/**
+ * Pack a station id with 6 bits per character.  Returns 0 if that is
+ * not possible.
+ */
+static constexpr uint64_t
+PackStationId(std::string_view station_id) noexcept
+{
+  constexpr std::size_t MAX_PACKED = 10;
+  if (station_id.empty() || station_id.size() > MAX_PACKED)
+    return 0;
+
+  uint64_t key = 0;
+  for (char ch : station_id) {
+    const unsigned code = StationCharCode(ch);
+    if (code == 0)
+      return 0;
+
+    key = (key << 6) | code;
+  }
+
+  return key;
+}
+
+uint64_t
+OGNStationKey(std::string_view station_id) noexcept
+{
+  if (const uint64_t key = PackStationId(station_id); key != 0)
+    return key;
+
+  uint64_t h = 14695981039346656037u;
+  for (unsigned char ch : station_id)
+    h = (h ^ uint64_t(ch)) * 1099511628211u;
+  return h | (uint64_t(1) << 63);
+}
+
 uint32_t
 OGNTrafficPilotId(const OGNTrafficEntry &t) noexcept
 {
   if (t.flarm_valid)
     return OGNPilotIdFromFlarm(t.flarm_id);
 
-  if (t.pilot_id != 0)
-    return t.pilot_id;
-
-  return OGNPilotIdFromStation(t.station_id);
+  return t.station_pilot_id;
 }
 
 bool
@@ -52,11 +97,14 @@ IsForwardableOgnTraffic(const OGNTrafficEntry &t) noexcept
   return true;
 }
 
-OGNTrafficContainer::OGNTrafficContainer() = default;
+OGNTrafficContainer::OGNTrafficContainer()
+  :by_station(StationSet::bucket_traits(station_buckets, N_BUCKETS)),
+   by_pilot_id(PilotIdSet::bucket_traits(pilot_id_buckets, N_BUCKETS)) {}
 
 OGNTrafficContainer::~OGNTrafficContainer()
 {
   clear();
+  free_list.clear();
 }
 
 void
@@ -64,37 +112,50 @@ OGNTrafficContainer::clear() noexcept
 {
   while (!list.empty())
     Remove(list.back());
-  by_pilot_id.clear();
 }
 
-void
-OGNTrafficContainer::Insert(OGNTrafficEntry &t) noexcept
+OGNTrafficEntry &
+OGNTrafficContainer::Allocate()
 {
-  list.push_front(t);
-  rtree.insert(t.shared_from_this());
+  if (free_list.empty()) {
+    chunks.emplace_back(new OGNTrafficEntry[CHUNK_SIZE]);
+
+    auto *chunk = chunks.back().get();
+    for (std::size_t i = 0; i < CHUNK_SIZE; ++i)
+      free_list.push_back(chunk[i]);
+  }
+
+  OGNTrafficEntry &t = free_list.front();
+  free_list.pop_front();
+  ++n_entries;
+  return t;
 }
 
 void
 OGNTrafficContainer::Remove(OGNTrafficEntry &t) noexcept
 {
-  by_station.erase(t.station_id);
-  by_pilot_id.erase(t.pilot_id);
+  by_station.erase(by_station.iterator_to(t));
+  by_pilot_id.erase(by_pilot_id.iterator_to(t));
   list.erase(list.iterator_to(t));
-  rtree.remove(t.shared_from_this());
+  grid.remove(t);
+
+  free_list.push_front(t);
+  --n_entries;
 }
 
 OGNTrafficEntry *
 OGNTrafficContainer::FindByPilotId(uint32_t pilot_id) const noexcept
 {
-  const auto it = by_pilot_id.find(pilot_id);
-  if (it == by_pilot_id.end())
+  const auto i = by_pilot_id.find(pilot_id, by_pilot_id.hash_function(),
+                                  by_pilot_id.key_eq());
+  if (i == by_pilot_id.end())
     return nullptr;
 
-  return it->second.get();
+  return const_cast<OGNTrafficEntry *>(&*i);
 }
 
 OGNTrafficEntry &
-OGNTrafficContainer::Upsert(std::string_view station_sv,
+OGNTrafficContainer::Upsert(std::string_view station_id,
                             const GeoPoint &location, int altitude,
                             bool altitude_valid,
                             unsigned track_deg, bool track_valid,
@@ -102,55 +163,55 @@ OGNTrafficContainer::Upsert(std::string_view station_sv,
                             unsigned aircraft_type, unsigned address_type,
                             std::string_view callsign)
 {
-  auto it = by_station.find(station_sv);
-  const auto now = std::chrono::steady_clock::now();
-
-  if (it == by_station.end()) {
-    std::string station{station_sv};
-    auto p = std::make_shared<OGNTrafficEntry>(
-      std::move(station), location, altitude, altitude_valid,
-      track_deg, track_valid,
-      flarm_id, flarm_valid, aircraft_type, address_type);
-    if (!callsign.empty())
-      p->callsign.assign(callsign.data(), callsign.size());
-    p->pilot_id = OGNTrafficPilotId(*p);
-    by_station.emplace(p->station_id, p);
-    by_pilot_id.emplace(p->pilot_id, p);
-    Insert(*p);
-    return *p;
+  const uint64_t station_key = OGNStationKey(station_id);
+
+  StationSet::insert_commit_data hint;
+  auto result = by_station.insert_check(station_key,
+                                        by_station.hash_function(),
+                                        by_station.key_eq(), hint);
+
+  OGNTrafficEntry *e;
+  if (result.second) {
+    e = &Allocate();
+    e->station_key = station_key;
+    e->station_pilot_id = OGNPilotIdFromStation(station_id);
+    e->location = location;
+    e->callsign.clear();
+    grid.insert(*e);
+    by_station.insert_commit(*e, hint);
+  } else {
+    e = &*result.first;
+
+    if (e->location != location) {
+      e->location = location;
+      grid.Move(*e);
+    }
+
+    list.erase(list.iterator_to(*e));
+    by_pilot_id.erase(by_pilot_id.iterator_to(*e));
   }
 
-  OGNTrafficEntry &e = *it->second;
-  const uint32_t old_pilot_id = e.pilot_id;
+  e->altitude = altitude;
+  e->altitude_valid = altitude_valid;
+  e->stamp = std::chrono::steady_clock::now();
+  e->track_deg = track_deg;
+  e->track_valid = track_valid;
+  e->flarm_id = flarm_id;
+  e->flarm_valid = flarm_valid;
+  e->aircraft_type = aircraft_type;
+  e->address_type = address_type;
 
-  if (e.location != location) {
-    const OGNTrafficPtr ptr = e.shared_from_this();
-    rtree.remove(ptr);
-    e.location = location;
-    rtree.insert(ptr);
-  }
-
-  e.altitude = altitude;
-  e.altitude_valid = altitude_valid;
-  e.stamp = now;
-  e.track_deg = track_deg;
-  e.track_valid = track_valid;
-  e.flarm_id = flarm_id;
-  e.flarm_valid = flarm_valid;
-  e.aircraft_type = aircraft_type;
-  e.address_type = address_type;
   if (!callsign.empty())
-    e.callsign.assign(callsign.data(), callsign.size());
-  e.pilot_id = OGNTrafficPilotId(e);
+    e->callsign.assign(callsign);
+  else if (flarm_valid)
+    /* no registration known: use the FLARM address */
+    e->callsign.Format("%06X", unsigned(flarm_id & 0xffffffu));
 
-  if (e.pilot_id != old_pilot_id) {
-    by_pilot_id.erase(old_pilot_id);
-    by_pilot_id.emplace(e.pilot_id, it->second);
-  }
+  e->pilot_id = OGNTrafficPilotId(*e);
+  by_pilot_id.insert(*e);
 
-  list.erase(list.iterator_to(e));
-  list.push_front(e);
-  return e;
+  list.push_front(*e);
+  return *e;
 }
 
 void
@@ -164,7 +225,5 @@ OGNTrafficContainer::query_iterator_range
 OGNTrafficContainer::QueryWithinRange(GeoPoint location,
                                       double range) const noexcept
 {
-  const auto q =
-    boost::geometry::index::intersects(BoostRangeBox(location, range));
-  return {rtree.qbegin(q), rtree.qend()};
+  return grid.QueryWithinRange(location, range);
 }
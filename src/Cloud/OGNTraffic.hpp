@@ -3,19 +3,18 @@
 
 #pragma once
 
-#include "Geo/Boost/GeoPoint.hpp"
+#include "GeoGrid.hpp"
+#include "Geo/GeoPoint.hpp"
+#include "util/StaticString.hxx"
 
 #include <boost/intrusive/list.hpp>
-#include <boost/geometry/index/rtree.hpp>
-#include <boost/range/iterator_range_core.hpp>
+#include <boost/intrusive/unordered_set.hpp>
 
 #include <chrono>
 #include <cstdint>
-#include <functional>
 #include <memory>
-#include <string>
 #include <string_view>
-#include <unordered_map>
+#include <vector>
 
 /**
  * Stable 31-bit FNV-1a folded into the OGN pilot namespace.
@@ -32,13 +31,47 @@ OGNPilotIdFromStation(std::string_view station_id) noexcept;
 uint32_t
 OGNPilotIdFromFlarm(uint32_t flarm_id) noexcept;
 
+/**
+ * Convert an APRS source address to a 64 bit key, which replaces the
+ * string as lookup key.  Addresses of up to 10 characters from
+ * [0-9A-Za-z-] (i.e. all regular APRS callsigns) are packed with 6
+ * bits per character, which is unique and never 0; others are
+ * hashed, with the most significant bit set.
+ */
+[[gnu::pure]]
+uint64_t
+OGNStationKey(std::string_view station_id) noexcept;
+
+namespace OGNTrafficDetail {
+
+struct StationTag;
+struct PilotIdTag;
+
+using StationHook = boost::intrusive::unordered_set_base_hook<
+  boost::intrusive::tag<StationTag>,
+  boost::intrusive::link_mode<boost::intrusive::normal_link>>;
+
+using PilotIdHook = boost::intrusive::unordered_set_base_hook<
+  boost::intrusive::tag<PilotIdTag>,
+  boost::intrusive::link_mode<boost::intrusive::normal_link>>;
+
+} // namespace OGNTrafficDetail
+
+/**
+ * One OGN aircraft.  Instances are owned by the pool of
+ * #OGNTrafficContainer and recycled; they contain no pointers to
+ * other allocations.
+ */
 struct OGNTrafficEntry
-  : std::enable_shared_from_this<OGNTrafficEntry>,
+  : GeoGridHook,
     boost::intrusive::list_base_hook<
-      boost::intrusive::link_mode<boost::intrusive::normal_link>> {
-  const std::string station_id;
+      boost::intrusive::link_mode<boost::intrusive::normal_link>>,
+    OGNTrafficDetail::StationHook,
+    OGNTrafficDetail::PilotIdHook {
+  /** See OGNStationKey(). */
+  uint64_t station_key = 0;
 
-  GeoPoint location;
+  GeoPoint location = GeoPoint::Invalid();
   int altitude = 0;
   bool altitude_valid = false;
 
@@ -56,23 +89,61 @@ struct OGNTrafficEntry
   unsigned address_type = 0;
 
   /** Cached #OGNPilotIdFromStation(station_id); set on insert. */
+  uint32_t station_pilot_id = 0;
+
+  /** Cached #OGNTrafficPilotId(); updated by #OGNTrafficContainer. */
   uint32_t pilot_id = 0;
 
   /** Registration/callsign when known (from OGN APRS or derived). */
-  std::string callsign;
-
-  template<typename S>
-  OGNTrafficEntry(S &&_station, const GeoPoint &_loc, int _altitude,
-                  bool _altitude_valid,
-                  unsigned _track_deg, bool _track_valid,
-                  uint32_t _flarm_id, bool _flarm_valid,
-                  unsigned _aircraft_type, unsigned _address_type)
-    :station_id(std::forward<S>(_station)), location(_loc),
-     altitude(_altitude), altitude_valid(_altitude_valid),
-     stamp(std::chrono::steady_clock::now()),
-     track_deg(_track_deg), track_valid(_track_valid),
-     flarm_id(_flarm_id), flarm_valid(_flarm_valid),
-     aircraft_type(_aircraft_type), address_type(_address_type) {}
+  StaticString<32> callsign;
+
+  struct StationHash {
+    constexpr std::size_t operator()(uint64_t key) const noexcept {
+      return std::size_t(key ^ (key >> 32));
+    }
+
+    [[gnu::pure]]
+    std::size_t operator()(const OGNTrafficEntry &t) const noexcept {
+      return (*this)(t.station_key);
+    }
+  };
+
+  struct StationEqual {
+    [[gnu::pure]]
+    bool operator()(const OGNTrafficEntry &a,
+                    const OGNTrafficEntry &b) const noexcept {
+      return a.station_key == b.station_key;
+    }
+
+    [[gnu::pure]]
+    bool operator()(uint64_t a, const OGNTrafficEntry &b) const noexcept {
+      return a == b.station_key;
+    }
+  };
+
+  struct PilotIdHash {
+    constexpr std::size_t operator()(uint32_t pilot_id) const noexcept {
+      return pilot_id;
+    }
+
+    [[gnu::pure]]
+    std::size_t operator()(const OGNTrafficEntry &t) const noexcept {
+      return t.pilot_id;
+    }
+  };
+
+  struct PilotIdEqual {
+    [[gnu::pure]]
+    bool operator()(const OGNTrafficEntry &a,
+                    const OGNTrafficEntry &b) const noexcept {
+      return a.pilot_id == b.pilot_id;
+    }
+
+    [[gnu::pure]]
+    bool operator()(uint32_t a, const OGNTrafficEntry &b) const noexcept {
+      return a == b.pilot_id;
+    }
+  };
 };
 
 [[gnu::pure]]
@@ -83,81 +154,87 @@ IsForwardableOgnTraffic(const OGNTrafficEntry &t) noexcept;
 uint32_t
 OGNTrafficPilotId(const OGNTrafficEntry &t) noexcept;
 
-using OGNTrafficPtr = std::shared_ptr<OGNTrafficEntry>;
-
-struct OGNTrafficIndexable {
-  typedef GeoPoint result_type;
-
-  [[gnu::pure]]
-  result_type operator()(const OGNTrafficPtr &t) const noexcept {
-    return t->location;
-  }
-};
-
-namespace OGNTrafficDetail {
-
-struct StationHash {
-  using is_transparent = void;
-
+/**
+ * Helper for #GeoGrid.
+ */
+struct OGNTrafficLocation {
   [[gnu::pure]]
-  std::size_t operator()(std::string_view s) const noexcept {
-    return std::hash<std::string_view>{}(s);
-  }
-
-  std::size_t operator()(const std::string &s) const noexcept {
-    return (*this)(std::string_view(s));
+  GeoPoint operator()(const OGNTrafficEntry &t) const noexcept {
+    return t.location;
   }
 };
 
-struct StationEqual {
-  using is_transparent = void;
-
-  bool operator()(std::string_view a, std::string_view b) const noexcept {
-    return a == b;
-  }
-
-  bool operator()(std::string_view a, const std::string &b) const noexcept {
-    return a == std::string_view(b);
-  }
-
-  bool operator()(const std::string &a, std::string_view b) const noexcept {
-    return std::string_view(a) == b;
-  }
-
-  bool operator()(const std::string &a, const std::string &b) const noexcept {
-    return a == b;
-  }
-};
-
-} // namespace OGNTrafficDetail
-
 /**
  * In-memory OGN-derived traffic positions (not persisted in cloud DB).
  *
+ * Entries are allocated in chunks and recycled through a free list,
+ * and the lookup tables are intrusive hash sets keyed by integers
+ * (see OGNStationKey()), so updating a known aircraft does not
+ * allocate memory.
+ *
  * CRUD-style API:
  * - Create / update: #Upsert
  * - Read: #Find, #QueryWithinRange
  * - Delete: #Erase, #Expire (time threshold), #clear
  */
 class OGNTrafficContainer {
-  typedef boost::geometry::index::rtree<
-    OGNTrafficPtr, boost::geometry::index::rstar<16>, OGNTrafficIndexable>
-    Tree;
+  typedef GeoGrid<OGNTrafficEntry, OGNTrafficLocation> Grid;
 
   typedef boost::intrusive::list<
     OGNTrafficEntry,
     boost::intrusive::constant_time_size<false>>
     List;
 
-  Tree rtree;
+  typedef boost::intrusive::unordered_set<
+    OGNTrafficEntry,
+    boost::intrusive::base_hook<OGNTrafficDetail::StationHook>,
+    boost::intrusive::hash<OGNTrafficEntry::StationHash>,
+    boost::intrusive::equal<OGNTrafficEntry::StationEqual>,
+    boost::intrusive::constant_time_size<false>>
+    StationSet;
+
+  /**
+   * Several stations may relay the same FLARM address, therefore
+   * this is a multiset; lookups return one of them.
+   */
+  typedef boost::intrusive::unordered_multiset<
+    OGNTrafficEntry,
+    boost::intrusive::base_hook<OGNTrafficDetail::PilotIdHook>,
+    boost::intrusive::hash<OGNTrafficEntry::PilotIdHash>,
+    boost::intrusive::equal<OGNTrafficEntry::PilotIdEqual>,
+    boost::intrusive::constant_time_size<false>>
+    PilotIdSet;
+
+  static constexpr std::size_t CHUNK_SIZE = 1024;
+
+  /**
+   * The pool which owns all #OGNTrafficEntry instances.
+   */
+  std::vector<std::unique_ptr<OGNTrafficEntry[]>> chunks;
+
+  /**
+   * Entries which are not in use.  They are linked with the same
+   * hook as #list.
+   */
+  List free_list;
+
+  Grid grid;
+
+  /**
+   * All entries in use, sorted by last update, with fresh items at
+   * the front.
+   */
   List list;
 
-  std::unordered_map<std::string, OGNTrafficPtr,
-                     OGNTrafficDetail::StationHash,
-                     OGNTrafficDetail::StationEqual>
-    by_station;
+  std::size_t n_entries = 0;
+
+  static constexpr std::size_t N_BUCKETS = 16381;
+
+  StationSet::bucket_type station_buckets[N_BUCKETS];
+  StationSet by_station;
 
-  std::unordered_map<uint32_t, OGNTrafficPtr> by_pilot_id;
+  PilotIdSet::bucket_type pilot_id_buckets[N_BUCKETS];
+  PilotIdSet by_pilot_id;
 
 public:
   OGNTrafficContainer();
@@ -172,9 +249,27 @@ public:
     return list.empty();
   }
 
+  /**
+   * Returns the number of entries in use.
+   */
+  std::size_t size() const noexcept {
+    return n_entries;
+  }
+
+  /**
+   * Returns the number of entries allocated by the pool (in use or
+   * free).
+   */
+  std::size_t GetPoolSize() const noexcept {
+    return chunks.size() * CHUNK_SIZE;
+  }
+
   [[gnu::pure]]
   OGNTrafficEntry *FindByPilotId(uint32_t pilot_id) const noexcept;
 
+  /**
+   * Throws std::bad_alloc if the pool needs to grow and that fails.
+   */
   OGNTrafficEntry &Upsert(std::string_view station_id, const GeoPoint &location,
                           int altitude, bool altitude_valid,
                           unsigned track_deg, bool track_valid,
@@ -184,14 +279,24 @@ public:
 
   void Expire(std::chrono::steady_clock::time_point before) noexcept;
 
-  typedef Tree::const_query_iterator query_iterator;
-  typedef boost::iterator_range<query_iterator> query_iterator_range;
+  typedef Grid::const_iterator query_iterator;
+  typedef Grid::Range query_iterator_range;
 
   [[gnu::pure]]
   query_iterator_range QueryWithinRange(GeoPoint location,
                                         double range) const noexcept;
 
+  /**
+   * Returns all entries within the given range of any location in
+   * the grid cell (see GeoGridHook::geo_grid_cell).
+   */
+  [[gnu::pure]]
+  query_iterator_range QueryCellWithinRange(unsigned cell,
+                                            double range) const noexcept {
+    return grid.QueryCellWithinRange(cell, range);
+  }
+
 private:
-  void Insert(OGNTrafficEntry &t) noexcept;
+  OGNTrafficEntry &Allocate();
   void Remove(OGNTrafficEntry &t) noexcept;
 };
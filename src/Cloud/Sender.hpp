@@ -78,9 +78,22 @@ public:
     data.header.reserved3 = 0;
   }
 
+  /**
+   * Serialise one traffic record, to be passed to Add() (possibly
+   * for many clients).
+   */
+  [[gnu::pure]]
+  static SkyLinesTracking::TrafficResponsePacket::Traffic
+  MakeRecord(uint32_t pilot_id, uint32_t time,
+             GeoPoint location, int altitude,
+             TrafficRecordExtensions ext = {}) noexcept;
+
+  void Add(const SkyLinesTracking::TrafficResponsePacket::Traffic &record);
+
   void Add(uint32_t pilot_id, uint32_t time,
            GeoPoint location, int altitude,
            TrafficRecordExtensions ext = {});
+
   void Flush();
 };
 
@@ -3,15 +3,10 @@
 
 #include "Thermal.hpp"
 #include "Serialiser.hpp"
-#include "Geo/Boost/RangeBox.hpp"
 #include "Tracking/SkyLines/Protocol.hpp"
 #include "Tracking/SkyLines/Assemble.hpp"
 #include "Tracking/SkyLines/Import.hpp"
 
-#include <boost/geometry/algorithms/distance.hpp>
-#include <boost/geometry/algorithms/intersection.hpp>
-#include <boost/geometry/strategies/strategies.hpp>
-
 CloudThermalContainer::CloudThermalContainer()
 {
 }
@@ -34,8 +29,8 @@ CloudThermalContainer::Make(uint64_t client_key,
                             const AGeoPoint &top_location,
                             double lift)
 {
-  auto thermal = std::make_shared<CloudThermal>(client_key, bottom_location,
-                                                top_location, lift);
+  auto thermal = new CloudThermal(client_key, bottom_location,
+                                  top_location, lift);
   Insert(*thermal);
   return *thermal;
 }
@@ -44,14 +39,15 @@ void
 CloudThermalContainer::Insert(CloudThermal &thermal)
 {
   list.push_front(thermal);
-  rtree.insert(thermal.shared_from_this());
+  grid.insert(thermal);
 }
 
 void
 CloudThermalContainer::Remove(CloudThermal &thermal)
 {
   list.erase(list.iterator_to(thermal));
-  rtree.remove(thermal.shared_from_this());
+  grid.remove(thermal);
+  delete &thermal;
 }
 
 void
@@ -64,8 +60,7 @@ CloudThermalContainer::Expire(std::chrono::steady_clock::time_point before)
 CloudThermalContainer::query_iterator_range
 CloudThermalContainer::QueryWithinRange(GeoPoint location, double range) const
 {
-  const auto q = boost::geometry::index::intersects(BoostRangeBox(location, range));
-  return {rtree.qbegin(q), rtree.qend()};
+  return grid.QueryWithinRange(location, range);
 }
 
 SkyLinesTracking::Thermal
@@ -130,8 +125,7 @@ CloudThermalContainer::Load(Deserialiser &s)
   s.Read8();
 
   while (s.Read8() != 0) {
-    auto thermal = std::make_shared<CloudThermal>(CloudThermal::Load(s));
-    Insert(*thermal);
+    Insert(*new CloudThermal(CloudThermal::Load(s)));
   }
 
   s.Read8();
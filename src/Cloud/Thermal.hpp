@@ -3,12 +3,10 @@
 
 #pragma once
 
-#include "Geo/Boost/GeoPoint.hpp"
+#include "GeoGrid.hpp"
+#include "Geo/GeoPoint.hpp"
 
 #include <boost/intrusive/list.hpp>
-#include <boost/geometry/index/rtree.hpp>
-#include <boost/range/iterator_range_core.hpp>
-#include <memory>
 #include <chrono>
 
 class Serialiser;
@@ -19,7 +17,7 @@ namespace SkyLinesTracking { struct Thermal; }
  * A client which has submitted data to us recently.
  */
 struct CloudThermal
-  : std::enable_shared_from_this<CloudThermal>,
+  : GeoGridHook,
     boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>>
 {
   const uint64_t client_key;
@@ -50,23 +48,21 @@ struct CloudThermal
   static CloudThermal Load(Deserialiser &s);
 };
 
-using CloudThermalPtr = std::shared_ptr<CloudThermal>;
-
 /**
- * Helper for boost::geometry::index::rtree.
+ * Helper for #GeoGrid.
  */
-struct CloudThermalIndexable {
-  typedef GeoPoint result_type;
-
+struct CloudThermalLocation {
   [[gnu::pure]]
-  result_type operator()(const CloudThermalPtr &client) const {
-    return client->top_location;
+  GeoPoint operator()(const CloudThermal &thermal) const noexcept {
+    return thermal.top_location;
   }
 };
 
+/**
+ * Owns all #CloudThermal instances.
+ */
 class CloudThermalContainer {
-  typedef boost::geometry::index::rtree<CloudThermalPtr, boost::geometry::index::rstar<16>,
-                                        CloudThermalIndexable> Tree;
+  typedef GeoGrid<CloudThermal, CloudThermalLocation> Grid;
 
   typedef boost::intrusive::list<CloudThermal,
                                  boost::intrusive::constant_time_size<false>> List;
@@ -75,7 +71,7 @@ class CloudThermalContainer {
    * A geospatial container of all thermals, for fast geographic
    * lookups.
    */
-  Tree rtree;
+  Grid grid;
 
   /**
    * A linked list of thermals, sorted by time, with newer items at
@@ -113,18 +109,22 @@ public:
                      const AGeoPoint &top_location,
                      double lift);
 
+  /**
+   * Add a #CloudThermal which was allocated with "new"; the
+   * container takes over ownership.
+   */
   void Insert(CloudThermal &client);
 
   /**
-   * Remove a #CloudThermal and its data.  Be careful - the given reference
-   * is invalidated, unless the caller holds another #CloudThermalPtr.
+   * Remove a #CloudThermal and delete it.  Be careful - the given
+   * reference is invalidated.
    */
   void Remove(CloudThermal &client);
 
   void Expire(std::chrono::steady_clock::time_point before);
 
-  typedef Tree::const_query_iterator query_iterator;
-  typedef boost::iterator_range<query_iterator> query_iterator_range;
+  typedef Grid::const_iterator query_iterator;
+  typedef Grid::Range query_iterator_range;
 
   [[gnu::pure]]
   query_iterator_range QueryWithinRange(GeoPoint location, double range) const;
@@ -7,6 +7,9 @@
 #include "NMEA/Derived.hpp"
 #include "NMEA/Aircraft.hpp"
 #include "Navigation/Aircraft.hpp"
+#include "Terrain/RasterTerrain.hpp"
+#include "Engine/GlideSolvers/GlidePolar.hpp"
+#include "util/StaticArray.hxx"
 
 #include <algorithm>
 
@@ -21,6 +24,7 @@ RouteComputer::ResetFlight()
 {
   route_clock.Reset();
   reach_clock.Reset();
+  region_clock.Reset();
   protected_route_planner.Reset();
 
   last_task_type = TaskType::NONE;
@@ -42,6 +46,7 @@ RouteComputer::ProcessRoute(const MoreData &basic, DerivedInfo &calculated,
                                     calculated.GetWindOrZero(),
                                     calculated.common_stats.height_min_working);
 
+  UpdateTerrainRegions(basic, calculated, glide_polar);
   Reach(basic, calculated, config);
   TerrainWarning(basic, calculated, config);
 }
@@ -133,8 +138,56 @@ RouteComputer::Reach(const MoreData &basic, DerivedInfo &calculated,
   }
 }
 
+inline void
+RouteComputer::UpdateTerrainRegions(const MoreData &basic,
+                                    const DerivedInfo &calculated,
+                                    const GlidePolar &glide_polar)
+{
+  if (terrain == nullptr || !calculated.terrain_valid ||
+      !region_clock.CheckAdvance(basic.time, PERIOD))
+    return;
+
+  /* don't go further than TerrainWarning() does */
+  constexpr double MAX_DISTANCE = 200000;
+
+  StaticArray<RasterTerrain::Region, 2> regions;
+
+  /* the reach footprint: the final glide distance above the terrain
+     base; this area is needed at full resolution, and has priority
+     over the map view (the map view still gets its share, because
+     ranks are weighted with the distance) */
+  const double height = std::max(basic.nav_altitude -
+                                 calculated.GetTerrainBaseFallback(), 0.);
+  const double glide_range = glide_polar.IsValid()
+    ? height * glide_polar.GetBestLD()
+    : 0;
+  regions.push_back({
+      basic.location, basic.location,
+      std::clamp(glide_range, MIN_REACH_REGION_RADIUS, MAX_DISTANCE),
+      RasterTerrain::Priority::HIGH,
+    });
+
+  /* the current task leg; the part within glide range is already
+     covered by the reach footprint, so the remainder has low
+     priority */
+  const GlideResult &sol = calculated.task_stats.current_leg.solution_remaining;
+  if (sol.IsDefined()) {
+    GeoVector v = sol.vector;
+    if (v.distance > MAX_DISTANCE)
+      v.distance = MAX_DISTANCE;
+
+    regions.push_back({
+        basic.location, v.EndPoint(basic.location),
+        LEG_REGION_RADIUS,
+        RasterTerrain::Priority::LOW,
+      });
+  }
+
+  terrain->SetRegions(regions);
+}
+
 void
-RouteComputer::set_terrain(const RasterTerrain* _terrain) {
+RouteComputer::set_terrain(RasterTerrain *_terrain) {
   terrain = _terrain;
   protected_route_planner.SetTerrain(terrain);
 }
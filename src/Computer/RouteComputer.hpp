@@ -22,10 +22,23 @@ class RouteComputer {
   RoutePlannerGlue route_planner;
   ProtectedRoutePlanner protected_route_planner;
 
+  /**
+   * Tiles around the aircraft are requested at least in this radius
+   * [m], even if the glide range is smaller.
+   */
+  static constexpr double MIN_REACH_REGION_RADIUS = 10000;
+
+  /**
+   * The radius [m] of the corridor along the current task leg whose
+   * tiles are requested.
+   */
+  static constexpr double LEG_REGION_RADIUS = 5000;
+
   GPSClock route_clock;
   GPSClock reach_clock;
+  GPSClock region_clock;
 
-  const RasterTerrain *terrain;
+  RasterTerrain *terrain;
 
   TaskType last_task_type;
   unsigned last_active_tp;
@@ -53,7 +66,7 @@ public:
                     const GlidePolar &glide_polar,
                     const GlidePolar &safety_polar);
 
-  void set_terrain(const RasterTerrain* _terrain);
+  void set_terrain(RasterTerrain *_terrain);
 
 private:
   void TerrainWarning(const MoreData &basic,
@@ -62,4 +75,13 @@ private:
 
   void Reach(const MoreData &basic, DerivedInfo &calculated,
              const RoutePlannerConfig &config);
+
+  /**
+   * Register the areas needed by Reach() and TerrainWarning() with
+   * the #RasterTerrain, so their tiles get loaded even if the map
+   * shows a different area.
+   */
+  void UpdateTerrainRegions(const MoreData &basic,
+                            const DerivedInfo &calculated,
+                            const GlidePolar &glide_polar);
 };
@@ -29,6 +29,7 @@
 #include "Input/InputQueue.hpp"
 #include "LogFile.hpp"
 #include "Job/Job.hpp"
+#include "Tracing/Tracing.hpp"
 #include "Operation/MessageOperationEnvironment.hpp"
 
 #ifdef ANDROID
@@ -1735,6 +1736,8 @@ DeviceDescriptor::PortError(const char *msg) noexcept
 bool
 DeviceDescriptor::DataReceived(std::span<const std::byte> s) noexcept
 {
+  const Tracing::Scope trace{Tracing::Point::DEVICE_PARSE};
+
   if (monitor != nullptr)
     monitor->DataReceived(s);
 
@@ -1776,7 +1779,8 @@ DeviceDescriptor::LineReceived(const char *line) noexcept
 
   const auto e = BeginEdit();
   e->UpdateClock();
-  ParseNMEA(line, *e);
+  if (ParseNMEA(line, *e))
+    Tracing::Count(Tracing::Counter::NMEA_SENTENCES);
   e.Commit();
 
   return true;
@@ -607,11 +607,12 @@ GDL90Device::ParseTrafficReport(std::span<const uint8_t> payload,
     altitude = Units::ToSysUnit(altitude_ft, Unit::FEET);
   }
 
-  if (gdl90_settings.hrange > 0 && info.location_available) {
+  GeoVector vec = GeoVector::Invalid();
+  if (info.location_available) {
     const GeoPoint target_location(Angle::Degrees(lon_deg),
                                    Angle::Degrees(lat_deg));
-    const GeoVector vec{info.location, target_location};
-    if (vec.distance > gdl90_settings.hrange)
+    vec = GeoVector{info.location, target_location};
+    if (gdl90_settings.hrange > 0 && vec.distance > gdl90_settings.hrange)
       return;
   }
 
@@ -661,12 +662,13 @@ GDL90Device::ParseTrafficReport(std::span<const uint8_t> payload,
 
   FlarmTraffic *slot = info.flarm.traffic.FindTraffic(id);
   if (slot == nullptr) {
-    slot = info.flarm.traffic.AllocateTraffic();
+    slot = info.flarm.traffic.AllocateTraffic(id,
+                                              FlarmTraffic::SourceType::ADSB,
+                                              vec.IsValid() ? vec.distance : 0);
     if (slot == nullptr)
       return;
 
     slot->Clear();
-    slot->id = id;
     /* Relatives are filled by FlarmComputer from ownship GPS; only clear
        on first insert so later reports do not stomp computed values. */
     slot->relative_north = 0;
@@ -727,6 +729,13 @@ GDL90Device::ParseTrafficReport(std::span<const uint8_t> payload,
   slot->location_available = true;
   slot->absolute_location = true;
 
+  if (vec.IsValid()) {
+    /* FlarmComputer recalculates this from the location, but the
+       traffic list needs it to rank the targets when it is full */
+    slot->relative_north = vec.distance * vec.bearing.cos();
+    slot->relative_east = vec.distance * vec.bearing.sin();
+  }
+
   if (altitude_available) {
     slot->altitude = altitude;
     slot->altitude_available = true;
@@ -24,6 +24,7 @@ enum ControlIndex {
   LoggerTimeStepCruise,
   LoggerTimeStepCircling,
   DisableAutoLogger,
+  LoggerSync,
   EnableNMEALogger,
   EnableFlightLogger,
   LoggerID,
@@ -46,6 +47,16 @@ static constexpr StaticEnumChoice auto_logger_list[] = {
   nullptr
 };
 
+static constexpr StaticEnumChoice logger_sync_list[] = {
+  { LoggerSettings::IGCSync::STOP, N_("Stop"),
+    N_("Write the IGC file to the storage when the logger stops.") },
+  { LoggerSettings::IGCSync::PERIODIC, N_("Periodic"),
+    N_("Write the IGC file to the storage every 10 seconds.") },
+  { LoggerSettings::IGCSync::ALWAYS, N_("Always"),
+    N_("Write every fix to the storage immediately. This may wear out SD cards.") },
+  nullptr
+};
+
 void
 LoggerConfigPanel::Prepare(ContainerWindow &parent,
                            const PixelRect &rc) noexcept
@@ -85,6 +96,12 @@ LoggerConfigPanel::Prepare(ContainerWindow &parent,
           auto_logger_list, (unsigned)logger.auto_logger);
   SetExpertRow(DisableAutoLogger);
 
+  AddEnum(_("Logger sync"),
+          _("How often the IGC file is flushed to the storage. The data "
+            "which was not flushed yet may be lost on power failure."),
+          logger_sync_list, (unsigned)logger.igc_sync);
+  SetExpertRow(LoggerSync);
+
   AddBoolean(_("NMEA Logger"),
              _("Enable the NMEA logger on startup? If this option is disabled, "
                  "the NMEA logger can still be started manually."),
@@ -126,6 +143,9 @@ LoggerConfigPanel::Save(bool &changed) noexcept
   changed |= SaveValueEnum(DisableAutoLogger, ProfileKeys::AutoLogger,
                            logger.auto_logger);
 
+  changed |= SaveValueEnum(LoggerSync, ProfileKeys::LoggerSync,
+                           logger.igc_sync);
+
   changed |= SaveValue(EnableNMEALogger, ProfileKeys::EnableNMEALogger,
                        logger.enable_nmea_logger);
 
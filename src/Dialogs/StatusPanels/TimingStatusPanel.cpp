@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "TimingStatusPanel.hpp"
+#include "Tracing/Tracing.hpp"
+#include "Dialogs/Error.hpp"
+#include "Dialogs/Message.hpp"
+#include "Language/Language.hpp"
+#include "LocalPath.hpp"
+#include "system/Path.hpp"
+#include "util/StaticString.hxx"
+
+enum Controls {
+  ENABLED,
+  EXPORT,
+  EVENTS,
+  FIRST_POINT,
+};
+
+static constexpr unsigned FIRST_COUNTER = FIRST_POINT + Tracing::N_POINTS;
+
+static double
+ToMilliseconds(Tracing::Clock::duration d) noexcept
+{
+  return std::chrono::duration<double, std::milli>(d).count();
+}
+
+void
+TimingStatusPanel::Refresh() noexcept
+{
+  LoadValue(ENABLED, Tracing::IsEnabled());
+
+  StaticString<64> buffer;
+  buffer.Format("%u", Tracing::GetEventCount());
+  SetText(EVENTS, buffer);
+
+  for (unsigned i = 0; i < Tracing::N_POINTS; ++i) {
+    const auto s = Tracing::GetStatistics(Tracing::Point(i));
+    if (s.count == 0) {
+      ClearText(FIRST_POINT + i);
+      continue;
+    }
+
+    buffer.Format("%u, avg %.2f ms, max %.1f ms", s.count,
+                  ToMilliseconds(s.GetAverage()),
+                  ToMilliseconds(s.max));
+    SetText(FIRST_POINT + i, buffer);
+  }
+
+  for (unsigned i = 0; i < Tracing::N_COUNTERS; ++i) {
+    buffer.Format("%llu", (unsigned long long)
+                  Tracing::GetCounter(Tracing::Counter(i)));
+    SetText(FIRST_COUNTER + i, buffer);
+  }
+}
+
+void
+TimingStatusPanel::Export() noexcept
+{
+  const auto path = LocalPath("trace.json");
+
+  try {
+    Tracing::ExportChromeTrace(path);
+  } catch (...) {
+    ShowError(std::current_exception(), _("Export"));
+    return;
+  }
+
+  ShowMessageBox(path.c_str(), _("Export"), MB_OK | MB_ICONINFORMATION);
+}
+
+void
+TimingStatusPanel::OnModified(DataField &df) noexcept
+{
+  if (!IsDataField(ENABLED, df))
+    return;
+
+  if (GetValueBoolean(ENABLED)) {
+    try {
+      Tracing::Enable();
+    } catch (...) {
+      ShowError(std::current_exception(), _("Timing"));
+    }
+  } else
+    Tracing::Disable();
+
+  Refresh();
+}
+
+void
+TimingStatusPanel::Prepare([[maybe_unused]] ContainerWindow &parent,
+                          [[maybe_unused]] const PixelRect &rc) noexcept
+{
+  AddBoolean(_("Record"),
+             _("Measure how long the calculations, map drawing, terrain and topography loading and device data parsing take.  Switching this on clears the previous results."),
+             Tracing::IsEnabled(), this);
+  AddButton(_("Export"), [this](){ Export(); });
+  AddReadOnly(_("Events"));
+
+  /* these are developer-facing names, not translated */
+  for (unsigned i = 0; i < Tracing::N_POINTS; ++i)
+    AddReadOnly(Tracing::GetName(Tracing::Point(i)));
+
+  for (unsigned i = 0; i < Tracing::N_COUNTERS; ++i)
+    AddReadOnly(Tracing::GetName(Tracing::Counter(i)));
+}
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "StatusPanel.hpp"
+#include "Form/DataField/Listener.hpp"
+
+/**
+ * Shows the statistics collected by the hot path timers (see
+ * Tracing/Tracing.hpp), and allows switching them on and exporting the
+ * recorded events.
+ */
+class TimingStatusPanel final : public StatusPanel, DataFieldListener {
+public:
+  explicit TimingStatusPanel(const DialogLook &look) noexcept
+    :StatusPanel(look) {}
+
+  /* virtual methods from class StatusPanel */
+  void Refresh() noexcept override;
+
+  /* virtual methods from class Widget */
+  void Prepare(ContainerWindow &parent, const PixelRect &rc) noexcept override;
+
+private:
+  void Export() noexcept;
+
+  /* virtual methods from class DataFieldListener */
+  void OnModified(DataField &df) noexcept override;
+};
@@ -13,6 +13,7 @@
 #include "StatusPanels/RulesStatusPanel.hpp"
 #include "StatusPanels/SystemStatusPanel.hpp"
 #include "StatusPanels/TimesStatusPanel.hpp"
+#include "StatusPanels/TimingStatusPanel.hpp"
 #include "Components.hpp"
 #include "DataComponents.hpp"
 #include "Engine/Waypoint/Waypoints.hpp"
@@ -65,6 +66,7 @@ dlgStatusShowModal(int start_page)
   const auto *TaskIcon = enable_icons ? &icons.hBmpTabTask : nullptr;
   const auto *RulesIcon = enable_icons ? &icons.hBmpTabRules : nullptr;
   const auto *TimesIcon = enable_icons ? &icons.hBmpTabTimes : nullptr;
+  const auto *TimingIcon = enable_icons ? &icons.hBmpTabTiming : nullptr;
 
   widget.AddTab(std::make_unique<FlightStatusPanel>(look,
                                                     std::move(nearest_waypoint)),
@@ -82,6 +84,9 @@ dlgStatusShowModal(int start_page)
   widget.AddTab(std::make_unique<TimesStatusPanel>(look),
                 _("Times"), TimesIcon);
 
+  widget.AddTab(std::make_unique<TimingStatusPanel>(look),
+                _("Timing"), TimingIcon);
+
   /* restore previous page */
 
   if (start_page != -1) {
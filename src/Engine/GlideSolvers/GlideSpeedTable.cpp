@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "GlideSpeedTable.hpp"
+#include "GlidePolar.hpp"
+#include "Math/ZeroFinder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Ground speed in still air for the specified airspeed with the given
+ * wind components; same as GlideState::CalcAverageSpeed().
+ *
+ * @return the ground speed (m/s), or a negative value if the cross
+ * wind cannot be compensated
+ */
+[[gnu::const]]
+static double
+GroundSpeed(double v_eff, double head_wind, double cross_wind) noexcept
+{
+  const double s = v_eff * v_eff - cross_wind * cross_wind;
+  if (s < 0)
+    return -1;
+
+  return std::sqrt(s) - head_wind;
+}
+
+/**
+ * Finds the speed which maximises the glide ratio over ground for
+ * the density-normalised polar.  Intended to be used temporarily.
+ */
+class GlideSpeedSearch final : public ZeroFinder {
+  static constexpr double TOLERANCE = 0.001;
+
+  const PolarCoefficients &polar;
+  const double cruise_efficiency;
+  const double head_wind, cross_wind;
+
+public:
+  GlideSpeedSearch(const PolarCoefficients &_polar,
+                   double _cruise_efficiency,
+                   double _head_wind, double _cross_wind,
+                   double vmin, double vmax) noexcept
+    :ZeroFinder(vmin, vmax, TOLERANCE),
+     polar(_polar), cruise_efficiency(_cruise_efficiency),
+     head_wind(_head_wind), cross_wind(_cross_wind) {}
+
+  [[gnu::pure]]
+  double GetGroundSpeed(double v) const noexcept {
+    return GroundSpeed(v * cruise_efficiency, head_wind, cross_wind);
+  }
+
+  /**
+   * @return the inverse glide ratio over ground, magnified like in
+   * MacCreadyVopt::f()
+   */
+  double f(const double v) noexcept override {
+    const double ground_speed = GetGroundSpeed(v);
+    if (ground_speed <= 0)
+      /* no progress: return a large value that will be discarded by
+         ZeroFinder */
+      return 1000000;
+
+    const double sink_rate = v * (v * polar.a + polar.b) + polar.c;
+    return sink_rate * 1024 / ground_speed;
+  }
+};
+
+bool
+GlideSpeedTable::IsValidFor(const GlidePolar &glide_polar,
+                            double _cruise_efficiency) const noexcept
+{
+  const auto &p = glide_polar.GetRealCoefficients();
+  return polar.IsValid() &&
+    p.a == polar.a && p.b == polar.b && p.c == polar.c &&
+    glide_polar.GetVMax() == v_max &&
+    _cruise_efficiency == cruise_efficiency;
+}
+
+void
+GlideSpeedTable::Initialise(const GlidePolar &glide_polar,
+                            double _cruise_efficiency) noexcept
+{
+  polar = glide_polar.GetRealCoefficients();
+  v_max = glide_polar.GetVMax();
+  cruise_efficiency = _cruise_efficiency;
+
+  if (!polar.IsValid() || cruise_efficiency <= 0) {
+    polar.SetInvalid();
+    return;
+  }
+
+  /* search beyond the maximum speed; the result gets clamped by
+     Lookup() after scaling with the actual density ratio */
+  const double search_min = -0.5 * polar.b / polar.a;
+  const double search_max = std::max(2 * v_max, search_min + 1);
+
+  float *p = speeds;
+  for (unsigned row = 0; row < CROSS_WIND_ROWS; ++row) {
+    const double cross_wind = row;
+
+    double v = search_min;
+    for (unsigned column = 0; column < HEAD_WIND_COLUMNS; ++column) {
+      const double head_wind = int(column) - int(MAX_WIND);
+
+      GlideSpeedSearch search(polar, cruise_efficiency,
+                              head_wind, cross_wind,
+                              search_min, search_max);
+      v = search.find_min(v);
+      *p++ = search.GetGroundSpeed(v) > 0
+        ? float(v)
+        : -1.f;
+    }
+  }
+}
+
+double
+GlideSpeedTable::Lookup(const GlidePolar &glide_polar,
+                        double head_wind, double cross_wind) const noexcept
+{
+  const double density_ratio = glide_polar.GetDensityRatio();
+  const double inv_density_ratio = 1. / density_ratio;
+
+  const double x = head_wind * inv_density_ratio + MAX_WIND;
+  const double y = std::fabs(cross_wind) * inv_density_ratio;
+  if (!(x >= 0 && x < HEAD_WIND_COLUMNS - 1 &&
+        y >= 0 && y < CROSS_WIND_ROWS - 1))
+    return -1;
+
+  const unsigned column = unsigned(x), row = unsigned(y);
+  const double fx = x - column, fy = y - row;
+
+  const float *p = speeds + row * HEAD_WIND_COLUMNS + column;
+  const double v00 = p[0], v01 = p[1];
+  const double v10 = p[HEAD_WIND_COLUMNS], v11 = p[HEAD_WIND_COLUMNS + 1];
+  if (v00 < 0 || v01 < 0 || v10 < 0 || v11 < 0)
+    /* close to excessive wind: the optimum is not smooth here */
+    return -1;
+
+  const double v0 = v00 + (v01 - v00) * fx;
+  const double v1 = v10 + (v11 - v10) * fx;
+  const double v = (v0 + (v1 - v0) * fy) * density_ratio;
+
+  return std::clamp(v, glide_polar.GetVMin(), glide_polar.GetVMax());
+}
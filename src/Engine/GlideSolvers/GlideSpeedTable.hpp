@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "PolarCoefficients.hpp"
+
+class GlidePolar;
+
+/**
+ * Fast lookup of the pure glide (MacCready zero) speed which
+ * maximises the glide ratio over ground, as a function of the head
+ * wind and cross wind components.  This replaces the #ZeroFinder
+ * search in MacCready::OptimiseGlide() with a bilinear interpolation.
+ *
+ * The table is built for the density-normalised polar (indicated
+ * airspeed, wind divided by the density ratio), so it remains valid
+ * while GlidePolar::SetDensityRatio() follows the altitude.  Only
+ * changes to the polar coefficients (bugs, ballast), the maximum
+ * speed or the cruise efficiency require rebuilding it.
+ */
+class GlideSpeedTable {
+  /** maximum normalised wind component covered by the table (m/s) */
+  static constexpr unsigned MAX_WIND = 32;
+
+  /** number of head wind columns (-MAX_WIND..MAX_WIND, 1 m/s step) */
+  static constexpr unsigned HEAD_WIND_COLUMNS = 2 * MAX_WIND + 1;
+
+  /** number of cross wind rows (0..MAX_WIND, 1 m/s step) */
+  static constexpr unsigned CROSS_WIND_ROWS = MAX_WIND + 1;
+
+  /** the polar (at density ratio 1) this table was built for */
+  PolarCoefficients polar = PolarCoefficients::Invalid();
+  double v_max;
+  double cruise_efficiency;
+
+  /**
+   * Optimum normalised speed (m/s) for each grid node, or a negative
+   * value if there is no speed which makes progress against the
+   * wind.  Row-major: cross wind rows, head wind columns.
+   */
+  float speeds[CROSS_WIND_ROWS * HEAD_WIND_COLUMNS];
+
+public:
+  /**
+   * Is this table up to date for the specified polar and cruise
+   * efficiency?
+   */
+  [[gnu::pure]]
+  bool IsValidFor(const GlidePolar &glide_polar,
+                  double cruise_efficiency) const noexcept;
+
+  /**
+   * Populate the table.  To be called when IsValidFor() returns
+   * false.
+   */
+  void Initialise(const GlidePolar &glide_polar,
+                  double cruise_efficiency) noexcept;
+
+  /**
+   * Look up the speed which maximises the glide ratio over ground.
+   *
+   * @param glide_polar the polar this table was built for (provides
+   * the density ratio and the speed range)
+   * @param head_wind the head wind component (m/s)
+   * @param cross_wind the cross wind component (m/s)
+   * @return the true airspeed (m/s), or a negative value if the wind
+   * components are out of the table's range or no solution exists
+   * nearby; the caller should then fall back to a full search
+   */
+  [[gnu::pure]]
+  double Lookup(const GlidePolar &glide_polar,
+                double head_wind, double cross_wind) const noexcept;
+};
@@ -5,6 +5,7 @@
 #include "GlideState.hpp"
 #include "GlidePolar.hpp"
 #include "GlideResult.hpp"
+#include "GlideSpeedTable.hpp"
 #include "Math/ZeroFinder.hpp"
 
 #include <cassert>
@@ -362,11 +363,36 @@ public:
   }
 };
 
+/**
+ * Returns the #GlideSpeedTable for the specified polar, rebuilding it
+ * if the polar has changed.  Each thread keeps its own table, because
+ * the calculation thread and the draw thread solve concurrently.
+ */
+static const GlideSpeedTable &
+GetGlideSpeedTable(const GlidePolar &glide_polar,
+                   double cruise_efficiency) noexcept
+{
+  static thread_local GlideSpeedTable table;
+  if (!table.IsValidFor(glide_polar, cruise_efficiency))
+    table.Initialise(glide_polar, cruise_efficiency);
+  return table;
+}
+
 GlideResult
 MacCready::OptimiseGlide(const GlideState &task, const bool allow_partial) const
 {
   assert(glide_polar.GetMC() <= 0);
 
+  /* with insufficient height, a partial glide has zero length at any
+     speed; let the full search handle that degenerate case */
+  if (!allow_partial || task.altitude_difference >= 0) {
+    const auto cross_wind = task.wind.norm * task.effective_wind_angle.sin();
+    const auto v = GetGlideSpeedTable(glide_polar, cruise_efficiency)
+      .Lookup(glide_polar, task.head_wind, cross_wind);
+    if (v > 0)
+      return SolveGlide(task, v, allow_partial);
+  }
+
   MacCreadyVopt mc_vopt(task, *this,
                        glide_polar.GetVMin(), glide_polar.GetVMax(),
                        allow_partial);
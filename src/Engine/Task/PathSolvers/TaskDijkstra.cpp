@@ -4,6 +4,8 @@
 #include "TaskDijkstra.hpp"
 #include "Geo/SearchPointVector.hpp"
 
+#include <algorithm>
+
 TaskDijkstra::TaskDijkstra(bool _is_min) noexcept
   :NavDijkstra(0),
    is_min(_is_min)
@@ -24,6 +26,64 @@ TaskDijkstra::GetPoint(const ScanTaskPoint sp) const noexcept
   return (*boundaries[sp.GetStageNumber()])[sp.GetPointIndex()];
 }
 
+unsigned
+TaskDijkstra::UpdateLegCache() noexcept
+{
+  unsigned n_unchanged = num_stages;
+
+  for (unsigned stage = 0; stage != num_stages; ++stage) {
+    const SearchPointVector &boundary = *boundaries[stage];
+    auto &locations = cached_locations[stage];
+
+    if (std::equal(boundary.begin(), boundary.end(),
+                   locations.begin(), locations.end(),
+                   [](const SearchPoint &a, const GeoPoint &b){
+                     return a.GetLocation() == b;
+                   }))
+      continue;
+
+    locations.clear();
+    locations.reserve(boundary.size());
+    for (const auto &i : boundary)
+      locations.push_back(i.GetLocation());
+
+    if (stage > 0)
+      leg_distances[stage - 1].clear();
+    leg_distances[stage].clear();
+
+    n_unchanged = std::min(n_unchanged, stage);
+  }
+
+  /* the best paths to this stage and all following ones depend on
+     the changed boundary */
+  n_solved_stages = std::min(n_solved_stages, n_unchanged);
+
+  n_calculated_edges = 0;
+  return n_unchanged;
+}
+
+TaskDijkstra::value_type
+TaskDijkstra::GetEdgeDistance(const ScanTaskPoint origin,
+                              unsigned destination_index) noexcept
+{
+  const unsigned stage = origin.GetStageNumber();
+  const unsigned dsize = GetStageSize(stage + 1);
+
+  auto &distances = leg_distances[stage];
+  if (distances.empty())
+    distances.assign(GetStageSize(stage) * dsize, UNKNOWN_DISTANCE);
+
+  value_type &distance =
+    distances[origin.GetPointIndex() * dsize + destination_index];
+  if (distance == UNKNOWN_DISTANCE) {
+    distance = CalcDistance(origin,
+                            ScanTaskPoint(stage + 1, destination_index));
+    ++n_calculated_edges;
+  }
+
+  return distance;
+}
+
 void
 TaskDijkstra::AddEdges(const ScanTaskPoint curNode) noexcept
 {
@@ -32,7 +92,50 @@ TaskDijkstra::AddEdges(const ScanTaskPoint curNode) noexcept
 
   for (const ScanTaskPoint end(destination.GetStageNumber(), dsize);
        destination != end; destination.IncrementPointIndex())
-    Link(destination, curNode, CalcDistance(curNode, destination));
+    Link(destination, curNode,
+         GetEdgeDistance(curNode, destination.GetPointIndex()));
+}
+
+void
+TaskDijkstra::SolveStages(unsigned last_stage) noexcept
+{
+  if (n_solved_stages == 0) {
+    /* the same biased zero start edges as AddZeroStartEdges() */
+    auto &values = stage_values[0];
+    values.resize(GetStageSize(0));
+    for (unsigned i = 0; i < values.size(); ++i)
+      values[i] = i;
+
+    n_solved_stages = 1;
+  }
+
+  for (unsigned stage = n_solved_stages; stage <= last_stage; ++stage) {
+    const auto &previous = stage_values[stage - 1];
+    auto &values = stage_values[stage];
+    auto &parents = stage_parents[stage];
+
+    const unsigned size = GetStageSize(stage);
+    values.assign(size, UNKNOWN_DISTANCE);
+    parents.assign(size, 0);
+
+    for (unsigned i = 0; i < previous.size(); ++i) {
+      const ScanTaskPoint origin(stage - 1, i);
+
+      for (unsigned j = 0; j < size; ++j) {
+        value_type distance = GetEdgeDistance(origin, j);
+        if (!is_min)
+          distance = DIJKSTRA_MINMAX_OFFSET - distance;
+
+        const value_type value = previous[i] + distance;
+        if (value < values[j]) {
+          values[j] = value;
+          parents[j] = i;
+        }
+      }
+    }
+  }
+
+  n_solved_stages = std::max(n_solved_stages, last_stage + 1);
 }
 
 void
@@ -72,7 +175,40 @@ TaskDijkstra::AddStartEdges(unsigned stage,
 bool
 TaskDijkstra::Run() noexcept
 {
+  UpdateLegCache();
+
+  const bool retval = DistanceGeneral() == SolverResult::VALID;
+  dijkstra.Clear();
+  return retval;
+}
+
+bool
+TaskDijkstra::RunIncremental() noexcept
+{
+  const unsigned n_unchanged = UpdateLegCache();
+
+  /* resume the search at the last stage whose best paths are still
+     valid; the final stage is searched anyway */
+  const unsigned resume_stage =
+    std::min(std::max(n_unchanged, 1U), num_stages) - 1;
+
+  SolveStages(resume_stage);
+
+  dijkstra.Clear();
+  dijkstra.Reserve(256);
+
+  const auto &values = stage_values[resume_stage];
+  for (unsigned i = 0; i < values.size(); ++i)
+    LinkStart(ScanTaskPoint(resume_stage, i), values[i]);
+
   const bool retval = DistanceGeneral() == SolverResult::VALID;
   dijkstra.Clear();
+
+  if (retval)
+    /* the search has filled the solution from the resume stage on;
+       the rest comes from the cached best paths */
+    for (unsigned stage = resume_stage; stage > 0; --stage)
+      solution[stage - 1] = stage_parents[stage][solution[stage]];
+
   return retval;
 }
@@ -6,6 +6,9 @@
 #include "PathSolvers/NavDijkstra.hpp"
 #include "Geo/SearchPoint.hpp"
 
+#include <limits>
+#include <vector>
+
 #include <cassert>
 
 class OrderedTask;
@@ -30,11 +33,57 @@ class SearchPointVector;
  * call SetBoundary() for each task point.
  *
  * This uses a Dijkstra search and so is O(N log(N)).
+ *
+ * Edge distances are cached across runs.  Boundaries of task points
+ * other than the active one rarely change, so usually only the legs
+ * adjacent to the active task point need to be recalculated.
+ *
+ * Searches with zero start edges (see RunIncremental()) also keep
+ * the best path to each point of the leading stages whose boundaries
+ * have not changed since the last run (the task points which have
+ * already been achieved), and resume the search from the last of
+ * those stages.
  */
 class TaskDijkstra : protected NavDijkstra<>
 {
+  static constexpr value_type UNKNOWN_DISTANCE =
+    std::numeric_limits<value_type>::max();
+
   const SearchPointVector *boundaries[MAX_STAGES];
 
+  /**
+   * The boundary locations which #leg_distances were calculated
+   * for.
+   */
+  std::vector<GeoPoint> cached_locations[MAX_STAGES];
+
+  /**
+   * Edge distances from each point of a stage to each point of the
+   * following stage (row-major), or #UNKNOWN_DISTANCE if not yet
+   * calculated.  An empty vector means the whole leg is unknown.
+   */
+  std::vector<value_type> leg_distances[MAX_STAGES];
+
+  /**
+   * The value of the best path (with zero start edges) to each point
+   * of a stage, valid for stages below #n_solved_stages.
+   */
+  std::vector<value_type> stage_values[MAX_STAGES];
+
+  /**
+   * The point index in the previous stage on the best path to each
+   * point of a stage, valid for stages 1 to #n_solved_stages-1.
+   */
+  std::vector<unsigned> stage_parents[MAX_STAGES];
+
+  unsigned n_solved_stages = 0;
+
+  /**
+   * The number of edge distances which were not found in the cache
+   * during the last run.
+   */
+  unsigned n_calculated_edges = 0;
+
   const bool is_min;
 
 public:
@@ -65,12 +114,27 @@ public:
     return GetPoint(ScanTaskPoint(stage, solution[stage]));
   }
 
+  /**
+   * Returns the number of edge distances which had to be calculated
+   * by the last run, i.e. were not found in the cache.
+   */
+  unsigned GetCalculatedEdgeCount() const noexcept {
+    return n_calculated_edges;
+  }
+
 protected:
   [[gnu::pure]]
   const SearchPoint &GetPoint(ScanTaskPoint sp) const noexcept;
 
   bool Run() noexcept;
 
+  /**
+   * Search with zero start edges (like AddZeroStartEdges()), but
+   * resume from the cached best paths of the leading stages whose
+   * boundaries have not changed since the last call.
+   */
+  bool RunIncremental() noexcept;
+
   bool Link(const ScanTaskPoint node, const ScanTaskPoint parent,
             value_type value) noexcept {
     if (!is_min)
@@ -128,6 +192,27 @@ private:
   [[gnu::pure]]
   unsigned GetStageSize(const unsigned stage) const noexcept;
 
+  /**
+   * Compare the boundaries with the cached locations and discard the
+   * distances of all legs whose boundaries have changed.
+   *
+   * @return the number of leading stages which have not changed
+   */
+  unsigned UpdateLegCache() noexcept;
+
+  /**
+   * Returns the (cached) distance of the edge from the given node to
+   * the specified point of the following stage.
+   */
+  value_type GetEdgeDistance(ScanTaskPoint origin,
+                             unsigned destination_index) noexcept;
+
+  /**
+   * Calculate #stage_values and #stage_parents up to the given
+   * stage.
+   */
+  void SolveStages(unsigned last_stage) noexcept;
+
 protected:
   /* methods from NavDijkstra */
   virtual void AddEdges(ScanTaskPoint curNode) noexcept final;
@@ -6,8 +6,8 @@
 bool
 TaskDijkstraMax::DistanceMax() noexcept
 {
-  dijkstra.Clear();
-  dijkstra.Reserve(256);
-  AddZeroStartEdges();
-  return Run();
+  /* the boundaries of the task points which have already been
+     achieved are frozen; resume the search from the first one which
+     has changed */
+  return RunIncremental();
 }
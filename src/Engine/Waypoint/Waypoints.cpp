@@ -80,19 +80,23 @@ Waypoints::Waypoints() noexcept = default;
 void
 Waypoints::Optimise() noexcept
 {
-  if (waypoint_tree.IsEmpty() || waypoint_tree.HaveBounds())
-    /* empty or already optimised */
+  if (waypoint_tree.IsEmpty())
     return;
 
-  task_projection.Update();
+  if (!waypoint_tree.HaveBounds()) {
+    task_projection.Update();
 
-  for (auto &i : waypoint_tree) {
-    // TODO: eliminate this const_cast hack
-    Waypoint &w = const_cast<Waypoint &>(*i);
-    w.Project(task_projection);
+    for (auto &i : waypoint_tree) {
+      // TODO: eliminate this const_cast hack
+      Waypoint &w = const_cast<Waypoint &>(*i);
+      w.Project(task_projection);
+    }
+
+    waypoint_tree.Optimise();
   }
 
-  waypoint_tree.Optimise();
+  if (waypoint_index.IsEmpty())
+    waypoint_index.Build(waypoint_tree.begin(), waypoint_tree.end());
 }
 
 void
@@ -110,6 +114,7 @@ Waypoints::Append(WaypointPtr wp) noexcept
 
   w.flags.watched = w.origin == WaypointOrigin::WATCHED;
 
+  waypoint_index.Clear();
   task_projection.Scan(w.location);
   w.id = next_id++;
 
@@ -126,8 +131,17 @@ Waypoints::GetNearest(const GeoPoint &loc, double range) const noexcept
     return nullptr;
 
   const FlatGeoPoint flat_location = task_projection.ProjectInteger(loc);
-  const WaypointTree::Point point(flat_location.x, flat_location.y);
   const unsigned mrange = task_projection.ProjectRangeInteger(loc, range);
+
+  if (!waypoint_index.IsEmpty()) {
+    const auto *found = waypoint_index.FindNearestIf({flat_location.x, flat_location.y},
+                                                     mrange, [](const WaypointPtr &){
+                                                       return true;
+                                                     });
+    return found != nullptr ? *found : nullptr;
+  }
+
+  const WaypointTree::Point point(flat_location.x, flat_location.y);
   const auto found = waypoint_tree.FindNearest(point, mrange);
 
   if (found.first == waypoint_tree.end())
@@ -156,12 +170,19 @@ Waypoints::GetNearestIf(const GeoPoint &loc, double range,
     return nullptr;
 
   const FlatGeoPoint flat_location = task_projection.ProjectInteger(loc);
-  const WaypointTree::Point point(flat_location.x, flat_location.y);
   const unsigned mrange = task_projection.ProjectRangeInteger(loc, range);
-  const auto found = waypoint_tree.FindNearestIf(point, mrange,
-                                                 [predicate](const WaypointPtr &ptr){
-                                                   return predicate(*ptr);
-                                                 });
+  const auto p = [predicate](const WaypointPtr &ptr){
+    return predicate(*ptr);
+  };
+
+  if (!waypoint_index.IsEmpty()) {
+    const auto *found = waypoint_index.FindNearestIf({flat_location.x, flat_location.y},
+                                                     mrange, p);
+    return found != nullptr ? *found : nullptr;
+  }
+
+  const WaypointTree::Point point(flat_location.x, flat_location.y);
+  const auto found = waypoint_tree.FindNearestIf(point, mrange, p);
 
   if (found.first == waypoint_tree.end())
     return nullptr;
@@ -234,9 +255,15 @@ Waypoints::VisitWithinRange(const GeoPoint &loc, const double range,
     return; // nothing to do
 
   const FlatGeoPoint flat_location = task_projection.ProjectInteger(loc);
-  const WaypointTree::Point point(flat_location.x, flat_location.y);
   const unsigned mrange = task_projection.ProjectRangeInteger(loc, range);
 
+  if (!waypoint_index.IsEmpty()) {
+    waypoint_index.VisitWithinRange({flat_location.x, flat_location.y},
+                                    mrange, visitor);
+    return;
+  }
+
+  const WaypointTree::Point point(flat_location.x, flat_location.y);
   waypoint_tree.VisitWithinRange(point, mrange, visitor);
 }
 
@@ -371,6 +398,7 @@ Waypoints::Clear() noexcept
   ++serial;
   home = nullptr;
   name_tree.Clear();
+  waypoint_index.Clear();
   waypoint_tree.clear();
   next_id = 1;
 }
@@ -388,6 +416,7 @@ Waypoints::Erase(WaypointPtr &&wp) noexcept
   assert(f.first != waypoint_tree.end());
 
   name_tree.Remove(std::move(wp));
+  waypoint_index.Clear();
   waypoint_tree.erase(f.first);
   ++serial;
 }
@@ -402,6 +431,7 @@ Waypoints::EraseUserMarkers() noexcept
           home = nullptr;
 
         name_tree.Remove(wp);
+        waypoint_index.Clear();
         ++serial;
         return true;
       } else
@@ -436,6 +466,7 @@ Waypoints::Replace(const WaypointPtr &orig, Waypoint &&replacement) noexcept
                                        });
   assert(f.first != waypoint_tree.end());
 
+  waypoint_index.Clear();
   waypoint_tree.Replace(f.first, std::move(new_ptr));
 
   ++serial;
@@ -8,6 +8,7 @@
 #include "Geo/Flat/TaskProjection.hpp"
 #include "util/RadixTree.hpp"
 #include "util/QuadTree.hxx"
+#include "util/MortonIndex.hpp"
 #include "util/Serial.hpp"
 
 #include <string_view>
@@ -41,6 +42,12 @@ class Waypoints {
    */
   using WaypointTree = QuadTree<WaypointPtr, WaypointAccessor>;
 
+  /**
+   * Flat index over the #WaypointTree elements for the spatial
+   * queries, which is cheaper to search than the tree.
+   */
+  using WaypointIndex = MortonIndex<WaypointPtr, WaypointAccessor>;
+
   class WaypointNameTree : public RadixTree<WaypointPtr> {
   public:
     [[gnu::pure]]
@@ -61,6 +68,13 @@ class Waypoints {
   unsigned next_id = 1;
 
   WaypointTree waypoint_tree;
+
+  /**
+   * Built by Optimise() and cleared by all modifications; while it
+   * is empty, the queries fall back to #waypoint_tree.
+   */
+  WaypointIndex waypoint_index;
+
   WaypointNameTree name_tree;
   TaskProjection task_projection;
 
@@ -155,6 +169,7 @@ public:
    * Prepare and enable the next Optimise() call.
    */
   void ScheduleOptimise() noexcept {
+    waypoint_index.Clear();
     waypoint_tree.Flatten();
     waypoint_tree.ClearBounds();
   }
@@ -3,24 +3,146 @@
 
 #include "Calculations.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+static constexpr unsigned
+WheelBucket(int_least64_t second, unsigned size) noexcept
+{
+  return unsigned(((second % size) + size) % size);
+}
+
+static int_least64_t
+ToSecond(TimeStamp t) noexcept
+{
+  return std::chrono::floor<std::chrono::seconds>(t.ToDuration()).count();
+}
+
+FlarmCalculations::FlarmCalculations() noexcept
+  :items(new Item[CAPACITY])
+{
+  std::fill_n(index, INDEX_SIZE, 0);
+
+  for (std::size_t i = 0; i < CAPACITY; ++i)
+    unused.push_back(items[i]);
+
+  expire_second = std::numeric_limits<int_least64_t>::min();
+  last_cleanup = TimeStamp::Undefined();
+}
+
+FlarmCalculations::~FlarmCalculations() noexcept
+{
+  /* the items are owned by #items; just detach them */
+  unused.clear();
+  for (auto &bucket : wheel)
+    bucket.clear();
+}
+
+inline unsigned
+FlarmCalculations::Probe(FlarmId id) const noexcept
+{
+  for (unsigned i = id.Hash<INDEX_BITS>();; i = (i + 1) % INDEX_SIZE) {
+    const unsigned n = index[i];
+    if (n == 0 || items[n - 1].id == id)
+      return i;
+  }
+}
+
+void
+FlarmCalculations::RemoveSlot(unsigned slot) noexcept
+{
+  assert(index[slot] != 0);
+
+  constexpr unsigned mask = INDEX_SIZE - 1;
+
+  unsigned hole = slot;
+  for (unsigned i = (hole + 1) & mask; index[i] != 0; i = (i + 1) & mask) {
+    const unsigned home = items[index[i] - 1].id.Hash<INDEX_BITS>();
+
+    /* move the entry into the hole unless its home slot lies
+       (cyclically) between the hole and its current position */
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      index[hole] = index[i];
+      hole = i;
+    }
+  }
+
+  index[hole] = 0;
+}
+
+inline void
+FlarmCalculations::Release(Item &item) noexcept
+{
+  RemoveSlot(Probe(item.id));
+  unused.push_back(item);
+  --n_items;
+}
+
 double
 FlarmCalculations::Average30s(FlarmId id, TimeStamp time,
                               double altitude) noexcept
 {
-  ClimbAverageCalculator &item = averageCalculatorMap[id];
-  return item.GetAverage(time, altitude, std::chrono::seconds{30});
+  const unsigned slot = Probe(id);
+
+  Item *item;
+  if (index[slot] == 0) {
+    if (unused.empty())
+      return 0;
+
+    item = &unused.pop_front();
+    item->id = id;
+    item->calculator.Reset();
+    index[slot] = unsigned(item - items.get()) + 1;
+    ++n_items;
+  } else {
+    item = &items[index[slot] - 1];
+    item->unlink();
+  }
+
+  item->last_update = time;
+  wheel[WheelBucket(ToSecond(time), WHEEL_SIZE)].push_back(*item);
+
+  return item->calculator.GetAverage(time, altitude,
+                                     std::chrono::seconds{30});
 }
 
 void
 FlarmCalculations::CleanUp(TimeStamp now) noexcept
 {
-  constexpr FloatDuration MAX_AGE = std::chrono::minutes{1};
+  if (last_cleanup.IsDefined() && now < last_cleanup)
+    /* time warp */
+    Clear();
+
+  last_cleanup = now;
+
+  const TimeStamp cutoff = now - MAX_AGE;
+  const auto cutoff_second = ToSecond(cutoff);
+
+  /* if this was not called for a while, every bucket is visited
+     once */
+  auto second = std::max(expire_second,
+                         cutoff_second - int_least64_t(WHEEL_SIZE));
+
+  for (; second <= cutoff_second; ++second)
+    wheel[WheelBucket(second, WHEEL_SIZE)].remove_and_dispose_if(
+      [cutoff](const Item &item){ return item.last_update < cutoff; },
+      [this](Item *item){ Release(*item); });
+
+  /* items of the cutoff second may not be expired yet; look at its
+     bucket again next time */
+  expire_second = cutoff_second;
+}
+
+void
+FlarmCalculations::Clear() noexcept
+{
+  for (auto &bucket : wheel)
+    bucket.clear_and_dispose([this](Item *item){
+      unused.push_back(*item);
+    });
 
-  // Iterate through ClimbAverageCalculators and remove expired ones
-  for (auto it = averageCalculatorMap.begin(),
-       it_end = averageCalculatorMap.end(); it != it_end;)
-    if (it->second.Expired(now, MAX_AGE))
-      it = averageCalculatorMap.erase(it);
-    else
-      ++it;
+  std::fill_n(index, INDEX_SIZE, 0);
+  n_items = 0;
+  expire_second = std::numeric_limits<int_least64_t>::min();
 }
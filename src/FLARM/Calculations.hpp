@@ -5,20 +5,127 @@
 
 #include "Id.hpp"
 #include "Computer/ClimbAverageCalculator.hpp"
+#include "time/Stamp.hpp"
+#include "util/IntrusiveList.hxx"
 
-#include <map>
-
-class TimeStamp;
+#include <chrono>
+#include <cstdint>
+#include <memory>
 
+/**
+ * Keeps a #ClimbAverageCalculator for each FLARM target.
+ *
+ * The items are allocated once by the constructor and are looked up
+ * with an open addressing hash table keyed like the one in
+ * #TrafficList.  Items which have
+ * not been updated for a minute are found with a time wheel (one
+ * bucket per second), so CleanUp() only looks at the items which
+ * are about to expire.  Nothing is allocated while processing
+ * traffic.
+ */
 class FlarmCalculations
 {
+public:
+  /**
+   * The maximum number of targets.  This object is not copied with
+   * the blackboard, so it is not limited by #TrafficList::MAX_COUNT;
+   * targets which drop out of the list and come back keep their
+   * history.
+   */
+  static constexpr std::size_t CAPACITY = 256;
+
 private:
-  typedef std::map<FlarmId, ClimbAverageCalculator> AverageCalculatorMap;
-  AverageCalculatorMap averageCalculatorMap;
+  static constexpr unsigned INDEX_BITS = 9;
+  static constexpr std::size_t INDEX_SIZE = std::size_t(1) << INDEX_BITS;
+  static_assert(INDEX_SIZE >= 2 * CAPACITY, "hash table too small");
+
+  static constexpr std::chrono::seconds MAX_AGE{60};
+
+  static constexpr unsigned WHEEL_SIZE = 64;
+  static_assert(WHEEL_SIZE > MAX_AGE.count(), "time wheel too small");
+
+  struct Item : IntrusiveListHook<> {
+    FlarmId id;
+
+    TimeStamp last_update;
+
+    ClimbAverageCalculator calculator;
+  };
+
+  const std::unique_ptr<Item[]> items;
+
+  /**
+   * Maps a #FlarmId to the position in #items plus one; 0 is an
+   * empty slot.
+   */
+  uint16_t index[INDEX_SIZE];
+
+  /**
+   * Each item is either in this list or in one of the #wheel
+   * buckets.
+   */
+  IntrusiveList<Item> unused;
+
+  /**
+   * The items which were last updated in the second "s" are in
+   * bucket "s % WHEEL_SIZE".
+   */
+  IntrusiveList<Item> wheel[WHEEL_SIZE];
+
+  /**
+   * The first second whose bucket has not been completely expired
+   * yet.
+   */
+  int_least64_t expire_second;
+
+  TimeStamp last_cleanup;
+
+  std::size_t n_items = 0;
 
 public:
+  FlarmCalculations() noexcept;
+  ~FlarmCalculations() noexcept;
+
+  FlarmCalculations(const FlarmCalculations &) = delete;
+  FlarmCalculations &operator=(const FlarmCalculations &) = delete;
+
+  /**
+   * Returns the number of targets which are being tracked.
+   */
+  std::size_t GetCount() const noexcept {
+    return n_items;
+  }
+
+  /**
+   * Add a sample for the given target and return its average climb
+   * rate over the past 30 seconds.  Returns 0 for new targets and if
+   * the table is full.
+   */
   double Average30s(FlarmId flarmId, TimeStamp curTime,
                     double curAltitude) noexcept;
 
+  /**
+   * Forget targets which have not been updated for a minute.  If the
+   * time goes backwards (e.g. replay restart), all targets are
+   * forgotten.
+   */
   void CleanUp(TimeStamp now) noexcept;
+
+  void Clear() noexcept;
+
+private:
+  /**
+   * Returns the hash table slot which refers to the given id, or the
+   * empty slot where it would be inserted.
+   */
+  [[gnu::pure]]
+  unsigned Probe(FlarmId id) const noexcept;
+
+  /**
+   * Remove an entry from the hash table, shifting the following
+   * entries of the probe sequence back.
+   */
+  void RemoveSlot(unsigned slot) noexcept;
+
+  void Release(Item &item) noexcept;
 };
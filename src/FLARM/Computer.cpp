@@ -7,6 +7,72 @@
 #include "Geo/GeoVector.hpp"
 #include "time/Cast.hxx"
 
+#include <cmath>
+
+/**
+ * ADS-B receivers report targets far beyond the FLARM range; those
+ * which are farther away than this (horizontally or vertically) are
+ * dropped, unless they have an alarm.
+ */
+static constexpr double REMOTE_MAX_DISTANCE = 40000;
+static constexpr double REMOTE_MAX_ALTITUDE_DIFFERENCE = 3000;
+
+static constexpr bool
+IsRemoteSource(FlarmTraffic::SourceType source) noexcept
+{
+  switch (source) {
+  case FlarmTraffic::SourceType::ADSB:
+  case FlarmTraffic::SourceType::ADSR:
+  case FlarmTraffic::SourceType::TISB:
+  case FlarmTraffic::SourceType::MODES:
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+/**
+ * Remove ADS-B targets which are out of the relevant range, before
+ * the (more expensive) per-target calculations.  This uses a
+ * flat-earth approximation with the precalculated scale factors,
+ * without trigonometry per target; that is precise enough to decide
+ * what is far away.
+ */
+static void
+CullRemoteTraffic(TrafficList &traffic, const GeoPoint &location,
+                  double north_to_latitude, double east_to_longitude,
+                  std::optional<double> ownship_altitude) noexcept
+{
+  traffic.RemoveIf([&](const FlarmTraffic &t){
+    if (!IsRemoteSource(t.source) || t.HasAlarm())
+      return false;
+
+    double north = t.relative_north, east = t.relative_east;
+    if (t.absolute_location) {
+      if (!t.location.IsValid())
+        return false;
+
+      north = (t.location.latitude - location.latitude).Degrees()
+        / north_to_latitude;
+      east = (t.location.longitude - location.longitude).AsDelta().Degrees()
+        / east_to_longitude;
+    }
+
+    if (north * north + east * east >
+        REMOTE_MAX_DISTANCE * REMOTE_MAX_DISTANCE)
+      return true;
+
+    if (!t.absolute_altitude)
+      return std::fabs(double(t.relative_altitude)) >
+        REMOTE_MAX_ALTITUDE_DIFFERENCE;
+
+    return ownship_altitude && t.altitude_available &&
+      std::fabs(double(t.altitude) - *ownship_altitude) >
+      REMOTE_MAX_ALTITUDE_DIFFERENCE;
+  });
+}
+
 void
 FlarmComputer::Process(FlarmData &flarm, const FlarmData &last_flarm,
                        const NMEAInfo &basic) noexcept
@@ -40,6 +106,10 @@ FlarmComputer::Process(FlarmData &flarm, const FlarmData &last_flarm,
     if (fabs(dlat) > 0 && fabs(dlon) > 0) {
       north_to_latitude = delta_lat.Degrees() / dlat;
       east_to_longitude = delta_lon.Degrees() / dlon;
+
+      CullRemoteTraffic(flarm.traffic, basic.location,
+                        north_to_latitude, east_to_longitude,
+                        basic.GetAnyAltitude());
     }
   }
 
@@ -43,6 +43,16 @@ public:
   friend constexpr auto operator<=>(const FlarmId &,
                                     const FlarmId &) noexcept = default;
 
+  /**
+   * Returns a hash value with the given number of bits, for open
+   * addressing hash tables (Fibonacci hashing).
+   */
+  template<unsigned bits>
+  constexpr unsigned Hash() const noexcept {
+    static_assert(bits > 0 && bits < 32);
+    return uint32_t(value * 2654435761u) >> (32 - bits);
+  }
+
   static FlarmId Parse(const char *input, char **endptr_r) noexcept;
   const char *Format(char *buffer) const noexcept;
 };
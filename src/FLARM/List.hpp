@@ -7,17 +7,33 @@
 #include "NMEA/Validity.hpp"
 #include "util/TrivialArray.hxx"
 
+#include <algorithm>
+#include <cstdint>
 #include <type_traits>
 
 /**
  * This class keeps track of the traffic objects received from a
  * FLARM device and injected online traffic merged into the same list.
+ *
+ * Lookups by #FlarmId use a small hash table which is part of this
+ * (trivial) object.  The list must therefore not be modified
+ * directly; use AllocateTraffic() and RemoveIf().
+ *
+ * This object is part of #NMEAInfo, which is copied for each device
+ * and for each merge, so its capacity is a trade-off: with 256
+ * entries it is about 27 kB (about 9 kB with the former 89 entries).
+ * When the list is full, the entries with the lowest priority are
+ * replaced (see AllocateTraffic()), so it always holds the most
+ * relevant targets for display and alerts.
  */
 struct TrafficList {
   /**
-   * Typical maximum simultaneous PFLAA targets from one FLARM device.
+   * Maximum simultaneous targets from the local receivers.  A FLARM
+   * device reports up to about 25 (PFLAA), but ADS-B receivers
+   * (GDL90, Stratux) see hundreds near busy airports; only the
+   * nearest ones are kept.
    */
-  static constexpr size_t DEVICE_MAX_COUNT = 25;
+  static constexpr size_t DEVICE_MAX_COUNT = 192;
   static constexpr size_t ONLINE_MAX_COUNT = 64;
 
   /**
@@ -31,6 +47,15 @@ struct TrafficList {
   static_assert(MAX_COUNT >= DEVICE_MAX_COUNT + ONLINE_MAX_COUNT,
                 "combined list must hold device and online traffic");
 
+  /**
+   * The number of slots in the hash table; a power of two, at least
+   * twice #MAX_COUNT to keep the probe sequences short.
+   */
+  static constexpr unsigned INDEX_BITS = 9;
+  static constexpr size_t INDEX_SIZE = size_t(1) << INDEX_BITS;
+
+  static_assert(INDEX_SIZE >= 2 * MAX_COUNT, "hash table too small");
+
   /**
    * Time stamp of the latest modification to this object.
    */
@@ -44,15 +69,24 @@ struct TrafficList {
   /** Flarm traffic information */
   TrivialArray<FlarmTraffic, MAX_COUNT> list;
 
+  /**
+   * Open addressing hash table (linear probing) which maps a
+   * #FlarmId to its position in #list plus one; 0 is an empty slot.
+   */
+  uint16_t index[INDEX_SIZE];
+
   constexpr void ClampListSize() noexcept {
-    if (list.size() > MAX_COUNT)
+    if (list.size() > MAX_COUNT) {
       list.resize(MAX_COUNT);
+      RebuildIndex();
+    }
   }
 
   constexpr void Clear() noexcept {
     modified.Clear();
     new_traffic.Clear();
     list.clear();
+    std::fill_n(index, INDEX_SIZE, 0);
   }
 
   constexpr bool IsEmpty() const noexcept {
@@ -76,6 +110,7 @@ struct TrafficList {
       /* don't bother merging the two lists, we can simply memcpy()
          it */
       list = add.list;
+      std::copy_n(add.index, INDEX_SIZE, index);
       ClampListSize();
       return;
     }
@@ -84,11 +119,15 @@ struct TrafficList {
       add.list.size() > MAX_COUNT ? MAX_COUNT : add.list.size();
     for (unsigned i = 0; i < add_count; ++i) {
       const FlarmTraffic &traffic = add.list[i];
-      if (FindTraffic(traffic.id) == nullptr) {
-        FlarmTraffic * new_traffic = AllocateTraffic();
-        if (new_traffic == nullptr)
+      const unsigned slot = Probe(traffic.id);
+      if (index[slot] == 0) {
+        /* no eviction here: the entries of both lists have been
+           selected already */
+        if (list.full())
           return;
-        *new_traffic = traffic;
+
+        list.append() = traffic;
+        index[slot] = list.size();
       }
     }
   }
@@ -99,10 +138,27 @@ struct TrafficList {
 
     ClampListSize();
 
+    RemoveIf([clock](FlarmTraffic &traffic){
+      return !traffic.Refresh(clock);
+    });
+  }
+
+  /**
+   * Remove all items for which the predicate returns true.
+   */
+  template<typename P>
+  constexpr void RemoveIf(P &&p) noexcept {
     for (unsigned i = 0; i < list.size(); ) {
-      if (!list[i].Refresh(clock))
+      if (p(list[i])) {
+        Unindex(Probe(list[i].id));
+
+        /* quick_remove() moves the last item to this position */
+        const unsigned last = list.size() - 1;
+        if (i < last)
+          index[Probe(list[last].id)] = i + 1;
+
         list.quick_remove(i);
-      else
+      } else
         ++i;
     }
   }
@@ -120,11 +176,10 @@ struct TrafficList {
   constexpr FlarmTraffic *FindTraffic(FlarmId id) noexcept {
     ClampListSize();
 
-    for (unsigned i = 0; i < list.size(); ++i)
-      if (list[i].id == id)
-        return &list[i];
-
-    return NULL;
+    const unsigned n = index[Probe(id)];
+    return n > 0
+      ? &list[n - 1]
+      : NULL;
   }
 
   /**
@@ -134,13 +189,10 @@ struct TrafficList {
    * @return the FLARM_TRAFFIC pointer, NULL if not found
    */
   constexpr const FlarmTraffic *FindTraffic(FlarmId id) const noexcept {
-    const unsigned n = list.size() > MAX_COUNT ? MAX_COUNT : list.size();
-
-    for (unsigned i = 0; i < n; ++i)
-      if (list[i].id == id)
-        return &list[i];
-
-    return NULL;
+    const unsigned n = index[Probe(id)];
+    return n > 0
+      ? &list[n - 1]
+      : NULL;
   }
 
   /**
@@ -174,16 +226,63 @@ struct TrafficList {
   }
 
   /**
-   * Allocates a new FLARM_TRAFFIC object from the array.
+   * Allocates a new FLARM_TRAFFIC object from the array and assigns
+   * the given id to it.  The caller must have checked that the id is
+   * not yet in the list (FindTraffic()).
    *
-   * @return the FLARM_TRAFFIC pointer, NULL if the array is full
+   * If the array is full, the target with the lowest priority is
+   * replaced, if it ranks below the new one: targets with an alarm
+   * are never replaced, online traffic ranks below traffic from the
+   * local receivers, and far targets rank below near ones.  Among
+   * equal ones, the least recently updated target is replaced.
+   *
+   * @param source the source of the new target
+   * @param distance the distance of the new target [m]; 0 if unknown
+   * @return the FLARM_TRAFFIC pointer, NULL if the array is full and
+   * no target ranks below the new one
    */
-  constexpr FlarmTraffic *AllocateTraffic() noexcept {
+  constexpr FlarmTraffic *
+  AllocateTraffic(FlarmId id,
+                  FlarmTraffic::SourceType source=FlarmTraffic::SourceType::FLARM,
+                  double distance=0) noexcept {
     ClampListSize();
 
-    return list.full()
-      ? NULL
-      : &list.append();
+    if (!list.full()) {
+      FlarmTraffic &traffic = list.append();
+      traffic.id = id;
+      index[Probe(id)] = list.size();
+      return &traffic;
+    }
+
+    /* the list is full; this linear scan happens only for new
+       targets */
+    const EvictionRank rank{FlarmTraffic::IsInjectedSource(source),
+                            distance * distance};
+
+    FlarmTraffic *victim = nullptr;
+    EvictionRank victim_rank{};
+    for (auto &traffic : list) {
+      if (traffic.HasAlarm())
+        continue;
+
+      const auto r = GetEvictionRank(traffic);
+      if (!rank.IsAbove(r))
+        continue;
+
+      if (victim == nullptr || victim_rank.IsAbove(r) ||
+          (!r.IsAbove(victim_rank) && traffic.valid < victim->valid)) {
+        victim = &traffic;
+        victim_rank = r;
+      }
+    }
+
+    if (victim == nullptr)
+      return NULL;
+
+    Unindex(Probe(victim->id));
+    victim->id = id;
+    index[Probe(id)] = TrafficIndex(victim) + 1;
+    return victim;
   }
 
   /**
@@ -233,6 +332,81 @@ struct TrafficList {
    * Is set if traffic is present and closer than 4Km.
    */
   bool InCloseRange() const noexcept;
+
+private:
+  /**
+   * The priority of a target when the list is full; a lower one is
+   * replaced first.
+   */
+  struct EvictionRank {
+    bool injected;
+
+    /**
+     * The squared distance [m^2].
+     */
+    double distance_squared;
+
+    /**
+     * Does this target rank above the other one?
+     */
+    constexpr bool IsAbove(const EvictionRank &other) const noexcept {
+      if (injected != other.injected)
+        return other.injected;
+
+      return distance_squared < other.distance_squared;
+    }
+  };
+
+  static constexpr EvictionRank
+  GetEvictionRank(const FlarmTraffic &traffic) noexcept {
+    return {
+      FlarmTraffic::IsInjectedSource(traffic.source),
+      traffic.relative_north * traffic.relative_north +
+      traffic.relative_east * traffic.relative_east,
+    };
+  }
+
+  /**
+   * Returns the hash table slot which refers to the given id, or
+   * the empty slot where it would be inserted.  Never loops forever,
+   * because the table is never more than half full.
+   */
+  constexpr unsigned Probe(FlarmId id) const noexcept {
+    for (unsigned i = id.Hash<INDEX_BITS>();; i = (i + 1) % INDEX_SIZE) {
+      const unsigned n = index[i];
+      if (n == 0 || list[n - 1].id == id)
+        return i;
+    }
+  }
+
+  /**
+   * Clear the given hash table slot.  Linear probing has no
+   * tombstones; instead, the following entries of the cluster which
+   * would no longer be found are moved back.
+   */
+  constexpr void Unindex(unsigned slot) noexcept {
+    index[slot] = 0;
+
+    for (unsigned i = (slot + 1) % INDEX_SIZE; index[i] != 0;
+         i = (i + 1) % INDEX_SIZE) {
+      const unsigned home = list[index[i] - 1].id.Hash<INDEX_BITS>();
+
+      /* can the entry move to the empty slot, i.e. is the empty slot
+         between its home slot and its position? */
+      if ((i - home) % INDEX_SIZE >= (i - slot) % INDEX_SIZE) {
+        index[slot] = index[i];
+        index[i] = 0;
+        slot = i;
+      }
+    }
+  }
+
+  constexpr void RebuildIndex() noexcept {
+    std::fill_n(index, INDEX_SIZE, 0);
+
+    for (unsigned i = 0; i < list.size(); ++i)
+      index[Probe(list[i].id)] = i + 1;
+  }
 };
 
 static_assert(std::is_trivial<TrafficList>::value, "type is not trivial");
@@ -70,14 +70,6 @@ FlarmTraffic::GetSourceString(SourceType source) noexcept
   return "Unknown";
 }
 
-bool
-FlarmTraffic::IsInjectedSource(SourceType source) noexcept
-{
-  return source == SourceType::OGN ||
-    source == SourceType::SKYLINES ||
-    source == SourceType::CLOUD;
-}
-
 void
 FlarmTraffic::Update(const FlarmTraffic &other) noexcept
 {
@@ -240,8 +240,11 @@ struct FlarmTraffic {
   [[gnu::const]]
   static const char *GetSourceString(SourceType source) noexcept;
 
-  [[gnu::const]]
-  static bool IsInjectedSource(SourceType source) noexcept;
+  static constexpr bool IsInjectedSource(SourceType source) noexcept {
+    return source == SourceType::OGN ||
+      source == SourceType::SKYLINES ||
+      source == SourceType::CLOUD;
+  }
 
   void Update(const FlarmTraffic &other) noexcept;
 
@@ -11,11 +11,13 @@
 
 #include <cassert>
 
-IGCWriter::IGCWriter(Path path)
+IGCWriter::IGCWriter(Path path,
+                     AsyncFileOutputStream::Duration sync_interval)
   :file(path,
         /* we use CREATE_VISIBLE here so the user can recover partial
            IGC files after a crash/battery failure/etc. */
-        FileOutputStream::Mode::CREATE_VISIBLE),
+        FileOutputStream::Mode::CREATE_VISIBLE,
+        sync_interval),
    buffered(file)
 {
   fix.Clear();
@@ -23,6 +25,13 @@ IGCWriter::IGCWriter(Path path)
   grecord.Initialize();
 }
 
+void
+IGCWriter::Close()
+{
+  buffered.Flush();
+  file.Commit();
+}
+
 void
 IGCWriter::CommitLine(std::string_view line)
 {
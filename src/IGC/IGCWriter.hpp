@@ -5,10 +5,11 @@
 
 #include "Logger/GRecord.hpp"
 #include "IGCFix.hpp"
-#include "io/FileOutputStream.hxx"
+#include "io/AsyncFileOutputStream.hpp"
 #include "io/BufferedOutputStream.hxx"
 
 #include <array>
+#include <chrono>
 #include <string_view>
 
 class Path;
@@ -18,7 +19,11 @@ struct NMEAInfo;
 struct GeoPoint;
 
 class IGCWriter {
-  FileOutputStream file;
+  /**
+   * The file is written by a separate thread, so storage latency
+   * does not stall the caller (the calculation thread).
+   */
+  AsyncFileOutputStream file;
   BufferedOutputStream buffered;
 
   GRecord grecord;
@@ -30,13 +35,30 @@ class IGCWriter {
 public:
   /**
    * Throws on error.
+   *
+   * @param sync_interval call fdatasync() if the last one is at
+   * least this long ago; see #AsyncFileOutputStream
    */
-  explicit IGCWriter(Path path);
+  explicit IGCWriter(Path path,
+                     AsyncFileOutputStream::Duration sync_interval =
+                     AsyncFileOutputStream::Duration::max());
 
+  /**
+   * Pass all buffered lines to the writer thread.  This does not
+   * wait for the storage.
+   */
   void Flush() {
     buffered.Flush();
   }
 
+  /**
+   * Flush and close the file, waiting for the writer thread to
+   * write and sync all pending data.
+   *
+   * Throws on error.
+   */
+  void Close();
+
   void Sign();
 
 private:
@@ -65,12 +65,16 @@ LoggerImpl::StopLogger([[maybe_unused]] const NMEAInfo &gps_info)
   if (writer == nullptr)
     return;
 
-  writer->Flush();
-
-  if (!simulator)
-    writer->Sign();
+  try {
+    if (!simulator)
+      writer->Sign();
 
-  writer->Flush();
+    /* wait for the writer thread; this is the only place where the
+       calculation thread waits for the storage */
+    writer->Close();
+  } catch (...) {
+    LogError(std::current_exception());
+  }
 
   LogFormat("Stopped logger: %s", filename.c_str());
 
@@ -189,9 +193,26 @@ LoggerImpl::WritePoint(const NMEAInfo &gps_info)
   writer->LogPoint(gps_info);
 }
 
+static AsyncFileOutputStream::Duration
+GetSyncInterval(LoggerSettings::IGCSync sync) noexcept
+{
+  switch (sync) {
+  case LoggerSettings::IGCSync::STOP:
+    break;
+
+  case LoggerSettings::IGCSync::PERIODIC:
+    return LoggerSettings::IGC_SYNC_PERIOD;
+
+  case LoggerSettings::IGCSync::ALWAYS:
+    return {};
+  }
+
+  return AsyncFileOutputStream::Duration::max();
+}
+
 bool
 LoggerImpl::StartLogger(const NMEAInfo &gps_info,
-                        [[maybe_unused]] const LoggerSettings &settings,
+                        const LoggerSettings &settings,
                         const char *logger_id)
 {
   assert(logger_id != nullptr);
@@ -221,7 +242,8 @@ LoggerImpl::StartLogger(const NMEAInfo &gps_info,
   frecord.Reset();
 
   try {
-    writer = std::make_unique<IGCWriter>(filename);
+    writer = std::make_unique<IGCWriter>(filename,
+                                         GetSyncInterval(settings.igc_sync));
   } catch (...) {
     LogError(std::current_exception());
     return false;
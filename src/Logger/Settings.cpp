@@ -9,6 +9,7 @@ LoggerSettings::SetDefaults()
   time_step_cruise = std::chrono::seconds{5};
   time_step_circling = std::chrono::seconds{1};
   auto_logger = AutoLogger::ON;
+  igc_sync = IGCSync::PERIODIC;
   logger_id.clear();
   pilot_name.clear();
   copilot_name.clear();
@@ -33,6 +33,22 @@ struct LoggerSettings {
     OFF,
   } auto_logger;
 
+  /**
+   * How often shall the IGC file be synced to the storage?  Each
+   * sync may take a long time on slow SD cards, but it is done by
+   * the writer thread, not by the calculation thread.
+   */
+  enum class IGCSync: uint8_t {
+    /** only when the logger stops */
+    STOP,
+    /** every #IGC_SYNC_PERIOD */
+    PERIODIC,
+    /** after every fix */
+    ALWAYS,
+  } igc_sync;
+
+  static constexpr std::chrono::seconds IGC_SYNC_PERIOD{10};
+
   StaticString<32> logger_id;
 
   StaticString<64> pilot_name;
@@ -16,4 +16,5 @@ IconLook::Initialise()
   hBmpTabSystem.LoadResource(IDB_DEVICE_ALL);
   hBmpTabRules.LoadResource(IDB_RULES_ALL);
   hBmpTabTimes.LoadResource(IDB_CLOCK_ALL);
+  hBmpTabTiming.LoadResource(IDB_STOPWATCH_ALL);
 }
@@ -20,6 +20,7 @@ struct IconLook {
   MaskedIcon hBmpTabSystem;
   MaskedIcon hBmpTabRules;
   MaskedIcon hBmpTabTimes;
+  MaskedIcon hBmpTabTiming;
 
   void Initialise();
 };
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "BaseMapTileCache.hpp"
+#include "ui/canvas/Canvas.hpp"
+
+#include <cassert>
+
+BaseMapTileCache::Tile &
+BaseMapTileCache::Use(Canvas &canvas, TilePosition position,
+                      const RenderFunction &render) noexcept
+{
+  auto [i, inserted] = tiles.try_emplace(position);
+  Tile &tile = i->second;
+
+  if (inserted) {
+    tile.buffer.Create(canvas, {TILE_SIZE + 2 * MARGIN,
+                                TILE_SIZE + 2 * MARGIN});
+    render(tile.buffer, grid.MakeTileProjection(position));
+    tile.lru = lru.insert(lru.end(), position);
+  } else
+    lru.splice(lru.end(), lru, tile.lru);
+
+  tile.last_used = frame;
+  return tile;
+}
+
+void
+BaseMapTileCache::Trim() noexcept
+{
+  while (tiles.size() > MAX_TILES) {
+    auto i = tiles.find(lru.front());
+    assert(i != tiles.end());
+
+    /* everything after this one has been drawn in this frame, too */
+    if (i->second.last_used == frame)
+      break;
+
+    lru.pop_front();
+    tiles.erase(i);
+  }
+}
+
+void
+BaseMapTileCache::Draw(Canvas &canvas, const WindowProjection &projection,
+                       const Content &content,
+                       const RenderFunction &render) noexcept
+{
+  if (grid.Update(projection, content)) {
+    tiles.clear();
+    lru.clear();
+  }
+
+  ++frame;
+
+  const auto range = grid.GetVisibleTiles(projection.GetScreenRect());
+  for (int row = range.min.row; row <= range.max.row; ++row) {
+    for (int column = range.min.column; column <= range.max.column;
+         ++column) {
+      const Tile &tile = Use(canvas, {column, row}, render);
+      canvas.Copy(grid.GetScreenPosition({column, row}),
+                  {TILE_SIZE, TILE_SIZE},
+                  tile.buffer, {MARGIN, MARGIN});
+    }
+  }
+
+  Trim();
+}
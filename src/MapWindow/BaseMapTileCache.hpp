@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "BaseMapTileGrid.hpp"
+#include "ui/canvas/BufferCanvas.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+
+/**
+ * Caches the static layers of the map (terrain and topography) in
+ * square tiles, so panning the map only needs to render the tiles
+ * which were not visible before, and the rest is copied from the
+ * cache.  The tile positions and the invalidation rules are managed
+ * by #BaseMapTileGrid.
+ *
+ * This is only used without OpenGL; with OpenGL, the GPU is fast
+ * enough to draw the map in each frame.
+ */
+class BaseMapTileCache {
+  static constexpr unsigned TILE_SIZE = BaseMapTileGrid::TILE_SIZE;
+  static constexpr unsigned MARGIN = BaseMapTileGrid::MARGIN;
+
+  /**
+   * The maximum number of tiles in #tiles.  Tiles which are on the
+   * screen are never evicted.
+   */
+  static constexpr std::size_t MAX_TILES = 48;
+
+public:
+  using Content = BaseMapTileGrid::Content;
+
+  using RenderFunction =
+    std::function<void(Canvas &canvas, const WindowProjection &projection)>;
+
+private:
+  using TilePosition = BaseMapTileGrid::TilePosition;
+
+  struct Tile {
+    BufferCanvas buffer;
+
+    /** the value of #frame when this tile was last drawn */
+    unsigned last_used;
+
+    std::list<TilePosition>::iterator lru;
+  };
+
+  BaseMapTileGrid grid;
+
+  std::map<TilePosition, Tile> tiles;
+
+  /** the keys of #tiles, least recently used first */
+  std::list<TilePosition> lru;
+
+  /** incremented by each Draw() call */
+  unsigned frame = 0;
+
+public:
+  /**
+   * Discard all tiles.  This may be called from any thread; the tiles
+   * are discarded by the next Draw() call.
+   */
+  void Flush() noexcept {
+    grid.Flush();
+  }
+
+  /**
+   * Copy the base map to the canvas.  Missing tiles are drawn by the
+   * #RenderFunction, which must fill the whole canvas passed to it.
+   */
+  void Draw(Canvas &canvas, const WindowProjection &projection,
+            const Content &content,
+            const RenderFunction &render) noexcept;
+
+private:
+  /**
+   * Look up a tile, render it if it does not exist yet, and mark it
+   * as used in this frame.
+   */
+  Tile &Use(Canvas &canvas, TilePosition position,
+            const RenderFunction &render) noexcept;
+
+  /**
+   * Evict least recently used tiles until there are no more than
+   * #MAX_TILES.
+   */
+  void Trim() noexcept;
+};
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "BaseMapTileGrid.hpp"
+
+#include <cassert>
+#include <cstdlib>
+
+bool
+BaseMapTileGrid::Content::IsCompatible(const Content &other) const noexcept
+{
+  /* small shading changes (e.g. wind direction) are ignored, just
+     like TerrainRenderer::Generate() does */
+  return terrain_settings == other.terrain_settings &&
+    shading_angle.CompareRoughly(other.shading_angle) &&
+    terrain_serial == other.terrain_serial &&
+    topography_serial == other.topography_serial &&
+    terrain == other.terrain &&
+    topography == other.topography;
+}
+
+/**
+ * Integer division rounding towards negative infinity.
+ */
+static constexpr int
+FloorDivide(int a, int b) noexcept
+{
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+bool
+BaseMapTileGrid::IsCompatible(const WindowProjection &projection,
+                              PixelPoint _offset) const noexcept
+{
+  if (grid_projection.GetScale() != projection.GetScale() ||
+      grid_projection.GetScreenAngle() != projection.GetScreenAngle())
+    return false;
+
+  /* the projection is not translation invariant; check how far the
+     grid has drifted away from the real projection at the screen
+     corners */
+  const PixelRect rc = projection.GetScreenRect();
+  for (const PixelPoint p : {rc.GetTopLeft(), rc.GetTopRight(),
+                             rc.GetBottomLeft(), rc.GetBottomRight()}) {
+    const GeoPoint g = projection.ScreenToGeo(p);
+    const PixelPoint expected = projection.GeoToScreen(g);
+    const PixelPoint actual = grid_projection.GeoToScreen(g) + _offset;
+    if (std::abs(actual.x - expected.x) > 1 ||
+        std::abs(actual.y - expected.y) > 1)
+      return false;
+  }
+
+  return true;
+}
+
+void
+BaseMapTileGrid::Reset(const WindowProjection &projection,
+                       const Content &_content) noexcept
+{
+  grid_projection = projection;
+  grid_projection.SetScreenOrigin(0, 0);
+  content = _content;
+  offset = projection.GetScreenOrigin();
+  valid = true;
+}
+
+bool
+BaseMapTileGrid::Update(const WindowProjection &projection,
+                        const Content &_content) noexcept
+{
+  assert(projection.IsValid());
+
+  if (flush_requested.exchange(false, std::memory_order_relaxed) ||
+      (valid && !content.IsCompatible(_content)))
+    valid = false;
+
+  if (valid) {
+    const PixelPoint new_offset = projection.GetScreenOrigin() -
+      grid_projection.GeoToScreen(projection.GetGeoLocation());
+    if (IsCompatible(projection, new_offset)) {
+      offset = new_offset;
+      return false;
+    }
+  }
+
+  Reset(projection, _content);
+  return true;
+}
+
+BaseMapTileGrid::TileRange
+BaseMapTileGrid::GetVisibleTiles(const PixelRect &rc) const noexcept
+{
+  assert(valid);
+
+  return {
+    {
+      FloorDivide(rc.left - offset.x, TILE_SIZE),
+      FloorDivide(rc.top - offset.y, TILE_SIZE),
+    },
+    {
+      FloorDivide(rc.right - 1 - offset.x, TILE_SIZE),
+      FloorDivide(rc.bottom - 1 - offset.y, TILE_SIZE),
+    },
+  };
+}
+
+WindowProjection
+BaseMapTileGrid::MakeTileProjection(TilePosition position) const noexcept
+{
+  assert(valid);
+
+  WindowProjection projection = grid_projection;
+  projection.SetScreenSize({TILE_SIZE + 2 * MARGIN, TILE_SIZE + 2 * MARGIN});
+  projection.SetScreenOrigin(int(MARGIN) - position.column * int(TILE_SIZE),
+                             int(MARGIN) - position.row * int(TILE_SIZE));
+  projection.UpdateScreenBounds();
+  return projection;
+}
@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "Math/Angle.hpp"
+#include "Projection/WindowProjection.hpp"
+#include "Terrain/TerrainSettings.hpp"
+#include "util/Serial.hpp"
+
+#include <atomic>
+#include <compare>
+
+/**
+ * The pixel grid of #BaseMapTileCache and the key of the tiles'
+ * contents.  It decides which tiles are visible and when all tiles
+ * must be discarded, but it does not own any pixels.
+ *
+ * The tiles are aligned to a pixel grid which is relative to an
+ * "anchor" location.  Moving the map away from the anchor slowly
+ * distorts the grid (the projection is not translation invariant),
+ * therefore the grid is reset when the error reaches one pixel.
+ * Changing the scale or the rotation resets the grid as well.
+ */
+class BaseMapTileGrid {
+public:
+  /** the width and height of a tile in pixels */
+  static constexpr unsigned TILE_SIZE = 256;
+
+  /**
+   * Tiles are rendered with this many extra pixels on each side, so
+   * symbols and labels which are located in the neighbouring tile
+   * are not cut off.
+   */
+  static constexpr unsigned MARGIN = 16;
+
+  /**
+   * Everything besides the projection which affects the contents of
+   * the tiles.  If it changes, all tiles are discarded.
+   */
+  struct Content {
+    TerrainRendererSettings terrain_settings;
+
+    /** the shading angle relative to the screen */
+    Angle shading_angle;
+
+    Serial terrain_serial;
+
+    unsigned topography_serial;
+
+    bool terrain, topography;
+
+    [[gnu::pure]]
+    bool IsCompatible(const Content &other) const noexcept;
+  };
+
+  struct TilePosition {
+    int column, row;
+
+    constexpr auto operator<=>(const TilePosition &) const noexcept = default;
+  };
+
+  /**
+   * A rectangle of tiles; both corners are inclusive.
+   */
+  struct TileRange {
+    TilePosition min, max;
+
+    constexpr unsigned GetCount() const noexcept {
+      return unsigned(max.column - min.column + 1) *
+        unsigned(max.row - min.row + 1);
+    }
+  };
+
+private:
+  /**
+   * The projection of the tile grid: the anchor location is at pixel
+   * (0,0) of tile (0,0).  Only valid if #valid is true.
+   */
+  WindowProjection grid_projection;
+
+  Content content;
+
+  /**
+   * The position of grid pixel (0,0) on the screen.  Only valid if
+   * #valid is true.
+   */
+  PixelPoint offset;
+
+  bool valid = false;
+
+  /** set by Flush(), evaluated by the next Update() call */
+  std::atomic_bool flush_requested{false};
+
+public:
+  /**
+   * Reset the grid in the next Update() call.  This may be called
+   * from any thread.
+   */
+  void Flush() noexcept {
+    flush_requested.store(true, std::memory_order_relaxed);
+  }
+
+  /**
+   * Prepare the grid for drawing the given projection.
+   *
+   * @return true if the grid has been reset, i.e. all tiles which
+   * were rendered before must be discarded
+   */
+  bool Update(const WindowProjection &projection,
+              const Content &content) noexcept;
+
+  /**
+   * Returns the tiles which intersect the given screen rectangle.
+   * Only valid after Update().
+   */
+  [[gnu::pure]]
+  TileRange GetVisibleTiles(const PixelRect &rc) const noexcept;
+
+  /**
+   * Returns the screen position of the top left pixel of the given
+   * tile (without #MARGIN).  Only valid after Update().
+   */
+  PixelPoint GetScreenPosition(TilePosition position) const noexcept {
+    return offset + PixelPoint{position.column * int(TILE_SIZE),
+                               position.row * int(TILE_SIZE)};
+  }
+
+  /**
+   * Returns the projection for rendering the given tile, including
+   * #MARGIN.  Only valid after Update().
+   */
+  [[gnu::pure]]
+  WindowProjection MakeTileProjection(TilePosition position) const noexcept;
+
+private:
+  /**
+   * Can the tile grid be used for the given projection?
+   */
+  [[gnu::pure]]
+  bool IsCompatible(const WindowProjection &projection,
+                    PixelPoint offset) const noexcept;
+
+  /**
+   * Start a new tile grid anchored at the center of the given
+   * projection.
+   */
+  void Reset(const WindowProjection &projection,
+             const Content &content) noexcept;
+};
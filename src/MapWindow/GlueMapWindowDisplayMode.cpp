@@ -18,6 +18,14 @@
 #include <algorithm> // for std::clamp()
 #include <cmath>
 
+#ifndef ENABLE_OPENGL
+/**
+ * Screen angle changes smaller than this are ignored, see
+ * GlueMapWindow::UpdateScreenAngle().
+ */
+static constexpr Angle SCREEN_ANGLE_THRESHOLD = Angle::Degrees(3);
+#endif
+
 void
 OffsetHistory::Reset() noexcept
 {
@@ -357,24 +365,36 @@ GlueMapWindow::UpdateScreenAngle() noexcept
     ? settings.circling_orientation
     : settings.cruise_orientation;
 
+  Angle angle;
   if (orientation == MapOrientation::TARGET_UP &&
       calculated.task_stats.current_leg.vector_remaining.IsValid())
-    visible_projection.SetScreenAngle(calculated.task_stats.current_leg.
-                                      vector_remaining.bearing);
+    angle = calculated.task_stats.current_leg.vector_remaining.bearing;
   else if (orientation == MapOrientation::HEADING_UP)
-    visible_projection.SetScreenAngle(
-      basic.attitude.heading_available ? basic.attitude.heading : Angle::Zero());
+    angle = basic.attitude.heading_available
+      ? basic.attitude.heading
+      : Angle::Zero();
   else if (orientation == MapOrientation::NORTH_UP)
-    visible_projection.SetScreenAngle(Angle::Zero());
+    angle = Angle::Zero();
   else if (orientation == MapOrientation::WIND_UP &&
            calculated.wind_available &&
            calculated.wind.norm >= 0.5)
-    visible_projection.SetScreenAngle(calculated.wind.bearing);
+    angle = calculated.wind.bearing;
   else
     // normal, glider forward
-    visible_projection.SetScreenAngle(
-      basic.track_available ? basic.track : Angle::Zero());
+    angle = basic.track_available ? basic.track : Angle::Zero();
+
+#ifndef ENABLE_OPENGL
+  /* while the base map tile cache is used, every rotation
+     invalidates it; ignore small changes so the map does not need to
+     be rendered from scratch each time the track wobbles */
+  if (base_map_cache_used.load(std::memory_order_relaxed) &&
+      orientation != MapOrientation::NORTH_UP &&
+      (angle - visible_projection.GetScreenAngle()).AsDelta().Absolute() <
+      SCREEN_ANGLE_THRESHOLD)
+    angle = visible_projection.GetScreenAngle();
+#endif
 
+  visible_projection.SetScreenAngle(angle);
   OnProjectionModified();
 
   compass_visible = orientation != MapOrientation::NORTH_UP;
@@ -9,6 +9,7 @@
 #include "Terrain/RasterTerrain.hpp"
 #include "Weather/Rasp/RaspRenderer.hpp"
 #include "Computer/GlideComputer.hpp"
+#include "Tracing/Tracing.hpp"
 
 #ifdef ENABLE_OPENGL
 #include "ui/canvas/opengl/Scissor.hpp"
@@ -82,6 +83,9 @@ void
 MapWindow::FlushCaches() noexcept
 {
   background.Flush();
+#ifndef ENABLE_OPENGL
+  base_map_cache.Flush();
+#endif
   if (rasp_renderer)
     rasp_renderer->Flush();
   airspace_renderer.Flush();
@@ -146,6 +150,8 @@ MapWindow::OnPaintBuffer(Canvas &canvas) noexcept
     const ScopeUnlock unlock{mutex};
 #endif
 
+    const Tracing::Scope trace{Tracing::Point::DRAW_FRAME};
+
     // Render the moving map
     Render(canvas, GetClientRect());
     draw_sw.Finish();
@@ -8,6 +8,7 @@
 #include "ui/window/DoubleBufferWindow.hpp"
 #ifndef ENABLE_OPENGL
 #include "ui/canvas/BufferCanvas.hpp"
+#include "BaseMapTileCache.hpp"
 #endif
 #include "Renderer/LabelBlock.hpp"
 #include "Screen/StopWatch.hpp"
@@ -21,6 +22,7 @@
 #include "Weather/Features.hpp"
 #include "Tracking/SkyLines/Features.hpp"
 
+#include <atomic>
 #include <memory>
 
 struct MapLook;
@@ -138,6 +140,20 @@ protected:
   const TrafficLook &traffic_look;
 
   BackgroundRenderer background;
+
+#ifndef ENABLE_OPENGL
+  /**
+   * Caches terrain and topography while no RASP layer is shown.
+   */
+  BaseMapTileCache base_map_cache;
+
+  /**
+   * Was the last frame drawn from the #base_map_cache?  Written by
+   * the DrawThread, read by the main thread.
+   */
+  std::atomic_bool base_map_cache_used{false};
+#endif
+
   WaypointRenderer waypoint_renderer;
 
   AirspaceRenderer airspace_renderer;
@@ -391,6 +407,24 @@ private:
 
   void RenderRasp(Canvas &canvas) noexcept;
 
+#ifndef ENABLE_OPENGL
+  [[gnu::pure]]
+  bool IsRaspVisible() const noexcept;
+
+  /**
+   * Shall terrain and topography be drawn from the #base_map_cache?
+   * This is only worth it if at least one of them is enabled, and
+   * it is impossible if RASP is drawn between them.
+   */
+  [[gnu::pure]]
+  bool ShouldUseBaseMapCache() const noexcept;
+
+  /**
+   * Renders terrain and topography from the #base_map_cache.
+   */
+  void RenderBaseMap(Canvas &canvas) noexcept;
+#endif
+
   void RenderTerrainAbove(Canvas &canvas, bool working) noexcept;
 
   /**
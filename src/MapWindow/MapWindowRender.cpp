@@ -12,6 +12,8 @@
 #include "Weather/SkySight/SkySightClient.hpp"
 #endif
 #include "Topography/CachedTopographyRenderer.hpp"
+#include "Topography/TopographyStore.hpp"
+#include "Terrain/RasterTerrain.hpp"
 #include "Renderer/AircraftRenderer.hpp"
 #include "Renderer/WaveRenderer.hpp"
 #include "Operation/Operation.hpp"
@@ -94,6 +96,60 @@ MapWindow::RenderRasp(Canvas &canvas) noexcept
                         map_settings.rasp_layer_opacity / 100.f);
 }
 
+#ifndef ENABLE_OPENGL
+
+bool
+MapWindow::IsRaspVisible() const noexcept
+{
+  if (rasp_store == nullptr)
+    return false;
+
+  const int map = GetUIState().weather.map;
+  return map >= 0 && unsigned(map) < rasp_store->GetItemCount();
+}
+
+bool
+MapWindow::ShouldUseBaseMapCache() const noexcept
+{
+  if (IsRaspVisible())
+    return false;
+
+  const auto &settings = GetMapSettings();
+  return (settings.terrain.enable && terrain != nullptr) ||
+    (settings.topography_enabled && topography_renderer != nullptr);
+}
+
+inline void
+MapWindow::RenderBaseMap(Canvas &canvas) noexcept
+{
+  const auto &terrain_settings = GetMapSettings().terrain;
+  background.SetShadingAngle(render_projection, terrain_settings,
+                             Calculated());
+
+  const bool draw_terrain = terrain_settings.enable && terrain != nullptr;
+  const bool draw_topography = topography_renderer != nullptr &&
+    GetMapSettings().topography_enabled;
+
+  const BaseMapTileCache::Content content{
+    terrain_settings,
+    background.GetShadingAngle(),
+    draw_terrain ? terrain->GetSerial() : Serial{},
+    draw_topography ? topography->GetSerial() : 0,
+    draw_terrain,
+    draw_topography,
+  };
+
+  base_map_cache.Draw(canvas, render_projection, content,
+                      [&](Canvas &tile_canvas,
+                          const WindowProjection &projection){
+    background.Draw(tile_canvas, projection, terrain_settings);
+    if (draw_topography)
+      topography_renderer->DrawUncached(tile_canvas, projection);
+  });
+}
+
+#endif
+
 inline void
 MapWindow::RenderTopography(Canvas &canvas) noexcept
 {
@@ -229,6 +285,19 @@ MapWindow::Render(Canvas &canvas, const PixelRect &rc) noexcept
   //////////////////////////////////////////////// items on ground
 
   // Render terrain, groundline and topography
+#ifndef ENABLE_OPENGL
+  const bool use_base_map_cache = ShouldUseBaseMapCache();
+  base_map_cache_used.store(use_base_map_cache, std::memory_order_relaxed);
+  if (use_base_map_cache) {
+    /* nothing between terrain and topography: both can be copied
+       from the tile cache */
+    draw_sw.Mark("RenderBaseMap");
+    RenderBaseMap(canvas);
+
+    /* releases the RASP renderer if the layer was switched off */
+    RenderRasp(canvas);
+  } else {
+#endif
   draw_sw.Mark("RenderTerrain");
   RenderTerrain(canvas);
 
@@ -242,6 +311,9 @@ MapWindow::Render(Canvas &canvas, const PixelRect &rc) noexcept
 
   draw_sw.Mark("RenderTopography");
   RenderTopography(canvas);
+#ifndef ENABLE_OPENGL
+  }
+#endif
 
   draw_sw.Mark("RenderOverlays");
   RenderOverlays(canvas);
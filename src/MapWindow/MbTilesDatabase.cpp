@@ -8,6 +8,7 @@
 #include "ui/canvas/custom/LibPNG.hpp"
 #include "ui/canvas/custom/UncompressedImage.hpp"
 #include "util/NumberParser.hpp"
+#include "util/ScopeExit.hxx"
 #include "util/StringSplit.hxx"
 
 #include <algorithm>
@@ -18,6 +19,7 @@
 #include <numbers>
 #include <span>
 #include <stdexcept>
+#include <string>
 #include <string_view>
 
 static constexpr double MAX_MERCATOR_LATITUDE = 85.05112878;
@@ -209,8 +211,13 @@ TileKey::GetSouthEast() const noexcept
   };
 }
 
+static constexpr const char *TILE_QUERY_WHERE =
+  " FROM tiles WHERE zoom_level=? AND tile_column=? AND tile_row=?";
+
 MbTilesDatabase::MbTilesDatabase(Path path)
-  :db(path)
+  :db(path),
+   has_tile_statement(db.CreateStatement(std::string{"SELECT 1"} + TILE_QUERY_WHERE)),
+   load_tile_statement(db.CreateStatement(std::string{"SELECT tile_data"} + TILE_QUERY_WHERE))
 {
   {
     auto stmt = db.CreateStatement("SELECT name, value FROM metadata");
@@ -251,15 +258,21 @@ MbTilesDatabase::MbTilesDatabase(Path path)
   NormaliseZoom(metadata.min_zoom, metadata.max_zoom);
 }
 
-bool
-MbTilesDatabase::HasTileUnlocked(TileKey key) const
+static void
+BindTileKey(const SqliteStatement &stmt, TileKey key) noexcept
 {
-  auto stmt = db.CreateStatement("SELECT 1 FROM tiles "
-                                 "WHERE zoom_level=? AND tile_column=? AND tile_row=?");
+  stmt.Reset();
   stmt.BindInt(1, key.zoom);
   stmt.BindInt(2, key.column);
   stmt.BindInt(3, key.row);
-  return stmt.StepRow();
+}
+
+bool
+MbTilesDatabase::HasTileUnlocked(TileKey key) const
+{
+  BindTileKey(has_tile_statement, key);
+  AtScopeExit(this) { has_tile_statement.Reset(); };
+  return has_tile_statement.StepRow();
 }
 
 bool
@@ -269,17 +282,18 @@ MbTilesDatabase::HasTile(TileKey key) const
   return HasTileUnlocked(key);
 }
 
+/**
+ * @return the decoded tile, or an undefined image if the tile does
+ * not exist
+ */
 static UncompressedImage
-LoadUncompressedTile(const SqliteDatabase &db, TileKey key)
+LoadUncompressedTile(const SqliteStatement &stmt, TileKey key)
 {
-  auto stmt = db.CreateStatement("SELECT tile_data FROM tiles "
-                                 "WHERE zoom_level=? AND tile_column=? AND tile_row=?");
-  stmt.BindInt(1, key.zoom);
-  stmt.BindInt(2, key.column);
-  stmt.BindInt(3, key.row);
+  BindTileKey(stmt, key);
+  AtScopeExit(&stmt) { stmt.Reset(); };
 
   if (!stmt.StepRow())
-    throw std::runtime_error("MBTiles tile not found");
+    return {};
 
   const auto *data = stmt.GetBlobColumn(0);
   const int size = stmt.GetBytesColumn(0);
@@ -366,17 +380,16 @@ MbTilesDatabase::SampleRgbaAtGeo(GeoPoint p, Rgba8 &pixel) const noexcept
   try {
     const std::lock_guard lock{mutex};
     const TileKey key = TileKey::FromGeoPoint(p, metadata.max_zoom);
-    if (!HasTileUnlocked(key))
-      return false;
 
     UncompressedImage image;
     try {
-      image = LoadUncompressedTile(db, key);
+      image = LoadUncompressedTile(load_tile_statement, key);
     } catch (const std::exception &) {
       return false;
     }
 
-    if (image.GetFormat() != UncompressedImage::Format::RGBA)
+    if (!image.IsDefined() ||
+        image.GetFormat() != UncompressedImage::Format::RGBA)
       return false;
 
     return SampleRgbaInImage(p, key, image, pixel);
@@ -385,11 +398,19 @@ MbTilesDatabase::SampleRgbaAtGeo(GeoPoint p, Rgba8 &pixel) const noexcept
   }
 }
 
+UncompressedImage
+MbTilesDatabase::LoadImage(TileKey key) const
+{
+  const std::lock_guard lock{mutex};
+  return LoadUncompressedTile(load_tile_statement, key);
+}
+
 Bitmap
 MbTilesDatabase::LoadTile(TileKey key) const
 {
-  const std::lock_guard lock{mutex};
-  UncompressedImage uncompressed = LoadUncompressedTile(db, key);
+  UncompressedImage uncompressed = LoadImage(key);
+  if (!uncompressed.IsDefined())
+    throw std::runtime_error("MBTiles tile not found");
 
   Bitmap bitmap;
   if (!bitmap.Load(std::move(uncompressed))) {
@@ -49,6 +49,13 @@ struct Rgba8 {
 class MbTilesDatabase {
   mutable std::mutex mutex;
   SqliteDatabase db;
+
+  /**
+   * Prepared statements, reused for each tile.  Protected by
+   * #mutex.
+   */
+  SqliteStatement has_tile_statement, load_tile_statement;
+
   MbTilesMetadata metadata;
 
   [[gnu::pure]]
@@ -72,6 +79,17 @@ public:
 
   Bitmap LoadTile(TileKey key) const;
 
+  /**
+   * Read and decode a tile image, without creating a #Bitmap.  This
+   * may be called from any thread.
+   *
+   * Throws on error.
+   *
+   * @return the image, or an undefined image if the database does
+   * not contain this tile
+   */
+  UncompressedImage LoadImage(TileKey key) const;
+
   /**
    * Sample one RGBA pixel at @p point from the tile at maximum zoom.
    */
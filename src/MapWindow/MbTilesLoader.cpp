@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "MbTilesLoader.hpp"
+#include "LogFile.hpp"
+
+#include <algorithm>
+
+MbTilesLoader::MbTilesLoader(const MbTilesDatabase &_database,
+                             std::function<void()> &&_callback) noexcept
+  :StandbyThread("MbTiles"),
+   database(_database),
+   callback(std::move(_callback)) {}
+
+MbTilesLoader::~MbTilesLoader() noexcept
+{
+  LockStop();
+}
+
+inline bool
+MbTilesLoader::IsLoadedOrLoading(TileKey key) const noexcept
+{
+  if (have_current && current == key)
+    return true;
+
+  return std::any_of(results.begin(), results.end(), [key](const auto &r){
+    return r.first == key;
+  });
+}
+
+void
+MbTilesLoader::Schedule(std::span<const Request> requests)
+{
+  const std::lock_guard lock{mutex};
+
+  queue.clear();
+  for (const auto &i : requests)
+    if (!IsLoadedOrLoading(i.key))
+      queue.push_back(i);
+
+  if (!queue.empty())
+    Trigger();
+}
+
+std::vector<MbTilesLoader::Result>
+MbTilesLoader::TakeResults() noexcept
+{
+  const std::lock_guard lock{mutex};
+  return std::exchange(results, {});
+}
+
+void
+MbTilesLoader::Tick() noexcept
+{
+  // TODO: call only once
+  SetIdlePriority();
+
+  bool notify = false;
+
+  while (!queue.empty() && !IsStopped()) {
+    const Request request = queue.front();
+    queue.erase(queue.begin());
+
+    current = request.key;
+    have_current = true;
+
+    UncompressedImage image;
+
+    {
+      const ScopeUnlock unlock(mutex);
+
+      try {
+        image = database.LoadImage(request.key);
+      } catch (...) {
+        LogError(std::current_exception(), "Failed to load MBTiles tile");
+      }
+    }
+
+    have_current = false;
+    results.emplace_back(request.key, std::move(image));
+
+    notify |= request.visible;
+
+    if (notify && (queue.empty() || !queue.front().visible) && callback) {
+      /* all visible tiles are done: redraw now, before the prefetch
+         requests are processed */
+      notify = false;
+
+      const ScopeUnlock unlock(mutex);
+      callback();
+    }
+  }
+}
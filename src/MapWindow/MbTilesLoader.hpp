@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "MbTilesDatabase.hpp"
+#include "thread/StandbyThread.hpp"
+#include "ui/canvas/custom/UncompressedImage.hpp"
+
+#include <functional>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * A thread which reads and decodes MBTiles tiles in background, so
+ * the draw thread only needs to upload the finished images.
+ */
+class MbTilesLoader final : private StandbyThread {
+public:
+  struct Request {
+    TileKey key;
+
+    /**
+     * Is this tile on the screen?  The callback is invoked after all
+     * visible tiles have been decoded; prefetched tiles are loaded
+     * silently.
+     */
+    bool visible;
+  };
+
+  /**
+   * A decoded tile.  The image is undefined if the database does not
+   * have this tile or if it could not be decoded.
+   */
+  using Result = std::pair<TileKey, UncompressedImage>;
+
+private:
+  const MbTilesDatabase &database;
+
+  const std::function<void()> callback;
+
+  /**
+   * The tiles to be loaded, most important first.  Protected by the
+   * mutex.
+   */
+  std::vector<Request> queue;
+
+  /**
+   * Decoded tiles which were not yet collected by TakeResults().
+   * Protected by the mutex.
+   */
+  std::vector<Result> results;
+
+  /**
+   * The tile which is currently being decoded, if the thread is
+   * busy.  Protected by the mutex.
+   */
+  TileKey current;
+  bool have_current = false;
+
+public:
+  MbTilesLoader(const MbTilesDatabase &_database,
+                std::function<void()> &&_callback) noexcept;
+  ~MbTilesLoader() noexcept;
+
+  /**
+   * Replace the pending requests.  Tiles which are currently being
+   * decoded or which are waiting to be collected are skipped.
+   */
+  void Schedule(std::span<const Request> requests);
+
+  /**
+   * Move all decoded tiles to the caller.
+   */
+  std::vector<Result> TakeResults() noexcept;
+
+private:
+  [[gnu::pure]]
+  bool IsLoadedOrLoading(TileKey key) const noexcept;
+
+  /* virtual methods from class StandbyThread*/
+  void Tick() noexcept override;
+};
@@ -7,15 +7,17 @@
 #include "Math/Angle.hpp"
 #include "Projection/WindowProjection.hpp"
 #include "ui/canvas/Canvas.hpp"
+#include "LogFile.hpp"
 
 #include <algorithm>
+#include <cassert>
 #include <cmath>
-#include <stdexcept>
 
-MbTilesOverlay::MbTilesOverlay(Path path, std::string _label)
-  :database(path), label(std::move(_label))
+MbTilesOverlay::MbTilesOverlay(Path path, std::string _label,
+                               std::function<void()> &&redraw_callback)
+  :database(path), label(std::move(_label)),
+   loader(database, std::move(redraw_callback))
 {
-  cached_zoom = database.GetMetadata().max_zoom;
 }
 
 unsigned
@@ -32,10 +34,8 @@ MbTilesOverlay::SelectZoom(const WindowProjection &projection) const noexcept
 }
 
 MapOverlayBitmap
-MbTilesOverlay::LoadTile(TileKey key)
+MbTilesOverlay::MakeOverlayBitmap(TileKey key, Bitmap &&bitmap) noexcept
 {
-  Bitmap bitmap = database.LoadTile(key);
-
   GeoQuadrilateral bounds{
     key.GetNorthWest(),
     key.GetNorthEast(),
@@ -48,6 +48,131 @@ MbTilesOverlay::LoadTile(TileKey key)
   return overlay;
 }
 
+void
+MbTilesOverlay::CollectLoadedTiles() noexcept
+{
+  for (auto &[key, image] : loader.TakeResults()) {
+    if (cache.contains(key))
+      continue;
+
+    std::optional<MapOverlayBitmap> bitmap;
+    std::size_t size = sizeof(CachedTile);
+
+    if (image.IsDefined()) {
+      size += image.GetPitch() * image.GetHeight();
+
+      /* the upload must happen in the draw thread, because that is
+         where the OpenGL context lives */
+      Bitmap b;
+      if (b.Load(std::move(image)))
+        bitmap.emplace(MakeOverlayBitmap(key, std::move(b)));
+      else
+        LogFmt("Failed to load MBTiles tile {}/{}/{}",
+               key.zoom, key.column, key.row);
+    }
+
+    const auto i = lru.insert(lru.end(), key);
+    cache.emplace(key, CachedTile{std::move(bitmap), size, 0, i});
+    cache_size += size;
+  }
+}
+
+MbTilesOverlay::CachedTile *
+MbTilesOverlay::Use(TileKey key) noexcept
+{
+  auto i = cache.find(key);
+  if (i == cache.end())
+    return nullptr;
+
+  CachedTile &tile = i->second;
+  lru.splice(lru.end(), lru, tile.lru);
+  tile.last_used = frame;
+  return &tile;
+}
+
+static constexpr unsigned
+ClampedSub(unsigned value, unsigned delta) noexcept
+{
+  return value > delta ? value - delta : 0;
+}
+
+static constexpr int
+Sign(int value) noexcept
+{
+  return (value > 0) - (value < 0);
+}
+
+void
+MbTilesOverlay::AddPrefetch(std::vector<MbTilesLoader::Request> &requests,
+                            const TileRange &range) const noexcept
+{
+  const std::size_t max_size = requests.size() + MAX_PREFETCH;
+
+  auto add = [&](TileKey key){
+    if (requests.size() < max_size && !cache.contains(key))
+      requests.push_back({key, false});
+  };
+
+  const unsigned scale = 1u << range.zoom;
+
+  /* in which direction is the map being panned? */
+  int dx = 0, dy = 0;
+  if (last_range && last_range->zoom == range.zoom) {
+    dx = Sign(int(range.min_column) - int(last_range->min_column));
+    dy = Sign(int(range.min_row) - int(last_range->min_row));
+  }
+
+  /* one tile around the visible range, two in the pan direction */
+  const unsigned min_column = ClampedSub(range.min_column, 1 + (dx < 0));
+  const unsigned max_column = std::min(scale - 1,
+                                       range.max_column + 1 + (dx > 0));
+  const unsigned min_row = ClampedSub(range.min_row, 1 + (dy < 0));
+  const unsigned max_row = std::min(scale - 1, range.max_row + 1 + (dy > 0));
+
+  for (unsigned row = min_row; row <= max_row; ++row)
+    for (unsigned column = min_column; column <= max_column; ++column)
+      if (!range.Contains(column, row))
+        add({range.zoom, column, row});
+
+  const auto &metadata = database.GetMetadata();
+
+  /* the next lower zoom level covers the whole visible range with a
+     quarter of the tiles */
+  if (range.zoom > metadata.min_zoom)
+    for (unsigned row = range.min_row / 2; row <= range.max_row / 2; ++row)
+      for (unsigned column = range.min_column / 2;
+           column <= range.max_column / 2; ++column)
+        add({range.zoom - 1, column, row});
+
+  /* the next higher zoom level: only the centre of the screen, which
+     is where the user zooms in */
+  if (range.zoom < metadata.max_zoom) {
+    const unsigned column = (range.min_column + range.max_column) / 2 * 2;
+    const unsigned row = (range.min_row + range.max_row) / 2 * 2;
+    add({range.zoom + 1, column, row});
+    add({range.zoom + 1, column + 1, row});
+    add({range.zoom + 1, column, row + 1});
+    add({range.zoom + 1, column + 1, row + 1});
+  }
+}
+
+void
+MbTilesOverlay::TrimCache() noexcept
+{
+  while (cache_size > MAX_CACHE_BYTES && !lru.empty()) {
+    auto i = cache.find(lru.front());
+    assert(i != cache.end());
+
+    /* everything after this one has been drawn in this frame, too */
+    if (i->second.last_used == frame)
+      break;
+
+    cache_size -= i->second.size;
+    lru.pop_front();
+    cache.erase(i);
+  }
+}
+
 bool
 MbTilesOverlay::IsInside(GeoPoint p) const noexcept
 {
@@ -63,45 +188,45 @@ MbTilesOverlay::Draw(Canvas &canvas, const WindowProjection &projection) noexcep
       !database.GetMetadata().bounds.Overlaps(screen_bounds))
     return;
 
+  ++frame;
+  CollectLoadedTiles();
+
   const unsigned zoom = SelectZoom(projection);
-  if (zoom != cached_zoom) {
-    cache.clear();
-    cached_zoom = zoom;
-  }
 
   const unsigned scale = 1u << zoom;
   const TileKey south_west_key = TileKey::FromGeoPoint(screen_bounds.GetSouthWest(), zoom);
   const TileKey north_east_key = TileKey::FromGeoPoint(screen_bounds.GetNorthEast(), zoom);
 
-  const unsigned int min_column = south_west_key.column;
-  const unsigned int max_column = std::min(scale - 1, north_east_key.column);
-  const unsigned int min_row = south_west_key.row;
-  const unsigned int max_row = std::min(scale - 1, north_east_key.row);
+  const TileRange range{
+    zoom,
+    south_west_key.column, std::min(scale - 1, north_east_key.column),
+    south_west_key.row, std::min(scale - 1, north_east_key.row),
+  };
+
+  std::vector<MbTilesLoader::Request> requests;
 
-  for (unsigned int row = min_row; row <= max_row; ++row) {
-    for (unsigned int column = min_column; column <= max_column; ++column) {
+  for (unsigned int row = range.min_row; row <= range.max_row; ++row) {
+    for (unsigned int column = range.min_column; column <= range.max_column; ++column) {
       const TileKey key{zoom, column, row};
-      auto it = cache.find(key);
-      if (it == cache.end()) {
-        try {
-          if (!database.HasTile(key)) {
-            it = cache.emplace(key, std::nullopt).first;
-          } else {
-            try {
-              it = cache.emplace(key, LoadTile(key)).first;
-            } catch (const std::exception &) {
-              it = cache.emplace(key, std::nullopt).first;
-            }
-          }
-        } catch (const std::exception &) {
-          it = cache.emplace(key, std::nullopt).first;
-        }
-      }
-
-      if (!it->second)
+      CachedTile *tile = Use(key);
+      if (tile == nullptr) {
+        requests.push_back({key, true});
         continue;
+      }
 
-      it->second->Draw(canvas, projection);
+      if (tile->bitmap)
+        tile->bitmap->Draw(canvas, projection);
     }
   }
+
+  AddPrefetch(requests, range);
+  last_range = range;
+
+  try {
+    loader.Schedule(requests);
+  } catch (...) {
+    LogError(std::current_exception(), "Failed to schedule MBTiles tiles");
+  }
+
+  TrimCache();
 }
@@ -6,24 +6,114 @@
 #include "MapWindow/OverlayBitmap.hpp"
 #include "MapWindow/Overlay.hpp"
 #include "MbTilesDatabase.hpp"
+#include "MbTilesLoader.hpp"
 #include "system/Path.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <compare>
+#include <functional>
+#include <list>
 #include <map>
 #include <optional>
 #include <string>
+#include <vector>
 
 class MbTilesOverlay : public MapOverlay {
+  /**
+   * The maximum total size of the decoded tiles in #cache.  Tiles
+   * which are on the screen are never evicted.
+   */
+  static constexpr std::size_t MAX_CACHE_BYTES = 32 * 1024 * 1024;
+
+  /**
+   * The maximum number of tiles which are prefetched per frame.
+   */
+  static constexpr std::size_t MAX_PREFETCH = 64;
+
+  struct CachedTile {
+    /**
+     * The tile bitmap, or std::nullopt if the database does not have
+     * this tile (or if it could not be loaded).
+     */
+    std::optional<MapOverlayBitmap> bitmap;
+
+    /** the approximate memory usage of #bitmap in bytes */
+    std::size_t size;
+
+    /** the value of #frame when this tile was last drawn */
+    unsigned last_used;
+
+    std::list<TileKey>::iterator lru;
+  };
+
+  /**
+   * A rectangular range of tiles on one zoom level.
+   */
+  struct TileRange {
+    unsigned zoom;
+    unsigned min_column, max_column;
+    unsigned min_row, max_row;
+
+    constexpr bool Contains(unsigned column, unsigned row) const noexcept {
+      return column >= min_column && column <= max_column &&
+        row >= min_row && row <= max_row;
+    }
+  };
+
   MbTilesDatabase database;
   std::string label;
-  unsigned cached_zoom = 0;
-  std::map<TileKey, std::optional<MapOverlayBitmap>> cache;
+
+  std::map<TileKey, CachedTile> cache;
+
+  /** the keys of #cache, least recently used first */
+  std::list<TileKey> lru;
+
+  /** the sum of all CachedTile::size values */
+  std::size_t cache_size = 0;
+
+  /** incremented by each Draw() call */
+  unsigned frame = 0;
+
+  /** the visible tiles of the previous Draw() call */
+  std::optional<TileRange> last_range;
+
+  /**
+   * Decodes tiles in background.  Declared after #database, because
+   * its destructor stops the thread which accesses the database.
+   */
+  MbTilesLoader loader;
 
   [[gnu::pure]]
   unsigned SelectZoom(const WindowProjection &projection) const noexcept;
 
-  MapOverlayBitmap LoadTile(TileKey key);
+  static MapOverlayBitmap MakeOverlayBitmap(TileKey key,
+                                            Bitmap &&bitmap) noexcept;
+
+  /**
+   * Upload the tiles which were decoded by the #loader and add them
+   * to the #cache.
+   */
+  void CollectLoadedTiles() noexcept;
+
+  /**
+   * Look up a tile in the #cache and mark it as used in this frame.
+   */
+  CachedTile *Use(TileKey key) noexcept;
+
+  /**
+   * Append prefetch requests for the tiles around the visible ones
+   * (more of them in the pan direction) and for the adjacent zoom
+   * levels.
+   */
+  void AddPrefetch(std::vector<MbTilesLoader::Request> &requests,
+                   const TileRange &range) const noexcept;
+
+  /**
+   * Evict least recently used tiles until the #cache fits into
+   * #MAX_CACHE_BYTES.
+   */
+  void TrimCache() noexcept;
 
 protected:
   const MbTilesDatabase &
@@ -39,7 +129,13 @@ protected:
   }
 
 public:
-  MbTilesOverlay(Path path, std::string _label);
+  /**
+   * @param redraw_callback invoked (from the loader thread) after
+   * tiles which are on the screen have been decoded; it should
+   * schedule a map redraw
+   */
+  MbTilesOverlay(Path path, std::string _label,
+                 std::function<void()> &&redraw_callback = {});
 
   const char *GetLabel() const noexcept override {
     return label.c_str();
@@ -59,6 +59,8 @@ Profile::Load(const ProfileMap &map, LoggerSettings &settings)
                                 LoggerSettings::AutoLogger::ON;
   }
 
+  map.GetEnum(ProfileKeys::LoggerSync, settings.igc_sync);
+
   map.Get(ProfileKeys::LoggerID, settings.logger_id);
   map.Get(ProfileKeys::PilotName, settings.pilot_name);
   map.Get(ProfileKeys::CoPilotName, settings.copilot_name);
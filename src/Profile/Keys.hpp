@@ -215,6 +215,7 @@ constexpr std::string_view ShowFAITriangleAreas = "ShowFAITriangleAreas";
 constexpr std::string_view FAITriangleThreshold = "FAITriangleThreshold";
 constexpr std::string_view AutoLogger = "AutoLogger";
 constexpr std::string_view DisableAutoLogger = "DisableAutoLogger";
+constexpr std::string_view LoggerSync = "LoggerSync";
 constexpr std::string_view EnableFlightLogger = "EnableFlightLogger";
 constexpr std::string_view EnableNMEALogger = "EnableNMEALogger";
 constexpr std::string_view MapFile = "MapFile"; // pL
@@ -58,6 +58,14 @@ public:
                        const DerivedInfo &calculated) noexcept;
   void SetTerrain(const RasterTerrain *terrain) noexcept;
 
+  /**
+   * Returns the shading angle which will be used by the next Draw()
+   * call.
+   */
+  Angle GetShadingAngle() const noexcept {
+    return shading_angle;
+  }
+
   /**
    * Returns true if contour lines are currently being rendered (not
    * suppressed due to extreme zoom-out, and terrain renderer exists).
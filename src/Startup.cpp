@@ -575,7 +575,7 @@ Startup(UI::Display &display)
     sub_env.SetText(_("Loading Waypoints..."));
     WaypointGlue::LoadWaypoints(*data_components->waypoints,
                                 data_components->terrain.get(),
-                                sub_env);
+                                file_cache, sub_env);
   }
 
   // Read and parse the airfield info file
@@ -0,0 +1,417 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "Terrain/CompressedRasterBuffer.hpp"
+#include "Terrain/RasterBuffer.hpp"
+#include "io/BufferedOutputStream.hxx"
+#include "io/BufferedReader.hxx"
+#include "util/SpanCast.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <stdexcept>
+
+#include <stdlib.h>
+
+static constexpr unsigned
+ZigZagEncode(int value) noexcept
+{
+  return value >= 0
+    ? unsigned(value) << 1
+    : (unsigned(-value) << 1) - 1;
+}
+
+static constexpr int
+ZigZagDecode(unsigned value) noexcept
+{
+  return (value & 1) != 0
+    ? -int((value + 1) >> 1)
+    : int(value >> 1);
+}
+
+/**
+ * Invoke the function with the zigzag-encoded difference of each
+ * pixel of a block, in the order they are stored.
+ */
+template<typename F>
+static void
+ForEachDifference(const TerrainHeight *src, std::size_t stride,
+                  unsigned width, unsigned height, F &&f) noexcept
+{
+  int row_base = src->GetValue();
+
+  for (unsigned y = 0; y < height; ++y, src += stride) {
+    int previous = src[0].GetValue();
+    f(ZigZagEncode(previous - row_base));
+    row_base = previous;
+
+    for (unsigned x = 1; x < width; ++x) {
+      const int value = src[x].GetValue();
+      f(ZigZagEncode(value - previous));
+      previous = value;
+    }
+  }
+}
+
+class BitWriter {
+  uint32_t *p;
+  uint64_t buffer = 0;
+  unsigned n_bits = 0;
+
+public:
+  explicit constexpr BitWriter(uint32_t *_p) noexcept:p(_p) {}
+
+  void Write(unsigned value, unsigned width) noexcept {
+    buffer |= uint64_t(value) << n_bits;
+    n_bits += width;
+
+    if (n_bits >= 32) {
+      *p++ = uint32_t(buffer);
+      buffer >>= 32;
+      n_bits -= 32;
+    }
+  }
+
+  void Flush() noexcept {
+    if (n_bits > 0)
+      *p = uint32_t(buffer);
+  }
+};
+
+class BitReader {
+  const uint32_t *p;
+  uint64_t buffer = 0;
+  unsigned n_bits = 0;
+
+public:
+  explicit constexpr BitReader(const uint32_t *_p) noexcept:p(_p) {}
+
+  unsigned Read(unsigned width) noexcept {
+    if (n_bits < width) {
+      buffer |= uint64_t(*p++) << n_bits;
+      n_bits += 32;
+    }
+
+    const unsigned value = unsigned(buffer) & ((1u << width) - 1);
+    buffer >>= width;
+    n_bits -= width;
+    return value;
+  }
+};
+
+/**
+ * Read one value at the specified bit position.  There must be one
+ * more word after the one containing the value.
+ */
+[[gnu::pure]]
+static unsigned
+Extract(const uint32_t *data, std::size_t bit, unsigned width) noexcept
+{
+  const uint32_t *p = data + bit / 32;
+  const uint64_t value = p[0] | (uint64_t(p[1]) << 32);
+  return unsigned(value >> (bit % 32)) & ((1u << width) - 1);
+}
+
+void
+CompressedRasterBuffer::Reset() noexcept
+{
+  size = {0, 0};
+  blocks = nullptr;
+  data = nullptr;
+}
+
+inline std::size_t
+CompressedRasterBuffer::GetBlockWords(unsigned bx, unsigned by,
+                                      unsigned width) const noexcept
+{
+  const unsigned x = bx << BLOCK_BITS, y = by << BLOCK_BITS;
+  const std::size_t n_pixels = std::size_t(std::min(BLOCK_SIZE, size.x - x))
+    * std::min(BLOCK_SIZE, size.y - y);
+  return (n_pixels * width + 31) / 32;
+}
+
+void
+CompressedRasterBuffer::Compress(const RasterBuffer &src) noexcept
+{
+  assert(src.IsDefined());
+
+  size = src.GetSize();
+  n_block_columns = (size.x + BLOCK_SIZE - 1) >> BLOCK_BITS;
+  const unsigned n_block_rows = GetBlockRows();
+  blocks.ResizeDiscard(n_block_columns * n_block_rows);
+
+  /* first pass: determine the number of bits per block */
+
+  std::size_t n_words = 0;
+  for (unsigned by = 0, i = 0; by < n_block_rows; ++by) {
+    const unsigned y = by << BLOCK_BITS;
+    const unsigned height = std::min(BLOCK_SIZE, size.y - y);
+
+    for (unsigned bx = 0; bx < n_block_columns; ++bx, ++i) {
+      const unsigned x = bx << BLOCK_BITS;
+      const unsigned width = std::min(BLOCK_SIZE, size.x - x);
+      const TerrainHeight *top_left = src.GetDataAt({x, y});
+
+      unsigned mask = 0;
+      ForEachDifference(top_left, size.x, width, height,
+                        [&mask](unsigned value){ mask |= value; });
+
+      Block &block = blocks[i];
+      block.offset = n_words;
+      block.base = top_left->GetValue();
+      block.width = std::bit_width(mask);
+
+      n_words += GetBlockWords(bx, by, block.width);
+    }
+  }
+
+  /* second pass: pack the differences */
+
+  data.ResizeDiscard(n_words + 1);
+  data[n_words] = 0;
+
+  for (unsigned by = 0, i = 0; by < n_block_rows; ++by) {
+    const unsigned y = by << BLOCK_BITS;
+    const unsigned height = std::min(BLOCK_SIZE, size.y - y);
+
+    for (unsigned bx = 0; bx < n_block_columns; ++bx, ++i) {
+      const Block &block = blocks[i];
+      if (block.width == 0)
+        continue;
+
+      const unsigned x = bx << BLOCK_BITS;
+      const unsigned width = std::min(BLOCK_SIZE, size.x - x);
+
+      BitWriter writer{data.data() + block.offset};
+      ForEachDifference(src.GetDataAt({x, y}), size.x, width, height,
+                        [&writer, &block](unsigned value){
+                          writer.Write(value, block.width);
+                        });
+      writer.Flush();
+    }
+  }
+}
+
+void
+CompressedRasterBuffer::Decompress(RasterBuffer &dest) const noexcept
+{
+  assert(IsDefined());
+
+  dest.Resize(size);
+
+  const unsigned n_block_rows = GetBlockRows();
+  for (unsigned by = 0, i = 0; by < n_block_rows; ++by) {
+    const unsigned y = by << BLOCK_BITS;
+    const unsigned height = std::min(BLOCK_SIZE, size.y - y);
+
+    for (unsigned bx = 0; bx < n_block_columns; ++bx, ++i) {
+      const Block &block = blocks[i];
+      const unsigned x = bx << BLOCK_BITS;
+      const unsigned width = std::min(BLOCK_SIZE, size.x - x);
+
+      TerrainHeight *row = dest.GetData() + std::size_t(y) * size.x + x;
+
+      if (block.width == 0) {
+        /* all pixels are equal */
+        for (unsigned j = 0; j < height; ++j, row += size.x)
+          std::fill_n(row, width, TerrainHeight(block.base));
+        continue;
+      }
+
+      BitReader reader{data.data() + block.offset};
+      int row_base = block.base;
+      for (unsigned j = 0; j < height; ++j, row += size.x) {
+        row_base += ZigZagDecode(reader.Read(block.width));
+        row[0] = TerrainHeight(int16_t(row_base));
+
+        int value = row_base;
+        for (unsigned k = 1; k < width; ++k) {
+          value += ZigZagDecode(reader.Read(block.width));
+          row[k] = TerrainHeight(int16_t(value));
+        }
+      }
+    }
+  }
+}
+
+void
+CompressedRasterBuffer::Save(BufferedOutputStream &os) const
+{
+  assert(IsDefined());
+
+  const uint32_t n_words = data.size() - 1;
+  os.WriteT(size);
+  os.WriteT(n_words);
+
+  /* write the attributes one by one, to avoid writing the padding
+     bytes of struct Block */
+  for (const Block &block : blocks) {
+    os.WriteT(block.offset);
+    os.WriteT(block.base);
+    os.WriteT(block.width);
+  }
+
+  os.Write(std::as_bytes(std::span{data.data(), n_words}));
+}
+
+void
+CompressedRasterBuffer::Load(BufferedReader &r)
+{
+  Reset();
+
+  const auto new_size = r.ReadFullT<RasterLocation>();
+  const auto n_words = r.ReadFullT<uint32_t>();
+  if (new_size.x < 1 || new_size.x > 16 * 1024 ||
+      new_size.y < 1 || new_size.y > 16 * 1024 ||
+      n_words > std::size_t(new_size.x) * new_size.y)
+    throw std::runtime_error("Malformed compressed raster header");
+
+  size = new_size;
+  n_block_columns = (size.x + BLOCK_SIZE - 1) >> BLOCK_BITS;
+  const unsigned n_block_rows = GetBlockRows();
+
+  try {
+    blocks.ResizeDiscard(n_block_columns * n_block_rows);
+
+    for (unsigned by = 0, i = 0; by < n_block_rows; ++by) {
+      for (unsigned bx = 0; bx < n_block_columns; ++bx, ++i) {
+        Block &block = blocks[i];
+        r.ReadFullT(block.offset);
+        r.ReadFullT(block.base);
+        r.ReadFullT(block.width);
+
+        /* verify that Get() will not read out of bounds */
+        if (block.width > 17 ||
+            block.offset + GetBlockWords(bx, by, block.width) > n_words)
+          throw std::runtime_error("Malformed compressed raster block");
+      }
+    }
+
+    data.ResizeDiscard(n_words + 1);
+    r.ReadFull(std::as_writable_bytes(std::span{data.data(), n_words}));
+    data[n_words] = 0;
+  } catch (...) {
+    Reset();
+    throw;
+  }
+}
+
+inline CompressedRasterBuffer::BlockLocation
+CompressedRasterBuffer::LocateBlock(RasterLocation p) const noexcept
+{
+  assert(p.x < size.x);
+  assert(p.y < size.y);
+
+  const unsigned bx = p.x >> BLOCK_BITS, by = p.y >> BLOCK_BITS;
+  const unsigned x = bx << BLOCK_BITS, y = by << BLOCK_BITS;
+
+  return {
+    blocks[by * n_block_columns + bx],
+    std::min(BLOCK_SIZE, size.x - x),
+    p.x - x, p.y - y,
+  };
+}
+
+TerrainHeight
+CompressedRasterBuffer::Get(RasterLocation p) const noexcept
+{
+  const auto l = LocateBlock(p);
+  const Block &block = l.block;
+  if (block.width == 0)
+    return TerrainHeight(block.base);
+
+  const std::size_t first_bit = std::size_t(block.offset) * 32;
+  const auto read = [this, first_bit, &block](unsigned index){
+    return ZigZagDecode(Extract(data.data(),
+                                first_bit + std::size_t(index) * block.width,
+                                block.width));
+  };
+
+  /* go down the first column, then along the row */
+  int value = block.base;
+  for (unsigned y = 1; y <= l.y; ++y)
+    value += read(y * l.width);
+
+  const unsigned row = l.y * l.width;
+  for (unsigned x = 1; x <= l.x; ++x)
+    value += read(row + x);
+
+  return TerrainHeight(int16_t(value));
+}
+
+TerrainHeight
+CompressedRasterBuffer::GetInterpolated(unsigned lx, unsigned ly,
+                                        unsigned ix, unsigned iy) const noexcept
+{
+  assert(IsDefined());
+  assert(lx < size.x);
+  assert(ly < size.y);
+  assert(ix < 0x100);
+  assert(iy < 0x100);
+
+  // perform piecewise linear interpolation
+  const unsigned dx = (lx == size.x - 1) ? 0 : 1;
+  const unsigned dy = (ly == size.y - 1) ? 0 : 1;
+
+  const TerrainHeight h = Get({lx, ly});
+  const TerrainHeight h_x = Get({lx + dx, ly});
+  const TerrainHeight h_y = Get({lx, ly + dy});
+  const TerrainHeight h_xy = Get({lx + dx, ly + dy});
+
+  if (h.IsSpecial() || h_x.IsSpecial() ||
+      h_y.IsSpecial() || h_xy.IsSpecial())
+    return h;
+
+  unsigned kx = 0x100 - ix;
+  unsigned ky = 0x100 - iy;
+
+  return TerrainHeight((h.GetValue() * kx * ky
+                        + h_x.GetValue() * ix * ky
+                        + h_y.GetValue() * kx * iy
+                        + h_xy.GetValue() * ix * iy) >> 16);
+}
+
+void
+CompressedRasterBuffer::ScanLine(RasterLocation a, RasterLocation b,
+                                 TerrainHeight *buffer,
+                                 unsigned n, bool interpolate) const noexcept
+{
+  assert(a.x < GetFineSize().x);
+  assert(a.y < GetFineSize().y);
+  assert(b.x < GetFineSize().x);
+  assert(b.y < GetFineSize().y);
+  assert(buffer != nullptr);
+  assert(n > 0);
+
+  if (n == 1) {
+    *buffer = Get(a >> RasterTraits::SUBPIXEL_BITS);
+    return;
+  }
+
+  --n;
+  const IntPoint2D d(b.x - a.x, b.y - a.y);
+
+  /* disable interpolation when an output pixel is larger than two
+     pixels (three for horizontal lines), just like
+     RasterBuffer::ScanLine() does */
+  const unsigned max_distance = a.y == b.y ? 3 * (n + 1) : 2 * n;
+  if (interpolate &&
+      unsigned(abs(d.x) + abs(d.y)) < (max_distance << RasterTraits::SUBPIXEL_BITS)) {
+    for (int i = 0; (unsigned)i <= n; ++i) {
+      const auto [cx, ix] =
+        RasterTraits::CalcSubpixel(a.x + (i * d.x) / (int)n);
+      const auto [cy, iy] =
+        RasterTraits::CalcSubpixel(a.y + (i * d.y) / (int)n);
+
+      *buffer++ = GetInterpolated(cx, cy, ix, iy);
+    }
+  } else {
+    for (int i = 0; (unsigned)i <= n; ++i) {
+      const RasterLocation c(a.x + (i * d.x) / (int)n,
+                             a.y + (i * d.y) / (int)n);
+
+      *buffer++ = Get(c >> RasterTraits::SUBPIXEL_BITS);
+    }
+  }
+}
@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "RasterTraits.hpp"
+#include "RasterLocation.hpp"
+#include "Height.hpp"
+#include "util/AllocatedArray.hxx"
+
+#include <cstddef>
+#include <cstdint>
+
+class RasterBuffer;
+class BufferedOutputStream;
+class BufferedReader;
+
+/**
+ * A compressed copy of a #RasterBuffer which uses a fraction of its
+ * memory.
+ *
+ * The raster is split into blocks of 16x16 pixels.  Each pixel is
+ * stored as the difference to its left neighbour (the first pixel of
+ * a row: to the first pixel of the row above), zigzag-encoded and
+ * packed with the number of bits needed by the largest difference in
+ * the block.  Smooth terrain needs only a few bits per pixel.
+ *
+ * Pixels can be read without decompressing the whole buffer, at the
+ * cost of adding up to 30 differences.
+ */
+class CompressedRasterBuffer {
+  static constexpr unsigned BLOCK_BITS = 4;
+  static constexpr unsigned BLOCK_SIZE = 1u << BLOCK_BITS;
+
+  struct Block {
+    /**
+     * The position of the first difference in #data (in words).
+     */
+    uint32_t offset;
+
+    /**
+     * The value of the top-left pixel.
+     */
+    int16_t base;
+
+    /**
+     * The number of bits per difference (0..17).
+     */
+    uint8_t width;
+  };
+
+  RasterLocation size{0, 0};
+
+  /**
+   * The number of blocks per row.
+   */
+  unsigned n_block_columns;
+
+  AllocatedArray<Block> blocks;
+
+  /**
+   * The bit-packed differences of all blocks.  There is one extra
+   * word at the end, which allows reading two words at any position.
+   */
+  AllocatedArray<uint32_t> data;
+
+public:
+  CompressedRasterBuffer() noexcept = default;
+
+  CompressedRasterBuffer(CompressedRasterBuffer &&) noexcept = default;
+  CompressedRasterBuffer &operator=(CompressedRasterBuffer &&) noexcept = default;
+
+  bool IsDefined() const noexcept {
+    return size.x > 0 && size.y > 0;
+  }
+
+  RasterLocation GetSize() const noexcept {
+    return size;
+  }
+
+  RasterLocation GetFineSize() const noexcept {
+    return GetSize() << RasterTraits::SUBPIXEL_BITS;
+  }
+
+  /**
+   * Returns the number of bytes allocated by this object.
+   */
+  std::size_t GetMemoryUsage() const noexcept {
+    return blocks.size() * sizeof(Block) + data.size() * sizeof(data[0]);
+  }
+
+  void Reset() noexcept;
+
+  void Compress(const RasterBuffer &src) noexcept;
+
+  /**
+   * Decompress all pixels into the given buffer (which will be
+   * resized).
+   */
+  void Decompress(RasterBuffer &dest) const noexcept;
+
+  /**
+   * Write the compressed data (in host byte order) to the stream.
+   *
+   * Throws on error.
+   */
+  void Save(BufferedOutputStream &os) const;
+
+  /**
+   * Load data which was written by Save().
+   *
+   * Throws on error, including malformed data.
+   */
+  void Load(BufferedReader &r);
+
+  [[gnu::pure]]
+  TerrainHeight Get(RasterLocation p) const noexcept;
+
+  /**
+   * @see RasterBuffer::GetInterpolated()
+   */
+  [[gnu::pure]]
+  TerrainHeight GetInterpolated(unsigned lx, unsigned ly,
+                                unsigned ix, unsigned iy) const noexcept;
+
+  /**
+   * @see RasterBuffer::ScanLine()
+   */
+  void ScanLine(RasterLocation a, RasterLocation b,
+                TerrainHeight *buffer, unsigned size,
+                bool interpolate) const noexcept;
+
+private:
+  unsigned GetBlockRows() const noexcept {
+    return (size.y + BLOCK_SIZE - 1) >> BLOCK_BITS;
+  }
+
+  /**
+   * Returns the number of words occupied by the differences of the
+   * specified block.
+   */
+  [[gnu::pure]]
+  std::size_t GetBlockWords(unsigned bx, unsigned by,
+                            unsigned width) const noexcept;
+
+  struct BlockLocation {
+    const Block &block;
+
+    /**
+     * The width of this block (may be smaller than #BLOCK_SIZE at the
+     * right edge).
+     */
+    unsigned width;
+
+    /**
+     * The position within the block.
+     */
+    unsigned x, y;
+  };
+
+  [[gnu::pure]]
+  BlockLocation LocateBlock(RasterLocation p) const noexcept;
+};
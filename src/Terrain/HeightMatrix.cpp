@@ -3,6 +3,8 @@
 
 #include "HeightMatrix.hpp"
 #include "RasterMap.hpp"
+#include "ScrollBuffer.hpp"
+#include "thread/ParallelFor.hpp"
 
 #ifdef ENABLE_OPENGL
 #include "Geo/GeoBounds.hpp"
@@ -12,6 +14,11 @@
 
 #include <cassert>
 
+/**
+ * Each thread scans at least this number of rows.
+ */
+static constexpr unsigned MIN_ROWS_PER_THREAD = 16;
+
 void
 HeightMatrix::FillGradient(UnsignedPoint2D _size,
                            int16_t min_h, int16_t max_h,
@@ -31,6 +38,12 @@ HeightMatrix::FillGradient(UnsignedPoint2D _size,
                   (int)(vertical ? y : x) / divisor));
 }
 
+void
+HeightMatrix::Scroll(int dx, int dy) noexcept
+{
+  ScrollBuffer(data.data(), size.x, size, dx, dy);
+}
+
 void
 HeightMatrix::SetSize(std::size_t _size) noexcept
 {
@@ -66,28 +79,54 @@ HeightMatrix::SetSize(UnsignedPoint2D _size,
 
 void
 HeightMatrix::Fill(const RasterMap &map, const GeoBounds &bounds,
-                   const UnsignedPoint2D _size, bool interpolate) noexcept
+                   const UnsignedPoint2D _size, bool interpolate,
+                   unsigned n_threads) noexcept
 {
   if (_size.x == 0 || _size.y == 0)
     return;
 
   SetSize(_size);
 
-  const Angle delta_y = bounds.GetHeight() / _size.y;
-  Angle latitude = bounds.GetNorth();
-  for (auto p = data.data(), end = p + _size.Area();
-       p != end; p += _size.x, latitude -= delta_y) {
-    map.ScanLine(GeoPoint(bounds.GetWest(), latitude),
-                 GeoPoint(bounds.GetEast(), latitude),
-                 p, _size.x, interpolate);
-  }
+  Fill(map, bounds, {0, 0}, _size, interpolate, n_threads);
+}
+
+void
+HeightMatrix::Fill(const RasterMap &map, const GeoBounds &bounds,
+                   const UnsignedPoint2D begin, const UnsignedPoint2D end,
+                   bool interpolate, unsigned n_threads) noexcept
+{
+  assert(begin.x < end.x && end.x <= size.x);
+  assert(begin.y < end.y && end.y <= size.y);
+
+  const Angle delta_x = bounds.GetWidth() / size.x;
+  const Angle delta_y = bounds.GetHeight() / size.y;
+
+  const Angle west = bounds.GetWest() + delta_x * begin.x;
+  const Angle east = end.x == size.x
+    ? bounds.GetEast()
+    : bounds.GetWest() + delta_x * end.x;
+  const unsigned width = end.x - begin.x;
+
+  /* RasterMap::ScanLine() is const and only reads the tile cache, so
+     rows can be scanned in parallel */
+  ParallelFor(end.y - begin.y, n_threads, MIN_ROWS_PER_THREAD,
+              [&](unsigned first, unsigned last){
+                for (unsigned y = begin.y + first; y < begin.y + last; ++y) {
+                  const Angle latitude = bounds.GetNorth() - delta_y * y;
+                  map.ScanLine(GeoPoint(west, latitude),
+                               GeoPoint(east, latitude),
+                               data.data() + y * size.x + begin.x,
+                               width, interpolate);
+                }
+              });
 }
 
 #else
 
 void
 HeightMatrix::Fill(const RasterMap &map, const WindowProjection &projection,
-                   unsigned quantisation_pixels, bool interpolate) noexcept
+                   unsigned quantisation_pixels, bool interpolate,
+                   unsigned n_threads) noexcept
 {
   if (quantisation_pixels < 1)
     quantisation_pixels = 1;
@@ -98,13 +137,18 @@ HeightMatrix::Fill(const RasterMap &map, const WindowProjection &projection,
 
   SetSize((UnsignedPoint2D)screen_size, quantisation_pixels);
 
-  auto p = data.data();
-  for (unsigned y = 0; y < screen_size.height;
-       y += quantisation_pixels, p += size.x) {
-    map.ScanLine(projection.ScreenToGeo({0, (int)y}),
-                 projection.ScreenToGeo({(int)screen_size.width, (int)y}),
-                 p, size.x, interpolate);
-  }
+  /* RasterMap::ScanLine() is const and only reads the tile cache, so
+     rows can be scanned in parallel */
+  ParallelFor(size.y, n_threads, MIN_ROWS_PER_THREAD,
+              [&](unsigned begin, unsigned end){
+                auto p = data.data() + begin * size.x;
+                for (unsigned row = begin; row < end; ++row, p += size.x) {
+                  const int y = row * quantisation_pixels;
+                  map.ScanLine(projection.ScreenToGeo({0, y}),
+                               projection.ScreenToGeo({(int)screen_size.width, y}),
+                               p, size.x, interpolate);
+                }
+              });
 }
 
 #endif
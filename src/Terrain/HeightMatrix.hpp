@@ -35,17 +35,42 @@ public:
 #ifdef ENABLE_OPENGL
   /**
    * Copy values from the #RasterMap to the buffer, north-up only.
+   *
+   * @param n_threads the maximum number of threads scanning rows in
+   * parallel
    */
   void Fill(const RasterMap &map, const GeoBounds &bounds,
-            UnsignedPoint2D _size, bool interpolate) noexcept;
+            UnsignedPoint2D _size, bool interpolate,
+            unsigned n_threads=1) noexcept;
+
+  /**
+   * Copy values from the #RasterMap to the cells [begin, end), e.g.
+   * the ones which were exposed by Scroll().  The size is unchanged.
+   *
+   * @param bounds the area covered by the whole matrix
+   */
+  void Fill(const RasterMap &map, const GeoBounds &bounds,
+            UnsignedPoint2D begin, UnsignedPoint2D end,
+            bool interpolate, unsigned n_threads=1) noexcept;
 #else
   /**
    * @param interpolate true enables interpolation of sub-pixel values
+   * @param n_threads the maximum number of threads scanning rows in
+   * parallel
    */
   void Fill(const RasterMap &map, const WindowProjection &map_projection,
-            unsigned quantisation_pixels, bool interpolate) noexcept;
+            unsigned quantisation_pixels, bool interpolate,
+            unsigned n_threads=1) noexcept;
 #endif
 
+  /**
+   * Move the contents: cell (x, y) receives the value of cell
+   * (x + dx, y + dy).  The cells whose source is outside of the
+   * matrix keep their old values; the caller is responsible for
+   * filling them.
+   */
+  void Scroll(int dx, int dy) noexcept;
+
   /**
    * Make height matrix with a gradient from min_h to max_h, default left-right
    */
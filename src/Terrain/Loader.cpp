@@ -307,7 +307,7 @@ LoadTerrainOverview(struct zzip_dir *dir,
 
 inline void
 TerrainLoader::UpdateTiles(struct zzip_dir *dir, const char *path,
-                           SignedRasterLocation p, unsigned radius)
+                           std::span<const RasterTileRegion> regions)
 {
   assert(!scan_overview);
 
@@ -316,7 +316,7 @@ TerrainLoader::UpdateTiles(struct zzip_dir *dir, const char *path,
        RasterTileCache::PollTiles() calls RasterTile::Unload() */
     const std::lock_guard lock{mutex};
 
-    if (!raster_tile_cache.PollTiles(p, radius))
+    if (!raster_tile_cache.PollTiles(regions))
       /* nothing to do */
       return;
   }
@@ -328,14 +328,23 @@ TerrainLoader::UpdateTiles(struct zzip_dir *dir, const char *path,
 void
 UpdateTerrainTiles(struct zzip_dir *dir, const char *path,
                    RasterTileCache &raster_tile_cache, SharedMutex &mutex,
-                   SignedRasterLocation p, unsigned radius)
+                   std::span<const RasterTileRegion> regions)
 {
   if (!raster_tile_cache.IsValid())
     return;
 
   NullOperationEnvironment env;
   TerrainLoader loader(mutex, raster_tile_cache, false, true, env);
-  loader.UpdateTiles(dir, path, p, radius);
+  loader.UpdateTiles(dir, path, regions);
+}
+
+void
+UpdateTerrainTiles(struct zzip_dir *dir, const char *path,
+                   RasterTileCache &raster_tile_cache, SharedMutex &mutex,
+                   SignedRasterLocation p, unsigned radius)
+{
+  const RasterTileRegion region{p, radius, 0};
+  UpdateTerrainTiles(dir, path, raster_tile_cache, mutex, {&region, 1});
 }
 
 void
@@ -7,10 +7,12 @@
 #include "thread/SharedMutex.hpp"
 
 #include <cstdint>
+#include <span>
 
 struct zzip_dir;
 struct GeoPoint;
 class RasterTileCache;
+struct RasterTileRegion;
 class RasterProjection;
 class OperationEnvironment;
 
@@ -47,7 +49,7 @@ public:
    * Throws on error.
    */
   void UpdateTiles(struct zzip_dir *dir, const char *path,
-                   SignedRasterLocation p, unsigned radius);
+                   std::span<const RasterTileRegion> regions);
 
   /* callback methods for libjasper (via jas_rtc.cpp) */
 
@@ -98,6 +100,25 @@ LoadTerrainOverview(struct zzip_dir *dir,
                       tile_cache, false, env);
 }
 
+/**
+ * Load the tiles within the given regions.  Tiles of regions with a
+ * lower priority value are loaded first.
+ *
+ * Throws on error.
+ */
+void
+UpdateTerrainTiles(struct zzip_dir *dir, const char *path,
+                   RasterTileCache &raster_tile_cache, SharedMutex &mutex,
+                   std::span<const RasterTileRegion> regions);
+
+static inline void
+UpdateTerrainTiles(struct zzip_dir *dir,
+                   RasterTileCache &tile_cache, SharedMutex &mutex,
+                   std::span<const RasterTileRegion> regions)
+{
+  UpdateTerrainTiles(dir, "terrain.jp2", tile_cache, mutex, regions);
+}
+
 /**
  * Throws on error.
  */
@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "Pack.hpp"
+#include "RasterTileCache.hpp"
+#include "io/FileReader.hxx"
+#include "io/FileOutputStream.hxx"
+#include "io/BufferedReader.hxx"
+#include "io/BufferedOutputStream.hxx"
+#include "util/ScopeExit.hxx"
+#include "util/SpanCast.hxx"
+
+#include <stdexcept>
+
+/*
+ * File layout:
+ *
+ * - PackHeader
+ * - the overview (RasterTileCache::SaveCache())
+ * - the compressed tiles (CompressedRasterBuffer::Save())
+ * - the directory: one 64 bit file offset per tile
+ * - PackTrailer
+ */
+
+static constexpr uint32_t PACK_MAGIC = 0x4b505458; // "XTPK"
+
+struct PackHeader {
+  static constexpr uint32_t VERSION = 1;
+
+  uint32_t magic, version;
+
+  /**
+   * The size of the "terrain.jp2" the pack was generated from.
+   */
+  uint64_t source_size;
+};
+
+struct PackTrailer {
+  uint64_t directory_offset;
+  uint32_t n_tiles, magic;
+};
+
+static_assert(sizeof(PackHeader) == 16, "unexpected padding");
+static_assert(sizeof(PackTrailer) == 16, "unexpected padding");
+
+TerrainPack::TerrainPack(Path _path, uint_least64_t source_size,
+                         RasterTileCache &rtc)
+  :path(_path)
+{
+  FileReader file(path);
+
+  const auto file_size = file.GetSize();
+  if (file_size < sizeof(PackHeader) + sizeof(PackTrailer))
+    throw std::runtime_error("Terrain pack is too small");
+
+  file.Seek(file_size - sizeof(PackTrailer));
+  PackTrailer trailer;
+  file.ReadT(trailer);
+  if (trailer.magic != PACK_MAGIC ||
+      trailer.directory_offset > file_size - sizeof(PackTrailer) ||
+      trailer.n_tiles * sizeof(uint64_t) !=
+      file_size - sizeof(PackTrailer) - trailer.directory_offset)
+    throw std::runtime_error("Malformed terrain pack trailer");
+
+  file.Rewind();
+
+  {
+    BufferedReader r(file);
+    const auto header = r.ReadFullT<PackHeader>();
+    if (header.magic != PACK_MAGIC ||
+        header.version != PackHeader::VERSION)
+      throw std::runtime_error("Unsupported terrain pack");
+
+    if (header.source_size != source_size)
+      throw std::runtime_error("Terrain pack does not match the map file");
+
+    rtc.LoadCache(r);
+  }
+
+  if (trailer.n_tiles != rtc.GetTileCount())
+    throw std::runtime_error("Wrong number of tiles in terrain pack");
+
+  directory.ResizeDiscard(trailer.n_tiles);
+  file.Seek(trailer.directory_offset);
+  file.ReadFull(std::as_writable_bytes(std::span{directory}));
+
+  for (const auto offset : directory)
+    if (offset >= trailer.directory_offset)
+      throw std::runtime_error("Malformed terrain pack directory");
+}
+
+void
+TerrainPack::UpdateTiles(RasterTileCache &rtc, SharedMutex &mutex,
+                         std::span<const RasterTileRegion> regions) const
+{
+  {
+    /* this write lock is necessary because
+       RasterTileCache::PollTiles() calls RasterTile::Unload() */
+    const std::lock_guard lock{mutex};
+
+    if (!rtc.PollTiles(regions))
+      /* nothing to do */
+      return;
+  }
+
+  AtScopeExit(&rtc) { rtc.FinishTileUpdate(); };
+
+  FileReader file(path);
+
+  for (unsigned i = 0; i < directory.size(); ++i) {
+    if (directory[i] == 0 || !rtc.IsTileRequested(i))
+      continue;
+
+    /* read without holding the lock */
+    CompressedRasterBuffer data;
+    file.Seek(directory[i]);
+    BufferedReader r(file);
+    data.Load(r);
+
+    const std::lock_guard lock{mutex};
+    rtc.PutCompressedTileData(i, std::move(data));
+  }
+}
+
+void
+WriteTerrainPack(Path path, const RasterTileCache &rtc,
+                 uint_least64_t source_size)
+{
+  FileOutputStream file(path);
+  BufferedOutputStream os(file);
+
+  PackHeader header;
+  header.magic = PACK_MAGIC;
+  header.version = PackHeader::VERSION;
+  header.source_size = source_size;
+  os.WriteT(header);
+
+  rtc.SaveCache(os);
+
+  AllocatedArray<uint64_t> directory(rtc.GetTileCount());
+  for (unsigned i = 0; i < directory.size(); ++i) {
+    const auto *tile = rtc.GetCompressedTile(i);
+    if (tile == nullptr) {
+      directory[i] = 0;
+      continue;
+    }
+
+    os.Flush();
+    directory[i] = file.Tell();
+    tile->Save(os);
+  }
+
+  os.Flush();
+
+  PackTrailer trailer;
+  trailer.directory_offset = file.Tell();
+  trailer.n_tiles = directory.size();
+  trailer.magic = PACK_MAGIC;
+
+  os.Write(std::as_bytes(std::span{directory}));
+  os.WriteT(trailer);
+  os.Flush();
+  file.Commit();
+}
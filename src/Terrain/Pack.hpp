@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "system/Path.hpp"
+#include "thread/SharedMutex.hpp"
+#include "util/AllocatedArray.hxx"
+
+#include <cstdint>
+#include <span>
+
+class RasterTileCache;
+struct RasterTileRegion;
+
+/**
+ * A terrain pack is a file next to the map file (with the suffix
+ * ".xtp") which contains the overview and all tiles of the map's
+ * terrain, already decoded from JPEG2000 and compressed with
+ * #CompressedRasterBuffer.  Loading tiles from it is much faster than
+ * decoding JPEG2000.  Packs are generated on a PC with the program
+ * "PackTerrain".
+ *
+ * The file is stored in host byte order; a pack generated on a
+ * machine with a different byte order is rejected.
+ */
+class TerrainPack {
+  AllocatedPath path;
+
+  /**
+   * The file offset of each tile; 0 if the tile is not in the pack.
+   */
+  AllocatedArray<uint64_t> directory;
+
+public:
+  /**
+   * Open the pack and load the overview into the #RasterTileCache.
+   *
+   * Throws on error.
+   *
+   * @param source_size the size of the "terrain.jp2" inside the map
+   * file; the pack is rejected if it was generated from a different
+   * file
+   */
+  TerrainPack(Path _path, uint_least64_t source_size,
+              RasterTileCache &rtc);
+
+  /**
+   * Load the tiles within the given regions, just like
+   * UpdateTerrainTiles().
+   *
+   * Throws on error.
+   */
+  void UpdateTiles(RasterTileCache &rtc, SharedMutex &mutex,
+                   std::span<const RasterTileRegion> regions) const;
+};
+
+/**
+ * Write a terrain pack containing the overview and all loaded tiles
+ * of the #RasterTileCache.
+ *
+ * Throws on error.
+ *
+ * @param source_size the size of the "terrain.jp2" the terrain was
+ * loaded from
+ */
+void
+WriteTerrainPack(Path path, const RasterTileCache &rtc,
+                 uint_least64_t source_size);
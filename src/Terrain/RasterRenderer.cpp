@@ -3,7 +3,9 @@
 
 #include "Terrain/RasterRenderer.hpp"
 #include "Terrain/RasterMap.hpp"
+#include "Terrain/ScrollBuffer.hpp"
 #include "Math/Constants.hpp"
+#include "Math/Util.hpp"
 #include "Screen/Layout.hpp"
 #include "ui/canvas/Ramp.hpp"
 #include "ui/canvas/Color.hpp"
@@ -12,6 +14,8 @@
 #include "Projection/WindowProjection.hpp"
 #include "ui/event/Idle.hpp"
 #include "LogFile.hpp"
+#include "thread/ParallelFor.hpp"
+#include "util/Compiler.h"
 
 #ifdef ENABLE_OPENGL
 #include "ui/canvas/opengl/Globals.hpp"
@@ -24,6 +28,8 @@
 #include <algorithm> // for std::clamp()
 #include <cassert>
 #include <cstdint>
+#include <thread>
+#include <utility> // for std::exchange()
 
 /**
  * Constants for terrain rendering thresholds and quantisation limits.
@@ -134,6 +140,13 @@ ContourInterval(const TerrainHeight h, const unsigned contour_height_scale)
   return ContourInterval(h.GetValue(), contour_height_scale);
 }
 
+/**
+ * A value in RasterRenderer::contour_intervals for pixels which never
+ * get a contour line: "special" pixels and, with slope shading, their
+ * neighbours.  ContourInterval() never returns this value.
+ */
+static constexpr uint8_t NO_CONTOUR = 0xff;
+
 struct ColumnContourPending {
   unsigned until_row;
   RawColor color;
@@ -181,7 +194,16 @@ ApplyContourExpansion(RawColor *p,
   }
 }
 
-RasterRenderer::RasterRenderer() noexcept = default;
+/**
+ * The default maximum number of threads for ScanMap() and
+ * GenerateImage().
+ */
+static constexpr unsigned MAX_THREADS = 4;
+
+RasterRenderer::RasterRenderer() noexcept
+  :n_threads(std::clamp(std::thread::hardware_concurrency(), 1u, MAX_THREADS))
+{
+}
 
 RasterRenderer::~RasterRenderer() noexcept
 {
@@ -230,8 +252,8 @@ RasterRenderer::BindAndGetTexture() const noexcept
 #endif
 
 void
-RasterRenderer::ScanMap(const RasterMap &map,
-                        const WindowProjection &projection) noexcept
+RasterRenderer::UpdateEffectiveQuantisation(const RasterMap &map,
+                                            const WindowProjection &projection) noexcept
 {
   // GeoPoint corresponding to the MapWindow center
   GeoPoint center = projection.ScreenToGeo(projection.GetScreenCenter());
@@ -285,54 +307,214 @@ RasterRenderer::ScanMap(const RasterMap &map,
        would suffer with reasonable quantisation */
     quantisation_effective = 0;
   }
+}
+
+#ifdef ENABLE_OPENGL
+
+/**
+ * Calculate the size of the height matrix for the given projection.
+ */
+[[gnu::pure]]
+static UnsignedPoint2D
+CalculateMatrixSize(const WindowProjection &projection,
+                    unsigned quantisation_pixels) noexcept
+{
+  return (UnsignedPoint2D)projection.GetScreenSize()
+    * static_cast<unsigned>(BOUNDS_SCALE_FACTOR * 128.0f + 0.5f)
+    / quantisation_pixels / 128;
+}
+
+/**
+ * VC4 (and other GLES2 GPUs) reject textures larger than
+ * GL_MAX_TEXTURE_SIZE (often 2048).  q=1 at 1080p with
+ * BOUNDS_SCALE_FACTOR can request ~2880 wide → GL_INVALID_VALUE on
+ * TexSubImage and a black map.
+ */
+[[gnu::pure]]
+static UnsignedPoint2D
+ClampToMaxTextureSize(UnsignedPoint2D matrix_size) noexcept
+{
+  const unsigned max_texture = OpenGL::max_texture_size > 0
+    ? OpenGL::max_texture_size
+    : OpenGL::DEFAULT_MAX_TEXTURE_SIZE;
+  if (matrix_size.x <= max_texture && matrix_size.y <= max_texture)
+    return matrix_size;
+
+  const double scale = std::min(double(max_texture) / matrix_size.x,
+                                double(max_texture) / matrix_size.y);
+  return {
+    std::max(1u, unsigned(matrix_size.x * scale)),
+    std::max(1u, unsigned(matrix_size.y * scale)),
+  };
+}
+
+#endif
+
+void
+RasterRenderer::ScanMap(const RasterMap &map,
+                        const WindowProjection &projection) noexcept
+{
+  UpdateEffectiveQuantisation(map, projection);
+  scrolled = false;
 
 #ifdef ENABLE_OPENGL
   bounds = projection.GetScreenBounds().Scale(BOUNDS_SCALE_FACTOR);
   bounds.IntersectWith(map.GetBounds());
 
   UnsignedPoint2D matrix_size =
-    (UnsignedPoint2D)projection.GetScreenSize()
-    * static_cast<unsigned>(BOUNDS_SCALE_FACTOR * 128.0f + 0.5f)
-    / quantisation_pixels / 128;
+    CalculateMatrixSize(projection, quantisation_pixels);
   if (matrix_size.x == 0 || matrix_size.y == 0) {
     quantisation_effective = 0;
     return;
   }
 
-  /* VC4 (and other GLES2 GPUs) reject textures larger than
-     GL_MAX_TEXTURE_SIZE (often 2048).  q=1 at 1080p with
-     BOUNDS_SCALE_FACTOR can request ~2880 wide → GL_INVALID_VALUE
-     on TexSubImage and a black map. */
-  const unsigned max_texture = OpenGL::max_texture_size > 0
-    ? OpenGL::max_texture_size
-    : OpenGL::DEFAULT_MAX_TEXTURE_SIZE;
-  if (matrix_size.x > max_texture || matrix_size.y > max_texture) {
-    const double scale = std::min(double(max_texture) / matrix_size.x,
-                                  double(max_texture) / matrix_size.y);
-    const unsigned clamped_x =
-      std::max(1u, unsigned(matrix_size.x * scale));
-    const unsigned clamped_y =
-      std::max(1u, unsigned(matrix_size.y * scale));
+  if (const auto clamped = ClampToMaxTextureSize(matrix_size);
+      clamped != matrix_size) {
     LogFmt("Terrain: clamp matrix {}x{} -> {}x{} (max texture {})",
-           matrix_size.x, matrix_size.y, clamped_x, clamped_y,
-           max_texture);
-    matrix_size = {clamped_x, clamped_y};
+           matrix_size.x, matrix_size.y, clamped.x, clamped.y,
+           OpenGL::max_texture_size > 0
+           ? OpenGL::max_texture_size
+           : OpenGL::DEFAULT_MAX_TEXTURE_SIZE);
+    matrix_size = clamped;
   }
 
-  height_matrix.Fill(map, bounds, matrix_size, true);
+  height_matrix.Fill(map, bounds, matrix_size, true, n_threads);
 
   ClampQuantisationEffectiveToMatrix(quantisation_effective,
                                      height_matrix.GetSize());
 
   last_quantisation_pixels = quantisation_pixels;
 #else
-  height_matrix.Fill(map, projection, quantisation_pixels, true);
+  height_matrix.Fill(map, projection, quantisation_pixels, true,
+                    n_threads);
 
   ClampQuantisationEffectiveToMatrix(quantisation_effective,
                                      height_matrix.GetSize());
 #endif
 }
 
+#ifdef ENABLE_OPENGL
+
+bool
+RasterRenderer::ScrollMap(const RasterMap &map,
+                          const WindowProjection &projection) noexcept
+{
+  if (image == nullptr || !bounds.IsValid() ||
+      quantisation_pixels != last_quantisation_pixels)
+    return false;
+
+  const UnsignedPoint2D matrix_size = height_matrix.GetSize();
+  if (ClampToMaxTextureSize(CalculateMatrixSize(projection,
+                                                quantisation_pixels))
+      != matrix_size)
+    return false;
+
+  /* move the bounds by whole cells, so the cells which remain
+     visible keep their values */
+  const Angle cell_width = bounds.GetWidth() / matrix_size.x;
+  const Angle cell_height = bounds.GetHeight() / matrix_size.y;
+  const GeoBounds screen_bounds = projection.GetScreenBounds();
+  const GeoPoint old_center = bounds.GetCenter();
+  const GeoPoint new_center = screen_bounds.GetCenter();
+  const int dx = iround((new_center.longitude - old_center.longitude)
+                        .AsDelta() / cell_width);
+  const int dy = iround((old_center.latitude - new_center.latitude)
+                        .AsDelta() / cell_height);
+
+  /* beyond half of the size, regenerating everything is cheaper */
+  if ((dx == 0 && dy == 0) ||
+      unsigned(std::abs(dx)) * 2 > matrix_size.x ||
+      unsigned(std::abs(dy)) * 2 > matrix_size.y)
+    return false;
+
+  const GeoBounds new_bounds{
+    GeoPoint{bounds.GetWest() + cell_width * dx,
+             bounds.GetNorth() - cell_height * dy},
+    GeoPoint{bounds.GetEast() + cell_width * dx,
+             bounds.GetSouth() - cell_height * dy},
+  };
+
+  /* the new bounds must cover the screen, and they must not need to
+     be clipped at the edge of the map (ScanMap() would shrink the
+     cells) */
+  if (!new_bounds.IsInside(screen_bounds) ||
+      !map.GetBounds().IsInside(new_bounds))
+    return false;
+
+  UpdateEffectiveQuantisation(map, projection);
+  ClampQuantisationEffectiveToMatrix(quantisation_effective, matrix_size);
+
+  bounds = new_bounds;
+  height_matrix.Scroll(dx, dy);
+
+  RawColor *const top_row = image->GetTopRow();
+  ScrollBuffer(top_row, image->GetNextRow(top_row) - top_row,
+               matrix_size, dx, dy);
+
+  /* GenerateContours() looks up the intervals of the pixels next to
+     the regenerated area */
+  if (contour_intervals.size() >= matrix_size.Area())
+    ScrollBuffer(contour_intervals.data(), matrix_size.x,
+                 matrix_size, dx, dy);
+
+  /* scan the exposed rows and columns; ScanLine() needs at least two
+     columns */
+
+  const unsigned abs_dx = std::abs(dx), abs_dy = std::abs(dy);
+  const unsigned rows_top = dy > 0 ? matrix_size.y - abs_dy : 0;
+  const unsigned rows_bottom = dy < 0 ? abs_dy : matrix_size.y;
+
+  if (dy > 0)
+    height_matrix.Fill(map, bounds, {0, rows_top}, matrix_size,
+                       true, n_threads);
+  else if (dy < 0)
+    height_matrix.Fill(map, bounds, {0, 0}, {matrix_size.x, rows_bottom},
+                       true, n_threads);
+
+  if (dx != 0) {
+    const unsigned n_columns = std::max(abs_dx, 2u);
+    const unsigned left = dx > 0 ? matrix_size.x - n_columns : 0;
+    const unsigned top = dy < 0 ? rows_bottom : 0;
+    const unsigned bottom = dy > 0 ? rows_top : matrix_size.y;
+    if (top < bottom)
+      height_matrix.Fill(map, bounds, {left, top},
+                         {left + n_columns, bottom},
+                         true, n_threads);
+  }
+
+  /* the pixels next to the exposed area need to be regenerated as
+     well, because their slope and contours depend on their
+     neighbours; and so do the pixels which were moved to the
+     opposite edge, because pixels at the edge are shaded
+     differently */
+  const int margin = quantisation_effective + contour_thickness + 1;
+  const int width = matrix_size.x, height = matrix_size.y;
+  const int top_rows = std::min(dy < 0 ? int(abs_dy) + margin : margin,
+                                height);
+  const int bottom_rows = std::min(dy > 0 ? int(abs_dy) + margin : margin,
+                                   height);
+  const int left_columns = std::min(dx < 0 ? int(abs_dx) + margin : margin,
+                                    width);
+  const int right_columns = std::min(dx > 0 ? int(abs_dx) + margin : margin,
+                                     width);
+
+  scroll_dirty.clear();
+  if (dy != 0) {
+    scroll_dirty.push_back({0, 0, width, top_rows});
+    scroll_dirty.push_back({0, height - bottom_rows, width, height});
+  }
+
+  if (dx != 0) {
+    scroll_dirty.push_back({0, 0, left_columns, height});
+    scroll_dirty.push_back({width - right_columns, 0, width, height});
+  }
+
+  scrolled = true;
+  return true;
+}
+
+#endif
+
 void
 RasterRenderer::FillGradient(UnsignedPoint2D size,
                              int16_t min_h, int16_t max_h,
@@ -349,9 +531,13 @@ RasterRenderer::GenerateImage(bool do_shading,
                               const Angle sunazimuth,
                               unsigned contour_spacing) noexcept
 {
+  bool incremental = std::exchange(scrolled, false);
+
   if (image == nullptr ||
       height_matrix.GetSize().x > image->GetSize().width ||
       height_matrix.GetSize().y > image->GetSize().height) {
+    incremental = false;
+
     delete image;
     image = new RawBitmap(PixelSize{height_matrix.GetSize()});
 
@@ -388,98 +574,111 @@ RasterRenderer::GenerateImage(bool do_shading,
                / (quantisation_pixels * 1024u))
     : 1;
 
-  ContourStart(contour_height_scale);
+  if (contour_height_scale < 16) {
+    if (contour_intervals.size() < height_matrix.GetSize().Area())
+      incremental = false;
+
+    contour_intervals.GrowDiscard(height_matrix.GetSize().Area());
+  }
+
+  /* after ScrollMap(), only the exposed parts need to be generated,
+     unless something else has changed since the last call */
+  const ImageParameters parameters{
+    do_shading, height_scale, contrast, brightness, sunazimuth,
+    contour_height_scale, contour_thickness,
+    quantisation_effective, pixel_size,
+  };
+  if (last_image_parameters != parameters)
+    incremental = false;
+  last_image_parameters = parameters;
+
+  if (incremental) {
+    for (const PixelRect &rc : scroll_dirty)
+      GenerateImage(do_shading, height_scale, contrast, brightness,
+                    sunazimuth, contour_height_scale, rc);
+  } else
+    GenerateImage(do_shading, height_scale, contrast, brightness,
+                  sunazimuth, contour_height_scale,
+                  PixelRect{PixelSize{height_matrix.GetSize()}});
+
+  image->SetDirty();
+}
 
+void
+RasterRenderer::GenerateImage(bool do_shading,
+                              unsigned height_scale,
+                              int contrast, int brightness,
+                              const Angle sunazimuth,
+                              unsigned contour_height_scale,
+                              const PixelRect &rc) noexcept
+{
   if (do_shading)
     GenerateSlopeImage(height_scale, contrast, brightness,
-                       sunazimuth, contour_height_scale);
+                       sunazimuth, contour_height_scale, rc);
   else
-    GenerateUnshadedImage(height_scale, contour_height_scale);
-
-  image->SetDirty();
+    GenerateUnshadedImage(height_scale, contour_height_scale, rc);
+
+  if (contour_height_scale < 16) {
+    /* thick contour lines extend into neighbouring pixels; redraw the
+       contour lines around the rectangle, too, to restore those which
+       reach into it */
+    const UnsignedPoint2D matrix_size = height_matrix.GetSize();
+    PixelRect contour_rc = rc;
+    contour_rc.Grow(contour_thickness - 1);
+    contour_rc.left = std::max(contour_rc.left, 0);
+    contour_rc.top = std::max(contour_rc.top, 0);
+    contour_rc.right = std::min(contour_rc.right, int(matrix_size.x));
+    contour_rc.bottom = std::min(contour_rc.bottom, int(matrix_size.y));
+
+    ContourStart(contour_height_scale, contour_rc);
+    GenerateContours(height_scale, contour_height_scale, contour_rc);
+  }
 }
 
+/**
+ * Each thread shades at least this number of rows.
+ */
+static constexpr unsigned MIN_ROWS_PER_THREAD = 32;
+
 void
 RasterRenderer::GenerateUnshadedImage(const unsigned height_scale,
-                                      const unsigned contour_height_scale) noexcept
+                                      const unsigned contour_height_scale,
+                                      const PixelRect &rc) noexcept
 {
-  const auto *src = height_matrix.GetData();
+  const UnsignedPoint2D matrix_size = height_matrix.GetSize();
   const RawColor *oColorBuf = color_table + 64 * 256;
-  RawColor *dest = image->GetTopRow();
-  const ptrdiff_t row_stride =
-    image->GetNextRow(dest) - dest;
-  const unsigned matrix_width = height_matrix.GetSize().x;
-  const unsigned contour_tl = contour_thickness / 2;
-  const unsigned contour_br = (contour_thickness - 1) / 2;
-
-  for (unsigned y = height_matrix.GetSize().y; y > 0; --y) {
-    RawColor *p = dest;
-    dest = image->GetNextRow(dest);
-
-    const unsigned current_row =
-      height_matrix.GetSize().y - y;
-
-    unsigned contour_row_base = ContourInterval(*src, contour_height_scale);
-    unsigned char *contour_this_column_base = contour_column_base;
-
-    for (unsigned x = matrix_width; x > 0; --x) {
-      const auto e = *src++;
-      const unsigned col = matrix_width - x;
-
-      // Check if pixel is claimed by a prior contour expansion
-      if (contour_br > 0 &&
-          contour_pending[col].until_row > 0 &&
-          current_row <= contour_pending[col].until_row)
-        [[unlikely]] {
-        *p++ = contour_pending[col].color;
-        if (!e.IsSpecial()) {
-          const unsigned ci = ContourInterval(
-            std::max(0, (int)e.GetValue()),
-            contour_height_scale);
-          *contour_this_column_base =
-            contour_row_base = ci;
-        }
-        contour_this_column_base++;
-        continue;
-      }
-
-      if (!e.IsSpecial()) [[likely]] {
-        unsigned h = std::max(0, (int)e.GetValue());
-
-        const unsigned contour_interval =
-          ContourInterval(h, contour_height_scale);
-
-        h = std::min(254u, h >> height_scale);
-        if (contour_interval != contour_row_base ||
-            contour_interval != *contour_this_column_base) [[unlikely]] {
-          const RawColor contour_color =
-            oColorBuf[(int)h - 64 * 256];
-
-          if (contour_thickness > 1)
-            ApplyContourExpansion(
-              p, row_stride,
-              col, current_row, matrix_width,
-              contour_tl, contour_br,
-              contour_color, contour_pending);
-          else
-            *p = contour_color;
-
-          ++p;
-          *contour_this_column_base = contour_row_base = contour_interval;
-        } else {
-          *p++ = oColorBuf[h];
-        }
-      } else if (e.IsWater()) {
-        // we're in the water, so look up the color for water
-        *p++ = oColorBuf[255];
-      } else {
-        /* outside the terrain file bounds */
-        *p++ = oColorBuf[255];
-      }
-      contour_this_column_base++;
-
-    }
-  }
+  RawColor *const top_row = image->GetTopRow();
+  const ptrdiff_t row_stride = image->GetNextRow(top_row) - top_row;
+
+  const bool contours = contour_height_scale < 16;
+  uint8_t *const intervals = contours ? contour_intervals.data() : nullptr;
+
+  ParallelFor(rc.GetHeight(), n_threads, MIN_ROWS_PER_THREAD,
+              [&](unsigned begin, unsigned end){
+                for (unsigned y = rc.top + begin; y < rc.top + end; ++y) {
+                  const auto *src = height_matrix.GetRow(y);
+                  RawColor *p = top_row + ptrdiff_t(y) * row_stride;
+                  uint8_t *row_intervals = intervals != nullptr
+                    ? intervals + y * matrix_size.x
+                    : nullptr;
+
+                  for (unsigned x = rc.left; x < unsigned(rc.right); ++x) {
+                    const auto e = src[x];
+                    if (!e.IsSpecial()) [[likely]] {
+                      const unsigned h = std::max(0, (int)e.GetValue());
+                      p[x] = oColorBuf[std::min(254u, h >> height_scale)];
+                      if (row_intervals != nullptr)
+                        row_intervals[x] =
+                          ContourInterval(h, contour_height_scale);
+                    } else {
+                      /* water or outside the terrain file bounds */
+                      p[x] = oColorBuf[255];
+                      if (row_intervals != nullptr)
+                        row_intervals[x] = NO_CONTOUR;
+                    }
+                  }
+                }
+              });
 }
 
 /**
@@ -500,11 +699,90 @@ ClipHeightDelta(TerrainHeight a, TerrainHeight b) noexcept
   return ClipHeightDelta(a.GetValue() - b.GetValue());
 }
 
+namespace {
+
+/**
+ * The slope shading formula with the parameters which are constant
+ * for the whole image.
+ */
+struct SlopeShading {
+  int sx, sy, sz;
+  int contrast;
+
+  /**
+   * Calculate the illumination of one pixel.  This is branch-free,
+   * so the compiler can vectorise loops calling it.
+   *
+   * @param dd0 the horizontal height difference multiplied with the
+   * vertical distance
+   * @param dd1 the vertical height difference multiplied with the
+   * horizontal distance
+   * @param dd2 the product of both distances and the height slope
+   * factor
+   * @return the illumination index (-63..63)
+   */
+  [[gnu::always_inline]]
+  int operator()(int dd0, int dd1, double dd2) const noexcept {
+    const double num =
+      dd2 * double(sz) + double(dd0) * double(sx) +
+      double(dd1) * double(sy);
+    const double square_mag =
+      double(dd0) * double(dd0) +
+      double(dd1) * double(dd1) +
+      dd2 * dd2;
+    const double mag = sqrt(square_mag);
+    /* this is a workaround for a SIGFPE (division by zero)
+       observed by our users on some Android devices (e.g. Nexus
+       7), even though we did our best to make sure that the
+       integer arithmetics above can't overflow */
+    /* TODO: debug this problem and replace this workaround */
+    const int sval = int(num / std::max(mag, 1.0));
+    const int sindex = (sval - sz) * contrast / 128;
+    return std::clamp(sindex, -63, 63);
+  }
+};
+
+} // anonymous namespace
+
+/**
+ * Calculate the illumination of the columns [begin, end) of one row,
+ * where all neighbours are #step pixels away.  The loops have no
+ * branches and no data-dependent offsets, so the compiler can
+ * vectorise them.  The integer part is a separate loop, because GCC
+ * cannot vectorise the conversion from 16 bit heights to double in
+ * one step.
+ *
+ * @param dd1 scratch buffer with at least #end elements
+ */
+static void
+CalculateSlopeRow(int *gcc_restrict illumination, int *gcc_restrict dd1,
+                  const TerrainHeight *src,
+                  const TerrainHeight *above, const TerrainHeight *below,
+                  unsigned begin, unsigned end,
+                  unsigned step, unsigned p31,
+                  unsigned height_slope_factor,
+                  const SlopeShading shading) noexcept
+{
+  const unsigned p20 = 2 * step;
+
+  int *gcc_restrict dd0 = illumination;
+  for (unsigned x = begin; x < end; ++x) {
+    dd0[x] = ClipHeightDelta(src[x + step], src[x - step]) * int(p31);
+    dd1[x] = int(p20) * ClipHeightDelta(above[x], below[x]);
+  }
+
+  const double dd2 = double(p20) * double(p31) *
+    double(height_slope_factor);
+  for (unsigned x = begin; x < end; ++x)
+    illumination[x] = shading(dd0[x], dd1[x], dd2);
+}
+
 void
 RasterRenderer::GenerateSlopeImage(unsigned height_scale,
                                    int contrast,
                                    const int sx, const int sy, const int sz,
-                                   const unsigned contour_height_scale) noexcept
+                                   const unsigned contour_height_scale,
+                                   const PixelRect &rc) noexcept
 {
   const UnsignedPoint2D matrix_size = height_matrix.GetSize();
   ClampQuantisationEffectiveToMatrix(quantisation_effective, matrix_size);
@@ -521,41 +799,157 @@ RasterRenderer::GenerateSlopeImage(unsigned height_scale,
                   its square will not overflow */
                max_height_slope_factor);
 
-  const auto *src = height_matrix.GetData();
+  const SlopeShading shading{sx, sy, sz, contrast};
+
+  const RawColor *oColorBuf = color_table + 64 * 256;
+  RawColor *const top_row = image->GetTopRow();
+  const ptrdiff_t row_stride = image->GetNextRow(top_row) - top_row;
+  const unsigned step = quantisation_effective;
+
+  const unsigned left = rc.left, right = rc.right;
+
+  /* columns where both horizontal neighbours are "step" pixels
+     away */
+  const unsigned inner_begin = std::clamp(step, left, right);
+  const unsigned inner_end =
+    std::clamp(matrix_size.x - step, inner_begin, right);
+
+  const bool contours = contour_height_scale < 16;
+  uint8_t *const intervals = contours ? contour_intervals.data() : nullptr;
+
+  ParallelFor(rc.GetHeight(), n_threads, MIN_ROWS_PER_THREAD,
+              [&](unsigned begin, unsigned end){
+                AllocatedArray<int> illumination(matrix_size.x);
+                AllocatedArray<int> scratch(matrix_size.x);
+
+                for (unsigned y = rc.top + begin; y < rc.top + end; ++y) {
+                  const unsigned row_plus_index =
+                    SafePlusStep(y, matrix_size.y, step);
+                  const unsigned row_minus_index =
+                    SafeMinusStep(y, step);
+                  const unsigned p31 = row_plus_index + row_minus_index;
+
+                  const auto *src = height_matrix.GetRow(y);
+                  const auto *above =
+                    height_matrix.GetRow(y - row_minus_index);
+                  const auto *below =
+                    height_matrix.GetRow(y + row_plus_index);
+
+                  /* first pass: calculate the illumination of all
+                     pixels, ignoring "special" values (vectorised) */
+
+                  CalculateSlopeRow(illumination.data(), scratch.data(),
+                                    src, above, below,
+                                    inner_begin, inner_end,
+                                    step, p31, height_slope_factor,
+                                    shading);
+
+                  const auto calculate_border = [&](unsigned x){
+                    const unsigned column_plus_index =
+                      SafePlusStep(x, matrix_size.x, step);
+                    const unsigned column_minus_index =
+                      SafeMinusStep(x, step);
+                    const unsigned p20 =
+                      column_plus_index + column_minus_index;
+
+                    const int p22 =
+                      ClipHeightDelta(src[x + column_plus_index],
+                                      src[x - column_minus_index]);
+                    const int p32 = ClipHeightDelta(above[x], below[x]);
+
+                    illumination[x] =
+                      shading(p22 * int(p31), int(p20) * p32,
+                              double(p20) * double(p31) *
+                              double(height_slope_factor));
+                  };
+
+                  for (unsigned x = left; x < inner_begin; ++x)
+                    calculate_border(x);
+                  for (unsigned x = inner_end; x < right; ++x)
+                    calculate_border(x);
+
+                  /* second pass: look up the colors */
+
+                  RawColor *p = top_row + ptrdiff_t(y) * row_stride;
+                  uint8_t *row_intervals = intervals != nullptr
+                    ? intervals + y * matrix_size.x
+                    : nullptr;
+
+                  for (unsigned x = left; x < right; ++x) {
+                    const auto e = src[x];
+                    if (e.IsSpecial()) [[unlikely]] {
+                      /* water or outside the terrain file bounds */
+                      p[x] = oColorBuf[255];
+                      if (row_intervals != nullptr)
+                        row_intervals[x] = NO_CONTOUR;
+                      continue;
+                    }
+
+                    const unsigned value = std::max(0, (int)e.GetValue());
+                    const unsigned h = std::min(254u, value >> height_scale);
+
+                    if (above[x].IsSpecial() || below[x].IsSpecial() ||
+                        src[x - SafeMinusStep(x, step)].IsSpecial() ||
+                        src[x + SafePlusStep(x, matrix_size.x, step)].IsSpecial())
+                      [[unlikely]] {
+                      /* some "special" terrain value surrounding us
+                         (water or invalid), skip slope calculation
+                         and contours */
+                      p[x] = oColorBuf[h];
+                      if (row_intervals != nullptr)
+                        row_intervals[x] = NO_CONTOUR;
+                      continue;
+                    }
+
+                    p[x] = oColorBuf[int(h) + 256 * illumination[x]];
+                    if (row_intervals != nullptr)
+                      row_intervals[x] =
+                        ContourInterval(value, contour_height_scale);
+                  }
+                }
+              });
+}
+
+void
+RasterRenderer::GenerateContours(const unsigned height_scale,
+                                 const unsigned contour_height_scale,
+                                 const PixelRect &rc) noexcept
+{
+  const UnsignedPoint2D matrix_size = height_matrix.GetSize();
   const RawColor *oColorBuf = color_table + 64 * 256;
 
-  RawColor *dest = image->GetTopRow();
-  const ptrdiff_t row_stride =
-    image->GetNextRow(dest) - dest;
+  RawColor *const top_row = image->GetTopRow();
+  const ptrdiff_t row_stride = image->GetNextRow(top_row) - top_row;
   const unsigned matrix_width = matrix_size.x;
   const unsigned contour_tl = contour_thickness / 2;
   const unsigned contour_br = (contour_thickness - 1) / 2;
 
-  for (unsigned y = 0; y < matrix_size.y; ++y) {
-    const unsigned row_plus_index =
-      SafePlusStep(y, matrix_size.y, quantisation_effective);
-    const unsigned row_plus_offset = matrix_size.x * row_plus_index;
-
-    const unsigned row_minus_index =
-      SafeMinusStep(y, quantisation_effective);
-    const unsigned row_minus_offset = matrix_size.x * row_minus_index;
-
-    const unsigned p31 = row_plus_index + row_minus_index;
-
-    RawColor *p = dest;
-    dest = image->GetNextRow(dest);
-
-    unsigned contour_row_base = ContourInterval(*src, contour_height_scale);
-    unsigned char *contour_this_column_base = contour_column_base;
-
-    for (unsigned x = 0; x < matrix_size.x; ++x, ++src) {
-      const auto e = *src;
+  for (unsigned y = rc.top; y < unsigned(rc.bottom); ++y) {
+    const std::size_t offset = std::size_t(y) * matrix_size.x + rc.left;
+    const auto *src = height_matrix.GetData() + offset;
+    const uint8_t *intervals = contour_intervals.data() + offset;
+    RawColor *p = top_row + ptrdiff_t(y) * row_stride + rc.left;
+
+    /* continue with the interval of the nearest pixel left of the
+       rectangle which takes part in contour detection, just like a
+       pass over the whole row would */
+    unsigned contour_row_base =
+      ContourInterval(height_matrix.GetRow(y)[0], contour_height_scale);
+    for (const uint8_t *i = intervals; i != intervals - rc.left;)
+      if (*--i != NO_CONTOUR) {
+        contour_row_base = *i;
+        break;
+      }
+    unsigned char *contour_this_column_base = contour_column_base + rc.left;
 
+    for (unsigned x = rc.left; x < unsigned(rc.right);
+         ++x, ++src, ++intervals, ++p, ++contour_this_column_base) {
       // Check if pixel is claimed by a prior contour expansion
       if (contour_br > 0 &&
           contour_pending[x].until_row > 0 &&
           y <= contour_pending[x].until_row) [[unlikely]] {
-        *p++ = contour_pending[x].color;
+        const auto e = *src;
+        *p = contour_pending[x].color;
         if (!e.IsSpecial()) {
           const unsigned ci = ContourInterval(
             std::max(0, (int)e.GetValue()),
@@ -563,92 +957,32 @@ RasterRenderer::GenerateSlopeImage(unsigned height_scale,
           *contour_this_column_base =
             contour_row_base = ci;
         }
-        contour_this_column_base++;
         continue;
       }
 
-      if (!e.IsSpecial()) [[likely]] {
-        unsigned h = std::max(0, (int)e.GetValue());
-
-        const unsigned contour_interval =
-          ContourInterval(h, contour_height_scale);
-
-        h = std::min(254u, h >> height_scale);
-
-        const unsigned column_plus_index =
-          SafePlusStep(x, matrix_size.x, quantisation_effective);
-        const unsigned column_minus_index =
-          SafeMinusStep(x, quantisation_effective);
-
-        const auto h_above = src[-(int)row_minus_offset];
-        const auto h_below = src[row_plus_offset];
-        const auto h_left = src[-(int)column_minus_index];
-        const auto h_right = src[column_plus_index];
-
-        if (h_above.IsSpecial() || h_below.IsSpecial() ||
-            h_left.IsSpecial() || h_right.IsSpecial()) [[unlikely]] {
-          /* some "special" terrain value surrounding us (water or
-             invalid), skip slope calculation */
-          *p++ = oColorBuf[h];
-          contour_this_column_base++;
-          continue;
-        }
-
-        if (contour_interval != contour_row_base ||
-            contour_interval != *contour_this_column_base) [[unlikely]] {
-
-          const RawColor contour_color =
-            oColorBuf[int(h) - 64 * 256];
-
-          *contour_this_column_base++ = contour_row_base = contour_interval;
-
-          if (contour_thickness > 1)
-            ApplyContourExpansion(
-              p, row_stride,
-              x, y, matrix_width,
-              contour_tl, contour_br,
-              contour_color, contour_pending);
-          else
-            *p = contour_color;
-
-          ++p;
-          continue;
-        }
+      const unsigned contour_interval = *intervals;
+      if (contour_interval == NO_CONTOUR)
+        continue;
 
-        const int p32 = ClipHeightDelta(h_above, h_below);
-        const int p22 = ClipHeightDelta(h_right, h_left);
-
-        const unsigned p20 = column_plus_index + column_minus_index;
-
-        const int dd0 = p22 * int(p31);
-        const int dd1 = int(p20) * p32;
-        const double dd2 = double(p20) * double(p31) *
-          double(height_slope_factor);
-        const double num =
-          dd2 * double(sz) + double(dd0) * double(sx) +
-          double(dd1) * double(sy);
-        const double square_mag =
-          double(dd0) * double(dd0) +
-          double(dd1) * double(dd1) +
-          dd2 * dd2;
-        const double mag = sqrt(square_mag);
-        /* this is a workaround for a SIGFPE (division by zero)
-           observed by our users on some Android devices (e.g. Nexus
-           7), even though we did our best to make sure that the
-           integer arithmetics above can't overflow */
-        /* TODO: debug this problem and replace this workaround */
-        const int sval = int(num / std::max(mag, 1.0));
-        const int sindex = (sval - sz) * contrast / 128;
-        *p++ = oColorBuf[int(h) + 256 * std::clamp(sindex, -63, 63)];
-      } else if (e.IsWater()) {
-        // we're in the water, so look up the color for water
-        *p++ = oColorBuf[255];
-      } else {
-        /* outside the terrain file bounds */
-        *p++ = oColorBuf[255];
+      if (contour_interval != contour_row_base ||
+          contour_interval != *contour_this_column_base) [[unlikely]] {
+        const unsigned h =
+          std::min(254u, unsigned(std::max(0, (int)src->GetValue()))
+                   >> height_scale);
+        const RawColor contour_color =
+          oColorBuf[int(h) - 64 * 256];
+
+        if (contour_thickness > 1)
+          ApplyContourExpansion(
+            p, row_stride,
+            x, y, matrix_width,
+            contour_tl, contour_br,
+            contour_color, contour_pending);
+        else
+          *p = contour_color;
+
+        *contour_this_column_base = contour_row_base = contour_interval;
       }
-      contour_this_column_base++;
-
     }
   }
 }
@@ -657,7 +991,8 @@ void
 RasterRenderer::GenerateSlopeImage(unsigned height_scale,
                                    int contrast, int brightness,
                                    const Angle sunazimuth,
-                                   const unsigned contour_height_scale) noexcept
+                                   const unsigned contour_height_scale,
+                                   const PixelRect &rc) noexcept
 {
   const Angle fudgeelevation = Angle::Degrees(10) +
     Angle::Degrees(80.0 / 255.0) * brightness;
@@ -667,7 +1002,7 @@ RasterRenderer::GenerateSlopeImage(unsigned height_scale,
   const int sz = (int)(255 * fudgeelevation.fastsine());
 
   GenerateSlopeImage(height_scale, contrast,
-                     sx, sy, sz, contour_height_scale);
+                     sx, sy, sz, contour_height_scale, rc);
 }
 
 void
@@ -675,6 +1010,7 @@ RasterRenderer::PrepareColorTable(const ColorRamp *color_ramp, bool do_water,
                                   unsigned height_scale, int interp_levels) noexcept
 {
   has_alpha = false;
+  last_image_parameters.reset();
 
   if (color_table == nullptr)
     color_table = new RawColor[256 * 128];
@@ -744,6 +1080,7 @@ RasterRenderer::PrepareColorTableAlpha(const ColorRamp *color_ramp,
                                        int interp_levels) noexcept
 {
   has_alpha = true;
+  last_image_parameters.reset();
 
   if (color_table == nullptr)
     color_table = new RawColor[256 * 128];
@@ -774,13 +1111,25 @@ RasterRenderer::PrepareColorTableAlpha(const ColorRamp *color_ramp,
 }
 
 void
-RasterRenderer::ContourStart(const unsigned contour_height_scale) noexcept
+RasterRenderer::ContourStart(const unsigned contour_height_scale,
+                             const PixelRect &rc) noexcept
 {
-  // initialise column to first row
-  const auto *src = height_matrix.GetData();
-  unsigned char *col_base = contour_column_base;
-  for (unsigned x = height_matrix.GetSize().x; x > 0; --x)
-    *col_base++ = ContourInterval(*src++, contour_height_scale);
+  /* initialise the columns to the interval of the nearest pixel
+     above the rectangle which takes part in contour detection (see
+     GenerateContours()), or to the first row if there is none */
+  const unsigned width = height_matrix.GetSize().x;
+  const auto *src = height_matrix.GetRow(0);
+  for (unsigned x = rc.left; x < unsigned(rc.right); ++x) {
+    contour_column_base[x] = ContourInterval(src[x], contour_height_scale);
+
+    for (unsigned y = rc.top; y-- > 0;) {
+      const uint8_t interval = contour_intervals[std::size_t(y) * width + x];
+      if (interval != NO_CONTOUR) {
+        contour_column_base[x] = interval;
+        break;
+      }
+    }
+  }
 
   // reset deferred contour expansion state
   std::fill_n(contour_pending, height_matrix.GetSize().x,
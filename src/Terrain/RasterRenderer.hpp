@@ -4,6 +4,13 @@
 #pragma once
 
 #include "Terrain/HeightMatrix.hpp"
+#include "Math/Angle.hpp"
+#include "ui/dim/Rect.hpp"
+#include "util/AllocatedArray.hxx"
+#include "util/StaticArray.hxx"
+
+#include <cstdint>
+#include <optional>
 
 #ifdef ENABLE_OPENGL
 #include "Geo/GeoBounds.hpp"
@@ -11,7 +18,6 @@
 
 static constexpr unsigned NUM_COLOR_RAMP_LEVELS = 13;
 
-class Angle;
 class Canvas;
 class RasterMap;
 class WindowProjection;
@@ -80,10 +86,54 @@ class RasterRenderer {
    */
   ColumnContourPending *contour_pending = nullptr;
 
+  /**
+   * The contour interval of each pixel, calculated by the (parallel)
+   * shading pass for the (sequential) GenerateContours() pass.
+   */
+  AllocatedArray<uint8_t> contour_intervals;
+
   double pixel_size = 0;
 
+  /**
+   * The maximum number of threads used by ScanMap() and
+   * GenerateImage().
+   */
+  unsigned n_threads;
+
   RawColor *color_table = nullptr;
 
+  /**
+   * The GenerateImage() parameters which affect all pixels.  If they
+   * are unchanged, an image which was scrolled by ScrollMap() can be
+   * updated incrementally.
+   */
+  struct ImageParameters {
+    bool do_shading;
+    unsigned height_scale;
+    int contrast, brightness;
+    Angle sunazimuth;
+    unsigned contour_height_scale, contour_thickness;
+    unsigned quantisation_effective;
+    double pixel_size;
+
+    bool operator==(const ImageParameters &) const noexcept = default;
+  };
+
+  /**
+   * The parameters of the last GenerateImage() call; cleared when the
+   * color table changes.
+   */
+  std::optional<ImageParameters> last_image_parameters;
+
+  /**
+   * Set by ScrollMap(): the height matrix and the image have been
+   * scrolled, and the next GenerateImage() call only needs to
+   * regenerate the rectangles in #scroll_dirty.
+   */
+  bool scrolled = false;
+
+  StaticArray<PixelRect, 4> scroll_dirty;
+
   /**
    * True if the current color table was prepared with alpha channel support.
    * This affects how the image should be drawn (with or without alpha blending).
@@ -118,6 +168,15 @@ public:
     return quantisation_pixels;
   }
 
+  /**
+   * Set the maximum number of threads used by ScanMap() and
+   * GenerateImage().  The default depends on the number of CPU
+   * cores.
+   */
+  void SetThreads(unsigned _n_threads) noexcept {
+    n_threads = _n_threads < 1 ? 1u : _n_threads;
+  }
+
   /**
    * Returns true if contour lines are currently rendered (i.e. not
    * suppressed due to extreme zoom-out).
@@ -192,6 +251,23 @@ public:
   void ScanMap(const RasterMap &map,
                const WindowProjection &projection) noexcept;
 
+#ifdef ENABLE_OPENGL
+  /**
+   * An alternative to ScanMap() if only the location has changed:
+   * scroll the existing height matrix and image by whole cells and
+   * scan only the newly exposed rows and columns.  The following
+   * GenerateImage() call then only generates the exposed parts of
+   * the image (if its parameters are unchanged).
+   *
+   * @return false if scrolling is not possible (e.g. the scale, the
+   * screen size or the quantisation has changed, or the new area is
+   * not completely inside the map); the caller shall then call
+   * ScanMap()
+   */
+  bool ScrollMap(const RasterMap &map,
+                 const WindowProjection &projection) noexcept;
+#endif
+
   /**
    * Make a gradient map from min_h to max_h, default left to right
    */
@@ -222,18 +298,29 @@ public:
             float alpha=1.0f) const noexcept;
 
 protected:
+  /**
+   * Convert a rectangle of the height matrix into the image.
+   */
+  void GenerateImage(bool do_shading,
+                     unsigned height_scale, int contrast, int brightness,
+                     Angle sunazimuth,
+                     unsigned contour_height_scale,
+                     const PixelRect &rc) noexcept;
+
   /**
    * Convert the height matrix into the image, without shading.
    */
   void GenerateUnshadedImage(unsigned height_scale,
-                             unsigned contour_height_scale) noexcept;
+                             unsigned contour_height_scale,
+                             const PixelRect &rc) noexcept;
 
   /**
    * Convert the height matrix into the image, with slope shading.
    */
   void GenerateSlopeImage(unsigned height_scale, int contrast,
                           int sx, int sy, int sz,
-                          unsigned contour_height_scale) noexcept;
+                          unsigned contour_height_scale,
+                          const PixelRect &rc) noexcept;
 
   /**
    * Convert the height matrix into the image, with slope shading.
@@ -241,8 +328,30 @@ protected:
   void GenerateSlopeImage(unsigned height_scale,
                           int contrast, int brightness,
                           Angle sunazimuth,
-                          unsigned contour_height_scale) noexcept;
+                          unsigned contour_height_scale,
+                          const PixelRect &rc) noexcept;
 
 private:
-  void ContourStart(unsigned contour_height_scale) noexcept;
+  /**
+   * Calculate #pixel_size and #quantisation_effective for the given
+   * projection.
+   */
+  void UpdateEffectiveQuantisation(const RasterMap &map,
+                                   const WindowProjection &projection) noexcept;
+
+  void ContourStart(unsigned contour_height_scale,
+                    const PixelRect &rc) noexcept;
+
+  /**
+   * Draw the contour lines over an image which was already filled
+   * by GenerateUnshadedImage() or GenerateSlopeImage().
+   *
+   * The contour state of each pixel depends on all pixels before it,
+   * therefore this pass is sequential, but it only looks at
+   * #contour_intervals and writes the pixels which are part of a
+   * contour line.
+   */
+  void GenerateContours(unsigned height_scale,
+                        unsigned contour_height_scale,
+                        const PixelRect &rc) noexcept;
 };
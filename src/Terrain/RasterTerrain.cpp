@@ -3,19 +3,47 @@
 
 #include "RasterTerrain.hpp"
 #include "Loader.hpp"
+#include "Pack.hpp"
 #include "Profile/Profile.hpp"
 #include "io/ZipArchive.hpp"
+#include "io/ZipReader.hpp"
 #include "io/FileCache.hpp"
 #include "io/FileOutputStream.hxx"
 #include "io/BufferedOutputStream.hxx"
 #include "io/Reader.hxx"
 #include "io/BufferedReader.hxx"
 #include "system/ConvertPathName.hpp"
+#include "system/FileUtil.hpp"
 #include "Operation/Operation.hpp"
+#include "Tracing/Tracing.hpp"
 #include "LogFile.hpp"
 
+#include <algorithm>
+#include <cassert>
+
+#include <math.h>
+
 static const char *const terrain_cache_name = "terrain";
 
+RasterTerrain::RasterTerrain(ZipArchive &&_archive) noexcept
+  :Guard<RasterMap>(map), archive(std::move(_archive)) {}
+
+RasterTerrain::~RasterTerrain() noexcept = default;
+
+inline bool
+RasterTerrain::LoadPack(Path path)
+{
+  const auto pack_path = path.WithSuffix(".xtp");
+  if (!File::Exists(pack_path))
+    return false;
+
+  const auto source_size = ZipReader{archive.get(), "terrain.jp2"}.GetSize();
+  pack = std::make_unique<TerrainPack>(pack_path, source_size,
+                                       map.GetTileCache());
+  map.UpdateProjection();
+  return true;
+}
+
 inline bool
 RasterTerrain::LoadCache(FileCache &cache, Path path)
 {
@@ -48,6 +76,13 @@ inline void
 RasterTerrain::Load(Path path, FileCache *cache,
                     OperationEnvironment &operation)
 {
+  try {
+    if (LoadPack(path))
+      return;
+  } catch (...) {
+    LogError(std::current_exception(), "Failed to load terrain pack");
+  }
+
   try {
     if (LoadCache(cache, path))
       return;
@@ -90,6 +125,84 @@ try {
   return nullptr;
 }
 
+/**
+ * By which fraction of its radius may a region move or grow before
+ * the tiles are updated again?
+ */
+static constexpr double REGION_TOLERANCE = 1. / 16;
+
+[[gnu::pure]]
+static bool
+IsSimilar(const RasterTerrain::Region &a,
+          const RasterTerrain::Region &b) noexcept
+{
+  const double tolerance = std::min(a.radius, b.radius) * REGION_TOLERANCE;
+  return a.priority == b.priority &&
+    fabs(a.radius - b.radius) <= tolerance &&
+    a.a.Distance(b.a) <= tolerance &&
+    a.b.Distance(b.b) <= tolerance;
+}
+
+[[gnu::pure]]
+static bool
+IsSimilar(std::span<const RasterTerrain::Region> a,
+          std::span<const RasterTerrain::Region> b) noexcept
+{
+  return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                    [](const auto &x, const auto &y){
+                      return IsSimilar(x, y);
+                    });
+}
+
+void
+RasterTerrain::SetRegions(std::span<const Region> _regions) noexcept
+{
+  assert(_regions.size() <= MAX_REGIONS);
+
+  const std::lock_guard lock{regions_mutex};
+
+  /* the calculation thread calls this periodically; small movements
+     (e.g. GPS noise on the ground) don't trigger a tile update */
+  if (IsSimilar(regions, _regions))
+    return;
+
+  regions.clear();
+  regions.insert(0, _regions.begin(), _regions.end());
+  ++regions_serial;
+}
+
+/**
+ * Approximate the #RasterTerrain::Region with circles along its line
+ * and append them to the array.
+ */
+template<std::size_t max>
+static void
+AppendRegion(StaticArray<RasterTileRegion, max> &dest,
+             const RasterProjection &projection,
+             const RasterTerrain::Region &region) noexcept
+{
+  const SignedRasterLocation a = projection.ProjectCoarse(region.a);
+  const SignedRasterLocation b = projection.ProjectCoarse(region.b);
+  const unsigned radius = projection.DistancePixelsCoarse(region.radius);
+  const uint8_t priority = uint8_t(region.priority);
+
+  /* one circle every "radius" pixels, but not more than one per tile
+     (RasterTileCache::PollTiles() adds a margin of one tile to each
+     circle) */
+  const unsigned spacing = std::max(radius, 256u);
+  const double length = hypot(b.x - a.x, b.y - a.y);
+  unsigned n = unsigned(ceil(length / spacing));
+  n = std::min(n, unsigned(dest.capacity() - dest.size()) - 1);
+
+  dest.push_back({a, radius, priority});
+  for (unsigned i = 1; i <= n; ++i)
+    dest.push_back({
+        SignedRasterLocation(a.x + int(i) * (b.x - a.x) / int(n),
+                             a.y + int(i) * (b.y - a.y) / int(n)),
+        radius, priority,
+      });
+}
+
 bool
 RasterTerrain::UpdateTiles(const GeoPoint &location, double radius) noexcept
 {
@@ -97,9 +210,29 @@ RasterTerrain::UpdateTiles(const GeoPoint &location, double radius) noexcept
   if (!tile_cache.IsValid())
     return false;
 
+  const auto &projection = map.GetProjection();
+
+  StaticArray<RasterTileRegion, 64> tile_regions;
+  tile_regions.push_back({
+      projection.ProjectCoarse(location),
+      projection.DistancePixelsCoarse(radius),
+      uint8_t(Priority::DISPLAY),
+    });
+
+  {
+    const std::lock_guard lock{regions_mutex};
+    for (const auto &i : regions)
+      if (!tile_regions.full())
+        AppendRegion(tile_regions, projection, i);
+  }
+
+  const Tracing::Scope trace{Tracing::Point::TERRAIN_LOAD};
+
   try {
-    UpdateTerrainTiles(archive.get(), tile_cache, mutex,
-                       map.GetProjection(), location, radius);
+    if (pack != nullptr)
+      pack->UpdateTiles(tile_cache, mutex, tile_regions);
+    else
+      UpdateTerrainTiles(archive.get(), tile_cache, mutex, tile_regions);
   } catch (...) {
     LogError(std::current_exception(), "Failed to update terrain tiles");
   }
@@ -6,13 +6,18 @@
 #include "RasterMap.hpp"
 #include "Geo/GeoPoint.hpp"
 #include "thread/Guard.hpp"
+#include "thread/Mutex.hxx"
 #include "io/ZipArchive.hpp"
+#include "util/StaticArray.hxx"
 
+#include <cstdint>
 #include <memory>
+#include <span>
 
 class Path;
 class FileCache;
 class OperationEnvironment;
+class TerrainPack;
 
 /**
  * Class to manage raster terrain database, potentially with caching
@@ -24,17 +29,79 @@ public:
   friend class ProtectedTaskManager; // for intersection
   friend class WaypointVisitorMap; // for intersection rendering
 
+  /**
+   * Tiles of regions with a higher priority are loaded first and
+   * discarded last.  This is weighted with the distance (see
+   * RasterTileRegion::priority), therefore tiles of a large region
+   * do not push out all tiles of a smaller one.
+   */
+  enum class Priority : uint8_t {
+    /**
+     * Needed by safety-related calculations (reach, terrain
+     * warnings).
+     */
+    HIGH,
+
+    /**
+     * The visible map area.
+     */
+    DISPLAY,
+
+    /**
+     * Used by calculations, but not critical.
+     */
+    LOW,
+  };
+
+  /**
+   * An area whose tiles shall be loaded, independent of the map view:
+   * all locations within #radius of the line from #a to #b (a circle
+   * if both are equal).
+   */
+  struct Region {
+    GeoPoint a, b;
+
+    /**
+     * The radius [m].
+     */
+    double radius;
+
+    Priority priority;
+  };
+
+  static constexpr unsigned MAX_REGIONS = 4;
+
 private:
   ZipArchive archive;
 
   RasterMap map;
 
+  /**
+   * If the map file has a terrain pack, tiles are loaded from it
+   * instead of the JPEG2000 file.
+   */
+  std::unique_ptr<TerrainPack> pack;
+
+  /**
+   * Protects #regions and #regions_serial.
+   */
+  mutable Mutex regions_mutex;
+
+  /**
+   * The regions of interest registered by the calculation thread;
+   * see SetRegions().
+   */
+  StaticArray<Region, MAX_REGIONS> regions;
+
+  Serial regions_serial;
+
 public:
   /**
    * Constructor.  Returns uninitialised object.
    */
-  explicit RasterTerrain(ZipArchive &&_archive) noexcept
-    :Guard<RasterMap>(map), archive(std::move(_archive)) {}
+  explicit RasterTerrain(ZipArchive &&_archive) noexcept;
+
+  ~RasterTerrain() noexcept;
 
   const Serial &GetSerial() const noexcept {
     return map.GetSerial();
@@ -64,11 +131,45 @@ public:
   }
 
   /**
+   * Replace the regions of interest, i.e. the areas which shall be
+   * loaded at full resolution regardless of the map view.  They will
+   * be considered by the next UpdateTiles() call.  Regions which
+   * differ only slightly from the current ones are ignored.
+   *
+   * This method is thread-safe.
+   */
+  void SetRegions(std::span<const Region> _regions) noexcept;
+
+  /**
+   * Returns a #Serial which is incremented each time SetRegions()
+   * changes the regions.
+   *
+   * This method is thread-safe.
+   */
+  [[gnu::pure]]
+  Serial GetRegionsSerial() const noexcept {
+    const std::lock_guard lock{regions_mutex};
+    return regions_serial;
+  }
+
+  /**
+   * Load the tiles around the given (display) location and within the
+   * regions of interest.
+   *
    * @return true if the method shall be called again
    */
   bool UpdateTiles(const GeoPoint &location, double radius) noexcept;
 
 private:
+  /**
+   * Load the overview from the terrain pack next to the map file.
+   *
+   * Throws on error.
+   *
+   * @return false if there is no terrain pack
+   */
+  bool LoadPack(Path path);
+
   /**
    * Throws on error.
    */
@@ -8,6 +8,7 @@
 #include "util/SpanCast.hxx"
 
 #include <algorithm>
+#include <climits>
 
 #include <stdlib.h>
 
@@ -47,6 +48,11 @@ RasterTile::CopyFrom(const struct jas_matrix &m) noexcept
     for (unsigned i = 0; i < width; ++i)
       *dest++ = TerrainHeight(src[i]);
   }
+
+  /* the decoded buffer is kept until the next
+     RasterTileCache::PollTiles() call decides which tiles remain
+     decoded */
+  compressed.Compress(buffer);
 }
 
 TerrainHeight
@@ -59,7 +65,7 @@ RasterTile::GetHeight(RasterLocation p) const noexcept
   assert(p.x < size.x);
   assert(p.y < size.y);
 
-  return buffer.Get(p);
+  return IsDecoded() ? buffer.Get(p) : compressed.Get(p);
 }
 
 TerrainHeight
@@ -79,7 +85,9 @@ RasterTile::GetInterpolatedHeight(unsigned lx, unsigned ly,
   if ((ly -= start.y) >= size.y)
     return TerrainHeight::Invalid();
 
-  return buffer.GetInterpolated(lx, ly, ix, iy);
+  return IsDecoded()
+    ? buffer.GetInterpolated(lx, ly, ix, iy)
+    : compressed.GetInterpolated(lx, ly, ix, iy);
 }
 
 inline unsigned
@@ -93,23 +101,53 @@ RasterTile::CalcDistanceTo(IntPoint2D p) const noexcept
   return std::max(std::min(dx1, dx2), std::min(dy1, dy2));
 }
 
-inline bool
-RasterTile::CheckTileVisibility(IntPoint2D view,
-                                unsigned view_radius) noexcept
+/**
+ * Tiles which are not in any region have a rank of at least this
+ * value.
+ */
+static constexpr unsigned OUT_OF_RANGE_RANK = 0xff000000;
+
+/**
+ * Weight a distance with the region priority.
+ */
+static constexpr unsigned
+MakeRank(uint8_t priority, unsigned distance) noexcept
+{
+  return unsigned(std::min<uint_least64_t>(uint_least64_t(distance) *
+                                           (priority + 1u),
+                                           OUT_OF_RANGE_RANK - 1));
+}
+
+bool
+RasterTile::VisibilityChanged(std::span<const RasterTileRegion> regions,
+                              unsigned margin) noexcept
 {
+  request = false;
+
   if (!IsDefined()) {
     assert(!IsLoaded());
     return false;
   }
 
-  distance = CalcDistanceTo(view);
-  return distance <= view_radius || IsLoaded();
-}
+  bool in_range = false;
+  unsigned min_distance = UINT_MAX;
+  rank = UINT_MAX;
 
-bool
-RasterTile::VisibilityChanged(IntPoint2D view,
-                              unsigned view_radius) noexcept
-{
-  request = false;
-  return CheckTileVisibility(view, view_radius);
+  for (const auto &region : regions) {
+    const unsigned distance = CalcDistanceTo(region.center);
+    min_distance = std::min(min_distance, distance);
+
+    if (distance <= region.radius + margin) {
+      in_range = true;
+      rank = std::min(rank, MakeRank(region.priority, distance));
+    }
+  }
+
+  if (in_range)
+    return true;
+
+  /* keep loaded tiles as long as there is room, but discard them
+     before all others */
+  rank = OUT_OF_RANGE_RANK | std::min(min_distance, 0xffffffu);
+  return IsLoaded();
 }
@@ -6,11 +6,36 @@
 #include "RasterTraits.hpp"
 #include "RasterLocation.hpp"
 #include "RasterBuffer.hpp"
+#include "CompressedRasterBuffer.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
 
 struct jas_matrix;
 class BufferedOutputStream;
 class BufferedReader;
 
+/**
+ * A circular area of the raster whose tiles shall be loaded.
+ */
+struct RasterTileRegion {
+  SignedRasterLocation center;
+
+  unsigned radius;
+
+  /**
+   * Tiles of regions with a lower value are loaded first and
+   * discarded last: the distance of a tile to the #center is
+   * multiplied with (priority+1).  This way, a large region cannot
+   * starve a small one with a lower priority.  The value 0xff is
+   * reserved for tiles which are not in any region.
+   */
+  uint8_t priority;
+};
+
 class RasterTile {
   struct MetaData {
     RasterLocation start, end;
@@ -20,15 +45,28 @@ public:
   RasterLocation start{0, 0}, end, size{0, 0};
 
   /**
-   * The distance of this tile to the center of the screen.  This
-   * attribute is used to determine which tiles should be loaded.
+   * The smallest weighted distance to the center of a region
+   * containing this tile (see RasterTileRegion::priority), or
+   * 0xff000000 plus the distance to the nearest region if the tile is
+   * not in any region.  This attribute is used to determine which
+   * tiles should be loaded.
    */
-  unsigned distance;
+  unsigned rank;
 
   bool request;
 
+  /**
+   * The decoded heights.  This is only defined for the tiles closest
+   * to the screen (see RasterTileCache::MAX_DECODED_TILES); the
+   * others are read from #compressed.
+   */
   RasterBuffer buffer;
 
+  /**
+   * The compressed heights.  This is defined for all loaded tiles.
+   */
+  CompressedRasterBuffer compressed;
+
 public:
   RasterTile() noexcept = default;
 
@@ -53,8 +91,8 @@ public:
     return size.x > 0 && size.y > 0;
   }
 
-  int GetDistance() const noexcept {
-    return distance;
+  unsigned GetRank() const noexcept {
+    return rank;
   }
 
   bool IsRequested() const noexcept {
@@ -75,18 +113,62 @@ public:
   [[gnu::pure]]
   unsigned CalcDistanceTo(IntPoint2D p) const noexcept;
 
-  bool CheckTileVisibility(IntPoint2D view, unsigned view_radius) noexcept;
-
   void Unload() noexcept {
     buffer.Reset();
+    compressed.Reset();
   }
 
   bool IsLoaded() const noexcept {
+    return compressed.IsDefined();
+  }
+
+  bool IsDecoded() const noexcept {
     return buffer.IsDefined();
   }
 
+  /**
+   * Decode the compressed heights for faster access.
+   */
+  void Decode() noexcept {
+    assert(IsLoaded());
+
+    if (!IsDecoded())
+      compressed.Decompress(buffer);
+  }
+
+  /**
+   * Free the decoded heights; they will be read from the compressed
+   * buffer.
+   */
+  void DiscardDecoded() noexcept {
+    buffer.Reset();
+  }
+
+  /**
+   * Returns the number of bytes allocated for this tile's heights.
+   */
+  [[gnu::pure]]
+  std::size_t GetMemoryUsage() const noexcept {
+    return std::size_t(buffer.GetSize().Area()) * sizeof(TerrainHeight) +
+      compressed.GetMemoryUsage();
+  }
+
   void CopyFrom(const struct jas_matrix &m) noexcept;
 
+  /**
+   * Load heights which were compressed elsewhere (e.g. read from a
+   * terrain pack).  They are ignored if their size does not match
+   * this tile.
+   */
+  void SetCompressed(CompressedRasterBuffer &&src) noexcept {
+    if (!IsDefined() || src.GetSize() != size)
+      return;
+
+    compressed = std::move(src);
+    buffer.Reset();
+    Decode();
+  }
+
   /**
    * Determine the non-interpolated height at the specified pixel
    * location.
@@ -110,13 +192,25 @@ public:
   TerrainHeight GetInterpolatedHeight(unsigned x, unsigned y,
                                       unsigned ix, unsigned iy) const noexcept;
 
-  bool VisibilityChanged(IntPoint2D view, unsigned view_radius) noexcept;
+  /**
+   * Clear the request flag and calculate the #rank.
+   *
+   * @param margin an additional radius for all regions
+   * @return true if the tile is within one of the regions or is
+   * already loaded
+   */
+  bool VisibilityChanged(std::span<const RasterTileRegion> regions,
+                         unsigned margin) noexcept;
 
   void ScanLine(RasterLocation a, RasterLocation b,
                 TerrainHeight *dest, unsigned dest_size,
                 bool interpolate) const noexcept {
-    buffer.ScanLine(a - (start << RasterTraits::SUBPIXEL_BITS),
-                    b - (start << RasterTraits::SUBPIXEL_BITS),
-                    dest, dest_size, interpolate);
+    a = a - (start << RasterTraits::SUBPIXEL_BITS);
+    b = b - (start << RasterTraits::SUBPIXEL_BITS);
+
+    if (IsDecoded())
+      buffer.ScanLine(a, b, dest, dest_size, interpolate);
+    else
+      compressed.ScanLine(a, b, dest, dest_size, interpolate);
   }
 };
@@ -3,6 +3,7 @@
 
 #include "RasterTileCache.hpp"
 #include "Math/Angle.hpp"
+#include "Tracing/Tracing.hpp"
 #include "io/BufferedOutputStream.hxx"
 #include "io/BufferedReader.hxx"
 #include "util/SpanCast.hxx"
@@ -66,30 +67,43 @@ RasterTileCache::PutTileData(unsigned index,
     return;
 
   tile.CopyFrom(m);
+  Tracing::Count(Tracing::Counter::TERRAIN_TILES);
 }
 
-struct RTDistanceSort {
+void
+RasterTileCache::PutCompressedTileData(unsigned index,
+                                       CompressedRasterBuffer &&data) noexcept
+{
+  auto &tile = tiles.GetLinear(index);
+  if (!tile.IsRequested())
+    return;
+
+  tile.SetCompressed(std::move(data));
+  Tracing::Count(Tracing::Counter::TERRAIN_TILES);
+}
+
+struct RTRankSort {
   const RasterTileCache &rtc;
 
-  constexpr RTDistanceSort(RasterTileCache &_rtc) noexcept:rtc(_rtc) {}
+  constexpr RTRankSort(RasterTileCache &_rtc) noexcept:rtc(_rtc) {}
 
   [[gnu::pure]]
   bool operator()(unsigned short ai, unsigned short bi) const noexcept {
     const RasterTile &a = rtc.tiles.GetLinear(ai);
     const RasterTile &b = rtc.tiles.GetLinear(bi);
 
-    return a.GetDistance() < b.GetDistance();
+    return a.GetRank() < b.GetRank();
   }
 };
 
 bool
-RasterTileCache::PollTiles(SignedRasterLocation p, unsigned radius) noexcept
+RasterTileCache::PollTiles(std::span<const RasterTileRegion> regions) noexcept
 {
   /* tiles are usually 256 pixels wide; with a radius smaller than
      that, the (optimized) tile distance calculations may fail;
      additionally, this ensures that tiles which are slightly out of
      the screen will be loaded in advance */
-  radius += 256;
+  constexpr unsigned margin = 256;
 
   /**
    * Maximum number of tiles loaded at a time, to reduce system load
@@ -104,16 +118,16 @@ RasterTileCache::PollTiles(SignedRasterLocation p, unsigned radius) noexcept
 
   request_tiles.clear();
   for (int i = tiles.GetSize() - 1; i >= 0 && !request_tiles.full(); --i)
-    if (tiles.GetLinear(i).VisibilityChanged(p, radius))
+    if (tiles.GetLinear(i).VisibilityChanged(regions, margin))
       request_tiles.append(i);
 
+  /* sort by the weighted distance */
+  const RTRankSort sort(*this);
+  std::sort(request_tiles.begin(), request_tiles.end(), sort);
+
   /* reduce if there are too many */
 
   if (request_tiles.size() > MAX_ACTIVE_TILES) {
-    /* sort by distance */
-    const RTDistanceSort sort(*this);
-    std::sort(request_tiles.begin(), request_tiles.end(), sort);
-
     /* dispose all tiles which are out of range */
     for (unsigned i = MAX_ACTIVE_TILES; i < request_tiles.size(); ++i) {
       RasterTile &tile = tiles.GetLinear(request_tiles[i]);
@@ -123,6 +137,22 @@ RasterTileCache::PollTiles(SignedRasterLocation p, unsigned radius) noexcept
     request_tiles.shrink(MAX_ACTIVE_TILES);
   }
 
+  /* decode the most important loaded tiles, and keep only the
+     compressed copy of the others */
+
+  unsigned num_decoded = 0;
+  for (unsigned i = 0; i < request_tiles.size(); ++i) {
+    RasterTile &tile = tiles.GetLinear(request_tiles[i]);
+    if (!tile.IsLoaded())
+      continue;
+
+    if (num_decoded < MAX_DECODED_TILES) {
+      tile.Decode();
+      ++num_decoded;
+    } else
+      tile.DiscardDecoded();
+  }
+
   /* fill ActiveTiles and request new tiles */
 
   dirty = false;
@@ -221,6 +251,15 @@ RasterTileCache::Reset() noexcept
     i.Unload();
 }
 
+std::size_t
+RasterTileCache::GetTileMemoryUsage() const noexcept
+{
+  std::size_t result = 0;
+  for (const auto &tile : tiles)
+    result += tile.GetMemoryUsage();
+  return result;
+}
+
 const RasterTileCache::MarkerSegmentInfo *
 RasterTileCache::FindMarkerSegment(uint32_t file_offset) const noexcept
 {
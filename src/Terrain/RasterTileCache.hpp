@@ -13,6 +13,7 @@
 #include <cassert>
 #include <cstdint>
 #include <optional>
+#include <span>
 
 static constexpr unsigned  RASTER_SLOPE_FACT = 12;
 
@@ -26,13 +27,27 @@ class RasterTileCache {
 
   /**
    * The maximum number of tiles which are loaded at a time.  This
-   * must be limited because the amount of memory is finite.
+   * must be limited because the amount of memory is finite.  Loaded
+   * tiles are kept compressed, which usually needs about a fifth of
+   * the memory of a decoded tile.
    */
 #if defined(ANDROID)
-  static constexpr unsigned MAX_ACTIVE_TILES = 128;
+  static constexpr unsigned MAX_ACTIVE_TILES = 384;
 #else
   // desktop: use a lot of memory
-  static constexpr unsigned MAX_ACTIVE_TILES = 512;
+  static constexpr unsigned MAX_ACTIVE_TILES = 2048;
+#endif
+
+  /**
+   * The maximum number of loaded tiles (the ones closest to the
+   * screen) which are also kept decoded for fast access.  Tiles
+   * loaded by the last update may exceed this limit until the next
+   * PollTiles() call.
+   */
+#if defined(ANDROID)
+  static constexpr unsigned MAX_DECODED_TILES = 32;
+#else
+  static constexpr unsigned MAX_DECODED_TILES = 128;
 #endif
 
   /**
@@ -42,7 +57,7 @@ class RasterTileCache {
   static constexpr unsigned INTERSECT_BITS = 7;
 
 protected:
-  friend struct RTDistanceSort;
+  friend struct RTRankSort;
   friend class TerrainLoader;
 
   struct MarkerSegmentInfo {
@@ -106,7 +121,7 @@ protected:
   StaticArray<MarkerSegmentInfo, 8192> segments;
 
   /**
-   * An array that is used to sort the requested tiles by distance.
+   * An array that is used to sort the requested tiles by rank.
    * This is only used by PollTiles() internally, but is stored in the
    * class because it would be too large for the stack.
    */
@@ -258,13 +273,56 @@ public:
                        RasterLocation start, RasterLocation end,
                        const struct jas_matrix &m) noexcept;
 
-  bool PollTiles(SignedRasterLocation p, unsigned radius) noexcept;
+  /**
+   * Decide which tiles shall be loaded, discarded and decoded, by
+   * their distance to the given regions and the regions' priorities.
+   *
+   * @return true if tiles have been requested
+   */
+  bool PollTiles(std::span<const RasterTileRegion> regions) noexcept;
 
   void PutTileData(unsigned index, const struct jas_matrix &m) noexcept;
 
+  /**
+   * Like PutTileData(), but with heights which were compressed
+   * elsewhere (see class TerrainPack).
+   */
+  void PutCompressedTileData(unsigned index,
+                             CompressedRasterBuffer &&data) noexcept;
+
   void FinishTileUpdate() noexcept;
 
+  unsigned GetTileCount() const noexcept {
+    return tiles.GetSize();
+  }
+
+  /**
+   * Is the specified tile requested by the last PollTiles() call?
+   */
+  [[gnu::pure]]
+  bool IsTileRequested(unsigned index) const noexcept {
+    return tiles.GetLinear(index).IsRequested();
+  }
+
+  /**
+   * Returns the compressed heights of the specified tile, or nullptr
+   * if it is not loaded.
+   */
+  [[gnu::pure]]
+  const CompressedRasterBuffer *
+  GetCompressedTile(unsigned index) const noexcept {
+    const RasterTile &tile = tiles.GetLinear(index);
+    return tile.IsLoaded() ? &tile.compressed : nullptr;
+  }
+
 public:
+  /**
+   * Returns the number of bytes allocated for the heights of all
+   * loaded tiles.
+   */
+  [[gnu::pure]]
+  std::size_t GetTileMemoryUsage() const noexcept;
+
   TerrainHeight GetMaxElevation() const noexcept {
     return overview.GetMaximum();
   }
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "Math/Point2D.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Move the contents of a two-dimensional buffer: element (x, y)
+ * receives the value of element (x + dx, y + dy).  Elements whose
+ * source is outside of the buffer are left unmodified.
+ *
+ * @param top_row pointer to the first element of the top-most row
+ * @param row_stride the distance between two rows in elements (may
+ * be negative for bottom-up bitmaps)
+ */
+template<typename T>
+void
+ScrollBuffer(T *top_row, std::ptrdiff_t row_stride, UnsignedPoint2D size,
+             int dx, int dy) noexcept
+{
+  static_assert(std::is_trivially_copyable_v<T>);
+
+  const unsigned abs_dx = std::abs(dx), abs_dy = std::abs(dy);
+  if (abs_dx >= size.x || abs_dy >= size.y)
+    return;
+
+  const std::size_t n_bytes = (size.x - abs_dx) * sizeof(T);
+  const unsigned src_x = dx > 0 ? dx : 0, dest_x = dx < 0 ? -dx : 0;
+  const unsigned height = size.y - abs_dy;
+
+  const auto row = [top_row, row_stride](unsigned y){
+    return top_row + std::ptrdiff_t(y) * row_stride;
+  };
+
+  /* copy in an order which does not overwrite rows before they have
+     been copied */
+  if (dy >= 0) {
+    for (unsigned y = 0; y < height; ++y)
+      std::memmove(row(y) + dest_x, row(y + abs_dy) + src_x, n_bytes);
+  } else {
+    for (unsigned y = height; y-- > 0;)
+      std::memmove(row(y + abs_dy) + dest_x, row(y) + src_x, n_bytes);
+  }
+}
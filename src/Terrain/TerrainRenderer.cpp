@@ -404,13 +404,19 @@ TerrainRenderer::Generate(const WindowProjection &map_projection,
     }
   }
 
+  /* if only the location has changed, the existing image can be
+     scrolled and only the newly exposed parts need to be generated */
+  const bool try_scroll = !quantisation_improved &&
+    old_bounds.IsValid() &&
+    !IsLargeSizeDifference(old_bounds, new_bounds) &&
+    terrain_serial == terrain.GetSerial() &&
+    sunazimuth.CompareRoughly(last_sun_azimuth) &&
+    map_projection.GetScale() == last_projection_scale;
 #endif
 
   terrain_serial = terrain.GetSerial();
   compare_projection = CompareProjection(map_projection);
 
-  last_sun_azimuth = sunazimuth;
-
   const bool do_water = true;
   const unsigned height_scale = 4;
   const int interp_levels = 2;
@@ -437,12 +443,21 @@ TerrainRenderer::Generate(const WindowProjection &map_projection,
 
   {
     RasterTerrain::Lease map(terrain);
-    raster_renderer.ScanMap(map, map_projection);
+#ifdef ENABLE_OPENGL
+    if (!try_scroll || !raster_renderer.ScrollMap(map, map_projection))
+#endif
+    {
+      raster_renderer.ScanMap(map, map_projection);
+
+      /* keep the old azimuth after scrolling; the scrolled image
+         was shaded with it */
+      last_sun_azimuth = sunazimuth;
+    }
   }
 
   raster_renderer.GenerateImage(do_shading, height_scale,
                                 settings.contrast, settings.brightness,
-                                sunazimuth,
+                                last_sun_azimuth,
                                 last_contour_spacing);
 
   last_projection_scale = map_projection.GetScale();
@@ -20,10 +20,14 @@ TerrainThread::Trigger(const WindowProjection &projection)
 
   GeoPoint center = projection.GetGeoScreenCenter();
   auto radius = projection.GetScreenWidthMeters() / 2;
+  const Serial regions_serial = terrain.GetRegionsSerial();
   if (last_center.IsValid() && last_radius >= radius &&
-      last_center.DistanceS(center) < 1000)
+      last_center.DistanceS(center) < 1000 &&
+      regions_serial == last_regions_serial)
     return;
 
+  last_regions_serial = regions_serial;
+
   next_center = center;
   next_radius = radius;
   StandbyThread::Trigger();
@@ -5,6 +5,7 @@
 
 #include "thread/StandbyThread.hpp"
 #include "Geo/GeoPoint.hpp"
+#include "util/Serial.hpp"
 
 #include <functional>
 
@@ -25,6 +26,12 @@ class TerrainThread final : private StandbyThread {
   GeoPoint next_center;
   double next_radius;
 
+  /**
+   * The RasterTerrain::GetRegionsSerial() value at the last
+   * Trigger() call.
+   */
+  Serial last_regions_serial;
+
 public:
   TerrainThread(RasterTerrain &_terrain, std::function<void()> &&_callback);
 
@@ -36,6 +36,15 @@ public:
   }
 #else
   void Draw(Canvas &canvas, const WindowProjection &projection) noexcept;
+
+  /**
+   * Draw directly to the canvas, bypassing the cache.  This is used
+   * when the caller caches the result itself.
+   */
+  void DrawUncached(Canvas &canvas,
+                    const WindowProjection &projection) noexcept {
+    renderer.Draw(canvas, projection);
+  }
 #endif
 
   void DrawLabels(Canvas &canvas, const WindowProjection &projection,
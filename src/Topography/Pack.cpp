@@ -0,0 +1,696 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "Pack.hpp"
+#include "XShape.hpp"
+#include "TopographyFile.hpp"
+#include "Convert.hpp"
+#include "Geo/FAISphere.hpp"
+#include "util/SpanCast.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+/*
+ * File layout:
+ *
+ * - PackHeader
+ * - the shapes of all layers: a ShapeHeader, the label, and for each
+ *   stored thinning level the number of points of each line
+ *   (uint16_t) followed by the points encoded with #ShapePointCodec
+ *   (the layout of XShape::thinned)
+ * - the index of each layer: ShapeEntry[n_shapes],
+ *   uint32_t cells[columns * rows + 1], uint32_t cell_shapes[]
+ * - the directory: one LayerHeader per layer
+ * - PackTrailer
+ */
+
+static constexpr uint32_t PACK_MAGIC = 0x504f5458; // "XTOP"
+
+struct PackHeader {
+  static constexpr uint32_t VERSION = 2;
+
+  uint32_t magic, version;
+};
+
+struct ShapeHeader {
+  uint8_t type, num_lines;
+
+  /**
+   * A bit mask of the stored thinning levels; a level which is not
+   * stored is the same as the previous one.  Level 0 is always
+   * stored.
+   */
+  uint8_t levels;
+
+  uint8_t reserved;
+
+  uint32_t label_size;
+
+  /**
+   * The size of the encoded points of each stored thinning level.
+   */
+  uint32_t point_sizes[TopographyPack::N_LEVELS];
+};
+
+struct LayerHeader {
+  char name[64];
+
+  /**
+   * The size and the CRC-32 of the ".shp" file the layer was
+   * generated from.
+   */
+  uint64_t source_size;
+  uint32_t source_crc32, reserved;
+
+  /**
+   * The center of the shapefile's bounds (native angles); all
+   * coordinates are relative to it.
+   */
+  double center_longitude, center_latitude;
+
+  int32_t bounds[4];
+
+  uint32_t columns, rows;
+  uint32_t n_shapes, n_cell_shapes;
+
+  uint64_t index_offset;
+};
+
+struct PackTrailer {
+  uint64_t directory_offset;
+  uint32_t n_layers, magic;
+};
+
+static_assert(sizeof(PackHeader) == 8, "unexpected padding");
+static_assert(sizeof(ShapeHeader) == 24, "unexpected padding");
+static_assert(sizeof(TopographyPack::ShapeEntry) == 24, "unexpected padding");
+static_assert(sizeof(LayerHeader) == 136, "unexpected padding");
+static_assert(sizeof(PackTrailer) == 16, "unexpected padding");
+static_assert(TopographyPack::N_LEVELS == XShape::THINNING_LEVELS);
+
+/**
+ * The maximum number of grid columns and rows of a layer index.
+ */
+static constexpr unsigned MAX_GRID = 256;
+
+/**
+ * The average number of shapes per grid cell the index aims for.
+ */
+static constexpr unsigned SHAPES_PER_CELL = 8;
+
+static constexpr std::size_t MAX_LABEL_SIZE = 4096;
+
+[[gnu::const]]
+static int
+QuantiseFloor(Angle a) noexcept
+{
+  return int(std::floor(a.Native() / ShapePointCodec::RESOLUTION));
+}
+
+[[gnu::const]]
+static int
+QuantiseCeil(Angle a) noexcept
+{
+  return int(std::ceil(a.Native() / ShapePointCodec::RESOLUTION));
+}
+
+[[gnu::const]]
+static Angle
+Unquantise(int value) noexcept
+{
+  return Angle::Native(value * ShapePointCodec::RESOLUTION);
+}
+
+/**
+ * Do the two quantised rectangles (west, south, east, north)
+ * overlap?
+ */
+[[gnu::pure]]
+static bool
+Overlaps(const int32_t a[4], const int32_t b[4]) noexcept
+{
+  return a[0] <= b[2] && b[0] <= a[2] && a[1] <= b[3] && b[1] <= a[3];
+}
+
+bool
+TopographyPack::Layer::WhichShapes(const GeoBounds &rect,
+                                   std::vector<bool> &result) const noexcept
+{
+  const int32_t q[4] = {
+    QuantiseFloor(rect.GetWest() - center.longitude),
+    QuantiseFloor(rect.GetSouth() - center.latitude),
+    QuantiseCeil(rect.GetEast() - center.longitude),
+    QuantiseCeil(rect.GetNorth() - center.latitude),
+  };
+
+  if (!Overlaps(q, bounds))
+    return false;
+
+  result.assign(shapes.size(), false);
+
+  const unsigned min_column = ToCell(q[0], 0), max_column = ToCell(q[2], 0);
+  const unsigned min_row = ToCell(q[1], 1), max_row = ToCell(q[3], 1);
+
+  for (unsigned row = min_row; row <= max_row; ++row) {
+    for (unsigned column = min_column; column <= max_column; ++column) {
+      const unsigned cell = row * columns + column;
+      for (uint32_t j = cells[cell]; j < cells[cell + 1]; ++j) {
+        const uint32_t i = cell_shapes[j];
+        if (!result[i] && Overlaps(q, shapes[i].bounds))
+          result[i] = true;
+      }
+    }
+  }
+
+  return true;
+}
+
+unsigned
+TopographyPack::Layer::ToCell(int value, unsigned axis) const noexcept
+{
+  const int64_t min = bounds[axis], max = bounds[axis + 2];
+  const unsigned n = axis == 0 ? columns : rows;
+
+  if (value <= min)
+    return 0;
+  if (value >= max)
+    return n - 1;
+
+  return std::min(unsigned((value - min) * n / (max - min + 1)), n - 1);
+}
+
+TopographyPack::Reader::Reader(const TopographyPack &pack)
+  :file(pack.path), file_size(file.GetSize())
+{
+}
+
+/**
+ * Check one stored thinning level (the number of points of each line
+ * followed by the encoded points) and return a pointer to the end of
+ * it.
+ *
+ * Throws if the level is malformed.
+ */
+static const std::byte *
+ValidateLevel(const std::byte *p, unsigned num_lines, std::size_t point_size)
+{
+  std::size_t num_points = 0;
+  for (unsigned i = 0; i < num_lines; ++i) {
+    /* the buffer is not aligned */
+    uint16_t n;
+    std::memcpy(&n, p, sizeof(n));
+    p += sizeof(n);
+    num_points += n;
+  }
+
+  if (!ShapePointCodec::Validate({p, point_size}, num_points))
+    throw std::runtime_error("Malformed topography pack shape");
+
+  return p + point_size;
+}
+
+std::unique_ptr<XShape>
+TopographyPack::Reader::ReadShape(const Layer &layer, std::size_t i)
+{
+  assert(i < layer.size());
+
+  const auto &entry = layer.shapes[i];
+
+  file.Seek(entry.offset);
+
+  ShapeHeader header;
+  file.ReadT(header);
+
+  if (header.num_lines > XShape::MAX_LINES ||
+      header.label_size > MAX_LABEL_SIZE ||
+      !(header.levels & 1))
+    throw std::runtime_error("Malformed topography pack shape");
+
+  const std::size_t lines_size = header.num_lines * sizeof(uint16_t);
+  uint_least64_t size = header.label_size;
+  for (unsigned level = 0; level < N_LEVELS; ++level)
+    if (header.levels & (1U << level))
+      size += lines_size + header.point_sizes[level];
+
+  if (size > file_size - entry.offset - sizeof(header))
+    throw std::runtime_error("Malformed topography pack shape");
+
+  const auto buffer = std::make_unique_for_overwrite<std::byte[]>(size);
+  file.ReadFull({buffer.get(), std::size_t(size)});
+
+  /* the decoder trusts the number of points of each line; verify
+     that it matches the encoded points of each level */
+  const std::byte *p = buffer.get() + header.label_size;
+  for (unsigned level = 0; level < N_LEVELS; ++level)
+    if (header.levels & (1U << level))
+      p = ValidateLevel(p, header.num_lines, header.point_sizes[level]);
+
+  p = buffer.get();
+
+  const std::string label{ToStringView(std::span{p, header.label_size})};
+  p += header.label_size;
+
+  const GeoBounds bounds{
+    GeoPoint{layer.center.longitude + Unquantise(entry.bounds[0]),
+             layer.center.latitude + Unquantise(entry.bounds[3])},
+    GeoPoint{layer.center.longitude + Unquantise(entry.bounds[2]),
+             layer.center.latitude + Unquantise(entry.bounds[1])},
+  };
+
+  std::unique_ptr<XShape> shape{
+    new XShape(bounds, header.type,
+               header.label_size > 0 ? label.c_str() : nullptr),
+  };
+
+  shape->num_lines = header.num_lines;
+  std::memcpy(shape->lines.data(), p, lines_size);
+  p += lines_size;
+
+#ifdef ENABLE_OPENGL
+  /* OpenGL keeps its own thinning indices (see XShape::GetIndices()),
+     so only the full level is used */
+  std::size_t num_points = 0;
+  for (const auto n : shape->GetLines())
+    num_points += n;
+
+  shape->points = std::make_unique<XShape::Point[]>(num_points);
+  ShapePointCodec::Decoder decoder{p};
+  for (std::size_t j = 0; j < num_points; ++j) {
+    const auto q = decoder.Read();
+    shape->points[j] = {
+      ShapeScalar(q.x * ShapePointCodec::RESOLUTION),
+      ShapeScalar(q.y * ShapePointCodec::RESOLUTION),
+    };
+  }
+#else
+  shape->points = std::make_unique_for_overwrite<std::byte[]>(header.point_sizes[0]);
+  std::copy_n(p, header.point_sizes[0], shape->points.get());
+  p += header.point_sizes[0];
+
+  for (unsigned level = 1; level < N_LEVELS; ++level) {
+    if (!(header.levels & (1U << level)))
+      continue;
+
+    const std::size_t point_size = header.point_sizes[level];
+
+    auto &thinned = shape->thinned[level - 1];
+    thinned = std::make_unique_for_overwrite<std::byte[]>(lines_size + point_size);
+    std::copy_n(p, lines_size + point_size, thinned.get());
+    p += lines_size + point_size;
+  }
+
+  shape->has_levels = true;
+#endif
+
+  return shape;
+}
+
+TopographyPack::TopographyPack(Path _path)
+  :path(_path)
+{
+  FileReader file(path);
+
+  const auto file_size = file.GetSize();
+  if (file_size < sizeof(PackHeader) + sizeof(PackTrailer))
+    throw std::runtime_error("Topography pack is too small");
+
+  PackHeader header;
+  file.ReadT(header);
+  if (header.magic != PACK_MAGIC || header.version != PackHeader::VERSION)
+    throw std::runtime_error("Unsupported topography pack");
+
+  file.Seek(file_size - sizeof(PackTrailer));
+  PackTrailer trailer;
+  file.ReadT(trailer);
+  if (trailer.magic != PACK_MAGIC ||
+      trailer.directory_offset > file_size - sizeof(PackTrailer) ||
+      trailer.n_layers * sizeof(LayerHeader) !=
+      file_size - sizeof(PackTrailer) - trailer.directory_offset)
+    throw std::runtime_error("Malformed topography pack trailer");
+
+  AllocatedArray<LayerHeader> directory(trailer.n_layers);
+  file.Seek(trailer.directory_offset);
+  file.ReadFull(std::as_writable_bytes(std::span{directory}));
+
+  layers.reserve(directory.size());
+  for (const auto &h : directory) {
+    if (h.name[sizeof(h.name) - 1] != 0 ||
+        h.columns == 0 || h.columns > MAX_GRID ||
+        h.rows == 0 || h.rows > MAX_GRID ||
+        h.index_offset >= trailer.directory_offset)
+      throw std::runtime_error("Malformed topography pack directory");
+
+    auto &layer = layers.emplace_back();
+    layer.name = h.name;
+    layer.source_size = h.source_size;
+    layer.source_crc32 = h.source_crc32;
+    layer.center = GeoPoint{Angle::Native(h.center_longitude),
+                            Angle::Native(h.center_latitude)};
+    std::copy_n(h.bounds, 4, layer.bounds);
+    layer.columns = h.columns;
+    layer.rows = h.rows;
+
+    layer.shapes.ResizeDiscard(h.n_shapes);
+    layer.cells.ResizeDiscard(h.columns * h.rows + 1);
+    layer.cell_shapes.ResizeDiscard(h.n_cell_shapes);
+
+    file.Seek(h.index_offset);
+    file.ReadFull(std::as_writable_bytes(std::span{layer.shapes}));
+    file.ReadFull(std::as_writable_bytes(std::span{layer.cells}));
+    file.ReadFull(std::as_writable_bytes(std::span{layer.cell_shapes}));
+
+    for (const auto &entry : layer.shapes)
+      if (entry.offset < sizeof(PackHeader) ||
+          entry.offset >= trailer.directory_offset)
+        throw std::runtime_error("Malformed topography pack index");
+
+    if (layer.cells.front() != 0 ||
+        layer.cells.back() != h.n_cell_shapes ||
+        !std::is_sorted(layer.cells.begin(), layer.cells.end()) ||
+        std::any_of(layer.cell_shapes.begin(), layer.cell_shapes.end(),
+                    [n = h.n_shapes](uint32_t i){ return i >= n; }))
+      throw std::runtime_error("Malformed topography pack index");
+  }
+}
+
+const TopographyPack::Layer *
+TopographyPack::FindLayer(std::string_view name,
+                          uint_least64_t source_size,
+                          uint_least32_t source_crc32) const noexcept
+{
+  for (const auto &layer : layers)
+    if (layer.name == name && layer.source_size == source_size &&
+        layer.source_crc32 == source_crc32)
+      return &layer;
+
+  return nullptr;
+}
+
+struct TopographyPackWriter::PendingLayer {
+  LayerHeader header;
+
+  GeoPoint center;
+
+  /**
+   * The minimum distance between two points in each thinning level
+   * [quantisation steps].
+   */
+  unsigned min_distance[TopographyPack::N_LEVELS];
+
+  std::vector<TopographyPack::ShapeEntry> shapes;
+
+  PendingLayer(std::string_view name, uint_least64_t source_size,
+               uint_least32_t source_crc32,
+               const GeoBounds &bounds, double scale_threshold) noexcept
+    :center(bounds.GetCenter())
+  {
+    std::fill_n(reinterpret_cast<char *>(&header), sizeof(header), 0);
+    std::copy_n(name.data(), name.size(), header.name);
+    header.source_size = source_size;
+    header.source_crc32 = source_crc32;
+    header.center_longitude = center.longitude.Native();
+    header.center_latitude = center.latitude.Native();
+    header.bounds[0] = header.bounds[1] = INT32_MAX;
+    header.bounds[2] = header.bounds[3] = INT32_MIN;
+
+    min_distance[0] = 0;
+    for (unsigned level = 1; level < TopographyPack::N_LEVELS; ++level)
+      min_distance[level] =
+        unsigned(double(TopographyFile::GetMinimumPointDistance(scale_threshold,
+                                                                level))
+                 / FAISphere::REARTH / ShapePointCodec::RESOLUTION);
+  }
+
+  /**
+   * Write the index to the file, and fill in the remaining
+   * #LayerHeader attributes.
+   */
+  void WriteIndex(BufferedOutputStream &os, uint64_t offset);
+};
+
+void
+TopographyPackWriter::PendingLayer::WriteIndex(BufferedOutputStream &os,
+                                               uint64_t offset)
+{
+  const std::size_t n = shapes.size();
+  const unsigned side =
+    std::clamp(unsigned(std::ceil(std::sqrt(double(n) / SHAPES_PER_CELL))),
+               1U, MAX_GRID);
+
+  if (header.bounds[0] > header.bounds[2])
+    /* no shapes */
+    std::fill_n(header.bounds, 4, 0);
+
+  header.columns = header.rows = side;
+  header.n_shapes = n;
+  header.index_offset = offset;
+
+  /* use a temporary Layer to calculate the cells of each shape */
+  TopographyPack::Layer layer;
+  std::copy_n(header.bounds, 4, layer.bounds);
+  layer.columns = layer.rows = side;
+
+  std::vector<std::vector<uint32_t>> grid(side * side);
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto &b = shapes[i].bounds;
+    const unsigned min_column = layer.ToCell(b[0], 0);
+    const unsigned max_column = layer.ToCell(b[2], 0);
+    const unsigned min_row = layer.ToCell(b[1], 1);
+    const unsigned max_row = layer.ToCell(b[3], 1);
+
+    for (unsigned row = min_row; row <= max_row; ++row)
+      for (unsigned column = min_column; column <= max_column; ++column)
+        grid[row * side + column].push_back(i);
+  }
+
+  std::vector<uint32_t> cells;
+  cells.reserve(grid.size() + 1);
+  uint32_t n_cell_shapes = 0;
+  for (const auto &cell : grid) {
+    cells.push_back(n_cell_shapes);
+    n_cell_shapes += cell.size();
+  }
+  cells.push_back(n_cell_shapes);
+
+  header.n_cell_shapes = n_cell_shapes;
+
+  os.Write(std::as_bytes(std::span{shapes}));
+  os.Write(std::as_bytes(std::span{cells}));
+  for (const auto &cell : grid)
+    os.Write(std::as_bytes(std::span{cell}));
+}
+
+TopographyPackWriter::TopographyPackWriter(Path path)
+  :file(path), os(file)
+{
+  PackHeader header;
+  header.magic = PACK_MAGIC;
+  header.version = PackHeader::VERSION;
+  os.WriteT(header);
+}
+
+TopographyPackWriter::~TopographyPackWriter() noexcept = default;
+
+void
+TopographyPackWriter::BeginLayer(std::string_view name,
+                                 uint_least64_t source_size,
+                                 uint_least32_t source_crc32,
+                                 const GeoBounds &bounds,
+                                 double scale_threshold)
+{
+  if (name.size() >= sizeof(LayerHeader::name))
+    throw std::runtime_error("Topography layer name is too long");
+
+  layers.emplace_back(name, source_size, source_crc32, bounds,
+                      scale_threshold);
+}
+
+using QuantisedLine = std::vector<ShapePointCodec::Point>;
+
+/**
+ * Simplify a line the way XShape::BuildIndices() does: drop points
+ * which are too close to the previous one, but keep the first and the
+ * last point.
+ *
+ * @param min_points the minimum number of points of the result;
+ * polygons which are simplified below this are omitted
+ */
+static QuantisedLine
+ThinLine(const QuantisedLine &src, unsigned min_distance,
+         std::size_t min_points) noexcept
+{
+  if (min_distance == 0 || src.size() <= 2)
+    return src;
+
+  QuantisedLine dest;
+  dest.push_back(src.front());
+
+  for (auto p = std::next(src.begin()), end = std::prev(src.end());
+       p != end; ++p)
+    if (ManhattanDistance<ShapePointCodec::Point, int64_t>(dest.back(), *p) >=
+        min_distance)
+      dest.push_back(*p);
+
+  /* remove points which are too close to the last point */
+  while (dest.size() > 1 &&
+         ManhattanDistance<ShapePointCodec::Point, int64_t>(dest.back(),
+                                                            src.back()) <
+         min_distance)
+    dest.pop_back();
+
+  dest.push_back(src.back());
+
+  if (dest.size() < min_points)
+    dest.clear();
+
+  return dest;
+}
+
+void
+TopographyPackWriter::AddShape(const shapeObj &shape, const char *label)
+{
+  assert(!layers.empty());
+
+  auto &layer = layers.back();
+
+  const GeoBounds shape_bounds = ImportRect(shape.bounds);
+  if (!shape_bounds.Check())
+    throw std::runtime_error("Malformed shape bounds");
+
+  auto &entry = layer.shapes.emplace_back();
+  entry.bounds[0] = QuantiseFloor(shape_bounds.GetWest() - layer.center.longitude);
+  entry.bounds[1] = QuantiseFloor(shape_bounds.GetSouth() - layer.center.latitude);
+  entry.bounds[2] = QuantiseCeil(shape_bounds.GetEast() - layer.center.longitude);
+  entry.bounds[3] = QuantiseCeil(shape_bounds.GetNorth() - layer.center.latitude);
+
+  for (unsigned i = 0; i < 2; ++i) {
+    layer.header.bounds[i] = std::min(layer.header.bounds[i], entry.bounds[i]);
+    layer.header.bounds[i + 2] = std::max(layer.header.bounds[i + 2],
+                                          entry.bounds[i + 2]);
+  }
+
+  /* import the lines like the XShape constructor does */
+
+  std::size_t min_points;
+  switch (shape.type) {
+  case MS_SHAPE_POINT:
+    min_points = 1;
+    break;
+
+  case MS_SHAPE_LINE:
+    min_points = 2;
+    break;
+
+  case MS_SHAPE_POLYGON:
+    min_points = 3;
+    break;
+
+  default:
+    /* not supported, write an empty shape */
+    min_points = SIZE_MAX;
+    break;
+  }
+
+  std::vector<QuantisedLine> lines;
+  for (int l = 0; l < shape.numlines && lines.size() < XShape::MAX_LINES; ++l) {
+    const lineObj &src = shape.line[l];
+    if (std::size_t(src.numpoints) < min_points)
+      /* malformed shape */
+      continue;
+
+    auto &line = lines.emplace_back();
+    const std::size_t n = std::min(src.numpoints, 16384);
+    line.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      const GeoPoint relative =
+        GeoPoint(Angle::Degrees(src.point[i].x),
+                 Angle::Degrees(src.point[i].y)) - layer.center;
+      line.push_back({
+        ShapePointCodec::Quantise(relative.longitude.Native()),
+        ShapePointCodec::Quantise(relative.latitude.Native()),
+      });
+    }
+  }
+
+  ShapeHeader header{};
+  header.type = shape.type;
+  header.num_lines = lines.size();
+
+  const std::string_view label_view = label != nullptr
+    ? std::string_view{label}.substr(0, MAX_LABEL_SIZE)
+    : std::string_view{};
+  header.label_size = label_view.size();
+
+  /* encode all levels; a level which is equal to the previous one is
+     omitted */
+
+  std::vector<std::byte> levels[TopographyPack::N_LEVELS];
+  std::vector<QuantisedLine> previous;
+
+  for (unsigned level = 0; level < TopographyPack::N_LEVELS; ++level) {
+    std::vector<QuantisedLine> thinned;
+    thinned.reserve(lines.size());
+    for (const auto &line : lines)
+      thinned.push_back(shape.type == MS_SHAPE_POINT
+                        ? line
+                        : ThinLine(line, layer.min_distance[level],
+                                   min_points));
+
+    if (level > 0 && thinned == previous)
+      continue;
+
+    auto &dest = levels[level];
+    for (const auto &line : thinned) {
+      const uint16_t n = line.size();
+      const auto b = ReferenceAsBytes(n);
+      dest.insert(dest.end(), b.begin(), b.end());
+    }
+
+    const std::size_t lines_size = dest.size();
+    ShapePointCodec::Encoder encoder{dest};
+    for (const auto &line : thinned)
+      for (const auto p : line)
+        encoder.Add(p);
+
+    header.levels |= 1U << level;
+    header.point_sizes[level] = dest.size() - lines_size;
+
+    previous = std::move(thinned);
+  }
+
+  os.Flush();
+  entry.offset = file.Tell();
+
+  os.WriteT(header);
+  os.Write(AsBytes(label_view));
+
+  for (const auto &level : levels)
+    os.Write(std::span{level});
+}
+
+void
+TopographyPackWriter::Commit()
+{
+  for (auto &layer : layers) {
+    os.Flush();
+    layer.WriteIndex(os, file.Tell());
+  }
+
+  os.Flush();
+
+  PackTrailer trailer;
+  trailer.directory_offset = file.Tell();
+  trailer.n_layers = layers.size();
+  trailer.magic = PACK_MAGIC;
+
+  for (const auto &layer : layers)
+    os.WriteT(layer.header);
+
+  os.WriteT(trailer);
+  os.Flush();
+  file.Commit();
+}
@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "ShapePointCodec.hpp"
+#include "shapelib/mapserver.h"
+#include "Geo/GeoBounds.hpp"
+#include "io/FileReader.hxx"
+#include "io/FileOutputStream.hxx"
+#include "io/BufferedOutputStream.hxx"
+#include "system/Path.hpp"
+#include "util/AllocatedArray.hxx"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class XShape;
+
+/**
+ * A topography pack is a file next to the map file (with the suffix
+ * ".xtop") which contains the shapes of all topography layers in a
+ * form which can be loaded quickly:
+ *
+ * - the points are quantised and encoded with #ShapePointCodec, so
+ *   the non-OpenGL #XShape can use them without conversion;
+ *
+ * - each shape has simplified versions for the coarser thinning
+ *   levels (see TopographyFile::GetThinningLevel());
+ *
+ * - each layer has a grid index which finds the shapes within a
+ *   rectangle without reading the shapefile's ".qix" file.
+ *
+ * Packs are generated on a PC with the program "PackTopography".
+ * The file is stored in host byte order; a pack generated on a
+ * machine with a different byte order is rejected.
+ */
+class TopographyPack {
+public:
+  /**
+   * The number of detail levels of each shape, see
+   * TopographyFile::GetThinningLevel().
+   */
+  static constexpr unsigned N_LEVELS = 4;
+
+  /**
+   * An entry of the shape index: the quantised bounds of a shape
+   * (relative to the layer center) and its position in the file.
+   */
+  struct ShapeEntry {
+    uint64_t offset;
+
+    /**
+     * West, south, east, north in #ShapePointCodec::RESOLUTION
+     * steps.
+     */
+    int32_t bounds[4];
+  };
+
+  class Layer {
+    friend class TopographyPack;
+    friend class TopographyPackWriter;
+
+    std::string name;
+
+    uint64_t source_size;
+
+    uint32_t source_crc32;
+
+    GeoPoint center;
+
+    /**
+     * The quantised bounds of all shapes (west, south, east, north).
+     */
+    int32_t bounds[4];
+
+    unsigned columns, rows;
+
+    AllocatedArray<ShapeEntry> shapes;
+
+    /**
+     * For each grid cell (row by row), the index of its first
+     * element in #cell_shapes; one extra element marks the end.
+     */
+    AllocatedArray<uint32_t> cells;
+
+    /**
+     * The indices of the shapes intersecting each cell.
+     */
+    AllocatedArray<uint32_t> cell_shapes;
+
+  public:
+    std::size_t size() const noexcept {
+      return shapes.size();
+    }
+
+    const GeoPoint &GetCenter() const noexcept {
+      return center;
+    }
+
+    /**
+     * Determine which shapes intersect the given rectangle.
+     *
+     * @param result receives one flag per shape
+     * @return false if the rectangle is outside of this layer
+     */
+    bool WhichShapes(const GeoBounds &rect,
+                     std::vector<bool> &result) const noexcept;
+
+  private:
+    /**
+     * Returns the grid column or row of the given quantised
+     * coordinate, clipped to the grid.
+     */
+    [[gnu::pure]]
+    unsigned ToCell(int value, unsigned axis) const noexcept;
+  };
+
+  /**
+   * Reads shapes from the pack.  Each thread needs its own instance.
+   */
+  class Reader {
+    FileReader file;
+
+    uint_least64_t file_size;
+
+  public:
+    /**
+     * Throws on error.
+     */
+    explicit Reader(const TopographyPack &pack);
+
+    /**
+     * Throws on error, e.g. if the shape is malformed.
+     */
+    std::unique_ptr<XShape> ReadShape(const Layer &layer, std::size_t i);
+  };
+
+private:
+  AllocatedPath path;
+
+  std::vector<Layer> layers;
+
+public:
+  /**
+   * Open the pack and load the index of all layers.
+   *
+   * Throws on error.
+   */
+  explicit TopographyPack(Path _path);
+
+  /**
+   * Find the layer which was generated from the given shapefile.
+   *
+   * @param source_size the size of the ".shp" file
+   * @param source_crc32 the CRC-32 of the ".shp" file (from the ZIP
+   * directory); a layer generated from a different file is ignored
+   */
+  [[gnu::pure]]
+  const Layer *FindLayer(std::string_view name,
+                         uint_least64_t source_size,
+                         uint_least32_t source_crc32) const noexcept;
+};
+
+/**
+ * Generates a #TopographyPack.
+ */
+class TopographyPackWriter {
+  FileOutputStream file;
+  BufferedOutputStream os;
+
+  struct PendingLayer;
+  std::vector<PendingLayer> layers;
+
+  std::vector<std::byte> buffer;
+
+public:
+  /**
+   * Throws on error.
+   */
+  explicit TopographyPackWriter(Path path);
+  ~TopographyPackWriter() noexcept;
+
+  /**
+   * Start a new layer.  Its shapes are added with AddShape().
+   *
+   * Throws on error.
+   *
+   * @param name the name of the ".shp" file in the map file
+   * @param source_size the size of the ".shp" file
+   * @param source_crc32 the CRC-32 of the ".shp" file
+   * @param bounds the bounds of the shapefile
+   * @param scale_threshold the zoom threshold of the layer, which
+   * determines the simplification of the thinning levels
+   */
+  void BeginLayer(std::string_view name, uint_least64_t source_size,
+                  uint_least32_t source_crc32,
+                  const GeoBounds &bounds, double scale_threshold);
+
+  /**
+   * Add the next shape of the current layer.  Shapes must be added
+   * in the order of the shapefile.
+   *
+   * Throws on error.
+   *
+   * @param label the raw label, or nullptr
+   */
+  void AddShape(const shapeObj &shape, const char *label);
+
+  /**
+   * Write the index and finish the file.
+   *
+   * Throws on error.
+   */
+  void Commit();
+};
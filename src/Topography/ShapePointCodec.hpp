@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "Math/Point2D.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * Compact storage for the vertices of topography shapes, used when
+ * the shapes are not uploaded to OpenGL.
+ *
+ * Coordinates are native angles relative to the file center,
+ * quantised to integer multiples of #RESOLUTION.  Each point is
+ * stored as the difference to its predecessor (the first one is
+ * relative to the file center) as two zigzag-encoded variable-length
+ * integers.  Neighbouring vertices are usually close together, so a
+ * typical point takes 2-4 bytes instead of 16 for a #GeoPoint.
+ */
+namespace ShapePointCodec {
+
+/**
+ * The size of one quantisation step in native angle units
+ * (radians).  This is about 0.6 m on the earth's surface.
+ */
+static constexpr double RESOLUTION = 1e-7;
+
+using Point = IntPoint2D;
+
+/**
+ * Convert a native angle (relative to the file center) to
+ * quantisation steps.
+ */
+inline int
+Quantise(double native) noexcept
+{
+  return int(std::lround(native / RESOLUTION));
+}
+
+constexpr uint32_t
+ZigZagEncode(int32_t value) noexcept
+{
+  return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+constexpr int32_t
+ZigZagDecode(uint32_t value) noexcept
+{
+  return int32_t(value >> 1) ^ -int32_t(value & 1);
+}
+
+class Encoder {
+  std::vector<std::byte> &buffer;
+
+  Point last{0, 0};
+
+public:
+  explicit Encoder(std::vector<std::byte> &_buffer) noexcept
+    :buffer(_buffer) {}
+
+  void Add(Point p) {
+    Write(ZigZagEncode(p.x - last.x));
+    Write(ZigZagEncode(p.y - last.y));
+    last = p;
+  }
+
+private:
+  void Write(uint32_t value) {
+    while (value >= 0x80) {
+      buffer.push_back(std::byte(value | 0x80));
+      value >>= 7;
+    }
+
+    buffer.push_back(std::byte(value));
+  }
+};
+
+/**
+ * Check whether the buffer contains exactly @a n points written by
+ * #Encoder, i.e. whether #Decoder can read @a n points from it
+ * without overrunning it.  This is used to validate data loaded from
+ * a file before decoding it.
+ */
+[[gnu::pure]]
+constexpr bool
+Validate(std::span<const std::byte> src, std::size_t n) noexcept
+{
+  std::size_t n_varints = 0;
+
+  /* the number of continuation bytes of the current varint; a
+     32 bit value has at most 4 */
+  unsigned length = 0;
+
+  for (const auto b : src) {
+    if ((b & std::byte{0x80}) == std::byte{}) {
+      ++n_varints;
+      length = 0;
+    } else if (++length > 4)
+      return false;
+  }
+
+  return length == 0 && n_varints == 2 * n;
+}
+
+/**
+ * Reads the points written by #Encoder in the same order.  The caller
+ * is responsible for not reading past the last point, see
+ * Validate().
+ */
+class Decoder {
+  const std::byte *p;
+
+  Point last{0, 0};
+
+public:
+  explicit constexpr Decoder(const std::byte *_p) noexcept
+    :p(_p) {}
+
+  constexpr Point Read() noexcept {
+    last.x += ZigZagDecode(ReadVarint());
+    last.y += ZigZagDecode(ReadVarint());
+    return last;
+  }
+
+  constexpr void Skip(std::size_t n) noexcept {
+    for (; n > 0; --n)
+      Read();
+  }
+
+private:
+  constexpr uint32_t ReadVarint() noexcept {
+    uint32_t value = 0;
+    unsigned shift = 0;
+
+    uint8_t b;
+    do {
+      b = uint8_t(*p++);
+      value |= uint32_t(b & 0x7f) << shift;
+      shift += 7;
+    } while (b & 0x80);
+
+    return value;
+  }
+};
+
+} // namespace ShapePointCodec
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "ShapePointCodec.hpp"
+#include "Projection/Projection.hpp"
+#include "Math/FastRotation.hpp"
+#include "Geo/FAISphere.hpp"
+#include "Geo/GeoPoint.hpp"
+#include "ui/dim/Point.hpp"
+
+/**
+ * A fast replacement for Projection::GeoToScreen() for points
+ * relative to the center of a #TopographyFile, quantised with
+ * #ShapePointCodec.
+ *
+ * Instead of looking up the cosine of each point's latitude, it uses
+ * a third-order approximation around the screen center's latitude,
+ * which keeps the result within one pixel of GeoToScreen() even at
+ * the widest zoom levels.  Truncation and rotation are the same as
+ * in GeoToScreen().
+ */
+class ShapeProjection {
+  const GeoPoint location;
+
+  /**
+   * The offset of the screen center from the file center [rad].
+   */
+  double l0, a0;
+
+  /**
+   * Pixels per radian, multiplied with the cosine and the sine of
+   * the screen center's latitude.
+   */
+  double d, d_cos, d_sin;
+
+  const FastIntegerRotation rotation;
+  const PixelPoint origin;
+
+public:
+  ShapeProjection(const Projection &projection,
+                  const GeoPoint &reference) noexcept
+    :location(projection.GetGeoLocation()),
+     rotation(projection.GetScreenAngle()),
+     origin(projection.GetScreenOrigin())
+  {
+    const GeoPoint delta = location - reference;
+    l0 = delta.longitude.Native();
+    a0 = delta.latitude.Native();
+
+    d = projection.GetScale() * FAISphere::REARTH;
+
+    const auto [sin_latitude, cos_latitude] = location.latitude.SinCos();
+    d_cos = d * cos_latitude;
+    d_sin = d * sin_latitude;
+  }
+
+  /**
+   * @param longitude the longitude relative to the screen center [rad]
+   * @param latitude the latitude relative to the screen center [rad]
+   */
+  PixelPoint Project(double longitude, double latitude) const noexcept {
+    /* Taylor series of cos() around the screen center's latitude */
+    const double l2 = latitude * latitude;
+    const IntPoint2D p{
+      int(longitude * (d_sin * latitude * (1 - l2 / 6) -
+                       d_cos * (1 - l2 / 2))),
+      int(-d * latitude),
+    };
+
+    const auto r = rotation.Rotate(p);
+    return {origin.x - r.x, origin.y + r.y};
+  }
+
+  PixelPoint operator()(ShapePointCodec::Point p) const noexcept {
+    constexpr double r = ShapePointCodec::RESOLUTION;
+    return Project(p.x * r - l0, p.y * r - a0);
+  }
+
+  PixelPoint operator()(const GeoPoint &g) const noexcept {
+    const GeoPoint relative = g - location;
+    return Project(relative.longitude.Native(), relative.latitude.Native());
+  }
+};
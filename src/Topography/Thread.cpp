@@ -4,6 +4,9 @@
 #include "Thread.hpp"
 #include "TopographyStore.hpp"
 
+#include <algorithm>
+#include <thread>
+
 TopographyThread::TopographyThread(TopographyStore &_store,
                                    std::function<void()> &&_callback)
   :StandbyThread("Topography"),
@@ -38,22 +41,49 @@ TopographyThread::Trigger(const WindowProjection &_projection)
   {
     const std::lock_guard lock{mutex};
     next_projection = _projection;
+    projection_changed = true;
     StandbyThread::Trigger();
   }
 }
 
+bool
+TopographyThread::IsObsolete(const TopographyFile &file,
+                             const GeoBounds &bounds) noexcept
+{
+  const std::lock_guard lock{mutex};
+
+  if (IsStopped())
+    return true;
+
+  if (!projection_changed)
+    return false;
+
+  /* abort only if the new projection needs something else from this
+     file; the other files continue loading */
+  return !file.IsVisible(next_projection.GetMapScale()) ||
+    !bounds.IsInside(next_projection.GetScreenBounds());
+}
+
 void
 TopographyThread::Tick() noexcept
 {
   // TODO: call only once
   SetIdlePriority();
 
-  bool again = true;
-  while (next_projection.IsValid() && again && !IsStopped()) {
+  const unsigned n_threads =
+    std::clamp(std::thread::hardware_concurrency(), 1u, MAX_THREADS);
+
+  const auto cancel = [this](const TopographyFile &file,
+                             const GeoBounds &bounds){
+    return IsObsolete(file, bounds);
+  };
+
+  while (next_projection.IsValid() && projection_changed && !IsStopped()) {
     const WindowProjection projection = next_projection;
+    projection_changed = false;
 
     const ScopeUnlock unlock(mutex);
-    again = store.ScanVisibility(projection, 1) > 0;
+    store.ScanVisibility(projection, n_threads, cancel);
   }
 
   /* notify the client that we have updated the topography cache */
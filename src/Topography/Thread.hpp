@@ -10,17 +10,31 @@
 #include <functional>
 
 class TopographyStore;
+class TopographyFile;
 
 /**
- * A thread that loads topography files asynchronously.
+ * A thread that loads topography files asynchronously.  The files
+ * are updated in parallel on a few short-lived helper threads.
  */
 class TopographyThread final : private StandbyThread {
+  /**
+   * The maximum number of threads which update files concurrently
+   * (including this one).
+   */
+  static constexpr unsigned MAX_THREADS = 4;
+
   TopographyStore &store;
 
   const std::function<void()> callback;
 
   WindowProjection next_projection;
 
+  /**
+   * Was #next_projection modified while an update was in progress?
+   * Protected by the mutex.
+   */
+  bool projection_changed = false;
+
   GeoBounds last_bounds;
   double scale_threshold;
 
@@ -33,6 +47,15 @@ public:
   void Trigger(const WindowProjection &_projection);
 
 private:
+  /**
+   * Shall the update of the given file be aborted, because a new
+   * projection was submitted which it does not cover?
+   *
+   * @param bounds the cache bounds which are being loaded
+   */
+  bool IsObsolete(const TopographyFile &file,
+                  const GeoBounds &bounds) noexcept;
+
   /* virtual methods from class StandbyThread*/
   void Tick() noexcept override;
 };
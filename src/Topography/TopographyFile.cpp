@@ -5,6 +5,7 @@
 #include "Topography/XShape.hpp"
 #include "Convert.hpp"
 #include "Projection/WindowProjection.hpp"
+#include "Tracing/Tracing.hpp"
 #include "util/ScopeExit.hxx"
 
 #include <zzip/lib.h>
@@ -20,9 +21,9 @@ TopographyFile::TopographyFile(zzip_dir *_dir, const char *filename,
                                int _label_field,
                                ResourceId _icon, ResourceId _big_icon,
                                ResourceId _ultra_icon,
-                               unsigned _pen_width)
+                               unsigned _pen_width,
+                               std::shared_ptr<const TopographyPack> _pack)
   :dir(_dir),
-   file(dir, filename),
    label_field(_label_field),
    icon(_icon), big_icon(_big_icon), ultra_icon(_ultra_icon),
    pen_width(_pen_width),
@@ -30,7 +31,23 @@ TopographyFile::TopographyFile(zzip_dir *_dir, const char *filename,
    label_threshold(_label_threshold),
    important_label_threshold(_important_label_threshold)
 {
-  const std::size_t n_shapes = file.size();
+  if (_pack != nullptr && dir != nullptr) {
+    /* the pack is used only if it was generated from this very
+       shapefile; the CRC-32 is read from the ZIP directory, so this
+       does not read the file */
+    ZZIP_STAT st;
+    if (zzip_dir_stat(dir, filename, &st, 0) == 0)
+      pack_layer = _pack->FindLayer(filename, st.st_size, st.d_crc32);
+    if (pack_layer != nullptr)
+      pack = std::move(_pack);
+  }
+
+  if (pack == nullptr)
+    file.emplace(dir, filename);
+
+  const std::size_t n_shapes = pack != nullptr
+    ? pack_layer->size()
+    : file->size();
   constexpr std::size_t MAX_SHAPES = 16 * 1024 * 1024;
   if (n_shapes == 0)
     throw std::runtime_error{"Empty shapefile"};
@@ -38,11 +55,15 @@ TopographyFile::TopographyFile(zzip_dir *_dir, const char *filename,
   if (n_shapes > MAX_SHAPES)
     throw std::runtime_error{"Too many shapes in shapefile"};
 
-  const auto file_bounds = ImportRect(file.GetBounds());
-  if (!file_bounds.Check())
-    throw std::runtime_error{"Malformed shapefile bounds"};
+  if (pack != nullptr) {
+    center = pack_layer->GetCenter();
+  } else {
+    const auto file_bounds = ImportRect(file->GetBounds());
+    if (!file_bounds.Check())
+      throw std::runtime_error{"Malformed shapefile bounds"};
 
-  center = file_bounds.GetCenter();
+    center = file_bounds.GetCenter();
+  }
 
   shapes.ResizeDiscard(n_shapes);
 
@@ -84,8 +105,29 @@ LoadShape(ShapeFile &file, GeoPoint &center, std::size_t i, int label_field)
   return std::make_unique<XShape>(shape, center, label);
 }
 
+std::unique_ptr<XShape>
+TopographyFile::LoadShape(std::size_t i,
+                          std::optional<TopographyPack::Reader> &pack_reader)
+{
+  Tracing::Count(Tracing::Counter::TOPOGRAPHY_SHAPES);
+
+  if (pack == nullptr)
+    return ::LoadShape(*file, center, i, label_field);
+
+  if (!pack_reader)
+    pack_reader.emplace(*pack);
+
+  return pack_reader->ReadShape(*pack_layer, i);
+}
+
+/**
+ * Check the #CancelFunction after this number of shapes.
+ */
+static constexpr std::size_t CANCEL_CHECK_INTERVAL = 64;
+
 bool
-TopographyFile::Update(const WindowProjection &map_projection)
+TopographyFile::Update(const WindowProjection &map_projection,
+                       const CancelFunction &cancel)
 {
   if (map_projection.GetMapScale() > scale_threshold)
     /* not visible, don't update cache now */
@@ -99,29 +141,48 @@ TopographyFile::Update(const WindowProjection &map_projection)
 
   cache_bounds = screenRect.Scale(2);
 
-  // Test which shapes are inside the given bounds and save the
-  // status to file.status
-  switch (file.WhichShapes(dir, ConvertRect(cache_bounds))) {
-  case MS_FAILURE:
-    ClearCache();
-    throw std::runtime_error{"Failed to update shapefile"};
-
-  case MS_DONE:
-    /* screen is outside of map bounds */
-    return false;
+  // Test which shapes are inside the given bounds
+  std::vector<bool> pack_status;
+  ms_const_bitarray status = nullptr;
+  if (pack != nullptr) {
+    if (!pack_layer->WhichShapes(cache_bounds, pack_status))
+      /* screen is outside of map bounds */
+      return false;
+  } else {
+    // save the status to file.status
+    switch (file->WhichShapes(dir, ConvertRect(cache_bounds))) {
+    case MS_FAILURE:
+      ClearCache();
+      throw std::runtime_error{"Failed to update shapefile"};
+
+    case MS_DONE:
+      /* screen is outside of map bounds */
+      return false;
+
+    case MS_SUCCESS:
+      break;
+    }
 
-  case MS_SUCCESS:
-    break;
+    status = file->GetStatus();
+    assert(status != nullptr);
   }
 
-  const auto status = file.GetStatus();
-  assert(status != nullptr);
+  std::optional<TopographyPack::Reader> pack_reader;
 
   // Iterate through the shapefile entries
   auto prev = list.before_begin();
   auto it = shapes.begin();
-  for (std::size_t i = 0; i < file.size(); ++i, ++it) {
-    if (!msGetBit(status, i)) {
+  for (std::size_t i = 0; i < shapes.size(); ++i, ++it) {
+    if (cancel && i % CANCEL_CHECK_INTERVAL == 0 &&
+        cancel(*this, cache_bounds)) {
+      /* the shapes before #i are up to date, the rest is still from
+         the old bounds; the list is consistent either way, and the
+         next call will finish the job */
+      cache_bounds = GeoBounds::Invalid();
+      return true;
+    }
+
+    if (pack != nullptr ? !pack_status[i] : !msGetBit(status, i)) {
       // If the shape is outside the bounds
       // delete the shape from the cache
       if (it->shape != nullptr) {
@@ -144,7 +205,7 @@ TopographyFile::Update(const WindowProjection &map_projection)
         assert(&*std::next(prev) != &*it);
 
         // shape isn't cached yet -> cache the shape
-        it->shape = LoadShape(file, center, i, label_field);
+        it->shape = LoadShape(i, pack_reader);
 
         /* insert into linked list (protected) */
         {
@@ -167,14 +228,16 @@ TopographyFile::Update(const WindowProjection &map_projection)
 void
 TopographyFile::LoadAll()
 {
+  std::optional<TopographyPack::Reader> pack_reader;
+
   // Iterate through the shapefile entries
   auto prev = list.before_begin();
   auto it = shapes.begin();
-  for (std::size_t i = 0; i < file.size(); ++i, ++it) {
+  for (std::size_t i = 0; i < shapes.size(); ++i, ++it) {
     if (it->shape == nullptr) {
       assert(&*std::next(prev) != &*it);
       // shape isn't cached yet -> cache the shape
-      it->shape = LoadShape(file, center, i, label_field);
+      it->shape = LoadShape(i, pack_reader);
       // update list pointer
       prev = list.insert_after(prev, *it);
     } else {
@@ -200,8 +263,6 @@ TopographyFile::GetSkipSteps(double map_scale) const noexcept
   return 1;
 }
 
-#ifdef ENABLE_OPENGL
-
 unsigned
 TopographyFile::GetThinningLevel(double map_scale) const noexcept
 {
@@ -216,7 +277,8 @@ TopographyFile::GetThinningLevel(double map_scale) const noexcept
 }
 
 unsigned
-TopographyFile::GetMinimumPointDistance(unsigned level) const noexcept
+TopographyFile::GetMinimumPointDistance(double scale_threshold,
+                                        unsigned level) noexcept
 {
   switch (level) {
     case 1:
@@ -228,5 +290,3 @@ TopographyFile::GetMinimumPointDistance(unsigned level) const noexcept
   }
   return 1;
 }
-
-#endif
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "ShapeFile.hpp"
+#include "Pack.hpp"
 #include "Geo/GeoBounds.hpp"
 #include "util/AllocatedArray.hxx"
 #include "util/IntrusiveForwardList.hxx"
@@ -14,16 +15,30 @@
 
 #ifdef ENABLE_OPENGL
 #include "XShapePoint.hpp"
+#else
+#include "ShapePointCodec.hpp"
 #endif
 
 #include <cassert>
+#include <functional>
 #include <memory>
+#include <optional>
 
 class WindowProjection;
 class XShape;
 struct zzip_dir;
 
 class TopographyFile {
+public:
+  /**
+   * Called periodically by Update() to check whether the update is
+   * still wanted.  It receives the file and the new cache bounds
+   * which are being loaded; returning true aborts the update.
+   */
+  using CancelFunction =
+    std::function<bool(const TopographyFile &file, const GeoBounds &bounds)>;
+
+private:
   struct ShapeEnvelope final : IntrusiveForwardListHook {
     std::unique_ptr<const XShape> shape;
   };
@@ -35,7 +50,21 @@ class TopographyFile {
 
   zzip_dir *const dir;
 
-  ShapeFile file;
+  /**
+   * The pack which contains this file's shapes; nullptr if the
+   * shapes are read from the shapefile.
+   */
+  std::shared_ptr<const TopographyPack> pack;
+
+  /**
+   * The layer of #pack for this file.  Only valid if #pack is set.
+   */
+  const TopographyPack::Layer *pack_layer = nullptr;
+
+  /**
+   * The shapefile; not opened if the shapes are read from the #pack.
+   */
+  std::optional<ShapeFile> file;
 
   /**
    * The center of shapefileObj::bounds.
@@ -133,6 +162,8 @@ public:
    * @param label_threshold the zoom threshold for label rendering
    * @param important_label_threshold labels below this zoom threshold will
    * be rendered in default style
+   * @param pack an optional #TopographyPack; if it contains a layer
+   * generated from this shapefile, the shapes are read from it
    */
   TopographyFile(zzip_dir *dir, const char *shpname,
                  double threshold, double label_threshold,
@@ -142,7 +173,8 @@ public:
                  ResourceId icon=ResourceId::Null(),
                  ResourceId big_icon=ResourceId::Null(),
                  ResourceId ultra_icon=ResourceId::Null(),
-                 unsigned pen_width=1);
+                 unsigned pen_width=1,
+                 std::shared_ptr<const TopographyPack> pack={});
 
   TopographyFile(const TopographyFile &) = delete;
 
@@ -155,6 +187,13 @@ public:
     return serial;
   }
 
+  /**
+   * Are the shapes read from a #TopographyPack?
+   */
+  bool IsPacked() const noexcept {
+    return pack != nullptr;
+  }
+
   const GeoPoint &GetCenter() const noexcept {
     return center;
   }
@@ -230,6 +269,15 @@ public:
     return GeoPoint(center.longitude + Angle::Native(p.x),
                     center.latitude + Angle::Native(p.y));
   }
+#else
+  [[gnu::pure]]
+  GeoPoint ToGeoPoint(ShapePointCodec::Point p) const noexcept {
+    return GeoPoint(center.longitude +
+                    Angle::Native(p.x * ShapePointCodec::RESOLUTION),
+                    center.latitude +
+                    Angle::Native(p.y * ShapePointCodec::RESOLUTION));
+  }
+#endif
 
   /**
    * @return thinning level, range: 0 .. XShape::THINNING_LEVELS-1
@@ -238,18 +286,29 @@ public:
   unsigned GetThinningLevel(double map_scale) const noexcept;
 
   /**
-   * @return minimum distance between points in ShapePoint coordinates
+   * @return the minimum distance between points [m] in the given
+   * thinning level of a file with the given zoom threshold; the
+   * OpenGL renderer divides it by Layout::Scale()
    */
+  [[gnu::const]]
+  static unsigned GetMinimumPointDistance(double scale_threshold,
+                                          unsigned level) noexcept;
+
   [[gnu::pure]]
-  unsigned GetMinimumPointDistance(unsigned level) const noexcept;
-#endif
+  unsigned GetMinimumPointDistance(unsigned level) const noexcept {
+    return GetMinimumPointDistance(scale_threshold, level);
+  }
 
   /**
    * Throws on error.
    *
+   * @param cancel an optional function which may abort the update;
+   * the cache is then left partially updated, and the next call
+   * completes it
    * @return true if new data from the topography file has been loaded
    */
-  bool Update(const WindowProjection &map_projection);
+  bool Update(const WindowProjection &map_projection,
+              const CancelFunction &cancel={});
 
   /**
    * Throws on error.
@@ -260,4 +319,16 @@ public:
 
 protected:
   void ClearCache() noexcept;
+
+private:
+  /**
+   * Load a shape from the #pack or from the shapefile.
+   *
+   * Throws on error.
+   *
+   * @param pack_reader a reader for the #pack; it is created on
+   * demand, and may be reused for the next call
+   */
+  std::unique_ptr<XShape> LoadShape(std::size_t i,
+                                    std::optional<TopographyPack::Reader> &pack_reader);
 };
@@ -25,6 +25,8 @@
 #include "ui/canvas/opengl/Shaders.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
+#else
+#include "Topography/ShapeProjection.hpp"
 #endif
 
 #include <string>
@@ -69,14 +71,13 @@ TopographyFileRenderer::UpdateVisibleShapes(const WindowProjection &projection)
     if (shape.get_type() != MS_SHAPE_NULL) {
       if (shape.get_type() == MS_SHAPE_POINT) {
         if (icon.IsDefined()) {
-          const auto *points = shape.GetPoints();
+          auto points = shape.GetPoints();
           for (const unsigned line_size : shape.GetLines()) {
-            const auto *end = points + line_size;
-            for (; points < end; ++points) {
+            for (unsigned i = 0; i < line_size; ++i) {
 #ifdef ENABLE_OPENGL
-              visible_points.push_back(file.ToGeoPoint(*points));
+              visible_points.push_back(file.ToGeoPoint(*points++));
 #else
-              visible_points.push_back(*points);
+              visible_points.push_back(file.ToGeoPoint(points.Read()));
 #endif
             }
           }
@@ -185,6 +186,9 @@ TopographyFileRenderer::Paint(Canvas &canvas,
   const GeoClip clip(projection.GetScreenBounds().Scale(1.1));
   AllocatedArray<GeoPoint> geo_points;
 
+  const ShapeProjection shape_projection(projection, file.GetCenter());
+
+  const unsigned level = file.GetThinningLevel(map_scale);
   const unsigned iskip = file.GetSkipSteps(map_scale);
 #endif
 
@@ -200,11 +204,14 @@ TopographyFileRenderer::Paint(Canvas &canvas,
   for (const XShape *shape_p : visible_shapes) {
     const XShape &shape = *shape_p;
 
-    const auto lines = shape.GetLines();
 #ifdef ENABLE_OPENGL
+    const auto lines = shape.GetLines();
     const ShapePoint *points = buffer + shape.GetOffset();
 #else // !ENABLE_OPENGL
-    const GeoPoint *points = shape.GetPoints();
+    /* shapes loaded from a TopographyPack have been simplified
+       already; the others are thinned by skipping points */
+    auto [lines, points] = shape.GetLevel(level);
+    const unsigned skip = shape.HasLevels() ? 1 : iskip;
 #endif
 
     switch (shape.get_type()) {
@@ -236,12 +243,11 @@ TopographyFileRenderer::Paint(Canvas &canvas,
         for (unsigned msize : lines) {
         shape_renderer.Begin(msize);
 
-        const GeoPoint *end = points + msize - 1;
-        for (; points < end; ++points)
-          shape_renderer.AddPointIfDistant(projection.GeoToScreen(*points));
+        for (unsigned i = 1; i < msize; ++i)
+          shape_renderer.AddPointIfDistant(shape_projection(points.Read()));
 
         // make sure we always draw the last point
-        shape_renderer.AddPoint(projection.GeoToScreen(*points));
+        shape_renderer.AddPoint(shape_projection(points.Read()));
 
         shape_renderer.FinishPolyline(canvas);
       }
@@ -275,17 +281,21 @@ TopographyFileRenderer::Paint(Canvas &canvas,
       }
 #else // !ENABLE_OPENGL
       {
-        const GeoPoint *src = &points[0];
         for (const unsigned n : lines) {
-          unsigned msize = n / iskip;
+          unsigned msize = n / skip;
 
           /* copy all polygon points into the geo_points array and
              clip them, to avoid integer overflows (as PixelPoint may
              store only 16 bit integers on some platforms) */
 
           geo_points.GrowDiscard(msize * 3);
-          for (unsigned i = 0; i < msize; ++i)
-            geo_points[i] = src[i * iskip];
+          for (unsigned i = 0; i < msize; ++i) {
+            geo_points[i] = file.ToGeoPoint(points.Read());
+            points.Skip(skip - 1);
+          }
+
+          /* advance to the next line */
+          points.Skip(n - msize * skip);
 
           msize = clip.ClipPolygon(geo_points.data(),
                                    geo_points.data(), msize);
@@ -294,14 +304,10 @@ TopographyFileRenderer::Paint(Canvas &canvas,
 
           shape_renderer.Begin(msize);
 
-          for (unsigned i = 0; i < msize; ++i) {
-            GeoPoint g = geo_points[i];
-            shape_renderer.AddPointIfDistant(projection.GeoToScreen(g));
-          }
+          for (unsigned i = 0; i < msize; ++i)
+            shape_renderer.AddPointIfDistant(shape_projection(geo_points[i]));
 
           shape_renderer.FinishPolygon(canvas);
-
-          src += n;
         }
       }
 #endif
@@ -370,6 +376,10 @@ TopographyFileRenderer::PaintLabels(Canvas &canvas,
 
   int iskip = file.GetSkipSteps(map_scale);
 
+#ifndef ENABLE_OPENGL
+  const ShapeProjection shape_projection(projection, file.GetCenter());
+#endif
+
   std::set<std::string> drawn_labels;
 
   // Iterate over all shapes in the file
@@ -381,27 +391,32 @@ TopographyFileRenderer::PaintLabels(Canvas &canvas,
     assert(label != nullptr);
 
     const auto lines = shape.GetLines();
-    const auto *points = shape.GetPoints();
+    auto points = shape.GetPoints();
 
     for (const unsigned n : lines) {
       int minx = canvas.GetWidth();
       int miny = canvas.GetHeight();
 
-      const auto *end = points + n;
-      for (; points < end; points += iskip) {
-#ifdef ENABLE_OPENGL
-        auto pt = projection.GeoToScreen(file.ToGeoPoint(*points));
-#else
-        auto pt = projection.GeoToScreen(*points);
-#endif
-
+      auto check = [&minx, &miny](PixelPoint pt){
         if (pt.x <= minx) {
           minx = pt.x;
           miny = pt.y;
         }
-      }
+      };
+
+#ifdef ENABLE_OPENGL
+      const auto *end = points + n;
+      for (; points < end; points += iskip)
+        check(projection.GeoToScreen(file.ToGeoPoint(*points)));
 
       points = end;
+#else
+      for (unsigned i = 0; i < n; ++i) {
+        const auto p = points.Read();
+        if (i % iskip == 0)
+          check(shape_projection(p));
+      }
+#endif
 
       minx += 2;
       miny += 2;
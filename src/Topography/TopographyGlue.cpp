@@ -3,27 +3,48 @@
 
 #include "Topography/TopographyGlue.hpp"
 #include "Topography/TopographyStore.hpp"
+#include "Topography/Pack.hpp"
 #include "Language/Language.hpp"
 #include "Profile/Profile.hpp"
 #include "LogFile.hpp"
-#include "io/MapFile.hpp"
 #include "io/ZipArchive.hpp"
 #include "io/ZipLineReader.hpp"
 #include "system/Path.hpp"
+#include "system/FileUtil.hpp"
+
+/**
+ * Open the topography pack next to the map file, if there is one.
+ */
+static std::shared_ptr<const TopographyPack>
+OpenTopographyPack(Path map_path) noexcept
+try {
+  const auto pack_path = map_path.WithSuffix(".xtop");
+  if (!File::Exists(pack_path))
+    return nullptr;
+
+  return std::make_shared<TopographyPack>(pack_path);
+} catch (...) {
+  LogError(std::current_exception(), "Failed to load topography pack");
+  return nullptr;
+}
 
 /**
  * Load topography from the map file (ZIP), load the other files from
- * the same ZIP file.
+ * the same ZIP file.  Each file gets its own handle of the ZIP file,
+ * so TopographyThread can load them in parallel.
  */
 static bool
 LoadConfiguredTopographyZip(TopographyStore &store)
 try {
-  auto archive = OpenMapFile();
-  if (!archive)
+  const auto path = Profile::GetPath(ProfileKeys::MapFile);
+  if (path == nullptr)
     return false;
 
-  ZipLineReaderA reader(archive->get(), "topology.tpl");
-  store.Load(reader, nullptr, archive->get());
+  ZipArchive archive{path};
+  ZipLineReaderA reader(archive.get(), "topology.tpl");
+  store.Load(reader, nullptr, archive.get(), [&path]{
+    return ZipArchive{path};
+  }, OpenTopographyPack(path));
   return true;
 } catch (...) {
   LogError(std::current_exception(), "No topography in map file");
@@ -6,13 +6,21 @@
 #include "util/StringAPI.hxx"
 #include "util/StringCompare.hxx"
 #include "io/LineReader.hpp"
+#include "io/ZipArchive.hpp"
+#include "Projection/WindowProjection.hpp"
 #include "system/ConvertPathName.hpp"
 #include "system/Path.hpp"
 #include "Operation/Operation.hpp"
+#include "Tracing/Tracing.hpp"
 #include "Compatibility/path.h"
 #include "LogFile.hpp"
+#include "thread/ParallelFor.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <optional>
+#include <vector>
 
 #include <windef.h> // for MAX_PATH
 
@@ -58,6 +66,59 @@ TopographyStore::ScanVisibility(const WindowProjection &m_projection,
   return num_updated;
 }
 
+/**
+ * Update one file, and log errors.
+ */
+static bool
+UpdateFile(TopographyFile &file, const WindowProjection &projection,
+           const TopographyFile::CancelFunction &cancel) noexcept
+try {
+  return file.Update(projection, cancel);
+} catch (...) {
+  LogError(std::current_exception());
+  return false;
+}
+
+unsigned
+TopographyStore::ScanVisibility(const WindowProjection &m_projection,
+                                unsigned max_threads,
+                                const TopographyFile::CancelFunction &cancel) noexcept
+{
+  const Tracing::Scope trace{Tracing::Point::TOPOGRAPHY_LOAD};
+
+  /* only the files which are visible at this scale need an update;
+     hidden ones return from Update() without doing anything */
+  std::vector<TopographyFile *> visible;
+  for (auto &file : files)
+    if (file.IsVisible(m_projection.GetMapScale()))
+      visible.push_back(&file);
+
+  if (!independent_files)
+    max_threads = 1;
+
+  std::atomic_uint next = 0, num_updated = 0;
+
+  auto worker = [&]{
+    unsigned i;
+    while ((i = next.fetch_add(1, std::memory_order_relaxed)) < visible.size())
+      if (UpdateFile(*visible[i], m_projection, cancel))
+        num_updated.fetch_add(1, std::memory_order_relaxed);
+  };
+
+  /* each chunk is one worker which takes the next file from the
+     list, because the files differ a lot in cost; the calling
+     thread is one of them; loading blocks on I/O, so this uses the
+     I/O pool, not the CPU workers */
+  const unsigned n_workers = std::min<std::size_t>(max_threads, visible.size());
+  ParallelFor(ThreadPool::GetIO(), n_workers, n_workers, 1,
+              [&worker](unsigned, unsigned){
+                worker();
+              });
+
+  serial += num_updated;
+  return num_updated;
+}
+
 void
 TopographyStore::LoadAll() noexcept
 {
@@ -67,10 +128,14 @@ TopographyStore::LoadAll() noexcept
 
 void
 TopographyStore::Load(NLineReader &reader,
-                      Path directory, struct zzip_dir *zdir) noexcept
+                      Path directory, struct zzip_dir *zdir,
+                      const std::function<ZipArchive()> &open_archive,
+                      std::shared_ptr<const TopographyPack> pack) noexcept
 {
   Reset();
 
+  independent_files = zdir == nullptr || open_archive;
+
   // Create buffer for the shape filenames
   // (shape_filename will be modified with the shape_filename_end pointer)
   char shape_filename[MAX_PATH];
@@ -100,15 +165,29 @@ TopographyStore::Load(NLineReader &reader,
 
     // Create TopographyFile instance from parsed line
     try {
+      /* the TopographyFile holds a reference on the zzip_dir, so
+         this ZipArchive may be closed right after the constructor */
+      std::optional<ZipArchive> archive;
+      if (zdir != nullptr && open_archive) {
+        try {
+          archive.emplace(open_archive());
+        } catch (...) {
+          /* fall back to the shared handle */
+          LogError(std::current_exception());
+          independent_files = false;
+        }
+      }
+
       i = files.emplace_after(i,
-                              zdir, shape_filename,
+                              archive ? archive->get() : zdir,
+                              shape_filename,
                               entry->shape_range,
                               entry->label_range,
                               entry->important_label_range,
                               entry->color,
                               entry->shape_field,
                               entry->icon, entry->big_icon, entry->ultra_icon,
-                              entry->pen_width);
+                              entry->pen_width, pack);
     } catch (...) {
       LogError(std::current_exception());
     }
@@ -7,8 +7,10 @@
 #include "util/NonCopyable.hpp"
 
 #include <forward_list>
+#include <functional>
 
 class Path;
+class ZipArchive;
 class WindowProjection;
 class NLineReader;
 struct zzip_dir;
@@ -19,6 +21,12 @@ struct zzip_dir;
 class TopographyStore : private NonCopyable {
   std::forward_list<TopographyFile> files;
 
+  /**
+   * Does each file have its own #zzip_dir (or none at all)?  Only
+   * then may they be updated in parallel.
+   */
+  bool independent_files = true;
+
   /**
    * This number is incremented each time this object is modified.
    */
@@ -58,13 +66,35 @@ public:
   unsigned ScanVisibility(const WindowProjection &m_projection,
                           unsigned max_update=1024) noexcept;
 
+  /**
+   * Update all files, distributing them over up to #max_threads
+   * tasks of the I/O #ThreadPool (including the calling thread).  Files
+   * which share a ZIP archive handle are always updated
+   * sequentially, because zziplib's #zzip_dir is not thread-safe.
+   *
+   * @param cancel see TopographyFile::Update()
+   * @return the number of files which were updated
+   */
+  unsigned ScanVisibility(const WindowProjection &m_projection,
+                          unsigned max_threads,
+                          const TopographyFile::CancelFunction &cancel) noexcept;
+
   /**
    * Load all shapes of all files into memory.  For debugging
    * purposes.
    */
   void LoadAll() noexcept;
 
+  /**
+   * @param open_archive if set, this function is used to open a
+   * separate handle of the ZIP archive #zdir for each file, which
+   * allows updating the files in parallel
+   * @param pack an optional #TopographyPack which replaces the
+   * shapefiles it was generated from
+   */
   void Load(NLineReader &reader,
-            Path directory, struct zzip_dir *zdir = nullptr) noexcept;
+            Path directory, struct zzip_dir *zdir = nullptr,
+            const std::function<ZipArchive()> &open_archive = {},
+            std::shared_ptr<const TopographyPack> pack = {}) noexcept;
   void Reset() noexcept;
 };
@@ -17,6 +17,10 @@
 #include <algorithm>
 #include <stdexcept>
 
+#ifndef ENABLE_OPENGL
+#include <vector>
+#endif
+
 static BasicAllocatedString<char>
 ImportLabel(const char *src) noexcept
 {
@@ -67,11 +71,12 @@ ToGeoPoint(const pointObj &src) noexcept
   };
 }
 
+#ifdef ENABLE_OPENGL
+
 [[gnu::pure]]
-static auto
-ImportShapePoint(const pointObj &src, [[maybe_unused]] const GeoPoint &file_center) noexcept
+static ShapePoint
+ImportShapePoint(const pointObj &src, const GeoPoint &file_center) noexcept
 {
-#ifdef ENABLE_OPENGL
   /* OpenGL: convert GeoPoints to ShapePoints, make them relative to
      the map's boundary center */
 
@@ -82,12 +87,27 @@ ImportShapePoint(const pointObj &src, [[maybe_unused]] const GeoPoint &file_cent
     ShapeScalar(relative.longitude.Native()),
     ShapeScalar(relative.latitude.Native()),
   };
+}
+
 #else
-  /* convert all points of all lines to GeoPoints */
-  return ToGeoPoint(src);
-#endif
+
+[[gnu::pure]]
+static ShapePointCodec::Point
+ImportShapePoint(const pointObj &src, const GeoPoint &file_center) noexcept
+{
+  /* quantise the position relative to the map's boundary center */
+
+  const GeoPoint vertex = ToGeoPoint(src);
+  const GeoPoint relative = vertex - file_center;
+
+  return {
+    ShapePointCodec::Quantise(relative.longitude.Native()),
+    ShapePointCodec::Quantise(relative.latitude.Native()),
+  };
 }
 
+#endif
+
 XShape::XShape(const shapeObj &shape, const GeoPoint &file_center,
                const char *_label)
   :label(ImportLabel(_label))
@@ -119,6 +139,7 @@ XShape::XShape(const shapeObj &shape, const GeoPoint &file_center,
     ++num_lines;
   }
 
+#ifdef ENABLE_OPENGL
   points = std::make_unique<Point[]>(num_points);
   auto *p = points.get();
   for (std::size_t l = 0; l < num_lines; ++l) {
@@ -128,10 +149,51 @@ XShape::XShape(const shapeObj &shape, const GeoPoint &file_center,
                          return ImportShapePoint(src, file_center);
                        });
   }
+#else
+  std::vector<std::byte> buffer;
+  buffer.reserve(num_points * 4);
+
+  ShapePointCodec::Encoder encoder{buffer};
+  for (std::size_t l = 0; l < num_lines; ++l) {
+    const pointObj *src = shape.line[l].point;
+    for (const auto *end = src + lines[l]; src != end; ++src)
+      encoder.Add(ImportShapePoint(*src, file_center));
+  }
+
+  /* copy to a buffer of the exact size */
+  points = std::make_unique_for_overwrite<std::byte[]>(buffer.size());
+  std::copy(buffer.begin(), buffer.end(), points.get());
+#endif
+}
+
+XShape::XShape(const GeoBounds &_bounds, uint8_t _type, const char *_label)
+  :bounds(_bounds), type(_type), num_lines(0),
+   label(ImportLabel(_label))
+{
 }
 
 XShape::~XShape() noexcept = default;
 
+#ifndef ENABLE_OPENGL
+
+XShape::Level
+XShape::GetLevel(unsigned level) const noexcept
+{
+  for (unsigned i = std::min<unsigned>(level, THINNING_LEVELS - 1);
+       i > 0; --i) {
+    const std::byte *p = thinned[i - 1].get();
+    if (p != nullptr)
+      return {
+        {reinterpret_cast<const uint16_t *>(p), num_lines},
+        ShapePointCodec::Decoder{p + num_lines * sizeof(uint16_t)},
+      };
+  }
+
+  return {GetLines(), GetPoints()};
+}
+
+#endif
+
 #ifdef ENABLE_OPENGL
 
 inline bool
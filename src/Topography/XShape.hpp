@@ -9,6 +9,8 @@
 #include "shapelib/mapshape.h"
 #ifdef ENABLE_OPENGL
 #include "Topography/XShapePoint.hpp"
+#else
+#include "Topography/ShapePointCodec.hpp"
 #endif
 
 #include <array>
@@ -20,10 +22,18 @@
 struct GeoPoint;
 
 class XShape {
-  static constexpr std::size_t MAX_LINES = 32;
-#ifdef ENABLE_OPENGL
+  friend class TopographyPack;
+  friend class TopographyPackWriter;
+
+public:
+  /**
+   * The number of thinning levels, see
+   * TopographyFile::GetThinningLevel().
+   */
   static constexpr std::size_t THINNING_LEVELS = 4;
-#endif
+
+private:
+  static constexpr std::size_t MAX_LINES = 32;
 
   GeoBounds bounds;
 
@@ -43,14 +53,32 @@ class XShape {
 
 #ifdef ENABLE_OPENGL
   using Point = ShapePoint;
-#else
-  using Point = GeoPoint;
-#endif
 
   /**
    * All points of all lines.
    */
   std::unique_ptr<Point[]> points;
+#else
+  /**
+   * All points of all lines, encoded with #ShapePointCodec.
+   */
+  std::unique_ptr<std::byte[]> points;
+
+  /**
+   * Simplified versions of the lines for the thinning levels 1 and
+   * up: the number of points of each line (uint16_t), followed by the
+   * points encoded with #ShapePointCodec.  nullptr means the level is
+   * the same as the previous one.  Only shapes loaded from a
+   * #TopographyPack have them, see #has_levels.
+   */
+  std::array<std::unique_ptr<std::byte[]>, THINNING_LEVELS - 1> thinned;
+
+  /**
+   * Was this shape loaded from a #TopographyPack, i.e. is #thinned
+   * valid?
+   */
+  bool has_levels = false;
+#endif
 
 #ifdef ENABLE_OPENGL
   /**
@@ -84,6 +112,14 @@ public:
 
   ~XShape() noexcept;
 
+private:
+  /**
+   * Construct an empty shape; used by TopographyPack::Reader, which
+   * fills in the lines and points.
+   */
+  XShape(const GeoBounds &_bounds, uint8_t _type, const char *label);
+
+public:
   XShape(const XShape &) = delete;
   XShape &operator=(const XShape &) = delete;
 
@@ -123,9 +159,39 @@ public:
     return { lines.data(), num_lines };
   }
 
+#ifdef ENABLE_OPENGL
   const Point *GetPoints() const noexcept {
     return points.get();
   }
+#else
+  /**
+   * Returns a decoder for all points of all lines (relative to the
+   * file center), see TopographyFile::ToGeoPoint().
+   */
+  ShapePointCodec::Decoder GetPoints() const noexcept {
+    return ShapePointCodec::Decoder{points.get()};
+  }
+
+  /**
+   * Does this shape have simplified lines for the thinning levels
+   * (see GetLevel())?  If not, the caller has to simplify them.
+   */
+  bool HasLevels() const noexcept {
+    return has_levels;
+  }
+
+  struct Level {
+    std::span<const uint16_t> lines;
+    ShapePointCodec::Decoder points;
+  };
+
+  /**
+   * Returns the lines of the given thinning level, or of the closest
+   * more detailed level which is available.
+   */
+  [[gnu::pure]]
+  Level GetLevel(unsigned level) const noexcept;
+#endif
 
   const char *GetLabel() const noexcept {
     return label.c_str();
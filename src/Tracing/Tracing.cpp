@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "Tracing.hpp"
+#include "thread/Mutex.hxx"
+#include "io/FileOutputStream.hxx"
+#include "io/BufferedOutputStream.hxx"
+
+#include <algorithm>
+#include <memory>
+
+namespace Tracing {
+
+std::atomic<bool> Internal::enabled{false};
+std::atomic<uint_least64_t> Internal::counters[N_COUNTERS];
+
+/**
+ * The maximum number of events kept in memory; when it is full, the
+ * oldest ones are overwritten.  At 16 bytes per event, this is 1 MiB.
+ */
+static constexpr unsigned MAX_EVENTS = 65536;
+
+struct Event {
+  /**
+   * Microseconds since #epoch.
+   */
+  uint64_t start;
+
+  /**
+   * Duration in microseconds.
+   */
+  uint32_t duration;
+
+  Point point;
+
+  uint8_t thread;
+};
+
+static Mutex mutex;
+
+static Clock::time_point epoch;
+
+static Statistics statistics[N_POINTS];
+
+static std::unique_ptr<Event[]> events;
+
+/**
+ * The total number of events recorded since Enable(); the next one
+ * is stored at (n_events % MAX_EVENTS).
+ */
+static uint64_t n_events;
+
+static std::atomic<uint8_t> next_thread{0};
+
+/**
+ * Returns a small number identifying the calling thread.
+ */
+static uint8_t
+GetThreadIndex() noexcept
+{
+  static thread_local uint8_t index = next_thread.fetch_add(1) + 1;
+  return index;
+}
+
+static constexpr struct {
+  const char *name, *category;
+} point_info[N_POINTS] = {
+  { "CalculationThread::Tick", "calculation" },
+  { "GlideComputer::ProcessGPS", "calculation" },
+  { "GlideComputer::ProcessIdle", "calculation" },
+  { "MapWindow frame", "draw" },
+  { "Terrain tiles", "terrain" },
+  { "Topography", "topography" },
+  { "Device data", "device" },
+};
+
+const char *
+GetName(Point point) noexcept
+{
+  return point_info[unsigned(point)].name;
+}
+
+const char *
+GetCategory(Point point) noexcept
+{
+  return point_info[unsigned(point)].category;
+}
+
+static constexpr const char *counter_names[N_COUNTERS] = {
+  "NMEA sentences",
+  "Terrain tiles loaded",
+  "Topography shapes loaded",
+};
+
+const char *
+GetName(Counter counter) noexcept
+{
+  return counter_names[unsigned(counter)];
+}
+
+void
+Enable()
+{
+  const std::lock_guard lock{mutex};
+
+  if (!events)
+    events = std::make_unique<Event[]>(MAX_EVENTS);
+
+  n_events = 0;
+  std::fill_n(statistics, N_POINTS, Statistics{});
+  for (auto &i : Internal::counters)
+    i.store(0, std::memory_order_relaxed);
+  epoch = Clock::now();
+
+  Internal::enabled.store(true, std::memory_order_relaxed);
+}
+
+void
+Disable() noexcept
+{
+  Internal::enabled.store(false, std::memory_order_relaxed);
+}
+
+void
+Record(Point point, Clock::time_point start, Clock::time_point end) noexcept
+{
+  const auto duration = end - start;
+
+  const std::lock_guard lock{mutex};
+
+  /* check again with the mutex held: an event which was started
+     before Enable() must not be recorded */
+  if (!IsEnabled() || start < epoch)
+    return;
+
+  auto &s = statistics[unsigned(point)];
+  ++s.count;
+  s.total += duration;
+  s.max = std::max(s.max, duration);
+
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  auto &e = events[n_events++ % MAX_EVENTS];
+  e.start = duration_cast<microseconds>(start - epoch).count();
+  e.duration = duration_cast<microseconds>(duration).count();
+  e.point = point;
+  e.thread = GetThreadIndex();
+}
+
+Statistics
+GetStatistics(Point point) noexcept
+{
+  const std::lock_guard lock{mutex};
+  return statistics[unsigned(point)];
+}
+
+uint_least64_t
+GetCounter(Counter counter) noexcept
+{
+  return Internal::counters[unsigned(counter)].load(std::memory_order_relaxed);
+}
+
+unsigned
+GetEventCount() noexcept
+{
+  const std::lock_guard lock{mutex};
+  return std::min<uint64_t>(n_events, MAX_EVENTS);
+}
+
+void
+ExportChromeTrace(Path path)
+{
+  /* copy the events, so the mutex is not held during file I/O */
+  std::unique_ptr<Event[]> copy;
+  unsigned n = 0;
+  uint64_t now;
+
+  {
+    const std::lock_guard lock{mutex};
+
+    now = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - epoch).count();
+
+    if (events) {
+      n = std::min<uint64_t>(n_events, MAX_EVENTS);
+      copy = std::make_unique<Event[]>(n);
+
+      /* oldest first */
+      const uint64_t first = n_events - n;
+      for (unsigned i = 0; i < n; ++i)
+        copy[i] = events[(first + i) % MAX_EVENTS];
+    }
+  }
+
+  FileOutputStream file(path);
+  BufferedOutputStream os(file);
+
+  os.Write("{\"traceEvents\":[");
+
+  for (unsigned i = 0; i < n; ++i) {
+    const auto &e = copy[i];
+    if (i > 0)
+      os.Write(',');
+    os.Fmt("\n{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\","
+           "\"ts\":{},\"dur\":{},\"pid\":1,\"tid\":{}}}",
+           GetName(e.point), GetCategory(e.point),
+           e.start, e.duration, e.thread);
+  }
+
+  for (unsigned i = 0; i < N_COUNTERS; ++i) {
+    if (n > 0 || i > 0)
+      os.Write(',');
+    os.Fmt("\n{{\"name\":\"{}\",\"ph\":\"C\",\"ts\":{},\"pid\":1,"
+           "\"args\":{{\"value\":{}}}}}",
+           GetName(Counter(i)), now, GetCounter(Counter(i)));
+  }
+
+  os.Write("\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  os.Flush();
+  file.Commit();
+}
+
+} // namespace Tracing
@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+class Path;
+
+/**
+ * Lightweight timing of hot code paths.  Each instrumented place is
+ * a #Tracing::Point; a #Tracing::Scope measures how long it takes.
+ * A #Tracing::Counter counts how often something happens (e.g. parsed
+ * sentences, loaded terrain tiles).
+ *
+ * Recording is compiled in, but disabled by default; while it is
+ * disabled, a #Tracing::Scope costs one relaxed atomic load.  While it
+ * is enabled, per-point statistics are collected and the most recent
+ * events are kept in memory, to be exported as a Chrome trace-event
+ * JSON file (chrome://tracing, https://ui.perfetto.dev).
+ */
+namespace Tracing {
+
+using Clock = std::chrono::steady_clock;
+
+enum class Point : uint8_t {
+  CALCULATION_TICK,
+  CALCULATION_GPS,
+  CALCULATION_IDLE,
+  DRAW_FRAME,
+  TERRAIN_LOAD,
+  TOPOGRAPHY_LOAD,
+  DEVICE_PARSE,
+
+  /**
+   * Not a point, just the number of items in this enum.
+   */
+  COUNT
+};
+
+static constexpr unsigned N_POINTS = unsigned(Point::COUNT);
+
+enum class Counter : uint8_t {
+  /**
+   * NMEA sentences which were parsed successfully.
+   */
+  NMEA_SENTENCES,
+
+  /**
+   * Terrain tiles which were loaded (decoded or read from a pack).
+   */
+  TERRAIN_TILES,
+
+  /**
+   * Topography shapes which were loaded into the cache.
+   */
+  TOPOGRAPHY_SHAPES,
+
+  /**
+   * Not a counter, just the number of items in this enum.
+   */
+  COUNT
+};
+
+static constexpr unsigned N_COUNTERS = unsigned(Counter::COUNT);
+
+/**
+ * Returns a short human-readable name, which is also used as the
+ * event name in the exported trace.
+ */
+[[gnu::const]]
+const char *
+GetName(Point point) noexcept;
+
+/**
+ * Returns the category which the point belongs to (e.g. "terrain").
+ */
+[[gnu::const]]
+const char *
+GetCategory(Point point) noexcept;
+
+/**
+ * Returns a short human-readable name, which is also used as the
+ * counter name in the exported trace.
+ */
+[[gnu::const]]
+const char *
+GetName(Counter counter) noexcept;
+
+struct Statistics {
+  unsigned count;
+  Clock::duration total, max;
+
+  Clock::duration GetAverage() const noexcept {
+    return count > 0
+      ? total / count
+      : Clock::duration{};
+  }
+};
+
+namespace Internal {
+extern std::atomic<bool> enabled;
+extern std::atomic<uint_least64_t> counters[N_COUNTERS];
+}
+
+static inline bool
+IsEnabled() noexcept
+{
+  return Internal::enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Add to a counter.  Does nothing if recording is disabled.
+ */
+static inline void
+Count(Counter counter, unsigned n=1) noexcept
+{
+  if (IsEnabled())
+    Internal::counters[unsigned(counter)].fetch_add(n, std::memory_order_relaxed);
+}
+
+/**
+ * Start recording.  Clears the statistics, the counters and the
+ * events recorded previously.
+ *
+ * Throws std::bad_alloc.
+ */
+void
+Enable();
+
+/**
+ * Stop recording.  The statistics and events are kept until the next
+ * Enable() call.
+ */
+void
+Disable() noexcept;
+
+/**
+ * Record one event.  Usually called by #Scope.  Does nothing if
+ * recording is disabled.
+ */
+void
+Record(Point point, Clock::time_point start, Clock::time_point end) noexcept;
+
+[[gnu::pure]]
+Statistics
+GetStatistics(Point point) noexcept;
+
+[[gnu::pure]]
+uint_least64_t
+GetCounter(Counter counter) noexcept;
+
+/**
+ * Returns the number of events which are currently kept in memory.
+ */
+[[gnu::pure]]
+unsigned
+GetEventCount() noexcept;
+
+/**
+ * Write the recorded events to a Chrome trace-event JSON file.  The
+ * counters are written as counter events at the time of the export.
+ *
+ * Throws on error.
+ */
+void
+ExportChromeTrace(Path path);
+
+/**
+ * Measure the lifetime of this object and record it as one event.
+ */
+class Scope {
+  const Point point;
+  Clock::time_point start;
+
+public:
+  explicit Scope(Point _point) noexcept
+    :point(_point)
+  {
+    if (IsEnabled())
+      start = Clock::now();
+  }
+
+  ~Scope() noexcept {
+    if (start != Clock::time_point{})
+      Record(point, start, Clock::now());
+  }
+
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+};
+
+} // namespace Tracing
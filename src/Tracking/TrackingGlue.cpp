@@ -12,6 +12,7 @@
 #include <ares.h>
 
 #include <chrono>
+#include <cmath>
 
 using namespace std::chrono;
 
@@ -162,8 +163,7 @@ TrackingGlue::MergeOnlineTraffic(FlarmData &flarm,
 
   const auto now = steady_clock::now();
 
-  for (unsigned i = 0; i < online_traffic.list.size(); ) {
-    const FlarmTraffic &t = online_traffic.list[i];
+  online_traffic.RemoveIf([&](const FlarmTraffic &t){
     const auto last_i = online_last_received.find(t.id);
     if (last_i == online_last_received.end() ||
         now - last_i->second > ONLINE_BUFFER_STALE ||
@@ -173,10 +173,11 @@ TrackingGlue::MergeOnlineTraffic(FlarmData &flarm,
                                                            t.id)) {
       online_last_received.erase(t.id);
       online_pilot_ids.erase(t.id);
-      online_traffic.list.quick_remove(i);
-    } else
-      ++i;
-  }
+      return true;
+    }
+
+    return false;
+  });
 
   for (const auto &online : online_traffic.list) {
     FlarmTraffic *existing = flarm.traffic.FindTraffic(online.id);
@@ -194,7 +195,12 @@ TrackingGlue::MergeOnlineTraffic(FlarmData &flarm,
       if (basic.time_available)
         existing->valid.Update(basic.time);
     } else {
-      FlarmTraffic *slot = flarm.traffic.AllocateTraffic();
+      /* online traffic never replaces a target from the local
+         receivers */
+      FlarmTraffic *slot =
+        flarm.traffic.AllocateTraffic(built.id, built.source,
+                                      hypot(built.relative_north,
+                                            built.relative_east));
       if (slot == nullptr)
         continue;
 
@@ -268,12 +274,11 @@ TrackingGlue::OnTraffic(uint32_t pilot_id,
 
     FlarmTraffic *slot = online_traffic.FindTraffic(built.id);
     if (slot == nullptr) {
-      slot = online_traffic.AllocateTraffic();
+      slot = online_traffic.AllocateTraffic(built.id);
       if (slot == nullptr)
         return;
 
       slot->Clear();
-      slot->id = built.id;
     }
 
     slot->UpdateOnline(built);
@@ -130,7 +130,7 @@ SettingsLeave(const UISettings &old_ui_settings)
   if (WaypointFileChanged || AirfieldFileChanged) {
     // re-load waypoints
     WaypointGlue::LoadWaypoints(way_points, data_components->terrain.get(),
-                                operation);
+                                file_cache, operation);
 
     try {
       WaypointDetails::ReadFileFromProfile(way_points, operation);
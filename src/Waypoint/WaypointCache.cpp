@@ -0,0 +1,298 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "WaypointCache.hpp"
+#include "Factory.hpp"
+#include "Engine/Waypoint/Waypoint.hpp"
+#include "io/BufferedOutputStream.hxx"
+#include "io/BufferedReader.hxx"
+#include "system/Path.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <string.h>
+
+namespace WaypointCache {
+
+struct CacheHeader {
+  uint32_t version;
+
+  uint32_t n_waypoints;
+
+  /** the length of the source path which follows the header */
+  uint32_t source_length;
+
+  /** the size of the string pool which follows the records */
+  uint32_t pool_size;
+};
+
+enum StringIndex : unsigned {
+  SHORTNAME,
+  NAME,
+  COMMENT,
+  DETAILS,
+  N_STRINGS
+};
+
+/**
+ * The fixed-size part of a #Waypoint.  Its strings are stored in the
+ * string pool in the same order as the records: first the
+ * #StringIndex strings, then the null-terminated embedded and
+ * external file names.
+ */
+struct WaypointRecord {
+  enum Flag : uint8_t {
+    TURN_POINT = 0x1,
+    HOME = 0x2,
+    START_POINT = 0x4,
+    FINISH_POINT = 0x8,
+    HAS_ELEVATION = 0x10,
+
+    ALL_FLAGS = 0x1f,
+  };
+
+  GeoPoint location;
+  double elevation;
+  uint32_t original_id;
+  uint32_t string_lengths[N_STRINGS];
+  uint16_t n_files_embed, n_files_external;
+  Runway runway;
+  RadioFrequency radio_frequency;
+
+  /** a bit mask of #Flag values */
+  uint8_t flags;
+
+  /** a #Waypoint::Type value */
+  uint8_t type;
+};
+
+/**
+ * Bump this when the meaning of a #WaypointRecord attribute changes.
+ * Layout changes are detected by #VERSION.
+ */
+static constexpr uint32_t FORMAT_VERSION = 2;
+
+/**
+ * FNV-1a hash of the given values.
+ */
+static constexpr uint32_t
+HashLayout(std::initializer_list<std::size_t> values) noexcept
+{
+  uint32_t hash = 2166136261u;
+  for (std::size_t value : values) {
+    hash ^= uint32_t(value);
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+/**
+ * The version stored in the header: derived from the layout of
+ * #CacheHeader and #WaypointRecord, so snapshots written by a build
+ * with a different layout are rejected.
+ */
+static constexpr uint32_t VERSION = HashLayout({
+    FORMAT_VERSION,
+    sizeof(CacheHeader),
+    sizeof(WaypointRecord),
+    offsetof(WaypointRecord, location),
+    offsetof(WaypointRecord, elevation),
+    offsetof(WaypointRecord, original_id),
+    offsetof(WaypointRecord, string_lengths),
+    offsetof(WaypointRecord, n_files_embed),
+    offsetof(WaypointRecord, n_files_external),
+    offsetof(WaypointRecord, runway),
+    offsetof(WaypointRecord, radio_frequency),
+    offsetof(WaypointRecord, flags),
+    offsetof(WaypointRecord, type),
+    sizeof(GeoPoint),
+    sizeof(Runway),
+    sizeof(RadioFrequency),
+  });
+
+static constexpr std::size_t MAX_WAYPOINTS = 1024 * 1024;
+static constexpr std::size_t MAX_POOL_SIZE = 256 * 1024 * 1024;
+
+static void
+AppendFiles(std::string &pool, uint16_t &n,
+            const std::forward_list<std::string> &files)
+{
+  n = 0;
+  for (const auto &i : files) {
+    if (n == UINT16_MAX)
+      break;
+
+    pool.append(i.c_str(), i.length() + 1);
+    ++n;
+  }
+}
+
+void
+Save(BufferedOutputStream &os, Path source,
+     std::span<const WaypointPtr> waypoints)
+{
+  const std::string_view source_string = source.c_str();
+
+  std::vector<WaypointRecord> records;
+  records.reserve(waypoints.size());
+
+  std::string pool;
+
+  for (const auto &wp : waypoints) {
+    auto &record = records.emplace_back();
+
+    /* zero-fill all implicit padding bytes (to make valgrind happy) */
+    memset(&record, 0, sizeof(record));
+
+    record.location = wp->location;
+    record.elevation = wp->elevation;
+    record.original_id = wp->original_id;
+
+    const std::string *const strings[N_STRINGS] = {
+      &wp->shortname, &wp->name, &wp->comment, &wp->details,
+    };
+
+    for (unsigned i = 0; i < N_STRINGS; ++i) {
+      record.string_lengths[i] = strings[i]->length();
+      pool.append(*strings[i]);
+    }
+
+    AppendFiles(pool, record.n_files_embed, wp->files_embed);
+#ifdef HAVE_RUN_FILE
+    AppendFiles(pool, record.n_files_external, wp->files_external);
+#endif
+
+    record.runway = wp->runway;
+    record.radio_frequency = wp->radio_frequency;
+    record.flags =
+      (wp->flags.turn_point ? WaypointRecord::TURN_POINT : 0) |
+      (wp->flags.home ? WaypointRecord::HOME : 0) |
+      (wp->flags.start_point ? WaypointRecord::START_POINT : 0) |
+      (wp->flags.finish_point ? WaypointRecord::FINISH_POINT : 0) |
+      (wp->has_elevation ? WaypointRecord::HAS_ELEVATION : 0);
+    record.type = uint8_t(wp->type);
+  }
+
+  if (records.size() > MAX_WAYPOINTS || pool.size() > MAX_POOL_SIZE)
+    throw std::runtime_error("Too many waypoints for the cache");
+
+  CacheHeader header;
+  header.version = VERSION;
+  header.n_waypoints = records.size();
+  header.source_length = source_string.size();
+  header.pool_size = pool.size();
+
+  os.WriteT(header);
+  os.Write(source_string);
+  os.Write(std::as_bytes(std::span{records}));
+  os.Write(std::string_view{pool});
+}
+
+/**
+ * Consume a string from the string pool.
+ */
+static std::string_view
+ShiftString(std::string_view &pool, std::size_t length)
+{
+  if (length > pool.size())
+    throw std::runtime_error("Malformed waypoint cache string pool");
+
+  const auto result = pool.substr(0, length);
+  pool.remove_prefix(length);
+  return result;
+}
+
+static void
+LoadFiles(std::string_view &pool, unsigned n,
+          std::forward_list<std::string> &files)
+{
+  auto last = files.before_begin();
+  for (unsigned i = 0; i < n; ++i) {
+    const auto end = pool.find('\0');
+    if (end == pool.npos)
+      throw std::runtime_error("Malformed waypoint cache string pool");
+
+    last = files.emplace_after(last, pool.substr(0, end));
+    pool.remove_prefix(end + 1);
+  }
+}
+
+std::vector<Waypoint>
+Load(BufferedReader &r, Path source, const WaypointFactory &factory)
+{
+  const auto header = r.ReadFullT<CacheHeader>();
+  if (header.version != VERSION ||
+      header.n_waypoints > MAX_WAYPOINTS ||
+      header.pool_size > MAX_POOL_SIZE)
+    throw std::runtime_error("Malformed waypoint cache header");
+
+  const std::string_view source_string = source.c_str();
+  if (header.source_length != source_string.size())
+    throw std::runtime_error("Waypoint cache source mismatch");
+
+  std::string buffer;
+  buffer.resize(header.source_length);
+  r.ReadFull(std::as_writable_bytes(std::span{buffer}));
+  if (buffer != source_string)
+    throw std::runtime_error("Waypoint cache source mismatch");
+
+  std::vector<WaypointRecord> records(header.n_waypoints);
+  r.ReadFull(std::as_writable_bytes(std::span{records}));
+
+  buffer.resize(header.pool_size);
+  r.ReadFull(std::as_writable_bytes(std::span{buffer}));
+  std::string_view pool = buffer;
+
+  std::vector<Waypoint> waypoints;
+  waypoints.reserve(records.size());
+
+  for (const auto &record : records) {
+    if (!record.location.Check() ||
+        (record.flags & ~WaypointRecord::ALL_FLAGS) != 0 ||
+        /* PGLANDING is the last Waypoint::Type */
+        record.type > uint8_t(Waypoint::Type::PGLANDING))
+      throw std::runtime_error("Malformed waypoint cache record");
+
+    auto &wp = waypoints.emplace_back(factory.Create(record.location));
+
+    std::string *const strings[N_STRINGS] = {
+      &wp.shortname, &wp.name, &wp.comment, &wp.details,
+    };
+
+    for (unsigned i = 0; i < N_STRINGS; ++i)
+      strings[i]->assign(ShiftString(pool, record.string_lengths[i]));
+
+    LoadFiles(pool, record.n_files_embed, wp.files_embed);
+#ifdef HAVE_RUN_FILE
+    LoadFiles(pool, record.n_files_external, wp.files_external);
+#else
+    std::forward_list<std::string> files_external;
+    LoadFiles(pool, record.n_files_external, files_external);
+#endif
+
+    wp.original_id = record.original_id;
+    wp.runway = record.runway;
+    wp.radio_frequency = record.radio_frequency;
+    wp.flags.turn_point = record.flags & WaypointRecord::TURN_POINT;
+    wp.flags.home = record.flags & WaypointRecord::HOME;
+    wp.flags.start_point = record.flags & WaypointRecord::START_POINT;
+    wp.flags.finish_point = record.flags & WaypointRecord::FINISH_POINT;
+    wp.type = Waypoint::Type(record.type);
+
+    if (record.flags & WaypointRecord::HAS_ELEVATION) {
+      wp.elevation = record.elevation;
+      wp.has_elevation = true;
+    } else
+      factory.FallbackElevation(wp);
+  }
+
+  return waypoints;
+}
+
+} // namespace WaypointCache
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "Engine/Waypoint/Ptr.hpp"
+
+#include <span>
+#include <vector>
+
+struct Waypoint;
+class Path;
+class BufferedOutputStream;
+class BufferedReader;
+class WaypointFactory;
+
+/**
+ * A binary snapshot of the waypoints parsed from one file, to be
+ * stored in the #FileCache.  Loading the snapshot is much cheaper than
+ * parsing the text formats again.
+ *
+ * The snapshot consists of a header, a table of fixed-size records
+ * and a string pool.  It is only meant to be read back by the same
+ * build on the same machine; it uses the native byte order and
+ * structure layout.
+ */
+namespace WaypointCache {
+
+/**
+ * Save the specified waypoints.  The attributes which are set by the
+ * #WaypointFactory (origin, file number) are not saved.  Waypoints
+ * should be parsed without terrain, so the elevation fallback can be
+ * applied by Load() with the terrain which is then current.
+ *
+ * Throws on error.
+ *
+ * @param source the path of the file the waypoints were read from
+ */
+void
+Save(BufferedOutputStream &os, Path source,
+     std::span<const WaypointPtr> waypoints);
+
+/**
+ * Load a snapshot created by Save().
+ *
+ * Throws on error, e.g. if the snapshot is malformed, has a different
+ * version or was created for a different source file.
+ *
+ * @param factory creates the #Waypoint instances and provides the
+ * elevation fallback
+ */
+std::vector<Waypoint>
+Load(BufferedReader &r, Path source, const WaypointFactory &factory);
+
+} // namespace WaypointCache
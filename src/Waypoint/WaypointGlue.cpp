@@ -12,24 +12,121 @@
 #include "Waypoint/Waypoints.hpp"
 #include "WaypointFileType.hpp"
 #include "WaypointReader.hpp"
+#include "WaypointCache.hpp"
+#include "io/BufferedOutputStream.hxx"
+#include "io/BufferedReader.hxx"
+#include "io/FileCache.hpp"
+#include "io/FileOutputStream.hxx"
 #include "io/MapFile.hpp"
+#include "io/Reader.hxx"
 #include "io/ZipArchive.hpp"
 #include "lib/fmt/PathFormatter.hpp"
 #include "system/Path.hpp"
+#include "util/StaticString.hxx"
+
+#include <algorithm>
+#include <vector>
 
 namespace WaypointGlue {
 
+static const char *const waypoint_cache_name = "waypoints";
+
+/**
+ * Build the name of the #FileCache entry for the specified waypoint
+ * file slot.  The snapshot itself records the path of its source.
+ */
+static StaticString<32>
+MakeCacheName(WaypointOrigin origin, uint8_t file_num) noexcept
+{
+  StaticString<32> name;
+  name.Format("%s-%u-%u", waypoint_cache_name,
+              unsigned(origin), unsigned(file_num));
+  return name;
+}
+
+static bool
+LoadCache(Waypoints &waypoints, FileCache &cache, const char *cache_name,
+          Path path, const WaypointFactory &factory)
+{
+  auto r = cache.Load(cache_name, path);
+  if (!r)
+    return false;
+
+  BufferedReader br(*r);
+  for (auto &wp : WaypointCache::Load(br, path, factory))
+    waypoints.Append(std::move(wp));
+  return true;
+}
+
+/**
+ * Parse the waypoint file without terrain (the elevation fallback is
+ * applied later, so the snapshot does not depend on the terrain),
+ * save the snapshot and append the waypoints.
+ */
+static void
+ReadAndSaveCache(Waypoints &waypoints, FileCache &cache,
+                 const char *cache_name, Path path,
+                 WaypointFileType file_type,
+                 WaypointOrigin origin, uint8_t file_num,
+                 const RasterTerrain *terrain,
+                 ProgressListener &progress)
+{
+  Waypoints parsed;
+  ReadWaypointFile(path, file_type, parsed,
+                   WaypointFactory(origin, file_num), progress);
+
+  /* restore the file order */
+  std::vector<WaypointPtr> list(parsed.begin(), parsed.end());
+  std::sort(list.begin(), list.end(), [](const auto &a, const auto &b){
+    return a->id < b->id;
+  });
+
+  try {
+    auto os = cache.Save(cache_name, path);
+    BufferedOutputStream bos(*os);
+    WaypointCache::Save(bos, path, list);
+    bos.Flush();
+    os->Commit();
+  } catch (...) {
+    LogError(std::current_exception(), "Failed to save waypoint cache");
+  }
+
+  const WaypointFactory factory(origin, file_num, terrain);
+  for (const auto &i : list) {
+    Waypoint wp = *i;
+    if (!wp.has_elevation)
+      factory.FallbackElevation(wp);
+    waypoints.Append(std::move(wp));
+  }
+}
+
 static bool
 LoadWaypointFile(Waypoints &waypoints, Path path,
                  WaypointFileType file_type,
                  WaypointOrigin origin,
                  uint8_t file_num,
                  const RasterTerrain *terrain,
+                 FileCache *cache,
                  ProgressListener &progress) noexcept
 try {
-  ReadWaypointFile(path, file_type, waypoints,
-                   WaypointFactory(origin, file_num, terrain),
-                   progress);
+  const WaypointFactory factory(origin, file_num, terrain);
+
+  if (cache == nullptr) {
+    ReadWaypointFile(path, file_type, waypoints, factory, progress);
+    return true;
+  }
+
+  const auto cache_name = MakeCacheName(origin, file_num);
+
+  try {
+    if (LoadCache(waypoints, *cache, cache_name, path, factory))
+      return true;
+  } catch (...) {
+    LogError(std::current_exception(), "Failed to load waypoint cache");
+  }
+
+  ReadAndSaveCache(waypoints, *cache, cache_name, path, file_type,
+                   origin, file_num, terrain, progress);
   return true;
 } catch (...) {
   LogFmt("Failed to read waypoint file: {}", path);
@@ -42,16 +139,11 @@ LoadWaypointFile(Waypoints &waypoints, Path path,
                  WaypointOrigin origin,
                  uint8_t file_num,
                  const RasterTerrain *terrain,
+                 FileCache *cache,
                  ProgressListener &progress) noexcept
-try {
-  ReadWaypointFile(path, waypoints,
-                   WaypointFactory(origin, file_num, terrain),
-                   progress);
-  return true;
-} catch (...) {
-  LogFmt("Failed to read waypoint file: {}", path);
-  LogError(std::current_exception());
-  return false;
+{
+  return LoadWaypointFile(waypoints, path, DetermineWaypointFileType(path),
+                          origin, file_num, terrain, cache, progress);
 }
 
 static bool
@@ -74,7 +166,7 @@ try {
 
 bool
 LoadWaypoints(Waypoints &way_points, const RasterTerrain *terrain,
-              ProgressListener &progress)
+              FileCache *cache, ProgressListener &progress)
 {
   bool found = false;
 
@@ -87,7 +179,7 @@ LoadWaypoints(Waypoints &way_points, const RasterTerrain *terrain,
   uint8_t file_num = 0;
   for (const auto &path : paths) {
     found |= LoadWaypointFile(way_points, path, WaypointOrigin::PRIMARY,
-                              file_num++, terrain, progress);
+                              file_num++, terrain, cache, progress);
   }
 
   // ### WATCHED WAYPOINT/THIRD FILE ###
@@ -96,7 +188,7 @@ LoadWaypoints(Waypoints &way_points, const RasterTerrain *terrain,
   file_num = 0;
   for (const auto &path : paths) {
     found |= LoadWaypointFile(way_points, path, WaypointOrigin::WATCHED,
-                              file_num++, terrain, progress);
+                              file_num++, terrain, cache, progress);
   }
 
   // ### MAP/FOURTH FILE ###
@@ -124,7 +216,7 @@ LoadWaypoints(Waypoints &way_points, const RasterTerrain *terrain,
   LoadWaypointFile(way_points,
                    ResolveTypedDataFilePath(FileType::WAYPOINT, "user.cup"),
                    WaypointFileType::SEEYOU,
-                   WaypointOrigin::USER, 0, terrain, progress);
+                   WaypointOrigin::USER, 0, terrain, cache, progress);
   // Optimise the waypoint list after attaching new waypoints
   way_points.Optimise();
 
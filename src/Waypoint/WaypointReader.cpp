@@ -12,14 +12,15 @@
 #include "system/Path.hpp"
 #include "io/FileReader.hxx"
 #include "io/CupxArchive.hpp"
-#include "io/MemoryReader.hxx"
 #include "io/ZipReader.hpp"
 #include "io/ProgressReader.hpp"
 #include "io/BufferedReader.hxx"
 
 #include "util/Compiler.h"
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 static WaypointReaderBase *
 CreateWaypointReader(WaypointFileType type, WaypointFactory factory)
@@ -53,6 +54,33 @@ CreateWaypointReader(WaypointFileType type, WaypointFactory factory)
   return nullptr;
 }
 
+/**
+ * Read the whole file into memory, so ParseSeeYou() can split it for
+ * parallel parsing.
+ */
+static std::vector<std::byte>
+ReadWholeFile(Reader &reader, uint_least64_t total_size)
+{
+  /* read in small portions to keep the progress bar moving */
+  static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+  std::vector<std::byte> buffer(total_size);
+  std::size_t position = 0;
+  while (position < buffer.size()) {
+    const std::size_t nbytes =
+      reader.Read(std::span{buffer}.subspan(position,
+                                            std::min(buffer.size() - position,
+                                                     CHUNK_SIZE)));
+    if (nbytes == 0)
+      break;
+
+    position += nbytes;
+  }
+
+  buffer.resize(position);
+  return buffer;
+}
+
 static void
 ReadWaypointFile(Reader &file_reader, WaypointFileType file_type,
                  uint_least64_t total_size,
@@ -60,11 +88,11 @@ ReadWaypointFile(Reader &file_reader, WaypointFileType file_type,
                  ProgressListener &progress)
 {
   ProgressReader progress_reader{file_reader, total_size, progress};
-  BufferedReader buffered_reader{progress_reader};
 
   switch (file_type) {
   case WaypointFileType::SEEYOU:
-    ParseSeeYou(factory, way_points, buffered_reader);
+    ParseSeeYou(factory, way_points,
+                ReadWholeFile(progress_reader, total_size));
     break;
 
   case WaypointFileType::CUPX:
@@ -75,6 +103,7 @@ ReadWaypointFile(Reader &file_reader, WaypointFileType file_type,
     if (!reader)
       throw std::runtime_error{"Unrecognised waypoint file"};
 
+    BufferedReader buffered_reader{progress_reader};
     reader->Parse(way_points, buffered_reader);
     break;
   }
@@ -90,10 +119,7 @@ ReadWaypointFile(Path path, WaypointFileType file_type,
     if (cup_data.empty())
       throw std::runtime_error{"Failed to read POINTS.CUP from CUPX archive"};
 
-    MemoryReader mem_reader{cup_data};
-    ProgressReader progress_reader{mem_reader, cup_data.size(), progress};
-    BufferedReader buffered_reader{progress_reader};
-    ParseSeeYou(factory, way_points, buffered_reader);
+    ParseSeeYou(factory, way_points, cup_data);
     return;
   }
 
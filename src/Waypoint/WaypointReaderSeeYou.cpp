@@ -7,8 +7,17 @@
 #include "util/DecimalParser.hxx"
 #include "util/IterableSplitString.hxx"
 #include "util/NumberParser.hxx"
+#include "util/UTF8.hpp"
 #include "io/StringConverter.hpp"
 #include "io/BufferedCsvReader.hpp"
+#include "io/BufferedReader.hxx"
+#include "io/MemoryReader.hxx"
+#include "thread/ParallelFor.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <optional>
+#include <vector>
 
 #include <stdlib.h>
 
@@ -175,180 +184,404 @@ ParseStyle(std::string_view src, Waypoint::Type &type)
   return true;
 }
 
-bool ParseSeeYou(WaypointFactory factory, Waypoints &waypoints, BufferedReader &reader) {
-  StringConverter string_converter;
-
-  // 2018: name, code, country, lat, lon, elev, style, rwydir, rwylen, freq, desc
-  // 2022: name, code, country, lat, lon, elev, style, rwdir, rwlen, rwwidth, freq, desc, userdata, pics
-  enum {
-    iName = 0,
-    iShortname = 1,
-    iLatitude = 3,
-    iLongitude = 4,
-    iElevation = 5,
-    iStyle = 6,
-    iRWDir = 7,
-    iRWLen = 8,
-    iRWWidth = 9,
-    iUserData = 12,
-    iPics = 13
-  };
-  unsigned iFrequency = 9;
-  unsigned iDescription = 10;
-
-  size_t params_num;
-  std::array<std::string_view,14> params;
-
-  bool tasks { false };
-  bool first_line = true;
+namespace {
+
+/**
+ * The CSV fields of one CUP record.
+ */
+using SeeYouParams = std::array<std::string_view, 14>;
+
+// 2018: name, code, country, lat, lon, elev, style, rwydir, rwylen, freq, desc
+// 2022: name, code, country, lat, lon, elev, style, rwdir, rwlen, rwwidth, freq, desc, userdata, pics
+enum {
+  iName = 0,
+  iShortname = 1,
+  iLatitude = 3,
+  iLongitude = 4,
+  iElevation = 5,
+  iStyle = 6,
+  iRWDir = 7,
+  iRWLen = 8,
+  iRWWidth = 9,
+  iUserData = 12,
+  iPics = 13
+};
+
+/**
+ * The column layout of a CUP file, determined by its header line.
+ */
+struct SeeYouColumns {
+  unsigned frequency = 9;
+  unsigned description = 10;
   bool has_rwwidth = false;
 
-  while ( true ) {
-    params_num = ReadCsvRecord(reader, params);
-
-    // first line of file
-    if (first_line) {
-      first_line = false;
-
-      // Empty file
-      if (params_num == 0)
-        return false;
-
-      // Check whether this is a header (a line with only field names).
-      if (StringIsEqualIgnoreCase(params[iLatitude],"lat"sv)) {
-
-        /*
-         * Newer cup/cupx specification adds rwwidth, shifts freq and desc
-         * right, and adds userdata and pics.
-         */
-        if (params_num > iRWWidth &&
-            StringIsEqualIgnoreCase(params[iRWWidth], "rwwidth"sv)) {
-          has_rwwidth = true;
-          iFrequency = 10;
-          iDescription = 11;
+  /**
+   * Check whether this is a header (a line with only field names)
+   * and apply the layout it describes.
+   *
+   * @return true if this record is a header
+   */
+  bool ParseHeader(const SeeYouParams &params, size_t params_num) noexcept {
+    if (!StringIsEqualIgnoreCase(params[iLatitude], "lat"sv))
+      return false;
+
+    /*
+     * Newer cup/cupx specification adds rwwidth, shifts freq and desc
+     * right, and adds userdata and pics.
+     */
+    if (params_num > iRWWidth &&
+        StringIsEqualIgnoreCase(params[iRWWidth], "rwwidth"sv)) {
+      has_rwwidth = true;
+      frequency = 10;
+      description = 11;
+    }
+
+    return true;
+  }
+};
+
+/**
+ * Does this record mark the start of the task section?
+ */
+[[gnu::pure]]
+static bool
+IsTaskSection(const SeeYouParams &params, size_t params_num) noexcept
+{
+  return params_num == 1 &&
+    StringIsEqualIgnoreCase(params[0], "-----Related Tasks-----"sv);
+}
+
+/**
+ * Parse one waypoint record.
+ *
+ * @return the waypoint, or std::nullopt if the record shall be
+ * skipped
+ */
+static std::optional<Waypoint>
+ParseRecord(const SeeYouColumns &columns, const WaypointFactory &factory,
+            StringConverter &string_converter,
+            const SeeYouParams &params, size_t params_num)
+{
+  // Skip blank lines and comments (comments are an extension)
+  if ( (params_num == 1 && params[0].empty()) ||
+       params[0].starts_with('*') )
+    return std::nullopt;
+
+  // Latitude (e.g. 5115.900N)
+  GeoPoint location;
+
+  if ( params_num <= iLatitude ||
+       !ParseAngle(params[iLatitude], location.latitude, true))
+    return std::nullopt;
+
+  // Longitude (e.g. 00715.900W)
+  if ( params_num <= iLongitude ||
+       !ParseAngle(params[iLongitude], location.longitude, false))
+    return std::nullopt;
+
+  location.Normalize(); // ensure longitude is within -180:180
+
+  Waypoint new_waypoint = factory.Create(location);
+
+  // Name (e.g. "Some Turnpoint")
+  if ( params_num <= iName ||
+       params[iName].empty() )
+    return std::nullopt;
+  new_waypoint.name.assign(string_converter.Convert(params[iName]));
+
+  // Elevation (e.g. 458.0m)
+  /// @todo configurable behaviour
+  if ( params_num > iElevation &&
+       !params[iElevation].empty() &&
+       ParseAltitude(params[iElevation], new_waypoint.elevation) )
+    new_waypoint.has_elevation = true;
+  else
+    factory.FallbackElevation(new_waypoint);
+
+  // Style (e.g. 5)
+  if ( params_num > iStyle &&
+       !params[iStyle].empty())
+    ParseStyle(params[iStyle], new_waypoint.type);
+
+  new_waypoint.flags.turn_point = true;
+
+  // Short name (code) of waypoint
+  if ( params_num <= iShortname )
+    return std::nullopt;
+  new_waypoint.shortname.assign(string_converter.Convert(params[iShortname]));
+
+  // Frequency & runway direction/length (for airports and landables)
+  // and description (e.g. "Some Description")
+  if ( new_waypoint.IsLandable() ) {
+    if ( params_num > columns.frequency &&
+         !params[columns.frequency].empty() )
+      new_waypoint.radio_frequency = RadioFrequency::Parse(params[columns.frequency]);
+
+    // Runway length (e.g. 546.0m)
+    double rwlen = -1;
+    if ( params_num > iRWLen &&
+         !params[iRWLen].empty() &&
+         ParseDistance(params[iRWLen], rwlen) &&
+         rwlen > 0 && rwlen <= 30000)
+      new_waypoint.runway.SetLength(uround(rwlen));
+
+    // Runway width (e.g. 15.0m; available in newer CUP formats)
+    double rwwidth = -1;
+    if (columns.has_rwwidth &&
+        params_num > iRWWidth &&
+        !params[iRWWidth].empty() &&
+        ParseDistance(params[iRWWidth], rwwidth) &&
+        rwwidth > 0 && rwwidth <= 30000)
+      new_waypoint.runway.SetWidth(uround(rwwidth));
+
+    if ( params_num > iRWDir &&
+         !params[iRWDir].empty()) {
+      if (auto value = ParseInteger<unsigned>(params[iRWDir])) {
+        unsigned direction = *value;
+
+        if (direction <= 360) {
+          if (direction == 360)
+            direction = 0;
+
+          new_waypoint.runway.SetDirectionDegrees(direction);
         }
-        continue;
       }
     }
+  }
+
+  /*
+   * This convention was introduced by the OpenAIP project
+   * (http://www.openaip.net/), since no waypoint type exists for
+   * thermal hotspots.
+   */
+  if ( params_num > columns.description &&
+       params[columns.description].starts_with("Hotspot"sv) )
+    new_waypoint.type = Waypoint::Type::THERMAL_HOTSPOT;
+
+  if ( params_num > columns.description )
+    new_waypoint.comment.assign(string_converter.Convert(params[columns.description]));
+
+  if ( params_num > iUserData )
+    new_waypoint.details.assign(string_converter.Convert(params[iUserData]));
+
+  if ( params_num > iPics &&
+       !params[iPics].empty() ) {
+    for (const auto i : IterableSplitString(params[iPics], ';')) {
+      new_waypoint.files_embed.emplace_front(string_converter.Convert(i));
+    }
+  }
 
-    // Tasks section
-    tasks = params_num == 1 &&
-      StringIsEqualIgnoreCase(params[0],"-----Related Tasks-----"sv);
+  return new_waypoint;
+}
+
+/**
+ * Parse records until the end of the input or the task section.
+ *
+ * @return true if the task section was found
+ */
+template<typename F>
+static bool
+ParseRecords(const SeeYouColumns &columns, const WaypointFactory &factory,
+             StringConverter &string_converter, BufferedReader &reader,
+             F &&f)
+{
+  SeeYouParams params;
+
+  while (true) {
+    const size_t params_num = ReadCsvRecord(reader, params);
 
     // End of file or start of task section
-    if ( !params_num || tasks )
-      break;
-
-    // Skip blank lines and comments (comments are an extension)
-    if ( (params_num == 1 && params[0].empty()) ||
-         params[0].starts_with('*') )
-      continue;
-
-    // Latitude (e.g. 5115.900N)
-    GeoPoint location;
-
-    if ( params_num <= iLatitude ||
-         !ParseAngle(params[iLatitude], location.latitude, true))
-      continue;
-
-    // Longitude (e.g. 00715.900W)
-    if ( params_num <= iLongitude ||
-         !ParseAngle(params[iLongitude], location.longitude, false))
-      continue;
-
-    location.Normalize(); // ensure longitude is within -180:180
-
-    Waypoint new_waypoint = factory.Create(location);
-
-    // Name (e.g. "Some Turnpoint")
-    if ( params_num <= iName ||
-         params[iName].empty() )
-      continue;
-    new_waypoint.name.assign(string_converter.Convert(params[iName]));
-
-    // Elevation (e.g. 458.0m)
-    /// @todo configurable behaviour
-    if ( params_num > iElevation &&
-         !params[iElevation].empty() &&
-         ParseAltitude(params[iElevation], new_waypoint.elevation) )
-      new_waypoint.has_elevation = true;
-    else
-      factory.FallbackElevation(new_waypoint);
-
-    // Style (e.g. 5)
-    if ( params_num > iStyle &&
-         !params[iStyle].empty())
-      ParseStyle(params[iStyle], new_waypoint.type);
-
-    new_waypoint.flags.turn_point = true;
-
-    // Short name (code) of waypoint
-    if ( params_num <= iShortname )
-      continue;
-    new_waypoint.shortname.assign(string_converter.Convert(params[iShortname]));
-
-    // Frequency & runway direction/length (for airports and landables)
-    // and description (e.g. "Some Description")
-    if ( new_waypoint.IsLandable() ) {
-      if ( params_num > iFrequency &&
-           !params[iFrequency].empty() )
-        new_waypoint.radio_frequency = RadioFrequency::Parse(params[iFrequency]);
-
-      // Runway length (e.g. 546.0m)
-      double rwlen = -1;
-      if ( params_num > iRWLen &&
-           !params[iRWLen].empty() &&
-           ParseDistance(params[iRWLen], rwlen) &&
-           rwlen > 0 && rwlen <= 30000)
-        new_waypoint.runway.SetLength(uround(rwlen));
-
-      // Runway width (e.g. 15.0m; available in newer CUP formats)
-      double rwwidth = -1;
-      if (has_rwwidth &&
-          params_num > iRWWidth &&
-          !params[iRWWidth].empty() &&
-          ParseDistance(params[iRWWidth], rwwidth) &&
-          rwwidth > 0 && rwwidth <= 30000)
-        new_waypoint.runway.SetWidth(uround(rwwidth));
-
-      if ( params_num > iRWDir &&
-           !params[iRWDir].empty()) {
-        if (auto value = ParseInteger<unsigned>(params[iRWDir])) {
-          unsigned direction = *value;
-
-          if (direction <= 360) {
-            if (direction == 360)
-              direction = 0;
-
-            new_waypoint.runway.SetDirectionDegrees(direction);
-          }
-        }
+    if (params_num == 0)
+      return false;
+    if (IsTaskSection(params, params_num))
+      return true;
+
+    if (auto wp = ParseRecord(columns, factory, string_converter,
+                              params, params_num))
+      f(std::move(*wp));
+  }
+}
+
+/**
+ * Files smaller than this are not split (unless the caller asks
+ * for it); the overhead is not worth it.
+ */
+static constexpr std::size_t PARALLEL_MIN_SIZE = 1024 * 1024;
+
+static constexpr unsigned MAX_PARSE_THREADS = 4;
+
+/**
+ * Split the CUP data into chunks which end at record boundaries,
+ * i.e. at newlines which are not inside a quoted field.  Quotes are
+ * interpreted the same way as ReadCsvRecord() does: only at the
+ * start of a field, with a doubled quote as escape.
+ *
+ * @return the end offsets of all chunks
+ */
+static std::vector<std::size_t>
+SplitRecords(std::string_view data, unsigned n_chunks) noexcept
+{
+  std::vector<std::size_t> ends;
+  ends.reserve(n_chunks);
+
+  bool quoted = false, field_start = true;
+  std::size_t next_split = data.size() / n_chunks;
+  for (std::size_t i = 0; i < data.size() && ends.size() + 1 < n_chunks; ++i) {
+    const char ch = data[i];
+
+    if (quoted) {
+      if (ch == '"') {
+        if (i + 1 < data.size() && data[i + 1] == '"')
+          ++i;
+        else
+          quoted = false;
       }
-    }
+    } else if (ch == '"' && field_start) {
+      quoted = true;
+      field_start = false;
+    } else if (ch == ',') {
+      field_start = true;
+    } else if (ch == '\n') {
+      field_start = true;
+
+      if (i + 1 >= next_split) {
+        ends.push_back(i + 1);
+        next_split = (ends.size() + 1) * data.size() / n_chunks;
+      }
+    } else if (ch != ' ')
+      field_start = false;
+  }
 
-    /*
-     * This convention was introduced by the OpenAIP project
-     * (http://www.openaip.net/), since no waypoint type exists for
-     * thermal hotspots.
-     */
-    if ( params_num > iDescription &&
-         params[iDescription].starts_with("Hotspot"sv) )
-      new_waypoint.type = Waypoint::Type::THERMAL_HOTSPOT;
+  ends.push_back(data.size());
+  return ends;
+}
+
+/**
+ * The result of parsing one chunk.
+ */
+struct SeeYouChunk {
+  std::vector<Waypoint> waypoints;
+  std::exception_ptr error;
+  bool tasks = false;
+};
+
+} // anonymous namespace
+
+bool
+ParseSeeYou(WaypointFactory factory, Waypoints &waypoints,
+            BufferedReader &reader)
+{
+  StringConverter string_converter;
+  SeeYouColumns columns;
+
+  // first line of file
+  SeeYouParams params;
+  const size_t params_num = ReadCsvRecord(reader, params);
+
+  // Empty file
+  if (params_num == 0)
+    return false;
+
+  if (!columns.ParseHeader(params, params_num)) {
+    if (IsTaskSection(params, params_num))
+      return true;
 
-    if ( params_num > iDescription )
-      new_waypoint.comment.assign(string_converter.Convert(params[iDescription]));
+    if (auto wp = ParseRecord(columns, factory, string_converter,
+                              params, params_num))
+      waypoints.Append(std::move(*wp));
+  }
 
-    if ( params_num > iUserData )
-      new_waypoint.details.assign(string_converter.Convert(params[iUserData]));
+  return ParseRecords(columns, factory, string_converter, reader,
+                      [&waypoints](Waypoint &&wp){
+                        waypoints.Append(std::move(wp));
+                      });
+}
 
-    if ( params_num > iPics &&
-         !params[iPics].empty() ) {
-      for (const auto i : IterableSplitString(params[iPics], ';')) {
-        new_waypoint.files_embed.emplace_front(string_converter.Convert(i));
+bool
+ParseSeeYou(WaypointFactory factory, Waypoints &waypoints,
+            std::span<const std::byte> data, unsigned n_chunks)
+{
+  const std::string_view text{reinterpret_cast<const char *>(data.data()),
+                              data.size()};
+
+  if (n_chunks == 0)
+    n_chunks = data.size() >= PARALLEL_MIN_SIZE
+      ? std::min(ThreadPool::Get().GetWorkerCount() + 1, MAX_PARSE_THREADS)
+      : 1;
+
+  /* the charset auto-detection of StringConverter switches to
+     ISO-Latin-1 at the first invalid UTF-8 sequence, which depends
+     on all preceding lines; only files which are valid UTF-8
+     throughout can be split */
+  if (n_chunks < 2 || !ValidateUTF8(text)) {
+    MemoryReader memory_reader{data};
+    BufferedReader buffered_reader{memory_reader};
+    return ParseSeeYou(factory, waypoints, buffered_reader);
+  }
+
+  const auto ends = SplitRecords(text, n_chunks);
+
+  /* the first line of the first chunk determines the column layout
+     for all chunks; it is parsed before the others are started */
+  MemoryReader first_reader{data.first(ends.front())};
+  BufferedReader first_buffered_reader{first_reader};
+
+  StringConverter string_converter;
+  SeeYouColumns columns;
+  SeeYouParams params;
+  const size_t params_num = ReadCsvRecord(first_buffered_reader, params);
+  if (params_num == 0)
+    return false;
+
+  std::vector<SeeYouChunk> chunks(ends.size());
+  if (!columns.ParseHeader(params, params_num)) {
+    if (IsTaskSection(params, params_num))
+      return true;
+
+    if (auto wp = ParseRecord(columns, factory, string_converter,
+                              params, params_num))
+      chunks.front().waypoints.emplace_back(std::move(*wp));
+  }
+
+  ParallelFor(chunks.size(), chunks.size(), 1,
+              [&](unsigned begin, unsigned end) noexcept {
+    for (unsigned i = begin; i < end; ++i) {
+      auto &chunk = chunks[i];
+      const auto add = [&chunk](Waypoint &&wp){
+        chunk.waypoints.emplace_back(std::move(wp));
+      };
+
+      try {
+        if (i == 0) {
+          /* continue after the header line */
+          chunk.tasks = ParseRecords(columns, factory, string_converter,
+                                     first_buffered_reader, add);
+        } else {
+          StringConverter chunk_converter;
+          MemoryReader chunk_reader{data.subspan(ends[i - 1],
+                                                 ends[i] - ends[i - 1])};
+          BufferedReader chunk_buffered_reader{chunk_reader};
+          chunk.tasks = ParseRecords(columns, factory, chunk_converter,
+                                     chunk_buffered_reader, add);
+        }
+      } catch (...) {
+        chunk.error = std::current_exception();
       }
     }
-    waypoints.Append(std::move(new_waypoint));
+  });
+
+  /* append in file order, so waypoint ids are the same as with
+     sequential parsing */
+  for (auto &chunk : chunks) {
+    for (auto &wp : chunk.waypoints)
+      waypoints.Append(std::move(wp));
+
+    if (chunk.error)
+      std::rethrow_exception(chunk.error);
+
+    if (chunk.tasks)
+      return true;
   }
 
-  return tasks;
+  return false;
 }
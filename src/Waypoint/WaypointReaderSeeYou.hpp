@@ -5,6 +5,9 @@
 
 #include "Factory.hpp"
 
+#include <cstddef>
+#include <span>
+
 class Waypoints;
 class BufferedReader;
 
@@ -15,3 +18,19 @@ class BufferedReader;
  * Throws on error.
  */
 bool ParseSeeYou(WaypointFactory factory, Waypoints &waypoints, BufferedReader &reader);
+
+/**
+ * Parse a CUP file which has been loaded into memory.  Large files
+ * are split at record boundaries and the chunks are parsed in
+ * parallel (see ParallelFor()); the waypoints are appended in file
+ * order, so the result is the same as with the #BufferedReader
+ * overload.
+ *
+ * @param n_chunks the number of chunks to split the file into; 0
+ * chooses by file size and the number of CPU cores
+ * @return true if the "Related Tasks" line was found
+ *
+ * Throws on error.
+ */
+bool ParseSeeYou(WaypointFactory factory, Waypoints &waypoints,
+                 std::span<const std::byte> data, unsigned n_chunks=0);
@@ -5,8 +5,10 @@
 
 #include "Weather/EDL/TileValue.hpp"
 
-EdlMbTilesOverlay::EdlMbTilesOverlay(Path path, std::string label)
-  :MbTilesOverlay(std::move(path), std::move(label))
+EdlMbTilesOverlay::EdlMbTilesOverlay(Path path, std::string label,
+                                     std::function<void()> &&redraw_callback)
+  :MbTilesOverlay(std::move(path), std::move(label),
+                  std::move(redraw_callback))
 {
 }
 
@@ -10,7 +10,8 @@
  */
 class EdlMbTilesOverlay final : public MbTilesOverlay {
 public:
-  EdlMbTilesOverlay(Path path, std::string label);
+  EdlMbTilesOverlay(Path path, std::string label,
+                    std::function<void()> &&redraw_callback = {});
 
   bool
   SampleAscendancyAt(GeoPoint p, double &value_mps) const noexcept;
@@ -324,10 +324,12 @@ ApplyOverlay(Path path)
   /* Reuse the generic overlay HUD by exposing the active EDL state as
      the overlay label instead of showing this mapping only in a widget. */
   const auto label = GetOverlayLabel();
-  auto overlay = std::make_unique<EdlMbTilesOverlay>(path, label.c_str());
-
   if (auto *map = UIGlobals::GetMap()) {
-    map->SetOverlay(std::move(overlay));
+    /* tiles are decoded in background; redraw when they are ready */
+    map->SetOverlay(std::make_unique<EdlMbTilesOverlay>(path, label.c_str(),
+                                                        [map]{
+                                                          map->InjectRedraw();
+                                                        }));
     map->QuickRedraw();
   }
 
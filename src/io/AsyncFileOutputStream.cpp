@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "AsyncFileOutputStream.hpp"
+
+#include <algorithm>
+
+AsyncFileOutputStream::AsyncFileOutputStream(Path path,
+                                             FileOutputStream::Mode mode,
+                                             Duration _sync_interval)
+  :Thread("FileWriter"),
+   file(path, mode),
+   sync_interval(_sync_interval),
+   ring(new std::byte[CAPACITY])
+{
+  Start();
+}
+
+AsyncFileOutputStream::~AsyncFileOutputStream() noexcept
+{
+  if (Thread::IsDefined())
+    StopThread();
+}
+
+void
+AsyncFileOutputStream::Write(std::span<const std::byte> src)
+{
+  while (!src.empty()) {
+    CheckError();
+
+    const std::size_t h = head.load(std::memory_order_relaxed);
+    const std::size_t available =
+      CAPACITY - (h - tail.load(std::memory_order_acquire));
+    if (available == 0) {
+      /* the writer thread is far behind; this is the only case
+         where the caller has to wait for the storage */
+      std::unique_lock lock{mutex};
+      space_cond.wait(lock, [this, h]{
+        return error || h - tail.load(std::memory_order_acquire) < CAPACITY;
+      });
+      continue;
+    }
+
+    const std::size_t offset = h % CAPACITY;
+    const std::size_t n = std::min({src.size(), available, CAPACITY - offset});
+    std::copy_n(src.data(), n, ring.get() + offset);
+
+    /* sequentially consistent, pairs with #sleeping */
+    head.store(h + n);
+
+    src = src.subspan(n);
+    WakeUp();
+  }
+}
+
+void
+AsyncFileOutputStream::Commit()
+{
+  StopThread();
+  CheckError();
+
+  /* the writer thread has already synced the file */
+  file.Commit();
+}
+
+inline void
+AsyncFileOutputStream::WakeUp() noexcept
+{
+  /* the writer thread sets #sleeping before it checks for new data
+     the last time, so either it sees the new #head or we see
+     #sleeping */
+  if (sleeping.load()) {
+    const std::lock_guard lock{mutex};
+    cond.notify_one();
+  }
+}
+
+void
+AsyncFileOutputStream::StopThread() noexcept
+{
+  {
+    const std::lock_guard lock{mutex};
+    stop = true;
+    cond.notify_one();
+  }
+
+  Join();
+}
+
+void
+AsyncFileOutputStream::CheckError()
+{
+  if (failed.load(std::memory_order_acquire)) {
+    const std::lock_guard lock{mutex};
+    std::rethrow_exception(error);
+  }
+}
+
+inline void
+AsyncFileOutputStream::Drain()
+{
+  const std::size_t h = head.load(std::memory_order_acquire);
+  std::size_t t = tail.load(std::memory_order_relaxed);
+
+  while (t != h) {
+    const std::size_t offset = t % CAPACITY;
+    const std::size_t n = std::min(h - t, CAPACITY - offset);
+    file.Write({ring.get() + offset, n});
+
+    t += n;
+    tail.store(t, std::memory_order_release);
+    dirty = true;
+  }
+}
+
+inline void
+AsyncFileOutputStream::SyncIfDue(bool force)
+{
+  if (!dirty)
+    return;
+
+  const auto now = std::chrono::steady_clock::now();
+  if (!force && now - last_sync < sync_interval)
+    return;
+
+  file.Sync();
+  dirty = false;
+  last_sync = now;
+}
+
+void
+AsyncFileOutputStream::Run() noexcept
+try {
+  last_sync = std::chrono::steady_clock::now();
+
+  std::unique_lock lock{mutex};
+
+  while (true) {
+    if (IsEmpty()) {
+      if (stop) {
+        const ScopeUnlock unlock{mutex};
+        SyncIfDue(true);
+        break;
+      }
+
+      sleeping.store(true);
+      if (IsEmpty() && !stop) {
+        if (dirty && sync_interval != Duration::max())
+          /* wake up when the next fdatasync() is due */
+          cond.wait_for(lock, sync_interval -
+                        (std::chrono::steady_clock::now() - last_sync));
+        else
+          cond.wait(lock);
+      }
+      sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    {
+      const ScopeUnlock unlock{mutex};
+      Drain();
+      SyncIfDue(false);
+    }
+
+    space_cond.notify_one();
+  }
+} catch (...) {
+  const std::lock_guard lock{mutex};
+  error = std::current_exception();
+  failed.store(true, std::memory_order_release);
+  space_cond.notify_one();
+}
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "OutputStream.hxx"
+#include "FileOutputStream.hxx"
+#include "thread/Thread.hpp"
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <memory>
+
+/**
+ * An #OutputStream which writes to a file in a separate thread, so
+ * the caller does not have to wait for slow storage (e.g. SD cards
+ * with erratic write latency).
+ *
+ * Write() copies the data into a lock-free single-producer
+ * single-consumer ring buffer; it blocks only if the writer thread
+ * is so far behind that the buffer is full.  The writer thread may
+ * call fdatasync() according to the configured interval, and always
+ * does so before Commit() returns.
+ *
+ * Write errors are detected by the writer thread; they are thrown by
+ * the next Write() or Commit() call.
+ *
+ * Only one thread may call Write() and Commit().
+ */
+class AsyncFileOutputStream final : public OutputStream, Thread {
+public:
+  using Duration = std::chrono::steady_clock::duration;
+
+private:
+  static constexpr std::size_t CAPACITY = 64 * 1024;
+
+  FileOutputStream file;
+
+  /**
+   * Call fdatasync() if the last one is at least this long ago.
+   * Zero means after each batch of data; Duration::max() means
+   * only in Commit().
+   */
+  const Duration sync_interval;
+
+  const std::unique_ptr<std::byte[]> ring;
+
+  /**
+   * The total number of bytes written into / consumed from the
+   * #ring.  The position within the #ring is the modulo of
+   * #CAPACITY.  Only the producer modifies #head, only the writer
+   * thread modifies #tail.
+   */
+  std::atomic<std::size_t> head{0}, tail{0};
+
+  /**
+   * Set by the writer thread before it waits for #cond; if this is
+   * not set, the producer does not need to lock the #mutex.
+   */
+  std::atomic<bool> sleeping{false};
+
+  /**
+   * Set when #error has been set, to allow checking it without
+   * locking the #mutex.
+   */
+  std::atomic<bool> failed{false};
+
+  Mutex mutex;
+
+  /**
+   * Wakes up the writer thread: new data or #stop.
+   */
+  Cond cond;
+
+  /**
+   * Wakes up the producer: free space in the #ring or #error.
+   */
+  Cond space_cond;
+
+  /**
+   * Protected by #mutex.
+   */
+  bool stop = false;
+
+  /**
+   * The error which occurred in the writer thread.  Protected by
+   * #mutex.
+   */
+  std::exception_ptr error;
+
+  /* the following are only used by the writer thread */
+
+  /**
+   * Was data written since the last fdatasync()?
+   */
+  bool dirty = false;
+
+  std::chrono::steady_clock::time_point last_sync;
+
+public:
+  /**
+   * Throws on error.
+   */
+  AsyncFileOutputStream(Path path, FileOutputStream::Mode mode,
+                        Duration _sync_interval=Duration::max());
+
+  /**
+   * Writes and syncs all pending data, but does not commit the
+   * file; errors are ignored.
+   */
+  ~AsyncFileOutputStream() noexcept override;
+
+  /* virtual methods from class OutputStream */
+  void Write(std::span<const std::byte> src) override;
+  void Commit() override;
+
+private:
+  bool IsEmpty() const noexcept {
+    /* sequentially consistent, pairs with #sleeping */
+    return head.load() == tail.load(std::memory_order_relaxed);
+  }
+
+  void WakeUp() noexcept;
+
+  /**
+   * Wait until the writer thread has written all pending data and
+   * exited.
+   */
+  void StopThread() noexcept;
+
+  /**
+   * Throw the error which occurred in the writer thread, if any.
+   */
+  void CheckError();
+
+  /**
+   * Write all data from the #ring to the file.  Called by the
+   * writer thread without holding the #mutex.
+   *
+   * Throws on error.
+   */
+  void Drain();
+
+  /**
+   * Call fdatasync() if it is due.  Called by the writer thread
+   * without holding the #mutex.
+   *
+   * Throws on error.
+   */
+  void SyncIfDue(bool force);
+
+  /* virtual methods from class Thread */
+  void Run() noexcept override;
+};
@@ -37,6 +37,13 @@ SqliteStatement::StepRow() const
   throw std::runtime_error(sqlite3_errmsg(sqlite3_db_handle(stmt)));
 }
 
+void
+SqliteStatement::Reset() const noexcept
+{
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+}
+
 void
 SqliteStatement::BindInt(int index, int value) const noexcept
 {
@@ -23,6 +23,13 @@ public:
   SqliteStatement &operator=(const SqliteStatement &) = delete;
 
   bool StepRow() const;
+
+  /**
+   * Reset the statement and clear its bindings, so it can be
+   * executed again.
+   */
+  void Reset() const noexcept;
+
   void BindInt(int index, int value) const noexcept;
   std::string_view GetTextColumn(int index) const noexcept;
   int GetIntColumn(int index) const noexcept;
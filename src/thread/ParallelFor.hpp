@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+/**
+ * Internal state of ParallelFor(), shared with the tasks submitted
+ * to the #ThreadPool.  Tasks which start after all chunks have been
+ * claimed return without touching the caller's function, which may
+ * be gone by then.
+ */
+class ParallelForState {
+  std::atomic<unsigned> next_chunk{0};
+
+  const unsigned n_chunks;
+
+  Mutex mutex;
+  Cond cond;
+  unsigned n_done = 0;
+
+public:
+  explicit ParallelForState(unsigned _n_chunks) noexcept
+    :n_chunks(_n_chunks) {}
+
+  /**
+   * Claim and process chunks until there are none left.
+   */
+  template<typename F>
+  void Work(const F &f) noexcept {
+    unsigned i;
+    while ((i = next_chunk.fetch_add(1, std::memory_order_relaxed)) < n_chunks) {
+      f(i);
+
+      const std::lock_guard lock{mutex};
+      if (++n_done == n_chunks)
+        cond.notify_all();
+    }
+  }
+
+  /**
+   * Wait until all chunks have been processed.
+   */
+  void Wait() noexcept {
+    std::unique_lock lock{mutex};
+    cond.wait(lock, [this]{ return n_done == n_chunks; });
+  }
+};
+
+/**
+ * Split the range [0, n) into up to #max_threads contiguous chunks
+ * and invoke f(begin, end) for each of them in parallel, using the
+ * given #ThreadPool.  The calling thread processes chunks, too.
+ * Returns after all chunks have been processed.
+ *
+ * If the pool has no workers or a task cannot be submitted, the
+ * remaining chunks are processed by the calling thread.
+ *
+ * @param min_chunk chunks are never smaller than this; small ranges
+ * are not worth the synchronisation
+ * @param priority the priority of the tasks submitted to the pool
+ */
+template<typename F>
+void
+ParallelFor(ThreadPool &pool,
+            unsigned n, unsigned max_threads, unsigned min_chunk,
+            F &&f,
+            ThreadPool::Priority priority=ThreadPool::Priority::HIGH) noexcept
+{
+  if (n == 0)
+    return;
+
+  max_threads = std::min(max_threads, pool.GetWorkerCount() + 1);
+
+  const unsigned n_chunks =
+    std::clamp(n / std::max(min_chunk, 1u), 1u, std::max(max_threads, 1u));
+  if (n_chunks == 1) {
+    f(0u, n);
+    return;
+  }
+
+  /* the tasks get a copy of this lambda, because a task may start
+     after this function has returned; the reference to #f is only
+     used for a chunk which has been claimed, i.e. before Wait()
+     returns */
+  const unsigned chunk_size = (n + n_chunks - 1) / n_chunks;
+  const auto chunk = [&f, n, chunk_size](unsigned i){
+    const unsigned begin = i * chunk_size;
+    if (begin < n)
+      f(begin, std::min(begin + chunk_size, n));
+  };
+
+  std::shared_ptr<ParallelForState> state;
+  try {
+    state = std::make_shared<ParallelForState>(n_chunks);
+
+    for (unsigned i = 1; i < n_chunks; ++i)
+      pool.Submit([state, chunk]{ state->Work(chunk); }, priority);
+  } catch (...) {
+    if (!state) {
+      f(0u, n);
+      return;
+    }
+
+    /* the remaining chunks are processed below */
+  }
+
+  state->Work(chunk);
+  state->Wait();
+}
+
+/**
+ * ParallelFor() with the process-wide #ThreadPool for CPU-heavy work.
+ */
+template<typename F>
+void
+ParallelFor(unsigned n, unsigned max_threads, unsigned min_chunk,
+            F &&f,
+            ThreadPool::Priority priority=ThreadPool::Priority::HIGH) noexcept
+{
+  ParallelFor(ThreadPool::Get(), n, max_threads, min_chunk,
+              std::forward<F>(f), priority);
+}
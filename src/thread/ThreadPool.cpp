@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "ThreadPool.hpp"
+#include "Name.hpp"
+
+#include <algorithm>
+
+/**
+ * The pool whose worker is running in the current thread (nullptr
+ * if this is not a worker thread).
+ */
+static thread_local const ThreadPool *current_pool = nullptr;
+static thread_local unsigned current_index;
+
+ThreadPool::ThreadPool(unsigned _n_workers, const char *_name) noexcept
+  :name(_name)
+{
+  if (_n_workers == 0) {
+    const unsigned n_cpus = std::thread::hardware_concurrency();
+    _n_workers = n_cpus > 1 ? n_cpus - 1 : 0;
+  }
+
+  _n_workers = std::min(_n_workers, MAX_WORKERS);
+  if (_n_workers == 0)
+    return;
+
+  try {
+    workers = std::make_unique<Worker[]>(_n_workers);
+  } catch (...) {
+    return;
+  }
+
+  /* the workers must know the final number before they start
+     stealing; if a thread cannot be started, its queues are emptied
+     by the others */
+  n_workers = _n_workers;
+
+  unsigned n_started = 0;
+  for (unsigned i = 0; i < n_workers; ++i) {
+    try {
+      workers[i].thread = std::thread{[this, i]{ Run(i); }};
+      ++n_started;
+    } catch (...) {
+    }
+  }
+
+  if (n_started == 0)
+    n_workers = 0;
+}
+
+ThreadPool::~ThreadPool() noexcept
+{
+  {
+    const std::lock_guard lock{mutex};
+    quit = true;
+    cond.notify_all();
+  }
+
+  for (unsigned i = 0; i < n_workers; ++i)
+    if (workers[i].thread.joinable())
+      workers[i].thread.join();
+}
+
+ThreadPool &
+ThreadPool::Get() noexcept
+{
+  static ThreadPool instance;
+  return instance;
+}
+
+ThreadPool &
+ThreadPool::GetIO() noexcept
+{
+  static ThreadPool instance{IO_WORKERS, "IOThreadPool"};
+  return instance;
+}
+
+inline ThreadPool::Worker *
+ThreadPool::GetCurrentWorker() noexcept
+{
+  return current_pool == this
+    ? &workers[current_index]
+    : nullptr;
+}
+
+void
+ThreadPool::Submit(Function &&function, Priority priority,
+                   CancellationToken token)
+{
+  if (n_workers == 0) {
+    if (!token.IsCancelled())
+      function();
+    return;
+  }
+
+  Worker *worker = GetCurrentWorker();
+  if (worker == nullptr)
+    worker = &workers[next_worker.fetch_add(1, std::memory_order_relaxed)
+                      % n_workers];
+
+  /* increment the counter before the task becomes visible, so it
+     never drops below the number of queued tasks */
+  {
+    const std::lock_guard lock{mutex};
+    ++pending;
+  }
+
+  try {
+    const std::lock_guard lock{worker->mutex};
+    worker->queues[unsigned(priority)].push_back({
+        std::move(function),
+        std::move(token),
+      });
+  } catch (...) {
+    --pending;
+    throw;
+  }
+
+  cond.notify_one();
+}
+
+inline bool
+ThreadPool::Pop(Worker &worker, unsigned priority, bool steal,
+                Task &task) noexcept
+{
+  const std::lock_guard lock{worker.mutex};
+
+  auto &queue = worker.queues[priority];
+  if (queue.empty())
+    return false;
+
+  if (steal) {
+    task = std::move(queue.front());
+    queue.pop_front();
+  } else {
+    task = std::move(queue.back());
+    queue.pop_back();
+  }
+
+  return true;
+}
+
+inline bool
+ThreadPool::FindTask(unsigned self, Task &task) noexcept
+{
+  for (unsigned priority = 0; priority < N_PRIORITIES; ++priority) {
+    if (Pop(workers[self], priority, false, task))
+      return true;
+
+    for (unsigned i = 1; i < n_workers; ++i)
+      if (Pop(workers[(self + i) % n_workers], priority, true, task))
+        return true;
+  }
+
+  return false;
+}
+
+void
+ThreadPool::Run(unsigned self) noexcept
+{
+  SetThreadName(name);
+
+  current_pool = this;
+  current_index = self;
+
+  Task task;
+
+  while (true) {
+    if (FindTask(self, task)) {
+      --pending;
+
+      if (!task.token.IsCancelled())
+        task.function();
+
+      /* release the function's state before going to sleep */
+      task = {};
+      continue;
+    }
+
+    std::unique_lock lock{mutex};
+    cond.wait(lock, [this]{
+      return quit || pending.load(std::memory_order_relaxed) > 0;
+    });
+
+    if (quit)
+      break;
+  }
+}
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * A flag which tells tasks that their result is no longer needed.
+ * It is cheap to copy; all copies share the same state.  A
+ * default-constructed token is never cancelled.
+ */
+class CancellationToken {
+  friend class CancellationSource;
+
+  std::shared_ptr<const std::atomic<bool>> flag;
+
+  explicit CancellationToken(std::shared_ptr<const std::atomic<bool>> _flag) noexcept
+    :flag(std::move(_flag)) {}
+
+public:
+  CancellationToken() noexcept = default;
+
+  bool IsCancelled() const noexcept {
+    return flag && flag->load(std::memory_order_relaxed);
+  }
+};
+
+/**
+ * Creates #CancellationToken instances and cancels them.
+ */
+class CancellationSource {
+  std::shared_ptr<std::atomic<bool>> flag =
+    std::make_shared<std::atomic<bool>>(false);
+
+public:
+  CancellationToken GetToken() const noexcept {
+    return CancellationToken{flag};
+  }
+
+  void Cancel() noexcept {
+    flag->store(true, std::memory_order_relaxed);
+  }
+};
+
+/**
+ * A pool of worker threads for work which can be split into
+ * independent tasks.  Each worker has its own queues; tasks submitted
+ * by a worker go to its own queue, and idle workers steal tasks from
+ * the others.
+ *
+ * There are two process-wide instances: Get() has one worker per CPU
+ * core and is meant for CPU-heavy work; a task which waits for
+ * something occupies a CPU core's worker.  Tasks which block on I/O
+ * (e.g. loading files) go to GetIO() instead, which has a small fixed
+ * number of workers, so they never delay the CPU-heavy tasks.
+ */
+class ThreadPool {
+public:
+  enum class Priority : uint8_t {
+    /**
+     * Somebody waits for the result (e.g. rendering).
+     */
+    HIGH,
+
+    /**
+     * Background work.
+     */
+    LOW,
+  };
+
+  static constexpr unsigned N_PRIORITIES = 2;
+
+  /**
+   * Never start more worker threads than this.
+   */
+  static constexpr unsigned MAX_WORKERS = 7;
+
+  /**
+   * The number of workers of the GetIO() instance.
+   */
+  static constexpr unsigned IO_WORKERS = 3;
+
+  using Function = std::function<void()>;
+
+private:
+  struct Task {
+    Function function;
+    CancellationToken token;
+  };
+
+  struct Worker {
+    /**
+     * Protects #queues.
+     */
+    Mutex mutex;
+
+    std::deque<Task> queues[N_PRIORITIES];
+
+    std::thread thread;
+  };
+
+  /**
+   * Allocated once by the constructor and never resized, because
+   * the workers refer to their entries.
+   */
+  std::unique_ptr<Worker[]> workers;
+
+  unsigned n_workers = 0;
+
+  /**
+   * The name of the worker threads.
+   */
+  const char *const name;
+
+  /**
+   * Protects #quit and (for incrementing) #pending; idle workers wait
+   * on #cond.
+   */
+  Mutex mutex;
+  Cond cond;
+
+  /**
+   * The number of tasks which have been submitted but not yet taken
+   * from a queue.
+   */
+  std::atomic<unsigned> pending{0};
+
+  /**
+   * Used to distribute tasks submitted by other threads.
+   */
+  std::atomic<unsigned> next_worker{0};
+
+  bool quit = false;
+
+public:
+  /**
+   * @param _n_workers the number of worker threads; 0 means one less
+   * than the number of CPU cores (the submitting thread is expected
+   * to help)
+   * @param _name the name of the worker threads
+   */
+  explicit ThreadPool(unsigned _n_workers=0,
+                      const char *_name="ThreadPool") noexcept;
+
+  /**
+   * Waits for the workers to finish their current task; tasks which
+   * have not been started yet are discarded.
+   */
+  ~ThreadPool() noexcept;
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * Returns the process-wide instance.  Its workers are started on
+   * the first call.
+   */
+  [[gnu::const]]
+  static ThreadPool &Get() noexcept;
+
+  /**
+   * Returns the process-wide instance for tasks which block on I/O.
+   * Its workers are started on the first call.
+   */
+  [[gnu::const]]
+  static ThreadPool &GetIO() noexcept;
+
+  /**
+   * Returns the number of worker threads; may be 0 if no thread
+   * could be started (or if there is only one CPU core).
+   */
+  unsigned GetWorkerCount() const noexcept {
+    return n_workers;
+  }
+
+  /**
+   * Submit a task.  It is skipped if the token has been cancelled
+   * before the task starts; after that, the task may check the token
+   * by itself.  If there are no workers, the task is invoked right
+   * away.
+   *
+   * Throws std::bad_alloc.
+   */
+  void Submit(Function &&function, Priority priority=Priority::LOW,
+              CancellationToken token={});
+
+private:
+  /**
+   * Returns the worker running in the current thread, or nullptr.
+   */
+  [[gnu::pure]]
+  Worker *GetCurrentWorker() noexcept;
+
+  /**
+   * Take the next task from the given worker's queue (from the
+   * front if stealing, from the back otherwise).
+   */
+  static bool Pop(Worker &worker, unsigned priority, bool steal,
+                  Task &task) noexcept;
+
+  /**
+   * Find a task, looking at the worker's own queue first and then
+   * stealing from the others, higher priorities first.
+   */
+  bool FindTask(unsigned self, Task &task) noexcept;
+
+  void Run(unsigned self) noexcept;
+};
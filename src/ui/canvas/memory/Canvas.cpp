@@ -6,6 +6,7 @@
 #include "ui/canvas/Util.hpp"
 #include "Optimised.hpp"
 #include "RasterCanvas.hpp"
+#include "RasterBands.hpp"
 #include "ui/canvas/custom/Cache.hpp"
 #include "Math/Angle.hpp"
 
@@ -19,6 +20,7 @@
 
 #include <algorithm>
 #include <cassert>
+
 #include <string.h>
 
 class SDLRasterCanvas : public RasterCanvas<ActivePixelTraits> {
@@ -35,6 +37,38 @@ public:
   }
 };
 
+/**
+ * Render the rows [top, bottom) (clipped to the buffer) in bands
+ * which are rendered in parallel; see RasterBands::Run().  The
+ * function is invoked with a #SDLRasterCanvas for the band and the
+ * y offset of the band.
+ *
+ * @param width the (approximate) number of pixels per row
+ * @return false if nothing was rendered; the caller shall then
+ * render the whole area by itself
+ */
+template<typename F>
+static bool
+RenderBands(WritableImageBuffer<ActivePixelTraits> buffer,
+            int top, int bottom, unsigned width, F &&f) noexcept
+{
+  top = std::max(top, 0);
+  bottom = std::min(bottom, int(buffer.size.height));
+  if (top >= bottom)
+    return false;
+
+  return RasterBands::Run(top, bottom, width,
+                          [&buffer, &f](unsigned band_top,
+                                        unsigned band_bottom){
+    SDLRasterCanvas canvas({
+        buffer.At(0, band_top),
+        buffer.pitch,
+        {buffer.size.width, band_bottom - band_top},
+      });
+    f(canvas, int(band_top));
+  });
+}
+
 void
 Canvas::DrawOutlineRectangle(PixelRect r, Color color) noexcept
 {
@@ -49,9 +83,17 @@ Canvas::DrawFilledRectangle(PixelRect r, Color color) noexcept
   if (r.IsEmpty())
     return;
 
+  const auto c = SDLRasterCanvas::Import(color);
+
+  if (RenderBands(buffer, r.top, r.bottom, r.GetWidth(),
+                  [&r, c](SDLRasterCanvas &canvas, int offset){
+                    canvas.FillRectangle(r.left, r.top - offset,
+                                         r.right, r.bottom - offset, c);
+                  }))
+    return;
+
   SDLRasterCanvas canvas(buffer);
-  canvas.FillRectangle(r.left, r.top, r.right, r.bottom,
-                       canvas.Import(color));
+  canvas.FillRectangle(r.left, r.top, r.right, r.bottom, c);
 }
 
 void
@@ -76,9 +118,48 @@ DrawPolyline(Canvas &canvas, [[maybe_unused]] PixelOperations operations, const
   canvas.DrawPolyline(lppt, n_points, loop, color, thickness, mask);
 }
 
+/**
+ * Fill a polygon.  Large polygons are split into bands which are
+ * rendered in parallel.
+ *
+ * @param fill a function which fills the polygon on the given canvas;
+ * its second parameter is the vertex row which is the first row of
+ * the canvas
+ */
+template<typename F>
+static void
+FillPolygon(SDLRasterCanvas &canvas,
+            WritableImageBuffer<ActivePixelTraits> buffer,
+            const BulkPixelPoint *points, unsigned n, F &&fill) noexcept
+{
+  assert(n > 0);
+
+  int top = points[0].y, bottom = points[0].y;
+  int left = points[0].x, right = points[0].x;
+  for (unsigned i = 1; i < n; ++i) {
+    top = std::min(top, points[i].y);
+    bottom = std::max(bottom, points[i].y);
+    left = std::min(left, points[i].x);
+    right = std::max(right, points[i].x);
+  }
+
+  left = std::max(left, 0);
+  right = std::min(right, int(buffer.size.width));
+  const unsigned width = right > left ? right - left : 0;
+
+  if (RenderBands(buffer, top, bottom + 1, width, fill))
+    return;
+
+  fill(canvas, 0);
+}
+
 void
 Canvas::DrawPolyline(const BulkPixelPoint *p, unsigned cPoints)
 {
+  /* this is not split into bands: each band would have to clip all
+     segments again, which costs more than the rasterising it saves
+     for a thin line, and the dash pattern would restart at each band
+     border */
   SDLRasterCanvas canvas(buffer);
   ::DrawPolyline(canvas, ActivePixelTraits(), pen,
                  p, cPoints, false);
@@ -92,13 +173,23 @@ Canvas::DrawPolygon(const BulkPixelPoint *lppt, unsigned cPoints)
 
   SDLRasterCanvas canvas(buffer);
 
-  if (!brush.IsHollow()) {
+  if (!brush.IsHollow() && cPoints >= 3) {
     const auto color = canvas.Import(brush.GetColor());
     if (brush.GetColor().IsOpaque())
-      canvas.FillPolygon(lppt, cPoints, color);
-    else
-      canvas.FillPolygon(lppt, cPoints, color,
-                         AlphaPixelOperations<ActivePixelTraits>(brush.GetColor().Alpha()));
+      ::FillPolygon(canvas, buffer, lppt, cPoints,
+                    [lppt, cPoints, color](SDLRasterCanvas &c, int offset){
+                      c.FillPolygon(lppt, cPoints, color, offset);
+                    });
+    else {
+      const AlphaPixelOperations<ActivePixelTraits>
+        operations(brush.GetColor().Alpha());
+      ::FillPolygon(canvas, buffer, lppt, cPoints,
+                    [lppt, cPoints, color, &operations](SDLRasterCanvas &c,
+                                                        int offset){
+                      c.FillPolygon(lppt, cPoints, color, operations,
+                                    offset);
+                    });
+    }
   }
 
   if (IsPenOverBrush())
@@ -344,10 +435,22 @@ Canvas::Copy(PixelPoint dest_position, PixelSize dest_size,
       !Clip(dest_position.y, dest_size.height, GetHeight(), src_position.y))
     return;
 
+  const auto src_pixels = src.At(src_position.x, src_position.y);
+
+  if (RenderBands(buffer, dest_position.y,
+                  dest_position.y + int(dest_size.height), dest_size.width,
+                  [&](SDLRasterCanvas &canvas, int offset){
+                    canvas.CopyRectangle(dest_position.x,
+                                         dest_position.y - offset,
+                                         dest_size.width, dest_size.height,
+                                         src_pixels, src.pitch);
+                  }))
+    return;
+
   SDLRasterCanvas canvas(buffer);
   canvas.CopyRectangle(dest_position.x, dest_position.y,
                        dest_size.width, dest_size.height,
-                       src.At(src_position.x, src_position.y), src.pitch);
+                       src_pixels, src.pitch);
 }
 
 void
@@ -386,12 +489,24 @@ Canvas::CopyTransparentWhite(PixelPoint dest_position, PixelSize dest_size,
       !Clip(dest_position.y, dest_size.height, GetHeight(), src_position.y))
     return;
 
+  TransparentPixelOperations<ActivePixelTraits> operations(SDLRasterCanvas::Import(COLOR_WHITE));
+  const auto src_pixels = src.buffer.At(src_position.x, src_position.y);
+
+  if (RenderBands(buffer, dest_position.y,
+                  dest_position.y + int(dest_size.height), dest_size.width,
+                  [&](SDLRasterCanvas &canvas, int offset){
+                    canvas.CopyRectangle(dest_position.x,
+                                         dest_position.y - offset,
+                                         dest_size.width, dest_size.height,
+                                         src_pixels, src.buffer.pitch,
+                                         operations);
+                  }))
+    return;
+
   SDLRasterCanvas canvas(buffer);
-  TransparentPixelOperations<ActivePixelTraits> operations(canvas.Import(COLOR_WHITE));
   canvas.CopyRectangle(dest_position.x, dest_position.y,
                        dest_size.width, dest_size.height,
-                       src.buffer.At(src_position.x, src_position.y),
-                       src.buffer.pitch,
+                       src_pixels, src.buffer.pitch,
                        operations);
 }
 
@@ -442,11 +557,22 @@ Canvas::Stretch(PixelPoint dest_position, PixelSize dest_size,
     return;
   }
 
+  const auto src_pixels = src.At(src_position.x, src_position.y);
+
+  if (RenderBands(buffer, dest_position.y,
+                  dest_position.y + int(dest_size.height), dest_size.width,
+                  [&](SDLRasterCanvas &canvas, int offset){
+                    canvas.ScaleRectangle({dest_position.x,
+                                           dest_position.y - offset},
+                                          dest_size, src_pixels,
+                                          src.pitch, src_size);
+                  }))
+    return;
+
   SDLRasterCanvas canvas(buffer);
 
   canvas.ScaleRectangle(dest_position, dest_size,
-                        src.At(src_position.x, src_position.y),
-                        src.pitch, src_size);
+                        src_pixels, src.pitch, src_size);
 }
 
 void
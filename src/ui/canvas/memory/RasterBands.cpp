@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "RasterBands.hpp"
+#include "thread/ParallelFor.hpp"
+
+namespace RasterBands {
+
+bool
+Run(unsigned top, unsigned bottom, unsigned width,
+    const Function &function) noexcept
+{
+  if (bottom <= top ||
+      std::size_t(bottom - top) * width < MIN_PIXELS ||
+      (bottom - top) < 2 * MIN_BAND_HEIGHT ||
+      ThreadPool::Get().GetWorkerCount() == 0)
+    return false;
+
+  ParallelFor(bottom - top, ThreadPool::MAX_WORKERS + 1, MIN_BAND_HEIGHT,
+              [top, &function](unsigned begin, unsigned end){
+                function(top + begin, top + end);
+              });
+  return true;
+}
+
+} // namespace RasterBands
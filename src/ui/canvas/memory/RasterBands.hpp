@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * Renders large primitives of the memory canvas in parallel.  The
+ * affected rows are split into horizontal bands, and each band is
+ * rendered by a different thread.  Bands never overlap, therefore
+ * the threads do not need to synchronise while writing pixels.
+ */
+namespace RasterBands {
+
+/**
+ * Areas smaller than this number of pixels are not worth the
+ * synchronisation overhead.
+ */
+static constexpr std::size_t MIN_PIXELS = 64 * 1024;
+
+/**
+ * Bands are never smaller than this number of rows.
+ */
+static constexpr unsigned MIN_BAND_HEIGHT = 32;
+
+/**
+ * Renders the rows [top, bottom).
+ */
+using Function = std::function<void(unsigned top, unsigned bottom)>;
+
+/**
+ * Split the rows [top, bottom) into bands and invoke the function
+ * for each of them in the #ThreadPool.  Returns after all bands have
+ * been rendered.
+ *
+ * @param width the number of pixels per row which will be rendered;
+ * used to decide whether splitting is worth it
+ * @return false if the function was not invoked at all, because the
+ * area is too small or because there is only one CPU; the caller
+ * shall then render the whole area by itself
+ */
+bool
+Run(unsigned top, unsigned bottom, unsigned width,
+    const Function &function) noexcept;
+
+} // namespace RasterBands
@@ -10,6 +10,7 @@
 #include "ui/dim/Point.hpp"
 #include "util/AllocatedArray.hxx"
 
+#include <algorithm>
 #include <cassert>
 
 /*
@@ -456,14 +457,24 @@ public:
     }
   }
 
-  template<typename PixelOperations>
+  /**
+   * @param y_offset the vertex row which is the first row of this
+   * canvas; this allows rendering one band of a large polygon without
+   * translating its vertices
+   */
+  template<AnyFillPixelOperation PixelOperations>
   void FillPolygonFast(const PixelPoint *points, unsigned n, color_type color,
-                       PixelOperations operations) noexcept {
+                       PixelOperations operations,
+                       int y_offset=0) noexcept {
     assert(points != nullptr);
 
     if (n < 3)
       return;
 
+    // the vertex rows covered by this canvas
+    const int first_row = y_offset;
+    const int last_row = y_offset + int(buffer.size.height) - 1;
+
     edge_buffer.GrowDiscard(n);
 
     // initialise buffer of edge iterators, and find y range to scan
@@ -477,6 +488,9 @@ public:
     while (p_1 < points+n) {
       if (p_1->y == p_0->y) {
         // don't add horizontal line, just draw it now?
+      } else if (std::max(p_0->y, p_1->y) < first_row ||
+                 std::min(p_0->y, p_1->y) > last_row) {
+        // the edge does not touch this canvas
       } else if (p_1->y < p_0->y) {
         edge_buffer[n_edges] = BresenhamIterator(*p_1, *p_0);
         n_edges++;
@@ -500,6 +514,10 @@ public:
     // sort array by y value (top best), then x value (left best)
     std::sort(edge_start, edge_end, BresenhamIterator::CompareVerticalHorizontal);
 
+    // skip the rows outside of the buffer; AdvanceTo() can jump there
+    miny = std::max(miny, first_row);
+    maxy = std::min(maxy, last_row);
+
     // perform scans
 
     for (int y = miny; y <= maxy; y++) {
@@ -545,7 +563,7 @@ public:
 
         int x1 = it->p.x;
         if (mode) 
-          DrawHLine(x0, x1, y, color, operations);
+          DrawHLine(x0, x1, y - y_offset, color, operations);
         mode = !mode;
         x0 = x1;
       }
@@ -554,9 +572,12 @@ public:
 
   }
 
-  template<typename PixelOperations>
+  /**
+   * @param y_offset see FillPolygonFast()
+   */
+  template<AnyFillPixelOperation PixelOperations>
   void FillPolygon(const PixelPoint *points, unsigned n, color_type color,
-                   PixelOperations operations) noexcept {
+                   PixelOperations operations, int y_offset=0) noexcept {
     assert(points != nullptr);
 
     if (n < 3)
@@ -577,8 +598,11 @@ public:
         maxy = points[i].y;
     }
 
-    // Draw, scanning y
-    for (int y = miny; y <= maxy; y++) {
+    // Draw, scanning y (only the rows inside the buffer)
+    const int first_y = std::max(miny, y_offset);
+    const int last_y = std::min(maxy,
+                                y_offset + int(buffer.size.height) - 1);
+    for (int y = first_y; y <= last_y; y++) {
       unsigned n_ints = 0;
       for (unsigned i = 0; i < n; i++) {
         unsigned ind1, ind2;
@@ -617,15 +641,15 @@ public:
         xa = (xa >> 16) + ((xa & 32768) >> 15);
         int xb = ints[i+1] - 1;
         xb = (xb >> 16) + ((xb & 32768) >> 15);
-        DrawHLine(xa, xb, y, color, operations);
+        DrawHLine(xa, xb, y - y_offset, color, operations);
       }
     }
   }
 
   void FillPolygon(const PixelPoint *points, unsigned n,
-                   color_type color) noexcept {
+                   color_type color, int y_offset=0) noexcept {
     FillPolygonFast(points, n, color,
-                    GetSolidPixelOperations());
+                    GetSolidPixelOperations(), y_offset);
 //    FillPolygon(points, n, color,
 //                GetSolidPixelOperations());
   }
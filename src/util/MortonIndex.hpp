@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+/**
+ * A read-only spatial index on a two dimensional integer plane.  The
+ * elements are referenced by pointer in a flat array which is sorted
+ * by their Morton (Z-order) code, so spatially close elements are
+ * close in memory.  Range queries scan the code interval of the query
+ * box and skip the parts outside the box with the BIGMIN algorithm
+ * (Tropf & Herzog, 1981).
+ *
+ * The index does not own the elements; it must be rebuilt (or
+ * cleared) whenever the referenced container is modified.
+ *
+ * The Accessor interface is the same as QuadTree's.
+ */
+template<typename T, typename Accessor>
+class MortonIndex {
+public:
+  using position_type = int;
+  using distance_type = unsigned;
+
+  struct Point {
+    position_type x, y;
+  };
+
+private:
+  struct Entry {
+    uint64_t code;
+    position_type x, y;
+    const T *value;
+  };
+
+  /** x occupies the even bits of a code, y the odd bits */
+  static constexpr uint64_t X_BITS = 0x5555555555555555ULL;
+  static constexpr uint64_t Y_BITS = X_BITS << 1;
+
+  /**
+   * Number of consecutive entries outside the query box which are
+   * scanned before skipping ahead with BigMin().
+   */
+  static constexpr unsigned MAX_LINEAR_MISSES = 4;
+
+  std::vector<Entry> entries;
+
+  /** the bounds of all elements; codes are relative to the minimum */
+  position_type left, top, right, bottom;
+
+  /**
+   * The radius of the first search box for FindNearestIf(),
+   * estimated from the element density.
+   */
+  distance_type initial_radius;
+
+  Accessor accessor;
+
+public:
+  [[gnu::pure]]
+  bool IsEmpty() const noexcept {
+    return entries.empty();
+  }
+
+  [[gnu::pure]]
+  std::size_t size() const noexcept {
+    return entries.size();
+  }
+
+  void Clear() noexcept {
+    entries.clear();
+  }
+
+  /**
+   * Build the index from a range of elements.  The elements must
+   * not be moved or modified while the index is in use.
+   */
+  template<typename I>
+  void Build(I begin, I end) noexcept {
+    entries.clear();
+    if (begin == end)
+      return;
+
+    left = top = std::numeric_limits<position_type>::max();
+    right = bottom = std::numeric_limits<position_type>::min();
+
+    for (I i = begin; i != end; ++i) {
+      const T &value = *i;
+      const position_type x = accessor.GetX(value);
+      const position_type y = accessor.GetY(value);
+
+      left = std::min(left, x);
+      right = std::max(right, x);
+      top = std::min(top, y);
+      bottom = std::max(bottom, y);
+
+      entries.push_back({0, x, y, &value});
+    }
+
+    for (auto &e : entries)
+      e.code = Encode(e.x, e.y);
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b){
+                return a.code < b.code;
+              });
+
+    /* start with a box which contains a few elements on average */
+    const double area = (double(right) - left + 1) * (double(bottom) - top + 1);
+    initial_radius = std::max(distance_type(std::sqrt(area / entries.size()) * 2),
+                              distance_type(1));
+  }
+
+  /**
+   * Call the visitor for each element within the specified distance
+   * (inclusive) of the location.
+   */
+  template<class V>
+  void VisitWithinRange(const Point location, distance_type range,
+                        V &visitor) const {
+    const distance_type square_range = Square(range);
+    VisitBox(location, range, [&](const Entry &e){
+      if (SquareDistance(e, location) <= square_range)
+        visitor(*e.value);
+    });
+  }
+
+  /**
+   * Find the nearest element within the specified distance
+   * (inclusive) which matches the predicate.
+   *
+   * @return the element or nullptr if there is none
+   */
+  template<class P>
+  [[gnu::pure]]
+  const T *FindNearestIf(const Point location, distance_type range,
+                         const P &predicate) const noexcept {
+    const T *nearest = nullptr;
+    distance_type nearest_square_distance = Square(range);
+
+    /* search in growing boxes until the nearest match is closer than
+       the box radius (there cannot be a closer one outside) */
+    for (distance_type radius = std::min(initial_radius, range);;
+         radius = radius > range / 2 ? range : radius * 2) {
+      VisitBox(location, radius, [&](const Entry &e){
+        const distance_type square_distance = SquareDistance(e, location);
+        if (square_distance <= nearest_square_distance &&
+            predicate(*e.value)) {
+          nearest_square_distance = square_distance;
+          nearest = e.value;
+        }
+      });
+
+      if (radius >= range ||
+          (nearest != nullptr &&
+           nearest_square_distance <= Square(radius)))
+        return nearest;
+    }
+  }
+
+private:
+  static constexpr distance_type Square(distance_type x) noexcept {
+    return x * x;
+  }
+
+  static constexpr distance_type SquareDistance(const Entry &e,
+                                                const Point p) noexcept {
+    const distance_type dx = e.x - p.x, dy = e.y - p.y;
+    return dx * dx + dy * dy;
+  }
+
+  /**
+   * Interleave the lower 32 bits of the value with zeroes.
+   */
+  static constexpr uint64_t Spread(uint32_t v) noexcept {
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+    x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+    x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & X_BITS;
+    return x;
+  }
+
+  [[gnu::pure]]
+  uint64_t Encode(position_type x, position_type y) const noexcept {
+    return Spread(uint32_t(int64_t(x) - left)) |
+      (Spread(uint32_t(int64_t(y) - top)) << 1);
+  }
+
+  /**
+   * Calculate the smallest code greater than #code which is inside
+   * the box spanned by #zmin and #zmax.  #code must be between the
+   * two, but outside the box.
+   */
+  static constexpr uint64_t BigMin(uint64_t code,
+                                   uint64_t zmin, uint64_t zmax) noexcept {
+    uint64_t bigmin = 0;
+
+    /* the common prefix of zmin and zmax (and thus #code) can be
+       skipped */
+    for (int bit = 63 - std::countl_zero(zmin ^ zmax); bit >= 0; --bit) {
+      const uint64_t mask = uint64_t(1) << bit;
+      /* the lower bits of the same dimension */
+      const uint64_t lower = (mask - 1) & ((bit & 1) ? Y_BITS : X_BITS);
+
+      const bool c = code & mask, lo = zmin & mask, hi = zmax & mask;
+      if (!c && !lo && hi) {
+        bigmin = (zmin & ~lower) | mask;
+        zmax = (zmax & ~mask) | lower;
+      } else if (!c && lo && hi) {
+        return zmin;
+      } else if (c && !lo && !hi) {
+        return bigmin;
+      } else if (c && !lo && hi) {
+        zmin = (zmin & ~lower) | mask;
+      }
+    }
+
+    return bigmin;
+  }
+
+  /**
+   * Call the function for each entry inside the square box around
+   * the location.
+   */
+  template<typename F>
+  void VisitBox(const Point location, distance_type radius, F &&f) const {
+    if (entries.empty())
+      return;
+
+    const int64_t box_left = std::max<int64_t>(int64_t(location.x) - radius, left);
+    const int64_t box_right = std::min<int64_t>(int64_t(location.x) + radius, right);
+    const int64_t box_top = std::max<int64_t>(int64_t(location.y) - radius, top);
+    const int64_t box_bottom = std::min<int64_t>(int64_t(location.y) + radius, bottom);
+    if (box_left > box_right || box_top > box_bottom)
+      return;
+
+    const uint64_t zmin = Encode(box_left, box_top);
+    const uint64_t zmax = Encode(box_right, box_bottom);
+
+    const auto compare = [](const Entry &e, uint64_t code){
+      return e.code < code;
+    };
+
+    auto i = std::lower_bound(entries.begin(), entries.end(), zmin, compare);
+    const auto end = std::upper_bound(i, entries.end(), zmax,
+                                      [](uint64_t code, const Entry &e){
+                                        return code < e.code;
+                                      });
+
+    unsigned misses = 0;
+    while (i != end) {
+      if (i->x >= box_left && i->x <= box_right &&
+          i->y >= box_top && i->y <= box_bottom) {
+        f(*i);
+        ++i;
+        misses = 0;
+      } else if (++misses < MAX_LINEAR_MISSES) {
+        /* short gaps are cheaper to scan than to skip */
+        ++i;
+      } else {
+        /* jump to the next code inside the box */
+        i = std::lower_bound(std::next(i), end,
+                             BigMin(i->code, zmin, zmax), compare);
+        misses = 0;
+      }
+    }
+  }
+};
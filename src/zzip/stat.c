@@ -81,6 +81,7 @@ zzip_dir_stat(ZZIP_DIR * dir, zzip_char_t * name, ZZIP_STAT * zs, int flags)
     zs->d_csize = hdr->d_csize;
     zs->st_size = hdr->d_usize;
     zs->d_name = hdr->d_name;
+    zs->d_crc32 = hdr->d_crc32;
 
     return 0;
 }
@@ -89,7 +90,7 @@ zzip_dir_stat(ZZIP_DIR * dir, zzip_char_t * name, ZZIP_STAT * zs, int flags)
  * This function will obtain information about a opened file _within_ a 
  * zip-archive. The file is supposed to be open (otherwise -1 is returned). 
  * The st_size stat-member contains the uncompressed size. The optional 
- * d_name is never set here.
+ * d_name and d_crc32 are never set here.
  */
 int
 zzip_file_stat(ZZIP_FILE * file, ZZIP_STAT * zs)
@@ -100,6 +101,7 @@ zzip_file_stat(ZZIP_FILE * file, ZZIP_STAT * zs)
     zs->d_csize = file->csize;
     zs->st_size = file->usize;
     zs->d_name = 0;
+    zs->d_crc32 = 0;
     return 0;
 }
 
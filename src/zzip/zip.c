@@ -882,6 +882,7 @@ zzip_dir_read(ZZIP_DIR * dir, ZZIP_DIRENT * d)
     d->d_csize = dir->hdr->d_csize;
     d->st_size = dir->hdr->d_usize;
     d->d_name = dir->hdr->d_name;
+    d->d_crc32 = dir->hdr->d_crc32;
 
     if (! dir->hdr->d_reclen)
     {
@@ -81,6 +81,7 @@ struct zzip_dirent
     int         d_csize;        /* compressed size */
     int	 	st_size;	/* file size / decompressed size */
     char * 	d_name;		/* file name / strdupped name */
+    unsigned	d_crc32;	/* CRC-32 of the decompressed data */
 };
 
 /*
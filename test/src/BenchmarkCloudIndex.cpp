@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+/*
+ * Simulate the xcsoar-cloud-server load: thousands of clients which
+ * move a bit with every fix and then look up the traffic around
+ * them.  Compares the boost::geometry rtree (remove and re-insert on
+ * every fix) with the #GeoGrid (move between cells).
+ */
+
+#include "Cloud/GeoGrid.hpp"
+#include "Geo/Boost/GeoPoint.hpp"
+#include "Geo/Boost/RangeBox.hpp"
+#include "Geo/GeoVector.hpp"
+#include "system/Args.hpp"
+#include "util/PrintException.hxx"
+
+#include <boost/geometry/index/rtree.hpp>
+#include <boost/geometry/algorithms/distance.hpp>
+#include <boost/geometry/algorithms/intersection.hpp>
+#include <boost/geometry/strategies/strategies.hpp>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <stdio.h>
+
+struct Item : GeoGridHook {
+  GeoPoint location;
+};
+
+struct ItemLocation {
+  GeoPoint operator()(const Item &item) const noexcept {
+    return item.location;
+  }
+};
+
+struct ItemIndexable {
+  typedef GeoPoint result_type;
+
+  result_type operator()(const Item *item) const noexcept {
+    return item->location;
+  }
+};
+
+using Tree = boost::geometry::index::rtree<Item *,
+                                           boost::geometry::index::rstar<16>,
+                                           ItemIndexable>;
+using Grid = GeoGrid<Item, ItemLocation>;
+
+/* like TRAFFIC_RANGE in Cloud/Main.cpp */
+static constexpr double RANGE = 50000;
+
+static constexpr unsigned N_ROUNDS = 10;
+
+template<typename F>
+static double
+Measure(unsigned n_fixes, F &&f)
+{
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  const std::chrono::duration<double, std::micro> duration =
+    std::chrono::steady_clock::now() - start;
+  return duration.count() / n_fixes;
+}
+
+/**
+ * Generate #N_ROUNDS new positions for each client: a random walk of
+ * about 100 m per fix over the Alps.
+ */
+static std::vector<GeoPoint>
+MakeTracks(unsigned n_clients)
+{
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> latitude(44, 50), longitude(5, 16);
+  std::uniform_real_distribution<double> bearing(0, 360);
+
+  std::vector<GeoPoint> tracks;
+  tracks.reserve(n_clients * (N_ROUNDS + 1));
+
+  for (unsigned i = 0; i < n_clients; ++i)
+    tracks.emplace_back(Angle::Degrees(longitude(rng)),
+                        Angle::Degrees(latitude(rng)));
+
+  for (unsigned round = 0; round < N_ROUNDS; ++round)
+    for (unsigned i = 0; i < n_clients; ++i) {
+      const GeoPoint &previous = tracks[round * n_clients + i];
+      tracks.push_back(GeoVector(100, Angle::Degrees(bearing(rng)))
+                       .EndPoint(previous));
+    }
+
+  return tracks;
+}
+
+int main(int argc, char **argv)
+try {
+  Args args(argc, argv, "[CLIENTS]\n\n"
+            "CLIENTS is the number of simulated clients (default 5000)");
+  const unsigned n_clients = args.IsEmpty() ? 5000 : args.ExpectNextInt();
+  args.ExpectEnd();
+
+  const auto tracks = MakeTracks(n_clients);
+  const unsigned n_fixes = n_clients * N_ROUNDS;
+
+  const auto tree_items = std::make_unique<Item[]>(n_clients);
+  const auto grid_items = std::make_unique<Item[]>(n_clients);
+
+  Tree tree;
+  Grid grid;
+  for (unsigned i = 0; i < n_clients; ++i) {
+    tree_items[i].location = grid_items[i].location = tracks[i];
+    tree.insert(&tree_items[i]);
+    grid.insert(grid_items[i]);
+  }
+
+  unsigned long tree_count = 0, grid_count = 0;
+
+  const double tree_time = Measure(n_fixes, [&]{
+    std::vector<Item *> result;
+
+    for (unsigned round = 1; round <= N_ROUNDS; ++round) {
+      for (unsigned i = 0; i < n_clients; ++i) {
+        Item &item = tree_items[i];
+        tree.remove(&item);
+        item.location = tracks[round * n_clients + i];
+        tree.insert(&item);
+
+        result.clear();
+        tree.query(boost::geometry::index::intersects(BoostRangeBox(item.location,
+                                                                    RANGE)),
+                   std::back_inserter(result));
+        for (const Item *other : result)
+          if (other != &item &&
+              other->location.DistanceS(item.location) <= RANGE)
+            ++tree_count;
+      }
+    }
+  });
+
+  const double grid_time = Measure(n_fixes, [&]{
+    for (unsigned round = 1; round <= N_ROUNDS; ++round) {
+      for (unsigned i = 0; i < n_clients; ++i) {
+        Item &item = grid_items[i];
+        item.location = tracks[round * n_clients + i];
+        grid.Move(item);
+
+        for (const Item *other : grid.QueryWithinRange(item.location, RANGE))
+          if (other != &item &&
+              other->location.DistanceS(item.location) <= RANGE)
+            ++grid_count;
+      }
+    }
+  });
+
+  printf("%u clients, %u fixes, range %.0f m\n",
+         n_clients, n_fixes, RANGE);
+  printf("rtree %.3f us/fix, grid %.3f us/fix\n", tree_time, grid_time);
+
+  /* BoostRangeBox() is not quite conservative, the rtree may miss
+     a few neighbours right at the edge of the range; the grid finds
+     all of them (see TestGeoGrid) */
+  printf("neighbours: rtree %lu, grid %lu\n", tree_count, grid_count);
+
+  /* detach the items before they are freed */
+  grid.clear();
+
+  return EXIT_SUCCESS;
+} catch (...) {
+  PrintException(std::current_exception());
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+/*
+ * Compare the nearest and range query times of the QuadTree and the
+ * MortonIndex (used by class Waypoints) on a waypoint file, with the
+ * same kind of queries as NearestWaypoints.
+ */
+
+#include "Waypoint/WaypointReader.hpp"
+#include "Waypoint/Factory.hpp"
+#include "Waypoint/Waypoints.hpp"
+#include "util/QuadTree.hxx"
+#include "util/MortonIndex.hpp"
+#include "system/Args.hpp"
+#include "Operation/ConsoleOperationEnvironment.hpp"
+#include "util/PrintException.hxx"
+
+#include <chrono>
+#include <climits>
+#include <random>
+#include <vector>
+
+#include <stdio.h>
+
+struct WaypointAccessor {
+  int GetX(const WaypointPtr &wp) const noexcept {
+    return wp->flat_location.x;
+  }
+
+  int GetY(const WaypointPtr &wp) const noexcept {
+    return wp->flat_location.y;
+  }
+};
+
+using Tree = QuadTree<WaypointPtr, WaypointAccessor>;
+using Index = MortonIndex<WaypointPtr, WaypointAccessor>;
+
+static constexpr unsigned N_QUERIES = 100000;
+
+template<typename F>
+static double
+Measure(F &&f)
+{
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  const std::chrono::duration<double, std::micro> duration =
+    std::chrono::steady_clock::now() - start;
+  return duration.count() / N_QUERIES;
+}
+
+int main(int argc, char **argv)
+try {
+  Args args(argc, argv, "PATH [RANGE]\n\n"
+            "PATH is expected to be any compatible waypoint file.\n"
+            "RANGE is the query range in projected units (default 50)");
+  const auto path = args.ExpectNextPath();
+  const unsigned range = args.IsEmpty() ? 50 : args.ExpectNextInt();
+  args.ExpectEnd();
+
+  Waypoints waypoints;
+  ConsoleOperationEnvironment operation;
+  ReadWaypointFile(path, waypoints, WaypointFactory(WaypointOrigin::NONE),
+                   operation);
+  waypoints.Optimise();
+
+  if (waypoints.IsEmpty()) {
+    fprintf(stderr, "No waypoints\n");
+    return EXIT_FAILURE;
+  }
+
+  Tree tree;
+  int left = INT_MAX, right = INT_MIN, top = INT_MAX, bottom = INT_MIN;
+  for (const auto &wp : waypoints) {
+    tree.Add(wp);
+    left = std::min(left, wp->flat_location.x);
+    right = std::max(right, wp->flat_location.x);
+    top = std::min(top, wp->flat_location.y);
+    bottom = std::max(bottom, wp->flat_location.y);
+  }
+  tree.Optimise();
+
+  Index index;
+  index.Build(tree.begin(), tree.end());
+
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> x_dist(left, right), y_dist(top, bottom);
+  std::vector<Tree::Point> points;
+  points.reserve(N_QUERIES);
+  for (unsigned i = 0; i < N_QUERIES; ++i)
+    points.emplace_back(x_dist(rng), y_dist(rng));
+
+  unsigned long tree_count = 0, index_count = 0;
+
+  const double tree_nearest = Measure([&]{
+    for (const auto &p : points)
+      tree_count += tree.FindNearest(p, range).first != tree.end();
+  });
+
+  const double index_nearest = Measure([&]{
+    for (const auto &p : points)
+      index_count += index.FindNearestIf({p.x, p.y}, range,
+                                         [](const WaypointPtr &){
+                                           return true;
+                                         }) != nullptr;
+  });
+
+  auto tree_visitor = [&tree_count](const WaypointPtr &){ ++tree_count; };
+  const double tree_range = Measure([&]{
+    for (const auto &p : points)
+      tree.VisitWithinRange(p, range, tree_visitor);
+  });
+
+  auto index_visitor = [&index_count](const WaypointPtr &){ ++index_count; };
+  const double index_range = Measure([&]{
+    for (const auto &p : points)
+      index.VisitWithinRange({p.x, p.y}, range, index_visitor);
+  });
+
+  printf("%u waypoints, %u queries, range %u\n",
+         waypoints.size(), N_QUERIES, range);
+  printf("nearest: QuadTree %.3f us, MortonIndex %.3f us\n",
+         tree_nearest, index_nearest);
+  printf("range:   QuadTree %.3f us, MortonIndex %.3f us\n",
+         tree_range, index_range);
+
+  if (tree_count != index_count) {
+    fprintf(stderr, "Result mismatch: %lu != %lu\n", tree_count, index_count);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+} catch (...) {
+  PrintException(std::current_exception());
+  return EXIT_FAILURE;
+}
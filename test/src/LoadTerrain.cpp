@@ -46,6 +46,8 @@ try {
                        1000);
   } while (rtc.IsDirty());
 
+  printf("tile memory = %zu KiB\n", rtc.GetTileMemoryUsage() / 1024);
+
   return EXIT_SUCCESS;
 } catch (const std::runtime_error &e) {
   PrintException(e);
@@ -56,7 +56,9 @@ try {
     ZipArchive archive(file);
 
     ZipLineReaderA reader(archive.get(), "topology.tpl");
-    topography.Load(reader, NULL, archive.get());
+    topography.Load(reader, NULL, archive.get(), [&file]{
+      return ZipArchive{file};
+    });
   } else {
     FileLineReaderA reader{file};
     topography.Load(reader, directory, nullptr);
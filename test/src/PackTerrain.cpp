@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+/*
+ * This program decodes all terrain tiles of a map file and writes
+ * them to a terrain pack (see class TerrainPack), which XCSoar loads
+ * instead of the JPEG2000 file if it is next to the map file.
+ */
+
+#include "Terrain/RasterTileCache.hpp"
+#include "Terrain/Loader.hpp"
+#include "Terrain/Pack.hpp"
+#include "Operation/ConsoleOperationEnvironment.hpp"
+#include "system/Args.hpp"
+#include "io/FileReader.hxx"
+#include "io/ZipArchive.hpp"
+#include "io/ZipReader.hpp"
+#include "util/PrintException.hxx"
+
+#include <stdio.h>
+
+int main(int argc, char **argv)
+try {
+  Args args(argc, argv, "MAP.xcm [PACK.xtp]");
+  const auto map_path = args.ExpectNextPath();
+  const auto pack_path = args.IsEmpty()
+    ? map_path.WithSuffix(".xtp")
+    : AllocatedPath{args.ExpectNextPath()};
+  args.ExpectEnd();
+
+  ZipArchive archive(map_path);
+  const auto source_size =
+    ZipReader{archive.get(), "terrain.jp2"}.GetSize();
+
+  RasterTileCache rtc;
+
+  {
+    ConsoleOperationEnvironment operation;
+    LoadTerrainOverview(archive.get(), "terrain.jp2", "terrain.j2w",
+                        rtc, true, operation);
+  }
+
+  unsigned n_loaded = 0;
+  for (unsigned i = 0; i < rtc.GetTileCount(); ++i)
+    if (rtc.GetCompressedTile(i) != nullptr)
+      ++n_loaded;
+
+  WriteTerrainPack(pack_path, rtc, source_size);
+
+  printf("%u of %u tiles, %zu KiB\n", n_loaded, rtc.GetTileCount(),
+         std::size_t(FileReader{pack_path}.GetSize() / 1024));
+
+  return EXIT_SUCCESS;
+} catch (...) {
+  PrintException(std::current_exception());
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+/*
+ * This program reads all topography shapefiles of a map file and
+ * writes them to a topography pack (see class TopographyPack), which
+ * XCSoar loads instead of the shapefiles if it is next to the map
+ * file.
+ */
+
+#include "Topography/Pack.hpp"
+#include "Topography/Index.hpp"
+#include "Topography/ShapeFile.hpp"
+#include "Topography/Convert.hpp"
+#include "system/Args.hpp"
+#include "io/FileReader.hxx"
+#include "io/ZipArchive.hpp"
+#include "io/ZipLineReader.hpp"
+#include "util/PrintException.hxx"
+#include "util/ScopeExit.hxx"
+
+#include <zzip/zzip.h>
+
+#include <stdexcept>
+#include <string>
+
+#include <stdio.h>
+
+static std::size_t
+PackLayer(TopographyPackWriter &writer, zzip_dir *dir,
+          const TopographyIndexEntry &entry)
+{
+  const std::string name = std::string{entry.name} + ".shp";
+
+  ZZIP_STAT st;
+  if (zzip_dir_stat(dir, name.c_str(), &st, 0) != 0)
+    throw std::runtime_error{"Shapefile not found: " + name};
+
+  ShapeFile file(dir, name.c_str());
+  writer.BeginLayer(name, st.st_size, st.d_crc32,
+                    ImportRect(file.GetBounds()), entry.shape_range);
+
+  for (std::size_t i = 0; i < file.size(); ++i) {
+    shapeObj shape;
+    msInitShape(&shape);
+    AtScopeExit(&shape) { msFreeShape(&shape); };
+    file.ReadShape(shape, i);
+
+    const char *label = entry.shape_field >= 0
+      ? file.ReadLabel(i, entry.shape_field)
+      : nullptr;
+
+    writer.AddShape(shape, label);
+  }
+
+  return file.size();
+}
+
+int main(int argc, char **argv)
+try {
+  Args args(argc, argv, "MAP.xcm [PACK.xtop]");
+  const auto map_path = args.ExpectNextPath();
+  const auto pack_path = args.IsEmpty()
+    ? map_path.WithSuffix(".xtop")
+    : AllocatedPath{args.ExpectNextPath()};
+  args.ExpectEnd();
+
+  ZipArchive archive(map_path);
+  ZipLineReaderA reader(archive.get(), "topology.tpl");
+
+  TopographyPackWriter writer(pack_path);
+
+  unsigned n_layers = 0;
+  std::size_t n_shapes = 0;
+  while (const char *line = reader.ReadLine()) {
+    const auto entry = ParseTopographyIndexLine(line);
+    if (!entry)
+      continue;
+
+    n_shapes += PackLayer(writer, archive.get(), *entry);
+    ++n_layers;
+  }
+
+  writer.Commit();
+
+  printf("%u layers, %zu shapes, %zu KiB\n", n_layers, n_shapes,
+         std::size_t(FileReader{pack_path}.GetSize() / 1024));
+
+  return EXIT_SUCCESS;
+} catch (...) {
+  PrintException(std::current_exception());
+  return EXIT_FAILURE;
+}
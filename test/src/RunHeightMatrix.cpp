@@ -11,14 +11,26 @@
 #include "io/ZipArchive.hpp"
 #include "util/PrintException.hxx"
 
+#include <algorithm>
+#include <chrono>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <thread>
+
+/**
+ * Run each fill this many times and report the fastest one.
+ */
+static constexpr unsigned N_ITERATIONS = 10;
 unsigned Layout::scale_1024 = 1024;
 
 int main(int argc, char **argv)
 try {
-  Args args(argc, argv, "PATH");
+  Args args(argc, argv, "PATH [MAX_THREADS]");
   const auto map_path = args.ExpectNextPath();
+  const unsigned max_threads = args.IsEmpty()
+    ? std::max(std::thread::hardware_concurrency(), 1u)
+    : std::max(atoi(args.GetNext()), 1);
   args.ExpectEnd();
 
   ZipArchive archive(map_path);
@@ -48,13 +60,26 @@ try {
   projection.UpdateScreenBounds();
 
   HeightMatrix matrix;
+
+  for (unsigned n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+    std::chrono::steady_clock::duration best =
+      std::chrono::steady_clock::duration::max();
+
+    for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+      const auto start = std::chrono::steady_clock::now();
 #ifdef ENABLE_OPENGL
-  matrix.Fill(map, projection.GetScreenBounds(),
-              (UnsignedPoint2D)projection.GetScreenSize(),
-              false);
+      matrix.Fill(map, projection.GetScreenBounds(),
+                  (UnsignedPoint2D)projection.GetScreenSize(),
+                  false, n_threads);
 #else
-  matrix.Fill(map, projection, 1, false);
+      matrix.Fill(map, projection, 1, false, n_threads);
 #endif
+      best = std::min(best, std::chrono::steady_clock::now() - start);
+    }
+
+    printf("threads=%u fill=%.2fms\n", n_threads,
+           std::chrono::duration<double, std::milli>(best).count());
+  }
 
   return EXIT_SUCCESS;
 } catch (const std::runtime_error &e) {
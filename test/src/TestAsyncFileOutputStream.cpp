@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "io/AsyncFileOutputStream.hpp"
+#include "system/Path.hpp"
+#include "TestUtil.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <stdio.h>
+
+using namespace std::chrono;
+
+static std::vector<std::byte>
+MakeData()
+{
+  /* much larger than the ring buffer, so the producer has to wait
+     for the writer thread and the ring wraps around many times */
+  std::vector<std::byte> data(1000 * 1000);
+  for (std::size_t i = 0; i < data.size(); ++i)
+    data[i] = std::byte(i * 7 + i / 251);
+  return data;
+}
+
+static std::vector<std::byte>
+ReadFile(Path path)
+{
+  std::vector<std::byte> result;
+
+  FILE *file = fopen(path.c_str(), "rb");
+  if (file == nullptr)
+    return result;
+
+  std::byte buffer[4096];
+  std::size_t nbytes;
+  while ((nbytes = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    result.insert(result.end(), buffer, buffer + nbytes);
+
+  fclose(file);
+  return result;
+}
+
+/**
+ * Write the data in odd-sized chunks.
+ */
+static void
+WriteChunks(OutputStream &os, std::span<const std::byte> data)
+{
+  while (!data.empty()) {
+    const std::size_t n = std::min<std::size_t>(data.size(), 1237);
+    os.Write(data.first(n));
+    data = data.subspan(n);
+  }
+}
+
+static bool
+TestWrite(Path path, const std::vector<std::byte> &data,
+          AsyncFileOutputStream::Duration sync_interval, bool commit)
+{
+  {
+    AsyncFileOutputStream os(path, FileOutputStream::Mode::CREATE_VISIBLE,
+                             sync_interval);
+    WriteChunks(os, data);
+
+    if (commit)
+      os.Commit();
+  }
+
+  return ReadFile(path) == data;
+}
+
+#ifdef __linux__
+
+/**
+ * Errors in the writer thread are reported to the caller.
+ */
+static bool
+TestError(const std::vector<std::byte> &data)
+try {
+  AsyncFileOutputStream os(Path("/dev/full"),
+                           FileOutputStream::Mode::APPEND_EXISTING);
+  WriteChunks(os, data);
+  os.Commit();
+  return false;
+} catch (...) {
+  return true;
+}
+
+#endif
+
+int main()
+{
+#ifdef __linux__
+  plan_tests(5);
+#else
+  plan_tests(4);
+#endif
+
+  const Path path("output/test/async.bin");
+  const auto data = MakeData();
+
+  ok1(TestWrite(path, data, AsyncFileOutputStream::Duration::max(), true));
+  ok1(TestWrite(path, data, {}, true));
+  ok1(TestWrite(path, data, milliseconds{1}, true));
+
+  /* the destructor writes all pending data, too */
+  ok1(TestWrite(path, data, seconds{10}, false));
+
+#ifdef __linux__
+  ok1(TestError(data));
+#endif
+
+  return exit_status();
+}
@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "MapWindow/BaseMapTileGrid.hpp"
+#include "TestUtil.hpp"
+
+#include <cstdlib>
+
+static constexpr PixelSize SCREEN_SIZE{640, 480};
+
+static WindowProjection
+MakeProjection(GeoPoint location, double scale = 1. / 20,
+               Angle angle = Angle::Zero())
+{
+  WindowProjection projection;
+  projection.SetScreenSize(SCREEN_SIZE);
+  projection.SetScreenOrigin(projection.GetScreenCenter());
+  projection.SetScale(scale);
+  projection.SetScreenAngle(angle);
+  projection.SetGeoLocation(location);
+  projection.UpdateScreenBounds();
+  return projection;
+}
+
+/**
+ * Move the projection by the given number of pixels.
+ */
+static WindowProjection
+Pan(const WindowProjection &projection, PixelPoint delta)
+{
+  WindowProjection result = projection;
+  result.SetGeoLocation(projection.ScreenToGeo(projection.GetScreenOrigin()
+                                               + delta));
+  result.UpdateScreenBounds();
+  return result;
+}
+
+static BaseMapTileGrid::Content
+MakeContent()
+{
+  BaseMapTileGrid::Content content{};
+  content.terrain_settings.SetDefaults();
+  content.shading_angle = Angle::Degrees(45);
+  content.terrain = true;
+  content.topography = true;
+  return content;
+}
+
+static bool
+IsNear(PixelPoint a, PixelPoint b)
+{
+  return std::abs(a.x - b.x) <= 1 && std::abs(a.y - b.y) <= 1;
+}
+
+static const GeoPoint location(Angle::Degrees(7.7), Angle::Degrees(51.4));
+
+/**
+ * Do the visible tiles cover the screen exactly, and does each tile
+ * projection match the screen projection?
+ */
+static void
+TestTiles()
+{
+  BaseMapTileGrid grid;
+  const auto projection = MakeProjection(location);
+  grid.Update(projection, MakeContent());
+
+  const PixelRect rc = projection.GetScreenRect();
+  const auto range = grid.GetVisibleTiles(rc);
+
+  /* the anchor is at the screen center */
+  ok1(range.min.column == -2 && range.max.column == 1);
+  ok1(range.min.row == -1 && range.max.row == 0);
+  ok1(range.GetCount() == 8);
+
+  const PixelPoint top_left = grid.GetScreenPosition(range.min);
+  const PixelPoint bottom_right = grid.GetScreenPosition(range.max) +
+    PixelPoint(BaseMapTileGrid::TILE_SIZE, BaseMapTileGrid::TILE_SIZE);
+  ok1(top_left.x <= rc.left && top_left.y <= rc.top);
+  ok1(top_left.x > rc.left - int(BaseMapTileGrid::TILE_SIZE));
+  ok1(top_left.y > rc.top - int(BaseMapTileGrid::TILE_SIZE));
+  ok1(bottom_right.x >= rc.right && bottom_right.y >= rc.bottom);
+
+  /* a location is drawn at the same screen position, no matter
+     whether it is rendered into a tile or directly */
+  const BaseMapTileGrid::TilePosition position{-1, 0};
+  const auto tile_projection = grid.MakeTileProjection(position);
+  const PixelPoint p = grid.GetScreenPosition(position) + PixelPoint(100, 50);
+  const GeoPoint g = projection.ScreenToGeo(p);
+  ok1(IsNear(tile_projection.GeoToScreen(g),
+             PixelPoint(BaseMapTileGrid::MARGIN + 100,
+                        BaseMapTileGrid::MARGIN + 50)));
+}
+
+static void
+TestPan()
+{
+  BaseMapTileGrid grid;
+  const auto content = MakeContent();
+  auto projection = MakeProjection(location);
+
+  ok1(grid.Update(projection, content));
+  ok1(!grid.Update(projection, content));
+
+  const PixelPoint origin = grid.GetScreenPosition({0, 0});
+
+  /* panning keeps the grid and moves the tiles on the screen */
+  projection = Pan(projection, {300, -100});
+  ok1(!grid.Update(projection, content));
+  ok1(IsNear(grid.GetScreenPosition({0, 0}), origin - PixelPoint(300, -100)));
+
+  const auto range = grid.GetVisibleTiles(projection.GetScreenRect());
+  ok1(range.min.column == -1 && range.max.column == 2);
+
+  /* far away from the anchor, the grid drifts and is reset */
+  bool reset = false;
+  for (unsigned i = 0; i < 1000 && !reset; ++i) {
+    projection = Pan(projection, {0, 400});
+    reset = grid.Update(projection, content);
+  }
+
+  ok1(reset);
+  ok1(grid.GetScreenPosition({0, 0}) == projection.GetScreenOrigin());
+}
+
+static void
+TestInvalidate()
+{
+  BaseMapTileGrid grid;
+  const auto projection = MakeProjection(location);
+  auto content = MakeContent();
+
+  ok1(grid.Update(projection, content));
+
+  /* projection */
+  ok1(grid.Update(MakeProjection(location, 1. / 25), content));
+  ok1(grid.Update(projection, content));
+  ok1(grid.Update(MakeProjection(location, 1. / 20, Angle::Degrees(1)),
+                  content));
+  ok1(grid.Update(projection, content));
+
+  /* small changes of the shading angle are ignored */
+  content.shading_angle = Angle::Degrees(50);
+  ok1(!grid.Update(projection, content));
+  content.shading_angle = Angle::Degrees(135);
+  ok1(grid.Update(projection, content));
+
+  ++content.terrain_serial;
+  ok1(grid.Update(projection, content));
+  ok1(!grid.Update(projection, content));
+
+  ++content.topography_serial;
+  ok1(grid.Update(projection, content));
+
+  content.topography = false;
+  ok1(grid.Update(projection, content));
+
+  content.terrain_settings.contrast += 10;
+  ok1(grid.Update(projection, content));
+  ok1(!grid.Update(projection, content));
+
+  grid.Flush();
+  ok1(grid.Update(projection, content));
+  ok1(!grid.Update(projection, content));
+}
+
+int main()
+{
+  plan_tests(8 + 7 + 15);
+
+  TestTiles();
+  TestPan();
+  TestInvalidate();
+
+  return exit_status();
+}
@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "Terrain/CompressedRasterBuffer.hpp"
+#include "Terrain/RasterBuffer.hpp"
+#include "io/BufferedOutputStream.hxx"
+#include "io/BufferedReader.hxx"
+#include "io/MemoryReader.hxx"
+#include "io/StringOutputStream.hxx"
+#include "TestUtil.hpp"
+
+#include <cmath>
+#include <random>
+
+enum class Pattern {
+  SMOOTH,
+  NOISE,
+  FLAT,
+  EXTREME,
+};
+
+static void
+Fill(RasterBuffer &buffer, RasterLocation size, Pattern pattern,
+     unsigned seed)
+{
+  buffer.Resize(size);
+
+  std::mt19937 rng(seed);
+  TerrainHeight *p = buffer.GetData();
+  for (unsigned y = 0; y < size.y; ++y) {
+    for (unsigned x = 0; x < size.x; ++x) {
+      int value = 0;
+      switch (pattern) {
+      case Pattern::SMOOTH:
+        value = int(1500 + 800 * std::sin(x * 0.03) * std::cos(y * 0.02)
+                    + rng() % 8);
+        if (x < size.x / 8)
+          /* sea */
+          value = -31000;
+        else if (x > size.x * 3 / 4 && y > size.y * 3 / 4)
+          /* a hole in the data */
+          value = TerrainHeight::Invalid().GetValue();
+        break;
+
+      case Pattern::NOISE:
+        value = int(rng() % 9000) - 500;
+        break;
+
+      case Pattern::FLAT:
+        value = 123;
+        break;
+
+      case Pattern::EXTREME:
+        value = (x + y) % 2 == 0 ? -32768 : 32767;
+        break;
+      }
+
+      *p++ = TerrainHeight(int16_t(value));
+    }
+  }
+}
+
+static bool
+Equals(TerrainHeight a, TerrainHeight b)
+{
+  return a.GetValue() == b.GetValue();
+}
+
+/**
+ * Compare all accessors of the compressed buffer with those of the
+ * original buffer.
+ */
+static bool
+Check(RasterLocation size, Pattern pattern, unsigned seed)
+{
+  RasterBuffer original;
+  Fill(original, size, pattern, seed);
+
+  CompressedRasterBuffer compressed;
+  compressed.Compress(original);
+  if (compressed.GetSize() != size)
+    return false;
+
+  RasterBuffer decompressed;
+  compressed.Decompress(decompressed);
+
+  for (unsigned y = 0; y < size.y; ++y)
+    for (unsigned x = 0; x < size.x; ++x)
+      if (!Equals(decompressed.Get({x, y}), original.Get({x, y})) ||
+          !Equals(compressed.Get({x, y}), original.Get({x, y})))
+        return false;
+
+  std::mt19937 rng(seed);
+  for (unsigned i = 0; i < 1000; ++i) {
+    const unsigned x = rng() % size.x, y = rng() % size.y;
+    const unsigned ix = rng() % 256, iy = rng() % 256;
+    if (!Equals(compressed.GetInterpolated(x, y, ix, iy),
+                original.GetInterpolated(x, y, ix, iy)))
+      return false;
+  }
+
+  /* lines which are not horizontal take the same samples; the
+     optimised horizontal scan of RasterBuffer may round
+     differently */
+  const RasterLocation fine = original.GetFineSize();
+  for (unsigned i = 0; i < 100; ++i) {
+    const RasterLocation a(rng() % fine.x, rng() % fine.y);
+    RasterLocation b(rng() % fine.x, rng() % fine.y);
+    if (b.y == a.y)
+      continue;
+
+    const unsigned n = 1 + rng() % 300;
+    const bool interpolate = rng() % 2;
+
+    TerrainHeight expected[300], actual[300];
+    original.ScanLine(a, b, expected, n, interpolate);
+    compressed.ScanLine(a, b, actual, n, interpolate);
+
+    for (unsigned j = 0; j < n; ++j)
+      if (!Equals(actual[j], expected[j]))
+        return false;
+  }
+
+  return true;
+}
+
+static std::string
+Save(const CompressedRasterBuffer &compressed)
+{
+  StringOutputStream sos;
+  BufferedOutputStream bos(sos);
+  compressed.Save(bos);
+  bos.Flush();
+  return std::move(sos).GetValue();
+}
+
+static bool
+Load(CompressedRasterBuffer &compressed, std::string_view data)
+try {
+  MemoryReader reader(AsBytes(data));
+  BufferedReader br(reader);
+  compressed.Load(br);
+  return true;
+} catch (...) {
+  return false;
+}
+
+/**
+ * Save a compressed buffer and load it into another one.
+ */
+static bool
+CheckSaveLoad(RasterLocation size, Pattern pattern, unsigned seed)
+{
+  RasterBuffer original;
+  Fill(original, size, pattern, seed);
+
+  CompressedRasterBuffer compressed;
+  compressed.Compress(original);
+
+  CompressedRasterBuffer loaded;
+  if (!Load(loaded, Save(compressed)) || loaded.GetSize() != size ||
+      loaded.GetMemoryUsage() != compressed.GetMemoryUsage())
+    return false;
+
+  for (unsigned y = 0; y < size.y; ++y)
+    for (unsigned x = 0; x < size.x; ++x)
+      if (!Equals(loaded.Get({x, y}), original.Get({x, y})))
+        return false;
+
+  return true;
+}
+
+static double
+BitsPerPixel(Pattern pattern)
+{
+  const RasterLocation size{256, 256};
+
+  RasterBuffer original;
+  Fill(original, size, pattern, 1);
+
+  CompressedRasterBuffer compressed;
+  compressed.Compress(original);
+  return compressed.GetMemoryUsage() * 8. / size.Area();
+}
+
+int main()
+{
+  plan_tests(14);
+
+  ok1(Check({256, 256}, Pattern::SMOOTH, 1));
+  ok1(Check({100, 37}, Pattern::SMOOTH, 2));
+  ok1(Check({1, 1}, Pattern::SMOOTH, 3));
+  ok1(Check({17, 300}, Pattern::NOISE, 4));
+  ok1(Check({64, 64}, Pattern::FLAT, 5));
+  ok1(Check({33, 18}, Pattern::EXTREME, 6));
+
+  ok1(BitsPerPixel(Pattern::SMOOTH) < 6);
+  ok1(BitsPerPixel(Pattern::FLAT) < 1);
+  ok1(BitsPerPixel(Pattern::NOISE) < 16);
+
+  /* the worst case needs 17 bits per pixel */
+  ok1(BitsPerPixel(Pattern::EXTREME) < 18);
+
+  ok1(CheckSaveLoad({256, 256}, Pattern::SMOOTH, 8));
+  ok1(CheckSaveLoad({33, 18}, Pattern::EXTREME, 9));
+
+  /* truncated data is rejected */
+  {
+    RasterBuffer original;
+    Fill(original, {64, 64}, Pattern::NOISE, 10);
+    CompressedRasterBuffer compressed;
+    compressed.Compress(original);
+    const std::string data = Save(compressed);
+
+    CompressedRasterBuffer loaded;
+    ok1(!Load(loaded, std::string_view{data}.substr(0, data.size() - 1)) &&
+        !loaded.IsDefined());
+  }
+
+  /* a reset buffer is undefined */
+  CompressedRasterBuffer compressed;
+  RasterBuffer original;
+  Fill(original, {16, 16}, Pattern::SMOOTH, 7);
+  compressed.Compress(original);
+  compressed.Reset();
+  ok1(!compressed.IsDefined() && compressed.GetMemoryUsage() == 0);
+
+  return exit_status();
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "FLARM/Calculations.hpp"
+#include "TestUtil.hpp"
+
+using namespace std::chrono;
+
+static constexpr unsigned N_TARGETS = 200;
+
+static constexpr FlarmId
+MakeId(unsigned i) noexcept
+{
+  return FlarmId::FromValue(0xDD0000 + i * 37);
+}
+
+/**
+ * Target #i climbs at (i % 5) m/s.
+ */
+static constexpr double
+GetAltitude(unsigned i, unsigned t) noexcept
+{
+  return 1000 + double(i % 5) * t;
+}
+
+static bool
+CheckAverages(FlarmCalculations &c, unsigned t) noexcept
+{
+  for (unsigned i = 0; i < N_TARGETS; ++i) {
+    const double average =
+      c.Average30s(MakeId(i), TimeStamp{seconds{t}}, GetAltitude(i, t));
+    if (!equals(average, double(i % 5)))
+      return false;
+  }
+
+  return true;
+}
+
+int main()
+{
+  plan_tests(10);
+
+  FlarmCalculations c;
+  ok1(c.GetCount() == 0);
+
+  /* 200 simultaneous targets, one fix per second */
+  for (unsigned t = 0; t < 20; ++t) {
+    c.CleanUp(TimeStamp{seconds{t}});
+    for (unsigned i = 0; i < N_TARGETS; ++i)
+      c.Average30s(MakeId(i), TimeStamp{seconds{t}}, GetAltitude(i, t));
+  }
+
+  ok1(c.GetCount() == N_TARGETS);
+  c.CleanUp(TimeStamp{seconds{20}});
+  ok1(CheckAverages(c, 20));
+
+  /* the even targets disappear; the others keep reporting */
+  for (unsigned t = 21; t < 100; ++t) {
+    c.CleanUp(TimeStamp{seconds{t}});
+    for (unsigned i = 1; i < N_TARGETS; i += 2)
+      c.Average30s(MakeId(i), TimeStamp{seconds{t}}, GetAltitude(i, t));
+  }
+
+  ok1(c.GetCount() == N_TARGETS / 2);
+
+  /* a returning target starts over */
+  ok1(equals(c.Average30s(MakeId(0), TimeStamp{seconds{100}},
+                          GetAltitude(0, 100)), 0));
+  ok1(c.GetCount() == N_TARGETS / 2 + 1);
+
+  /* the hash table entries which were shifted back are still found */
+  bool all_odd_found = true;
+  for (unsigned i = 1; i < N_TARGETS; i += 2)
+    if (!equals(c.Average30s(MakeId(i), TimeStamp{seconds{100}},
+                             GetAltitude(i, 100)), double(i % 5)))
+      all_odd_found = false;
+  ok1(all_odd_found);
+
+  /* a long pause expires everything */
+  c.CleanUp(TimeStamp{seconds{1000}});
+  ok1(c.GetCount() == 0);
+
+  /* the table never holds more than CAPACITY targets */
+  for (unsigned i = 0; i < 1000; ++i)
+    c.Average30s(FlarmId::FromValue(i + 1), TimeStamp{seconds{1001}}, 0);
+  ok1(c.GetCount() == FlarmCalculations::CAPACITY);
+
+  /* time warp */
+  c.CleanUp(TimeStamp{seconds{10}});
+  ok1(c.GetCount() == 0);
+
+  return exit_status();
+}
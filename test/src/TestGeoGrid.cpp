@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "Cloud/GeoGrid.hpp"
+#include "TestUtil.hpp"
+
+#include <random>
+#include <set>
+#include <vector>
+
+struct Item : GeoGridHook {
+  GeoPoint location;
+  bool removed = false;
+};
+
+struct ItemLocation {
+  GeoPoint operator()(const Item &item) const noexcept {
+    return item.location;
+  }
+};
+
+using Grid = GeoGrid<Item, ItemLocation>;
+
+static std::mt19937 gen(42);
+
+static GeoPoint
+RandomLocation(double max_latitude)
+{
+  std::uniform_real_distribution<double> longitude(-180, 180);
+  std::uniform_real_distribution<double> latitude(-max_latitude, max_latitude);
+  return GeoPoint(Angle::Degrees(longitude(gen)),
+                  Angle::Degrees(latitude(gen)));
+}
+
+/**
+ * Every item within the range is returned exactly once, and nothing
+ * far outside of it.
+ */
+static bool
+CheckQuery(const Grid &grid, const std::vector<Item> &items,
+           GeoPoint location, double range)
+{
+  std::set<const Item *> found;
+  for (const Item *i : grid.QueryWithinRange(location, range)) {
+    if (i->removed || !found.insert(i).second)
+      return false;
+
+    /* the query box is at most this much larger than the circle */
+    if (location.DistanceS(i->location) > 2 * range &&
+        std::abs(location.latitude.Degrees()) < 80)
+      return false;
+  }
+
+  for (const auto &i : items)
+    if (!i.removed && location.DistanceS(i.location) <= range &&
+        found.find(&i) == found.end())
+      return false;
+
+  return true;
+}
+
+static bool
+CheckQueries(const Grid &grid, const std::vector<Item> &items)
+{
+  for (unsigned i = 0; i < 100; ++i)
+    if (!CheckQuery(grid, items, RandomLocation(85), 200000))
+      return false;
+
+  return true;
+}
+
+/**
+ * The query of a cell returns every item within the range of a
+ * location inside that cell.
+ */
+static bool
+CheckCellQuery(Grid &grid, const std::vector<Item> &items,
+               GeoPoint location, double range)
+{
+  Item probe;
+  probe.location = location;
+  grid.insert(probe);
+  const unsigned cell = probe.geo_grid_cell;
+  grid.remove(probe);
+
+  std::set<const Item *> found;
+  for (const Item *i : grid.QueryCellWithinRange(cell, range))
+    if (i->removed || !found.insert(i).second)
+      return false;
+
+  for (const auto &i : items)
+    if (!i.removed && location.DistanceS(i.location) <= range &&
+        found.find(&i) == found.end())
+      return false;
+
+  return true;
+}
+
+static bool
+CheckCellQueries(Grid &grid, const std::vector<Item> &items)
+{
+  for (unsigned i = 0; i < 100; ++i)
+    if (!CheckCellQuery(grid, items, RandomLocation(85), 200000))
+      return false;
+
+  return true;
+}
+
+int main()
+{
+  plan_tests(9);
+
+  std::vector<Item> items(5000);
+
+  Grid grid;
+  for (auto &i : items) {
+    i.location = RandomLocation(89);
+    grid.insert(i);
+  }
+
+  ok1(CheckQueries(grid, items));
+  ok1(CheckCellQueries(grid, items));
+
+  /* across the antimeridian and near the poles */
+  ok1(CheckQuery(grid, items,
+                 GeoPoint(Angle::Degrees(179.9), Angle::Degrees(10)), 500000));
+  ok1(CheckQuery(grid, items,
+                 GeoPoint(Angle::Degrees(-179.9), Angle::Degrees(-10)), 500000));
+  ok1(CheckQuery(grid, items,
+                 GeoPoint(Angle::Degrees(20), Angle::Degrees(89.5)), 300000));
+  ok1(CheckCellQuery(grid, items,
+                     GeoPoint(Angle::Degrees(179.9), Angle::Degrees(60)),
+                     500000));
+
+  /* small moves stay in the cell or change it; both must work */
+  std::normal_distribution<double> delta(0, 0.3);
+  for (auto &i : items) {
+    i.location = GeoPoint(Angle::Degrees(i.location.longitude.Degrees() +
+                                         delta(gen)).AsDelta(),
+                          Angle::Degrees(std::clamp(i.location.latitude.Degrees() +
+                                                    delta(gen), -89., 89.)));
+    grid.Move(i);
+  }
+
+  ok1(CheckQueries(grid, items));
+
+  for (std::size_t i = 0; i < items.size(); i += 2) {
+    grid.remove(items[i]);
+    items[i].removed = true;
+  }
+
+  ok1(CheckQueries(grid, items));
+
+  /* an empty query */
+  Grid empty;
+  ok1(empty.QueryWithinRange(GeoPoint(Angle::Degrees(7), Angle::Degrees(51)),
+                             50000).begin() ==
+      empty.QueryWithinRange(GeoPoint(Angle::Degrees(7), Angle::Degrees(51)),
+                             50000).end());
+
+  return exit_status();
+}
@@ -10,6 +10,8 @@
 
 #include "TestUtil.hpp"
 
+#include <algorithm>
+
 static GlideSettings glide_settings;
 static GlidePolar glide_polar(0);
 
@@ -109,6 +111,47 @@ TestWind(const SpeedVector &wind)
   Test(100000, 4000, wind);
 }
 
+/**
+ * Compare the pure glide solution (MacCready zero) with cross wind
+ * against a brute-force scan for the best glide ratio over ground.
+ */
+static void
+TestCrossWind(const double density_ratio, const SpeedVector wind)
+{
+  GlidePolar polar = glide_polar;
+  polar.SetDensityRatio(density_ratio);
+
+  const double distance = 10000;
+  const GeoVector vector(distance, Angle::Zero());
+  const GlideState state(vector, 2000, 3000, wind);
+  const GlideResult result = MacCready::Solve(glide_settings, polar, state);
+
+  double best_ratio = 1e6;
+  for (double v = polar.GetVMin(); v <= polar.GetVMax(); v += 0.001) {
+    const double ground_speed = state.CalcAverageSpeed(v);
+    if (ground_speed > 0)
+      best_ratio = std::min(best_ratio, polar.SinkRate(v) / ground_speed);
+  }
+
+  ok1(result.validity == GlideResult::Validity::OK);
+  ok1(equals(result.height_glide, distance * best_ratio));
+}
+
+static void
+TestCrossWind()
+{
+  for (const double density_ratio : {1., 1.25}) {
+    for (const double bearing : {0., 45., 90., 135., 180., 300.}) {
+      TestCrossWind(density_ratio,
+                    SpeedVector(Angle::Degrees(bearing), 5));
+      TestCrossWind(density_ratio,
+                    SpeedVector(Angle::Degrees(bearing), 12.5));
+      TestCrossWind(density_ratio,
+                    SpeedVector(Angle::Degrees(bearing), 20));
+    }
+  }
+}
+
 static void
 TestAll()
 {
@@ -122,11 +165,12 @@ TestAll()
 
 int main()
 {
-  plan_tests(2103);
+  plan_tests(2175);
 
   glide_settings.SetDefaults();
 
   TestAll();
+  TestCrossWind();
 
   glide_polar.SetMC(0.1);
   TestAll();
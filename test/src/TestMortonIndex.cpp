@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "util/MortonIndex.hpp"
+#include "TestUtil.hpp"
+
+#include <random>
+#include <vector>
+
+struct Item {
+  int x, y;
+  unsigned id;
+};
+
+struct ItemAccessor {
+  int GetX(const Item &item) const noexcept {
+    return item.x;
+  }
+
+  int GetY(const Item &item) const noexcept {
+    return item.y;
+  }
+};
+
+using Index = MortonIndex<Item, ItemAccessor>;
+
+static unsigned
+SquareDistance(const Item &item, Index::Point p)
+{
+  const unsigned dx = item.x - p.x, dy = item.y - p.y;
+  return dx * dx + dy * dy;
+}
+
+static bool
+IsEven(const Item &item)
+{
+  return item.id % 2 == 0;
+}
+
+/**
+ * Compare all queries with a linear search.
+ */
+static void
+TestQueries(const std::vector<Item> &items, const Index &index,
+            std::mt19937 &rng, int min, int max)
+{
+  std::uniform_int_distribution<int> position(min - 100, max + 100);
+  std::uniform_int_distribution<unsigned> range(0, (max - min) / 4);
+
+  bool range_ok = true, nearest_ok = true, nearest_if_ok = true;
+
+  for (unsigned n = 0; n < 500; ++n) {
+    const Index::Point p{position(rng), position(rng)};
+    const unsigned r = range(rng);
+    const unsigned square_range = r * r;
+
+    std::vector<bool> expected(items.size()), visited(items.size());
+    unsigned best = square_range + 1, best_even = square_range + 1;
+    for (const auto &i : items) {
+      const unsigned d = SquareDistance(i, p);
+      expected[i.id] = d <= square_range;
+      if (d < best)
+        best = d;
+      if (IsEven(i) && d < best_even)
+        best_even = d;
+    }
+
+    auto visitor = [&visited](const Item &item){
+      visited[item.id] = true;
+    };
+    index.VisitWithinRange(p, r, visitor);
+    range_ok &= visited == expected;
+
+    const Item *nearest = index.FindNearestIf(p, r, [](const Item &){
+      return true;
+    });
+    nearest_ok &= best > square_range
+      ? nearest == nullptr
+      : nearest != nullptr && SquareDistance(*nearest, p) == best;
+
+    nearest = index.FindNearestIf(p, r, IsEven);
+    nearest_if_ok &= best_even > square_range
+      ? nearest == nullptr
+      : nearest != nullptr && IsEven(*nearest) &&
+        SquareDistance(*nearest, p) == best_even;
+  }
+
+  ok1(range_ok);
+  ok1(nearest_ok);
+  ok1(nearest_if_ok);
+}
+
+static void
+TestRandom(int min, int max, unsigned n)
+{
+  std::mt19937 rng(n);
+  std::uniform_int_distribution<int> position(min, max);
+
+  std::vector<Item> items;
+  for (unsigned i = 0; i < n; ++i)
+    items.push_back({position(rng), position(rng), i});
+
+  Index index;
+  index.Build(items.begin(), items.end());
+  ok1(index.size() == n);
+
+  TestQueries(items, index, rng, min, max);
+}
+
+static void
+TestClustered()
+{
+  /* two dense clusters far apart, with duplicate positions */
+  std::mt19937 rng(42);
+  std::normal_distribution<double> offset(0, 50);
+
+  std::vector<Item> items;
+  for (unsigned i = 0; i < 2000; ++i) {
+    const int base = i % 2 ? -15000 : 15000;
+    items.push_back({base + int(offset(rng)), base / 2 + int(offset(rng)), i});
+  }
+
+  Index index;
+  index.Build(items.begin(), items.end());
+  ok1(index.size() == items.size());
+
+  TestQueries(items, index, rng, -15200, 15200);
+}
+
+static void
+TestEmpty()
+{
+  std::vector<Item> items;
+  Index index;
+  index.Build(items.begin(), items.end());
+  ok1(index.IsEmpty());
+
+  ok1(index.FindNearestIf({0, 0}, 1000, [](const Item &){
+    return true;
+  }) == nullptr);
+}
+
+int main()
+{
+  plan_tests(4 + 4 + 4 + 2);
+
+  TestRandom(-1000, 1000, 300);
+  TestRandom(-20000, 20000, 5000);
+  TestClustered();
+  TestEmpty();
+
+  return exit_status();
+}
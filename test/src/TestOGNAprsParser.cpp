@@ -2,16 +2,18 @@
 // Copyright The XCSoar Project
 
 #include "Cloud/OGNAprs.hpp"
+#include "Cloud/OGNAreaFilter.hpp"
 #include "Cloud/OGNTraffic.hpp"
 
 #include "TestUtil.hpp"
 
 #include <cmath>
+#include <cstdio>
 
 int
 main()
 {
-  plan_tests(42);
+  plan_tests(62);
 
   const OGNAprsParseResult bad = ParseOGNAprsLine("# comment");
   ok1(!bad.valid);
@@ -95,5 +97,66 @@ main()
   ok1(no_alt_r.valid);
   ok1(!no_alt_r.altitude_valid);
 
+  /* the area filter rejects before the rest of the line is parsed */
+  OGNAreaFilter area;
+  ok1(ParseOGNAprsLine(sample, &area).valid);
+
+  area.Clear();
+  const OGNAprsParseResult outside = ParseOGNAprsLine(sample, &area);
+  ok1(!outside.valid);
+  ok1(outside.outside_area);
+  ok1(outside.station_id.empty());
+
+  area.Add(GeoPoint(Angle::Degrees(9.5), Angle::Degrees(48.5)), 50000);
+  ok1(ParseOGNAprsLine(sample, &area).valid);
+  ok1(ParseOGNAprsLine(adsb, &area).outside_area);
+
+  /* across the antimeridian */
+  area.Clear();
+  area.Add(GeoPoint(Angle::Degrees(179.9), Angle::Degrees(-40)), 50000);
+  ok1(area.Contains(GeoPoint(Angle::Degrees(-179.9), Angle::Degrees(-40))));
+  ok1(!area.Contains(GeoPoint(Angle::Degrees(0), Angle::Degrees(-40))));
+
+  /* station keys */
+  ok1(OGNStationKey("FLRDD3030F") != OGNStationKey("FLRDD3030E"));
+  ok1(OGNStationKey("ABC") != OGNStationKey("0ABC"));
+  ok1((OGNStationKey("FLRDD3030F") >> 63) == 0);
+  ok1((OGNStationKey("Station_1") >> 63) == 1);
+  ok1(OGNStationKey("Station_1") != OGNStationKey("Station_2"));
+
+  /* updating an entry does not create a new one */
+  ok1(traffic.size() == 1);
+  OGNTrafficEntry &e2 = traffic.Upsert("FLRDD3030F", r.location, r.altitude,
+                                       r.altitude_valid,
+                                       r.track_deg, r.track_valid,
+                                       r.flarm_id, r.flarm_valid,
+                                       r.aircraft_type, r.address_type,
+                                       "D-1234");
+  ok1(&e2 == &e);
+  ok1(traffic.size() == 1);
+  ok1(traffic.FindByPilotId(e.pilot_id) == &e);
+  ok1(e.callsign == "D-1234");
+
+  /* expired entries are recycled by the pool */
+  const auto Fill = [&traffic, &r](unsigned n){
+    for (unsigned i = 0; i < n; ++i) {
+      char station[16];
+      std::snprintf(station, sizeof(station), "FLR%06X", i);
+      traffic.Upsert(station, r.location, r.altitude, r.altitude_valid,
+                     r.track_deg, r.track_valid, i, true,
+                     r.aircraft_type, r.address_type, {});
+    }
+  };
+
+  Fill(2000);
+  const bool filled = traffic.size() == 2001;
+  const std::size_t pool_size = traffic.GetPoolSize();
+  traffic.Expire(std::chrono::steady_clock::now() + std::chrono::seconds(1));
+  ok1(filled && traffic.empty() &&
+      traffic.FindByPilotId(OGNPilotIdFromFlarm(0x303030u)) == nullptr);
+
+  Fill(2000);
+  ok1(traffic.size() == 2000 && traffic.GetPoolSize() == pool_size);
+
   return exit_status();
 }
@@ -0,0 +1,326 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+/*
+ * Check that the row-parallel HeightMatrix::Fill() and
+ * RasterRenderer::GenerateImage() produce the same output as a
+ * single thread.  On a single-CPU machine, the #ThreadPool has no
+ * workers and both runs are sequential.
+ */
+
+#include "Terrain/RasterRenderer.hpp"
+#include "Terrain/RasterMap.hpp"
+#include "Terrain/HeightMatrix.hpp"
+#include "Terrain/jasper/jas_seq.h"
+#include "Projection/WindowProjection.hpp"
+#include "Renderer/GeoBitmapRenderer.hpp"
+#include "Screen/Layout.hpp"
+#include "ui/canvas/Ramp.hpp"
+#include "ui/canvas/RawBitmap.hpp"
+#include "ui/event/Idle.hpp"
+#include "thread/ThreadPool.hpp"
+#include "TestUtil.hpp"
+
+#ifdef ENABLE_OPENGL
+#include "ui/canvas/opengl/Globals.hpp"
+#include "ui/canvas/opengl/ConstantAlpha.hpp"
+#include "ui/canvas/opengl/Texture.hpp"
+#endif
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+/* stubs for the screen functions used by RasterRenderer; this test
+   only looks at the RawBitmap buffer */
+
+unsigned Layout::scale = 1;
+unsigned Layout::pen_width_scale = 1024;
+
+bool
+IsUserIdle([[maybe_unused]] unsigned duration_ms) noexcept
+{
+  return true;
+}
+
+#ifdef ENABLE_OPENGL
+
+unsigned OpenGL::max_texture_size;
+
+RawBitmap::RawBitmap(PixelSize _size) noexcept
+  :size(_size),
+   buffer(new RawColor[size.width * size.height])
+{
+}
+
+RawBitmap::~RawBitmap() noexcept = default;
+
+GLTexture &
+RawBitmap::BindAndGetTexture() const noexcept
+{
+  return *texture;
+}
+
+ScopeTextureConstantAlpha::ScopeTextureConstantAlpha(bool, float)
+  :enabled(false)
+{
+}
+
+ScopeTextureConstantAlpha::~ScopeTextureConstantAlpha() = default;
+
+void
+DrawGeoBitmap(const RawBitmap &, PixelSize, const GeoBounds &,
+              const Projection &)
+{
+}
+
+#else
+
+RawBitmap::RawBitmap(PixelSize _size) noexcept
+  :size(_size),
+   buffer(new RawColor[size.width * size.height])
+{
+}
+
+void
+RawBitmap::StretchTo(PixelSize, Canvas &, PixelSize, bool, bool,
+                     float) const noexcept
+{
+}
+
+#endif
+
+static constexpr unsigned TILE_SIZE = 256;
+static constexpr unsigned N_TILES = 4;
+static constexpr unsigned SIZE = TILE_SIZE * N_TILES;
+
+/**
+ * The number of threads compared with a single thread.
+ */
+static constexpr unsigned N_THREADS = 4;
+
+/**
+ * Synthetic terrain: hills, a lake (water) and a corner without
+ * data.
+ */
+[[gnu::const]]
+static jas_seqent_t
+Height(unsigned x, unsigned y) noexcept
+{
+  if (x + y < 64)
+    return TerrainHeight::Invalid().GetValue();
+
+  const double h = 800 +
+    600 * std::sin(x * 0.011) * std::cos(y * 0.017) +
+    40 * std::sin(x * 0.29 + y * 0.13);
+  if (h < 300)
+    return -30001;
+
+  return jas_seqent_t(h);
+}
+
+/**
+ * The heights of one tile in the layout of the JPEG2000 decoder.
+ */
+class TileMatrix {
+  std::vector<jas_seqent_t> values;
+  std::vector<jas_seqent_t *> rows;
+  jas_matrix matrix{};
+
+public:
+  TileMatrix(unsigned tile_x, unsigned tile_y) noexcept
+    :values(TILE_SIZE * TILE_SIZE), rows(TILE_SIZE)
+  {
+    for (unsigned y = 0; y < TILE_SIZE; ++y) {
+      rows[y] = values.data() + y * TILE_SIZE;
+      for (unsigned x = 0; x < TILE_SIZE; ++x)
+        rows[y][x] = Height(tile_x * TILE_SIZE + x, tile_y * TILE_SIZE + y);
+    }
+
+    matrix.numrows_ = matrix.numcols_ = TILE_SIZE;
+    matrix.rows_ = rows.data();
+  }
+
+  operator const jas_matrix &() const noexcept {
+    return matrix;
+  }
+};
+
+static void
+LoadMap(RasterMap &map) noexcept
+{
+  auto &cache = map.GetTileCache();
+  cache.SetSize({SIZE, SIZE}, {TILE_SIZE, TILE_SIZE}, {N_TILES, N_TILES});
+  cache.SetLatLonBounds(7, 7.25, 47.25, 47);
+
+  for (unsigned y = 0; y < N_TILES; ++y)
+    for (unsigned x = 0; x < N_TILES; ++x)
+      cache.PutOverviewTile(y * N_TILES + x,
+                            {x * TILE_SIZE, y * TILE_SIZE},
+                            {(x + 1) * TILE_SIZE, (y + 1) * TILE_SIZE},
+                            TileMatrix{x, y});
+
+  map.UpdateProjection();
+
+  const RasterTileRegion region{
+    SignedRasterLocation(SIZE / 2, SIZE / 2), SIZE, 0,
+  };
+
+  for (unsigned i = 0; i < 100 && cache.PollTiles({&region, 1}); ++i) {
+    for (unsigned index = 0; index < cache.GetTileCount(); ++index)
+      if (cache.IsTileRequested(index))
+        cache.PutTileData(index, TileMatrix{index % N_TILES,
+                                            index / N_TILES});
+
+    cache.FinishTileUpdate();
+  }
+
+  /* decode the loaded tiles */
+  cache.PollTiles({&region, 1});
+}
+
+static WindowProjection
+MakeProjection(const RasterMap &map) noexcept
+{
+  WindowProjection projection;
+  projection.SetScreenSize({640, 480});
+  projection.SetScaleFromRadius(8000);
+  projection.SetGeoLocation(map.GetMapCenter());
+  projection.SetScreenOrigin(320, 240);
+  projection.SetScreenAngle(Angle::Degrees(30));
+  projection.UpdateScreenBounds();
+  return projection;
+}
+
+static void
+Fill(HeightMatrix &matrix, const RasterMap &map,
+     const WindowProjection &projection,
+     bool interpolate, unsigned n_threads) noexcept
+{
+#ifdef ENABLE_OPENGL
+  matrix.Fill(map, projection.GetScreenBounds(),
+              (UnsignedPoint2D)projection.GetScreenSize(),
+              interpolate, n_threads);
+#else
+  matrix.Fill(map, projection, 1, interpolate, n_threads);
+#endif
+}
+
+[[gnu::pure]]
+static bool
+operator==(const HeightMatrix &a, const HeightMatrix &b) noexcept
+{
+  return a.GetSize() == b.GetSize() &&
+    std::equal(a.GetData(), a.GetDataEnd(), b.GetData(),
+               [](TerrainHeight x, TerrainHeight y){
+                 return x.GetValue() == y.GetValue();
+               });
+}
+
+/**
+ * Does the matrix contain ground, water and invalid heights?  This
+ * verifies that the synthetic map was loaded.
+ */
+[[gnu::pure]]
+static bool
+HasAllTypes(const HeightMatrix &matrix) noexcept
+{
+  bool ground = false, water = false, unknown = false;
+  for (auto i = matrix.GetData(), end = matrix.GetDataEnd(); i != end; ++i) {
+    switch (i->GetType()) {
+    case TerrainType::GROUND:
+      ground = true;
+      break;
+
+    case TerrainType::WATER:
+      water = true;
+      break;
+
+    case TerrainType::UNKNOWN:
+      unknown = true;
+      break;
+    }
+  }
+
+  return ground && water && unknown;
+}
+
+static void
+TestFill(const RasterMap &map, const WindowProjection &projection)
+{
+  for (const bool interpolate : {false, true}) {
+    HeightMatrix single, multi;
+    Fill(single, map, projection, interpolate, 1);
+    Fill(multi, map, projection, interpolate, N_THREADS);
+    ok1(single == multi);
+  }
+}
+
+static constexpr ColorRampEntry ramp_entries[] = {
+  {0, {0x70, 0xc0, 0xa7}},
+  {250, {0xca, 0xe7, 0xb9}},
+  {500, {0xf4, 0xea, 0xaf}},
+  {750, {0xdc, 0xb2, 0x82}},
+  {1000, {0xca, 0x8e, 0x72}},
+  {1250, {0xde, 0xc8, 0xbd}},
+  {1500, {0xe3, 0xe4, 0xe9}},
+};
+
+static constexpr ColorRamp ramp{
+  false, std::size(ramp_entries), ramp_entries, nullptr,
+};
+
+[[gnu::pure]]
+static bool
+CompareImages(const RasterRenderer &a, const RasterRenderer &b) noexcept
+{
+  const auto size = a.GetSize();
+  return size == b.GetSize() &&
+    std::memcmp(a.GetImage().GetBuffer(), b.GetImage().GetBuffer(),
+                std::size_t(size.x) * size.y * sizeof(RawColor)) == 0;
+}
+
+static void
+TestRenderer(const RasterMap &map, const WindowProjection &projection)
+{
+  RasterRenderer single, multi;
+  single.SetThreads(1);
+  multi.SetThreads(N_THREADS);
+
+  single.ScanMap(map, projection);
+  multi.ScanMap(map, projection);
+  ok1(HasAllTypes(single.GetHeightMatrix()));
+  ok1(single.GetHeightMatrix() == multi.GetHeightMatrix());
+
+  /* the slope shading and the contours are enabled at this scale */
+  ok1(single.AreContoursVisible());
+
+  constexpr unsigned height_scale = 4;
+  single.PrepareColorTable(&ramp, true, height_scale, 1);
+  multi.PrepareColorTable(&ramp, true, height_scale, 1);
+
+  for (const bool do_shading : {false, true}) {
+    for (const unsigned contour_spacing : {0u, 64u}) {
+      single.GenerateImage(do_shading, height_scale, 64, 192,
+                           Angle::Degrees(45), contour_spacing);
+      multi.GenerateImage(do_shading, height_scale, 64, 192,
+                          Angle::Degrees(45), contour_spacing);
+      ok1(CompareImages(single, multi));
+    }
+  }
+}
+
+int main()
+{
+  plan_tests(2 + 3 + 4);
+
+  RasterMap map;
+  LoadMap(map);
+
+  const auto projection = MakeProjection(map);
+
+  TestFill(map, projection);
+  TestRenderer(map, projection);
+
+  return exit_status();
+}
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "Terrain/RasterTileCache.hpp"
+#include "TestUtil.hpp"
+
+static constexpr unsigned TILE_SIZE = 32;
+static constexpr unsigned N_TILES = 64;
+static constexpr unsigned SIZE = TILE_SIZE * N_TILES;
+
+/**
+ * A #RasterTileCache with a regular grid of small tiles, which are
+ * "loaded" with flat heights.
+ */
+class TestTileCache : public RasterTileCache {
+public:
+  TestTileCache() noexcept {
+    SetSize({SIZE, SIZE}, {TILE_SIZE, TILE_SIZE}, {N_TILES, N_TILES});
+
+    for (unsigned y = 0; y < N_TILES; ++y)
+      for (unsigned x = 0; x < N_TILES; ++x)
+        tiles.Get(x, y).Set({x * TILE_SIZE, y * TILE_SIZE},
+                            {(x + 1) * TILE_SIZE, (y + 1) * TILE_SIZE});
+  }
+
+  static constexpr unsigned GetIndex(unsigned x, unsigned y) noexcept {
+    return y * N_TILES + x;
+  }
+
+  const RasterTile &GetTile(unsigned x, unsigned y) const noexcept {
+    return tiles.Get(x, y);
+  }
+
+  /**
+   * Poll and load the requested tiles until there is nothing left to
+   * load.
+   */
+  void LoadAll(std::span<const RasterTileRegion> regions) noexcept {
+    RasterBuffer buffer;
+    buffer.Resize({TILE_SIZE, TILE_SIZE});
+    std::fill_n(buffer.GetData(), TILE_SIZE * TILE_SIZE, TerrainHeight{100});
+
+    for (unsigned i = 0; i < 1000 && PollTiles(regions); ++i) {
+      for (unsigned index = 0; index < GetTileCount(); ++index) {
+        if (IsTileRequested(index)) {
+          CompressedRasterBuffer compressed;
+          compressed.Compress(buffer);
+          PutCompressedTileData(index, std::move(compressed));
+        }
+      }
+
+      FinishTileUpdate();
+    }
+
+    /* apply the decoding budget to the last tiles */
+    PollTiles(regions);
+  }
+
+  unsigned CountLoaded() const noexcept {
+    unsigned n = 0;
+    for (unsigned i = 0; i < GetTileCount(); ++i)
+      if (GetCompressedTile(i) != nullptr)
+        ++n;
+    return n;
+  }
+};
+
+static RasterTileRegion
+MakeRegion(unsigned x, unsigned y, unsigned radius, uint8_t priority)
+{
+  return {SignedRasterLocation(x, y), radius, priority};
+}
+
+static void
+TestRank()
+{
+  RasterTile tile;
+  tile.Set({1000, 1000}, {1032, 1032});
+
+  /* equal distances: the lower priority value wins */
+  const RasterTileRegion high = MakeRegion(1016, 500, 5000, 0);
+  const RasterTileRegion display = MakeRegion(500, 1016, 5000, 1);
+  ok1(tile.VisibilityChanged({&high, 1}, 256));
+  const unsigned high_rank = tile.GetRank();
+  ok1(tile.VisibilityChanged({&display, 1}, 256));
+  ok1(tile.GetRank() > high_rank);
+
+  /* but a close region with a lower priority beats a far region with
+     a higher priority */
+  const RasterTileRegion near_display = MakeRegion(1016, 800, 100, 1);
+  ok1(tile.VisibilityChanged({&near_display, 1}, 256));
+  ok1(tile.GetRank() < high_rank);
+
+  /* the best region counts */
+  const RasterTileRegion both[] = {high, near_display};
+  ok1(tile.VisibilityChanged(both, 256));
+  ok1(tile.GetRank() < high_rank);
+
+  /* out of range, not loaded */
+  const RasterTileRegion far = MakeRegion(0, 0, 10, 0);
+  ok1(!tile.VisibilityChanged({&far, 1}, 256));
+  ok1(tile.GetRank() >= 0xff000000);
+}
+
+/**
+ * A huge region with a high priority must not push out the tiles of
+ * a small region with a lower priority.
+ */
+static void
+TestMerge()
+{
+  TestTileCache cache;
+
+  const RasterTileRegion regions[] = {
+    /* the reach footprint covering all tiles */
+    MakeRegion(0, 0, 2 * SIZE, 0),
+    /* the map view in the opposite corner */
+    MakeRegion(SIZE - 200, SIZE - 200, 100, 1),
+  };
+
+  /* the first batch contains tiles of both regions */
+  ok1(cache.PollTiles(regions));
+  ok1(cache.IsTileRequested(cache.GetIndex(0, 0)));
+  ok1(cache.IsTileRequested(cache.GetIndex((SIZE - 200) / TILE_SIZE,
+                                           (SIZE - 200) / TILE_SIZE)));
+
+  cache.LoadAll(regions);
+
+  /* the reach footprint alone is larger than the budget */
+  ok1(cache.CountLoaded() > 0);
+  ok1(cache.CountLoaded() < N_TILES * N_TILES);
+
+  /* the center tiles of both regions are loaded and decoded */
+  ok1(cache.GetTile(0, 0).IsLoaded());
+  ok1(cache.GetTile(0, 0).IsDecoded());
+
+  const unsigned view = (SIZE - 200) / TILE_SIZE;
+  ok1(cache.GetTile(view, view).IsLoaded());
+  ok1(cache.GetTile(view, view).IsDecoded());
+
+  /* all tiles of the map view are loaded, but the far end of the
+     reach footprint is not */
+  bool view_loaded = true;
+  for (unsigned y = (SIZE - 300) / TILE_SIZE; y < N_TILES; ++y)
+    for (unsigned x = (SIZE - 300) / TILE_SIZE; x < N_TILES; ++x)
+      view_loaded = view_loaded && cache.GetTile(x, y).IsLoaded();
+  ok1(view_loaded);
+
+  ok1(!cache.GetTile(N_TILES - 4, N_TILES / 4).IsLoaded());
+}
+
+int main()
+{
+  plan_tests(9 + 11);
+
+  TestRank();
+  TestMerge();
+
+  return exit_status();
+}
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "Terrain/ScrollBuffer.hpp"
+#include "TestUtil.hpp"
+
+#include <vector>
+
+/**
+ * Fill a buffer with values which encode their position, scroll it
+ * and verify each element.  The rows have some padding, to make sure
+ * it is not touched.
+ */
+static bool
+TestScroll(UnsignedPoint2D size, int dx, int dy, bool bottom_up)
+{
+  constexpr unsigned padding = 3;
+  constexpr unsigned UNTOUCHED = 0xffff;
+  const unsigned stride = size.x + padding;
+
+  std::vector<unsigned> buffer(stride * size.y, UNTOUCHED);
+  const auto at = [&](unsigned x, unsigned y) -> unsigned & {
+    return buffer[(bottom_up ? size.y - 1 - y : y) * stride + x];
+  };
+
+  for (unsigned y = 0; y < size.y; ++y)
+    for (unsigned x = 0; x < size.x; ++x)
+      at(x, y) = y * 256 + x;
+
+  unsigned *top_row = &at(0, 0);
+  ScrollBuffer(top_row, bottom_up ? -std::ptrdiff_t(stride) : stride,
+               size, dx, dy);
+
+  for (unsigned y = 0; y < size.y; ++y) {
+    for (unsigned x = 0; x < size.x; ++x) {
+      const int src_x = int(x) + dx, src_y = int(y) + dy;
+      const bool moved = src_x >= 0 && src_x < int(size.x) &&
+        src_y >= 0 && src_y < int(size.y);
+      const unsigned expected = moved
+        ? unsigned(src_y) * 256 + unsigned(src_x)
+        /* not overwritten */
+        : y * 256 + x;
+      if (at(x, y) != expected)
+        return false;
+    }
+
+    for (unsigned x = size.x; x < stride; ++x)
+      if (at(x, y) != UNTOUCHED)
+        return false;
+  }
+
+  return true;
+}
+
+int main()
+{
+  plan_tests(6);
+
+  ok1(TestScroll({7, 5}, 0, 0, false));
+  ok1(TestScroll({7, 5}, 2, 1, false));
+  ok1(TestScroll({7, 5}, -3, -2, false));
+  ok1(TestScroll({7, 5}, 1, -4, true));
+  ok1(TestScroll({7, 5}, -6, 3, true));
+
+  /* shifts beyond the size leave the buffer unmodified */
+  ok1(TestScroll({7, 5}, 7, 0, false) && TestScroll({7, 5}, 0, -5, true));
+
+  return exit_status();
+}
@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "Topography/ShapePointCodec.hpp"
+#include "TestUtil.hpp"
+
+#include <climits>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace ShapePointCodec;
+
+static bool
+RoundTrip(const std::vector<Point> &points, std::size_t &size)
+{
+  std::vector<std::byte> buffer;
+  Encoder encoder{buffer};
+  for (const auto &p : points)
+    encoder.Add(p);
+
+  size = buffer.size();
+
+  Decoder decoder{buffer.data()};
+  for (const auto &p : points)
+    if (decoder.Read() != p)
+      return false;
+
+  return true;
+}
+
+static void
+TestZigZag()
+{
+  ok1(ZigZagEncode(0) == 0);
+  ok1(ZigZagEncode(-1) == 1);
+  ok1(ZigZagEncode(1) == 2);
+  ok1(ZigZagDecode(ZigZagEncode(INT_MIN)) == INT_MIN);
+  ok1(ZigZagDecode(ZigZagEncode(INT_MAX)) == INT_MAX);
+}
+
+static void
+TestExtremes()
+{
+  /* jumps across the whole globe */
+  const int max = Quantise(M_PI);
+  const std::vector<Point> points{
+    {0, 0},
+    {max, -max / 2},
+    {-max, max / 2},
+    {-1, 1},
+  };
+
+  std::size_t size;
+  ok1(RoundTrip(points, size));
+}
+
+static void
+TestTrack()
+{
+  /* a random walk with small steps, like the vertices of a river:
+     most points fit into 2 bytes */
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> step(-50, 50);
+
+  std::vector<Point> points;
+  Point p{Quantise(0.01), Quantise(-0.02)};
+  for (unsigned i = 0; i < 10000; ++i) {
+    p.x += step(rng);
+    p.y += step(rng);
+    points.push_back(p);
+  }
+
+  std::size_t size;
+  ok1(RoundTrip(points, size));
+  ok1(size < points.size() * 3);
+
+  /* skipping must yield the same points as reading */
+  std::vector<std::byte> buffer;
+  Encoder encoder{buffer};
+  for (const auto &i : points)
+    encoder.Add(i);
+
+  Decoder decoder{buffer.data()};
+  decoder.Skip(1234);
+  ok1(decoder.Read() == points[1234]);
+}
+
+static void
+TestValidate()
+{
+  const int max = Quantise(M_PI);
+  std::vector<std::byte> buffer;
+  Encoder encoder{buffer};
+  encoder.Add({1, -2});
+  encoder.Add({max, -max});
+
+  ok1(Validate(buffer, 2));
+
+  /* too few or too many points */
+  ok1(!Validate(buffer, 1));
+  ok1(!Validate(buffer, 3));
+
+  /* truncated in the middle of a varint */
+  ok1(!Validate(std::span{buffer}.first(buffer.size() - 1), 2));
+
+  /* a varint which is too long for 32 bit */
+  const std::vector<std::byte> overlong(6, std::byte{0x80});
+  ok1(!Validate(overlong, 1));
+}
+
+int main()
+{
+  plan_tests(5 + 1 + 3 + 5);
+
+  TestZigZag();
+  TestExtremes();
+  TestTrack();
+  TestValidate();
+
+  return exit_status();
+}
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "Topography/ShapeProjection.hpp"
+#include "Projection/WindowProjection.hpp"
+#include "TestUtil.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+static constexpr PixelSize screen_size{640, 480};
+
+/**
+ * Project a grid of points covering the (slightly enlarged) screen
+ * with #ShapeProjection and with Projection::GeoToScreen() and
+ * return the largest difference [pixels].
+ */
+static int
+MaxError(const GeoPoint &location, double radius, Angle angle,
+         const GeoPoint &reference)
+{
+  WindowProjection projection;
+  projection.SetScreenSize(screen_size);
+  projection.SetScreenOrigin(screen_size.width / 2, screen_size.height / 2);
+  projection.SetScaleFromRadius(radius);
+  projection.SetGeoLocation(location);
+  projection.SetScreenAngle(angle);
+  projection.UpdateScreenBounds();
+
+  const ShapeProjection shape_projection(projection, reference);
+
+  int max_error = 0;
+
+  constexpr int margin = 64, step = 16;
+  for (int y = -margin; y <= int(screen_size.height) + margin; y += step) {
+    for (int x = -margin; x <= int(screen_size.width) + margin; x += step) {
+      /* a quantised shape point near this pixel */
+      const GeoPoint g = projection.ScreenToGeo({x, y});
+      const GeoPoint relative = g - reference;
+      const ShapePointCodec::Point p{
+        ShapePointCodec::Quantise(relative.longitude.Native()),
+        ShapePointCodec::Quantise(relative.latitude.Native()),
+      };
+
+      const GeoPoint q{
+        reference.longitude + Angle::Native(p.x * ShapePointCodec::RESOLUTION),
+        reference.latitude + Angle::Native(p.y * ShapePointCodec::RESOLUTION),
+      };
+
+      const PixelPoint expected = projection.GeoToScreen(q);
+      const PixelPoint actual = shape_projection(p);
+      max_error = std::max({max_error,
+                            std::abs(actual.x - expected.x),
+                            std::abs(actual.y - expected.y)});
+
+      /* the GeoPoint overload used for labels */
+      const PixelPoint label = shape_projection(q);
+      max_error = std::max({max_error,
+                            std::abs(label.x - expected.x),
+                            std::abs(label.y - expected.y)});
+    }
+  }
+
+  return max_error;
+}
+
+static constexpr GeoPoint locations[] = {
+  {Angle::Degrees(7.7), Angle::Degrees(0.5)},
+  {Angle::Degrees(7.7), Angle::Degrees(51.4)},
+  {Angle::Degrees(-122.3), Angle::Degrees(47.6)},
+  {Angle::Degrees(25.7), Angle::Degrees(-62.1)},
+};
+
+/* map radii [m] from the closest to the widest zoom level */
+static constexpr double radii[] = {
+  100, 1000, 10000, 50000, 200000, 1000000,
+};
+
+static constexpr double angles[] = {
+  0, 17, 90, 135, 180, 241, 315,
+};
+
+/* offsets of the file center from the screen center [degrees] */
+static constexpr double reference_offsets[] = {
+  0, 0.4, -1.3,
+};
+
+int main()
+{
+  plan_tests(std::size(locations) * std::size(radii) * std::size(angles) *
+             std::size(reference_offsets));
+
+  for (const GeoPoint &location : locations) {
+    for (const double radius : radii) {
+      for (const double angle : angles) {
+        for (const double offset : reference_offsets) {
+          const GeoPoint reference{
+            location.longitude + Angle::Degrees(offset),
+            location.latitude - Angle::Degrees(offset / 2),
+          };
+
+          const int error = MaxError(location, radius,
+                                     Angle::Degrees(angle), reference);
+          if (!ok(error <= 1,
+                  "lat=%g radius=%g angle=%g offset=%g: %d pixels",
+                  location.latitude.Degrees(), radius, angle, offset,
+                  error))
+            diag("max error %d pixels", error);
+        }
+      }
+    }
+  }
+
+  return exit_status();
+}
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "Engine/Task/PathSolvers/TaskDijkstraMin.hpp"
+#include "Engine/Task/PathSolvers/TaskDijkstraMax.hpp"
+#include "Geo/SearchPointVector.hpp"
+#include "Geo/GeoVector.hpp"
+#include "TestUtil.hpp"
+
+#include <random>
+
+static constexpr unsigned N_STAGES = 6;
+
+static std::mt19937 rng(1);
+
+/**
+ * Generate a random observation zone boundary: points on a circle
+ * around the given centre.
+ */
+static SearchPointVector
+MakeBoundary(const GeoPoint &center)
+{
+  std::uniform_real_distribution<double> radius(500, 20000);
+  std::uniform_int_distribution<unsigned> size(3, 12);
+
+  const double r = radius(rng);
+  const unsigned n = size(rng);
+
+  SearchPointVector boundary;
+  for (unsigned i = 0; i < n; ++i)
+    boundary.emplace_back(GeoVector(r, Angle::FullCircle() * i / n)
+                          .EndPoint(center));
+  return boundary;
+}
+
+static GeoPoint
+MakeCenter(unsigned stage)
+{
+  return GeoPoint(Angle::Degrees(7 + 0.3 * (stage % 2) + 0.05 * stage),
+                  Angle::Degrees(47 + 0.4 * stage));
+}
+
+template<typename D>
+static void
+SetBoundaries(D &dijkstra, const SearchPointVector *boundaries)
+{
+  dijkstra.SetTaskSize(N_STAGES);
+  for (unsigned i = 0; i < N_STAGES; ++i)
+    dijkstra.SetBoundary(i, boundaries[i]);
+}
+
+template<typename D>
+static double
+GetSolutionDistance(const D &dijkstra)
+{
+  double distance = 0;
+  for (unsigned i = 1; i < N_STAGES; ++i)
+    distance += dijkstra.GetSolution(i - 1).GetLocation()
+      .Distance(dijkstra.GetSolution(i).GetLocation());
+  return distance;
+}
+
+/**
+ * Compare the result of the (cached) #TaskDijkstraMax with a new
+ * instance.
+ */
+static bool
+CompareMax(TaskDijkstraMax &cached, const SearchPointVector *boundaries)
+{
+  SetBoundaries(cached, boundaries);
+
+  TaskDijkstraMax uncached;
+  SetBoundaries(uncached, boundaries);
+
+  return cached.DistanceMax() && uncached.DistanceMax() &&
+    equals(GetSolutionDistance(cached), GetSolutionDistance(uncached));
+}
+
+static bool
+CompareMin(TaskDijkstraMin &cached, const SearchPointVector *boundaries,
+           const GeoPoint &location)
+{
+  SetBoundaries(cached, boundaries);
+
+  TaskDijkstraMin uncached;
+  SetBoundaries(uncached, boundaries);
+
+  const SearchPoint sp(location);
+  return cached.DistanceMin(sp) && uncached.DistanceMin(sp) &&
+    equals(GetSolutionDistance(cached), GetSolutionDistance(uncached));
+}
+
+/**
+ * The number of edges of the legs adjacent to the given stage.
+ */
+static unsigned
+CountAdjacentEdges(const SearchPointVector *boundaries, unsigned stage)
+{
+  unsigned n = 0;
+  if (stage > 0)
+    n += boundaries[stage - 1].size() * boundaries[stage].size();
+  if (stage + 1 < N_STAGES)
+    n += boundaries[stage].size() * boundaries[stage + 1].size();
+  return n;
+}
+
+static void
+TestMax()
+{
+  SearchPointVector boundaries[N_STAGES];
+  for (unsigned i = 0; i < N_STAGES; ++i)
+    boundaries[i] = MakeBoundary(MakeCenter(i));
+
+  TaskDijkstraMax dijkstra;
+  ok1(CompareMax(dijkstra, boundaries));
+
+  /* nothing has changed: no distance needs to be calculated */
+  ok1(CompareMax(dijkstra, boundaries));
+  ok1(dijkstra.GetCalculatedEdgeCount() == 0);
+
+  /* a changed boundary discards only the two adjacent legs */
+  for (unsigned stage : {3U, 0U, N_STAGES - 1, 2U}) {
+    boundaries[stage] = MakeBoundary(MakeCenter(stage));
+    ok1(CompareMax(dijkstra, boundaries));
+    ok1(dijkstra.GetCalculatedEdgeCount() > 0);
+    ok1(dijkstra.GetCalculatedEdgeCount() <=
+        CountAdjacentEdges(boundaries, stage));
+  }
+
+  /* change several stages at once */
+  std::uniform_int_distribution<unsigned> stage(0, N_STAGES - 1);
+  bool all_equal = true;
+  for (unsigned round = 0; round < 20; ++round) {
+    for (unsigned i = 0; i < 2; ++i) {
+      const unsigned s = stage(rng);
+      boundaries[s] = MakeBoundary(MakeCenter(s));
+    }
+
+    all_equal = all_equal && CompareMax(dijkstra, boundaries);
+  }
+
+  ok1(all_equal);
+}
+
+static void
+TestMin()
+{
+  SearchPointVector boundaries[N_STAGES];
+  for (unsigned i = 0; i < N_STAGES; ++i)
+    boundaries[i] = MakeBoundary(MakeCenter(i));
+
+  TaskDijkstraMin dijkstra;
+  const GeoPoint location(Angle::Degrees(6.8), Angle::Degrees(46.9));
+  ok1(CompareMin(dijkstra, boundaries, location));
+
+  boundaries[2] = MakeBoundary(MakeCenter(2));
+  ok1(CompareMin(dijkstra, boundaries, location));
+  ok1(dijkstra.GetCalculatedEdgeCount() <=
+      CountAdjacentEdges(boundaries, 2));
+
+  ok1(CompareMin(dijkstra, boundaries,
+                 GeoPoint(Angle::Degrees(7.5), Angle::Degrees(48))));
+  ok1(dijkstra.GetCalculatedEdgeCount() == 0);
+}
+
+int main()
+{
+  plan_tests(21);
+
+  TestMax();
+  TestMin();
+
+  return exit_status();
+}
@@ -0,0 +1,233 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "thread/ThreadPool.hpp"
+#include "thread/ParallelFor.hpp"
+#include "TestUtil.hpp"
+
+#include <atomic>
+#include <vector>
+
+/**
+ * Wait until a number of tasks have finished.
+ */
+class Latch {
+  Mutex mutex;
+  Cond cond;
+  unsigned remaining;
+
+public:
+  explicit Latch(unsigned n) noexcept:remaining(n) {}
+
+  void CountDown() noexcept {
+    const std::lock_guard lock{mutex};
+    if (--remaining == 0)
+      cond.notify_all();
+  }
+
+  void Wait() noexcept {
+    std::unique_lock lock{mutex};
+    cond.wait(lock, [this]{ return remaining == 0; });
+  }
+};
+
+static bool
+TestSubmit(ThreadPool &pool)
+{
+  constexpr unsigned N = 1000;
+  std::atomic<unsigned> counter{0};
+  Latch latch(N);
+
+  for (unsigned i = 0; i < N; ++i)
+    pool.Submit([&]{ ++counter; latch.CountDown(); });
+
+  latch.Wait();
+  return counter == N;
+}
+
+static bool
+TestCancel(ThreadPool &pool)
+{
+  CancellationSource source;
+  source.Cancel();
+
+  std::atomic<bool> cancelled_ran{false};
+  pool.Submit([&]{ cancelled_ran = true; },
+              ThreadPool::Priority::LOW, source.GetToken());
+
+  /* tasks run in order on a single worker */
+  Latch latch(1);
+  pool.Submit([&]{ latch.CountDown(); });
+  latch.Wait();
+
+  return !cancelled_ran;
+}
+
+/**
+ * With a busy single worker, a task with higher priority overtakes
+ * one which was submitted earlier.
+ */
+static bool
+TestPriority(ThreadPool &pool)
+{
+  Latch started(1), release(1), done(2);
+  pool.Submit([&]{ started.CountDown(); release.Wait(); });
+  started.Wait();
+
+  std::vector<int> order;
+  Mutex mutex;
+  pool.Submit([&]{
+    const std::lock_guard lock{mutex};
+    order.push_back(1);
+    done.CountDown();
+  }, ThreadPool::Priority::LOW);
+  pool.Submit([&]{
+    const std::lock_guard lock{mutex};
+    order.push_back(2);
+    done.CountDown();
+  }, ThreadPool::Priority::HIGH);
+
+  release.CountDown();
+  done.Wait();
+
+  return order == std::vector<int>{2, 1};
+}
+
+/**
+ * Every index is visited exactly once.
+ */
+static bool
+TestParallelFor(unsigned n, unsigned min_chunk)
+{
+  std::vector<std::atomic<unsigned>> visits(n);
+  ParallelFor(n, 8, min_chunk, [&visits](unsigned begin, unsigned end){
+    for (unsigned i = begin; i < end; ++i)
+      ++visits[i];
+  });
+
+  for (const auto &i : visits)
+    if (i != 1)
+      return false;
+
+  return true;
+}
+
+/**
+ * ParallelFor() inside pool tasks does not deadlock, even if all
+ * workers are busy.
+ */
+static bool
+TestNested()
+{
+  auto &pool = ThreadPool::Get();
+  const unsigned n_tasks = pool.GetWorkerCount() + 2;
+
+  std::atomic<unsigned> total{0};
+  Latch latch(n_tasks);
+  for (unsigned i = 0; i < n_tasks; ++i)
+    pool.Submit([&]{
+      ParallelFor(1000, 8, 10, [&total](unsigned begin, unsigned end){
+        total += end - begin;
+      });
+      latch.CountDown();
+    });
+
+  latch.Wait();
+  return total == n_tasks * 1000;
+}
+
+/**
+ * Tasks which start after ParallelFor() has returned find no chunk
+ * left and return without touching the caller's stack frame.
+ */
+static bool
+TestLateTasks()
+{
+  auto &pool = ThreadPool::Get();
+  const unsigned n_workers = pool.GetWorkerCount();
+
+  /* keep all workers busy, so the calling thread processes all
+     chunks */
+  Latch started(n_workers), release(1);
+  for (unsigned i = 0; i < n_workers; ++i)
+    pool.Submit([&]{ started.CountDown(); release.Wait(); },
+                ThreadPool::Priority::HIGH);
+  started.Wait();
+
+  unsigned total = 0;
+  ParallelFor(1000, 8, 10, [&total](unsigned begin, unsigned end){
+    total += end - begin;
+  }, ThreadPool::Priority::LOW);
+
+  /* now the tasks submitted by ParallelFor() start */
+  release.CountDown();
+
+  /* more tasks with the same priority, which usually run after the
+     late ones */
+  Latch done(n_workers);
+  for (unsigned i = 0; i < n_workers; ++i)
+    pool.Submit([&]{ done.CountDown(); }, ThreadPool::Priority::LOW);
+  done.Wait();
+
+  return total == 1000;
+}
+
+/**
+ * ParallelFor() with the I/O pool does not need the CPU workers.
+ */
+static bool
+TestIOPool()
+{
+  auto &pool = ThreadPool::Get();
+  const unsigned n_workers = pool.GetWorkerCount();
+
+  /* keep all CPU workers busy */
+  Latch started(n_workers), release(1);
+  for (unsigned i = 0; i < n_workers; ++i)
+    pool.Submit([&]{ started.CountDown(); release.Wait(); },
+                ThreadPool::Priority::HIGH);
+  started.Wait();
+
+  std::atomic<unsigned> total{0};
+  ParallelFor(ThreadPool::GetIO(), 1000, 8, 10,
+              [&total](unsigned begin, unsigned end){
+                total += end - begin;
+              });
+
+  release.CountDown();
+
+  Latch done(n_workers);
+  for (unsigned i = 0; i < n_workers; ++i)
+    pool.Submit([&]{ done.CountDown(); }, ThreadPool::Priority::LOW);
+  done.Wait();
+
+  return total == 1000;
+}
+
+int main()
+{
+  plan_tests(11);
+
+  {
+    ThreadPool pool(4);
+    ok1(pool.GetWorkerCount() == 4);
+    ok1(TestSubmit(pool));
+  }
+
+  {
+    ThreadPool pool(1);
+    ok1(TestCancel(pool));
+    ok1(TestPriority(pool));
+  }
+
+  ok1(TestParallelFor(1, 1));
+  ok1(TestParallelFor(1000, 7));
+  ok1(TestParallelFor(12345, 100));
+  ok1(TestNested());
+  ok1(TestLateTasks());
+
+  ok1(ThreadPool::GetIO().GetWorkerCount() == ThreadPool::IO_WORKERS);
+  ok1(TestIOPool());
+
+  return exit_status();
+}
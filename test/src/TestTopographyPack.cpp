@@ -0,0 +1,438 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "Topography/Pack.hpp"
+#include "Topography/XShape.hpp"
+#include "Topography/Convert.hpp"
+#include "system/Path.hpp"
+#include "TestUtil.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+
+static constexpr double SCALE_THRESHOLD = 15000;
+static constexpr uint_least64_t SOURCE_SIZE = 123456;
+static constexpr uint_least32_t SOURCE_CRC32 = 0x89abcdef;
+
+static std::mt19937 rng(1);
+
+struct TestShape {
+  shapeObj shape;
+  std::string label;
+
+  TestShape() noexcept {
+    msInitShape(&shape);
+  }
+
+  ~TestShape() noexcept {
+    msFreeShape(&shape);
+  }
+
+  TestShape(const TestShape &) = delete;
+  TestShape &operator=(const TestShape &) = delete;
+};
+
+/**
+ * Append a line to the shape; the memory is freed by msFreeShape().
+ */
+static void
+AddLine(shapeObj &shape, const std::vector<pointObj> &points)
+{
+  shape.line = (lineObj *)realloc(shape.line,
+                                  (shape.numlines + 1) * sizeof(lineObj));
+  auto &line = shape.line[shape.numlines++];
+  line.numpoints = points.size();
+  line.point = (pointObj *)malloc(points.size() * sizeof(pointObj));
+  std::copy(points.begin(), points.end(), line.point);
+
+  if (shape.numlines == 1) {
+    const auto &p = points.front();
+    shape.bounds = {p.x, p.y, p.x, p.y};
+  }
+
+  for (const auto &p : points) {
+    shape.bounds.minx = std::min(shape.bounds.minx, p.x);
+    shape.bounds.miny = std::min(shape.bounds.miny, p.y);
+    shape.bounds.maxx = std::max(shape.bounds.maxx, p.x);
+    shape.bounds.maxy = std::max(shape.bounds.maxy, p.y);
+  }
+}
+
+/**
+ * A random walk with steps of about 300 m.
+ */
+static std::vector<pointObj>
+MakeTrack(double x, double y, unsigned n)
+{
+  std::uniform_real_distribution<double> step(-0.003, 0.003);
+
+  std::vector<pointObj> points;
+  for (unsigned i = 0; i < n; ++i) {
+    points.push_back({x, y, 0, 0});
+    x += step(rng);
+    y += step(rng);
+  }
+
+  return points;
+}
+
+/**
+ * A closed ring with the given radius [degrees].
+ */
+static std::vector<pointObj>
+MakeRing(double x, double y, double radius, unsigned n)
+{
+  std::vector<pointObj> points;
+  for (unsigned i = 0; i < n; ++i) {
+    const double a = 2 * M_PI * i / n;
+    points.push_back({x + radius * cos(a), y + radius * sin(a), 0, 0});
+  }
+
+  points.push_back(points.front());
+  return points;
+}
+
+static void
+MakeShapes(std::deque<TestShape> &shapes, int type, unsigned n)
+{
+  std::uniform_real_distribution<double> x(6.5, 7.5), y(46.5, 47.5);
+  std::uniform_real_distribution<double> radius(0.0005, 0.05);
+  std::uniform_int_distribution<unsigned> n_lines(1, 3), n_points(2, 200);
+
+  for (unsigned i = 0; i < n; ++i) {
+    auto &s = shapes.emplace_back();
+    s.shape.type = type;
+
+    switch (type) {
+    case MS_SHAPE_POINT:
+      AddLine(s.shape, {{x(rng), y(rng), 0, 0}});
+      break;
+
+    case MS_SHAPE_LINE:
+      for (unsigned l = n_lines(rng); l > 0; --l)
+        AddLine(s.shape, MakeTrack(x(rng), y(rng), n_points(rng)));
+      break;
+
+    case MS_SHAPE_POLYGON:
+      AddLine(s.shape, MakeRing(x(rng), y(rng), radius(rng),
+                                n_points(rng) + 2));
+      break;
+    }
+
+    if (i % 3 == 0)
+      s.label = "Shape " + std::to_string(i);
+  }
+}
+
+static GeoBounds
+GetBounds(const std::deque<TestShape> &shapes)
+{
+  GeoBounds bounds = ImportRect(shapes.front().shape.bounds);
+  for (const auto &s : shapes) {
+    const auto b = ImportRect(s.shape.bounds);
+    bounds.Extend(b.GetNorthWest());
+    bounds.Extend(b.GetSouthEast());
+  }
+
+  return bounds;
+}
+
+static void
+WriteLayer(TopographyPackWriter &writer, const char *name,
+           const std::deque<TestShape> &shapes)
+{
+  writer.BeginLayer(name, SOURCE_SIZE, SOURCE_CRC32, GetBounds(shapes),
+                    SCALE_THRESHOLD);
+  for (const auto &s : shapes)
+    writer.AddShape(s.shape, s.label.empty() ? nullptr : s.label.c_str());
+}
+
+static ShapePointCodec::Point
+Quantise(const pointObj &p, const GeoPoint &center) noexcept
+{
+  const GeoPoint relative =
+    GeoPoint(Angle::Degrees(p.x), Angle::Degrees(p.y)) - center;
+  return {
+    ShapePointCodec::Quantise(relative.longitude.Native()),
+    ShapePointCodec::Quantise(relative.latitude.Native()),
+  };
+}
+
+/**
+ * Compare the full detail level of the shape with the quantised
+ * input.
+ */
+static bool
+ComparePoints(const XShape &shape, const shapeObj &src,
+              const GeoPoint &center)
+{
+  const auto lines = shape.GetLines();
+  if (lines.size() != std::size_t(src.numlines))
+    return false;
+
+  auto points = shape.GetPoints();
+  for (std::size_t l = 0; l < lines.size(); ++l) {
+    if (lines[l] != src.line[l].numpoints)
+      return false;
+
+    for (unsigned i = 0; i < lines[l]; ++i) {
+      const auto expected = Quantise(src.line[l].point[i], center);
+#ifdef ENABLE_OPENGL
+      const ShapePoint p = *points++;
+      if (p.x != ShapeScalar(expected.x * ShapePointCodec::RESOLUTION) ||
+          p.y != ShapeScalar(expected.y * ShapePointCodec::RESOLUTION))
+        return false;
+#else
+      if (points.Read() != expected)
+        return false;
+#endif
+    }
+  }
+
+  return true;
+}
+
+static bool
+CompareLabel(const XShape &shape, const std::string &label)
+{
+  return label.empty()
+    ? shape.GetLabel() == nullptr
+    : shape.GetLabel() != nullptr && label == shape.GetLabel();
+}
+
+#ifndef ENABLE_OPENGL
+
+[[gnu::pure]]
+static std::size_t
+CountPoints(std::span<const uint16_t> lines) noexcept
+{
+  std::size_t n = 0;
+  for (const auto i : lines)
+    n += i;
+  return n;
+}
+
+/**
+ * Check that the coarsest level is a subset of the full level which
+ * keeps the first and the last point of each line.
+ */
+static bool
+CheckLevels(const XShape &shape, std::size_t &n_full, std::size_t &n_coarse)
+{
+  const auto full = shape.GetLevel(0);
+  const auto coarse = shape.GetLevel(XShape::THINNING_LEVELS - 1);
+
+  n_full += CountPoints(full.lines);
+  n_coarse += CountPoints(coarse.lines);
+
+  if (!shape.HasLevels() || coarse.lines.size() != full.lines.size())
+    return false;
+
+  auto a = full.points, b = coarse.points;
+  for (std::size_t l = 0; l < full.lines.size(); ++l) {
+    std::vector<ShapePointCodec::Point> line;
+    for (unsigned i = 0; i < full.lines[l]; ++i)
+      line.push_back(a.Read());
+
+    const unsigned n = coarse.lines[l];
+    if (n == 0) {
+      /* only polygons may be omitted */
+      if (shape.get_type() != MS_SHAPE_POLYGON)
+        return false;
+      continue;
+    }
+
+    if (n > line.size())
+      return false;
+
+    auto i = line.begin();
+    for (unsigned j = 0; j < n; ++j) {
+      const auto p = b.Read();
+      if (j == 0 && p != line.front())
+        return false;
+      if (j == n - 1 && p != line.back())
+        return false;
+
+      i = std::find(i, line.end(), p);
+      if (i == line.end())
+        return false;
+    }
+  }
+
+  return true;
+}
+
+#endif
+
+static void
+TestLayer(const TopographyPack &pack, const char *name,
+          const std::deque<TestShape> &shapes)
+{
+  const auto *layer = pack.FindLayer(name, SOURCE_SIZE, SOURCE_CRC32);
+  ok1(layer != nullptr);
+  if (layer == nullptr) {
+#ifdef ENABLE_OPENGL
+    skip(5, 0, "layer not found");
+#else
+    skip(7, 0, "layer not found");
+#endif
+    return;
+  }
+
+  ok1(layer->size() == shapes.size());
+
+  TopographyPack::Reader reader(pack);
+
+  std::vector<std::unique_ptr<XShape>> loaded;
+  bool points_equal = true, labels_equal = true, bounds_inside = true;
+#ifndef ENABLE_OPENGL
+  bool levels_valid = true;
+  std::size_t n_full = 0, n_coarse = 0;
+#endif
+
+  for (std::size_t i = 0; i < shapes.size(); ++i) {
+    const auto &src = shapes[i];
+    auto shape = reader.ReadShape(*layer, i);
+
+    points_equal = points_equal &&
+      ComparePoints(*shape, src.shape, layer->GetCenter());
+    labels_equal = labels_equal && CompareLabel(*shape, src.label);
+
+    const auto src_bounds = ImportRect(src.shape.bounds);
+    bounds_inside = bounds_inside &&
+      shape->get_bounds().IsInside(src_bounds.GetNorthWest()) &&
+      shape->get_bounds().IsInside(src_bounds.GetSouthEast());
+
+#ifndef ENABLE_OPENGL
+    levels_valid = levels_valid && CheckLevels(*shape, n_full, n_coarse);
+#endif
+
+    loaded.emplace_back(std::move(shape));
+  }
+
+  ok1(points_equal);
+  ok1(labels_equal);
+  ok1(bounds_inside);
+
+#ifndef ENABLE_OPENGL
+  ok1(levels_valid);
+  ok1(shapes.front().shape.type == MS_SHAPE_POINT || n_coarse < n_full);
+#endif
+
+  /* compare the grid index with a brute-force search */
+  std::uniform_real_distribution<double> x(6.3, 7.7), y(46.3, 47.7);
+  std::uniform_real_distribution<double> size(0.001, 0.5);
+  bool index_equal = true;
+  std::vector<bool> result;
+  for (unsigned round = 0; round < 50; ++round) {
+    const GeoPoint nw(Angle::Degrees(x(rng)), Angle::Degrees(y(rng)));
+    const GeoPoint se(nw.longitude + Angle::Degrees(size(rng)),
+                      nw.latitude - Angle::Degrees(size(rng)));
+    const GeoBounds rect(nw, se);
+
+    if (!layer->WhichShapes(rect, result)) {
+      for (const auto &shape : loaded)
+        if (rect.Overlaps(shape->get_bounds()))
+          index_equal = false;
+      continue;
+    }
+
+    for (std::size_t i = 0; i < loaded.size(); ++i)
+      if (result[i] != rect.Overlaps(loaded[i]->get_bounds()))
+        index_equal = false;
+  }
+
+  ok1(index_equal);
+}
+
+/**
+ * Increment the number of points of the first line of the first
+ * shape in the file, so it does not match the encoded points anymore.
+ */
+static bool
+CorruptFirstShape(Path path)
+{
+  FILE *file = fopen(path.c_str(), "r+b");
+  if (file == nullptr)
+    return false;
+
+  /* skip the PackHeader and read ShapeHeader::label_size */
+  uint32_t label_size;
+  const long offset = 8 + 24;
+  uint16_t n;
+  const bool success = fseek(file, 8 + 4, SEEK_SET) == 0 &&
+    fread(&label_size, sizeof(label_size), 1, file) == 1 &&
+    fseek(file, offset + long(label_size), SEEK_SET) == 0 &&
+    fread(&n, sizeof(n), 1, file) == 1 &&
+    fseek(file, offset + long(label_size), SEEK_SET) == 0 &&
+    (++n, fwrite(&n, sizeof(n), 1, file) == 1);
+  return fclose(file) == 0 && success;
+}
+
+static bool
+ReadShapeThrows(const TopographyPack &pack, const char *name)
+{
+  const auto *layer = pack.FindLayer(name, SOURCE_SIZE, SOURCE_CRC32);
+  if (layer == nullptr)
+    return false;
+
+  try {
+    TopographyPack::Reader{pack}.ReadShape(*layer, 0);
+    return false;
+  } catch (const std::runtime_error &) {
+    return true;
+  }
+}
+
+int main()
+{
+#ifdef ENABLE_OPENGL
+  plan_tests(5 + 3 * 6);
+#else
+  plan_tests(5 + 3 * 8);
+#endif
+
+  std::deque<TestShape> points, lines, polygons;
+  MakeShapes(points, MS_SHAPE_POINT, 100);
+  MakeShapes(lines, MS_SHAPE_LINE, 300);
+  MakeShapes(polygons, MS_SHAPE_POLYGON, 300);
+
+  const Path path("output/test/topography.xtop");
+
+  {
+    TopographyPackWriter writer(path);
+    WriteLayer(writer, "points.shp", points);
+    WriteLayer(writer, "lines.shp", lines);
+    WriteLayer(writer, "polygons.shp", polygons);
+    writer.Commit();
+  }
+
+  const TopographyPack pack(path);
+
+  /* a layer generated from a different shapefile is ignored */
+  ok1(pack.FindLayer("lines.shp", SOURCE_SIZE + 1, SOURCE_CRC32) == nullptr);
+  ok1(pack.FindLayer("lines.shp", SOURCE_SIZE, SOURCE_CRC32 + 1) == nullptr);
+  ok1(pack.FindLayer("roads.shp", SOURCE_SIZE, SOURCE_CRC32) == nullptr);
+
+  /* outside of all layers */
+  std::vector<bool> result;
+  ok1(!pack.FindLayer("lines.shp", SOURCE_SIZE, SOURCE_CRC32)->WhichShapes(
+        GeoBounds(GeoPoint(Angle::Degrees(20), Angle::Degrees(10)),
+                  GeoPoint(Angle::Degrees(21), Angle::Degrees(9))),
+        result));
+
+  TestLayer(pack, "points.shp", points);
+  TestLayer(pack, "lines.shp", lines);
+  TestLayer(pack, "polygons.shp", polygons);
+
+  /* a shape whose line lengths do not match its points is rejected */
+  ok1(CorruptFirstShape(path) && ReadShapeThrows(pack, "points.shp"));
+
+  return exit_status();
+}
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "Tracing/Tracing.hpp"
+#include "system/Path.hpp"
+#include "io/FileReader.hxx"
+#include "TestUtil.hpp"
+
+#include <string>
+
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace std::chrono;
+
+static std::string
+ReadFile(Path path)
+{
+  FileReader reader(path);
+  std::string result;
+  char buffer[4096];
+  std::size_t nbytes;
+  while ((nbytes = reader.Read(std::as_writable_bytes(std::span{buffer}))) > 0)
+    result.append(buffer, nbytes);
+  return result;
+}
+
+int main()
+{
+  plan_tests(18);
+
+  /* disabled: nothing is recorded */
+  {
+    const Tracing::Scope scope{Tracing::Point::TERRAIN_LOAD};
+  }
+  ok1(Tracing::GetStatistics(Tracing::Point::TERRAIN_LOAD).count == 0);
+  ok1(Tracing::GetEventCount() == 0);
+
+  Tracing::Count(Tracing::Counter::NMEA_SENTENCES);
+  ok1(Tracing::GetCounter(Tracing::Counter::NMEA_SENTENCES) == 0);
+
+  Tracing::Enable();
+  ok1(Tracing::IsEnabled());
+
+  Tracing::Count(Tracing::Counter::NMEA_SENTENCES);
+  Tracing::Count(Tracing::Counter::NMEA_SENTENCES);
+  Tracing::Count(Tracing::Counter::TERRAIN_TILES, 5);
+  ok1(Tracing::GetCounter(Tracing::Counter::NMEA_SENTENCES) == 2);
+  ok1(Tracing::GetCounter(Tracing::Counter::TERRAIN_TILES) == 5);
+  ok1(Tracing::GetCounter(Tracing::Counter::TOPOGRAPHY_SHAPES) == 0);
+
+  const auto t = Tracing::Clock::now();
+  Tracing::Record(Tracing::Point::DEVICE_PARSE, t, t + milliseconds{2});
+  Tracing::Record(Tracing::Point::DEVICE_PARSE, t, t + milliseconds{4});
+
+  {
+    const Tracing::Scope scope{Tracing::Point::TERRAIN_LOAD};
+  }
+
+  /* started before Enable(): discarded */
+  Tracing::Record(Tracing::Point::DEVICE_PARSE, t - seconds{1}, t);
+
+  const auto s = Tracing::GetStatistics(Tracing::Point::DEVICE_PARSE);
+  ok1(s.count == 2);
+  ok1(s.max == milliseconds{4});
+  ok1(s.GetAverage() == milliseconds{3});
+  ok1(Tracing::GetStatistics(Tracing::Point::TERRAIN_LOAD).count == 1);
+  ok1(Tracing::GetEventCount() == 3);
+
+  Tracing::Disable();
+  Tracing::Record(Tracing::Point::DEVICE_PARSE, t, t + milliseconds{1});
+  ok1(Tracing::GetEventCount() == 3);
+
+  char path[] = "/tmp/TestTracing.XXXXXX";
+  const int fd = mkstemp(path);
+  close(fd);
+
+  Tracing::ExportChromeTrace(Path{path});
+  const auto json = ReadFile(Path{path});
+  unlink(path);
+
+  ok1(json.starts_with("{\"traceEvents\":["));
+  ok1(json.find("\"name\":\"Device data\",\"cat\":\"device\",\"ph\":\"X\",") != json.npos);
+  ok1(json.find("\"dur\":4000,") != json.npos);
+  ok1(json.find("\"name\":\"Terrain tiles loaded\",\"ph\":\"C\",") != json.npos &&
+      json.find("\"args\":{\"value\":5}") != json.npos);
+
+  /* Enable() resets the counters */
+  Tracing::Enable();
+  ok1(Tracing::GetCounter(Tracing::Counter::NMEA_SENTENCES) == 0);
+  Tracing::Disable();
+
+  return exit_status();
+}
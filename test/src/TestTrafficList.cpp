@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The XCSoar Project
+
+#include "FLARM/List.hpp"
+#include "TestUtil.hpp"
+
+#include <random>
+#include <set>
+
+using namespace std::chrono;
+
+using SourceType = FlarmTraffic::SourceType;
+
+static constexpr FlarmId
+MakeId(unsigned i) noexcept
+{
+  /* spread over the 24 bit range, with some colliding hash values */
+  return FlarmId::FromValue(0x100000 + i * 0x1000 + (i % 7));
+}
+
+static FlarmTraffic *
+Add(TrafficList &list, FlarmId id, TimeStamp now,
+    SourceType source=SourceType::FLARM, double distance=0) noexcept
+{
+  FlarmTraffic *traffic = list.AllocateTraffic(id, source, distance);
+  if (traffic != nullptr) {
+    traffic->Clear();
+    traffic->alarm_level = FlarmTraffic::AlarmType::NONE;
+    traffic->source = source;
+    traffic->relative_north = distance;
+    traffic->relative_east = 0;
+    traffic->valid.Update(now);
+  }
+
+  return traffic;
+}
+
+/**
+ * Is every item found at its own position, and nothing else?
+ */
+static bool
+CheckIndex(const TrafficList &list) noexcept
+{
+  for (const auto &i : list.list)
+    if (list.FindTraffic(i.id) != &i)
+      return false;
+
+  return list.FindTraffic(FlarmId::FromValue(0xffffff)) == nullptr;
+}
+
+static unsigned
+CountInjected(const TrafficList &list) noexcept
+{
+  unsigned n = 0;
+  for (const auto &i : list.list)
+    if (FlarmTraffic::IsInjectedSource(i.source))
+      ++n;
+  return n;
+}
+
+static void
+TestIndex()
+{
+  const TimeStamp t0{seconds{1000}};
+
+  TrafficList list;
+  list.Clear();
+  ok1(list.FindTraffic(MakeId(0)) == nullptr);
+
+  /* a full list */
+  bool all_allocated = true;
+  for (unsigned i = 0; i < TrafficList::MAX_COUNT; ++i)
+    if (Add(list, MakeId(i), t0 + seconds{i % 2}) == nullptr)
+      all_allocated = false;
+
+  ok1(all_allocated);
+  ok1(list.GetActiveTrafficCount() == TrafficList::MAX_COUNT);
+  ok1(CheckIndex(list));
+  ok1(list.FindTraffic(MakeId(123)) != nullptr);
+  ok1(list.FindTraffic(MakeId(123))->id == MakeId(123));
+
+  /* the odd ones are newer and survive; the index follows the moved
+     items */
+  list.Expire(t0 + seconds{3});
+  ok1(list.GetActiveTrafficCount() == TrafficList::MAX_COUNT / 2);
+  ok1(list.FindTraffic(MakeId(122)) == nullptr);
+  ok1(list.FindTraffic(MakeId(123)) != nullptr);
+  ok1(CheckIndex(list));
+
+  /* copying and merging keeps the index */
+  TrafficList other;
+  other.Clear();
+  Add(other, MakeId(122), t0);
+  Add(other, MakeId(123), t0);
+  list.Complement(other);
+  ok1(list.GetActiveTrafficCount() == TrafficList::MAX_COUNT / 2 + 1);
+  ok1(CheckIndex(list));
+}
+
+/**
+ * Compare random insertions and removals with a std::set.
+ */
+static void
+TestRandom()
+{
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<unsigned> random_id(0, 400);
+
+  TrafficList list;
+  list.Clear();
+  std::set<FlarmId> expected;
+
+  const TimeStamp t0{seconds{1000}};
+  bool index_valid = true, contents_equal = true;
+
+  for (unsigned round = 0; round < 200; ++round) {
+    for (unsigned i = 0; i < 20; ++i) {
+      const FlarmId id = MakeId(random_id(rng));
+      if (list.FindTraffic(id) == nullptr && !list.list.full()) {
+        Add(list, id, t0);
+        expected.insert(id);
+      }
+    }
+
+    const unsigned modulo = 2 + round % 5;
+    list.RemoveIf([modulo, &expected](const FlarmTraffic &traffic){
+      if (traffic.id.Hash<8>() % modulo != 0)
+        return false;
+
+      expected.erase(traffic.id);
+      return true;
+    });
+
+    index_valid = index_valid && CheckIndex(list);
+    contents_equal = contents_equal && list.list.size() == expected.size();
+    for (const auto id : expected)
+      if (list.FindTraffic(id) == nullptr)
+        contents_equal = false;
+  }
+
+  ok1(index_valid);
+  ok1(contents_equal);
+}
+
+static void
+TestEviction()
+{
+  const TimeStamp t0{seconds{1000}};
+  constexpr unsigned n = TrafficList::MAX_COUNT;
+
+  /* full of device targets; the farthest one has an alarm */
+  TrafficList list;
+  list.Clear();
+  for (unsigned i = 0; i < n; ++i)
+    Add(list, MakeId(i), t0, SourceType::ADSB, 1000 + i * 100);
+  list.FindTraffic(MakeId(n - 1))->alarm_level =
+    FlarmTraffic::AlarmType::URGENT;
+
+  /* a near target replaces the farthest one without alarm */
+  ok1(Add(list, MakeId(1000), t0, SourceType::ADSB, 500) != nullptr);
+  ok1(list.FindTraffic(MakeId(n - 1)) != nullptr);
+  ok1(list.FindTraffic(MakeId(n - 2)) == nullptr);
+  ok1(list.FindTraffic(MakeId(1000)) != nullptr);
+  ok1(CheckIndex(list));
+
+  /* a target farther than all others is not added */
+  ok1(Add(list, MakeId(1001), t0, SourceType::ADSB, 1e6) == nullptr);
+
+  /* online traffic never replaces a device target, even a far one */
+  ok1(Add(list, MakeId(1002), t0, SourceType::SKYLINES, 1) == nullptr);
+  ok1(CountInjected(list) == 0);
+
+  /* half online (near), half device (far) */
+  list.Clear();
+  for (unsigned i = 0; i < n; ++i) {
+    if (i % 2 == 0)
+      Add(list, MakeId(i), t0, SourceType::CLOUD, 100 + i);
+    else
+      Add(list, MakeId(i), t0, SourceType::FLARM, 5000 + i);
+  }
+
+  /* a device target replaces the farthest online target first */
+  ok1(Add(list, MakeId(1000), t0, SourceType::FLARM, 50000) != nullptr);
+  ok1(list.FindTraffic(MakeId(n - 2)) == nullptr);
+  ok1(CountInjected(list) == n / 2 - 1);
+
+  /* online traffic replaces only farther online traffic */
+  ok1(Add(list, MakeId(1001), t0, SourceType::OGN, 1000) == nullptr);
+  ok1(Add(list, MakeId(1002), t0, SourceType::OGN, 10) != nullptr);
+  ok1(list.FindTraffic(MakeId(n - 4)) == nullptr);
+  ok1(CountInjected(list) == n / 2 - 1);
+  ok1(CheckIndex(list));
+
+  /* among equal targets, the least recently updated one is replaced */
+  list.Clear();
+  for (unsigned i = 0; i < n; ++i)
+    Add(list, MakeId(i), t0 + seconds{i == 7 ? 0 : 10},
+        SourceType::FLARM, 100);
+  ok1(Add(list, MakeId(1000), t0 + seconds{20},
+          SourceType::FLARM, 100) == nullptr);
+  ok1(Add(list, MakeId(1000), t0 + seconds{20},
+          SourceType::FLARM, 50) != nullptr);
+  ok1(list.FindTraffic(MakeId(7)) == nullptr);
+}
+
+int main()
+{
+  plan_tests(12 + 2 + 19);
+
+  TestIndex();
+  TestRandom();
+  TestEviction();
+
+  return exit_status();
+}
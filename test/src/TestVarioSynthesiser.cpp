@@ -6,12 +6,18 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+static constexpr unsigned sample_rate = 44100;
 
 static bool
 IsSilent(double vario, bool dead_band_enabled,
          double min_dead=-0.3, double max_dead=0.1)
 {
-  VarioSynthesiser synthesiser(44100);
+  VarioSynthesiser synthesiser(sample_rate);
   synthesiser.SetDeadBand(dead_band_enabled);
   synthesiser.SetDeadBandRange(min_dead, max_dead);
   synthesiser.SetVario(vario);
@@ -22,10 +28,167 @@ IsSilent(double vario, bool dead_band_enabled,
                      [](int16_t sample) { return sample == 0; });
 }
 
+/**
+ * Estimate the tone frequency from the distance between the first
+ * and the last rising zero crossing [Hz].
+ */
+static double
+MeasureFrequency(const int16_t *p, size_t n)
+{
+  int first = -1, last = -1;
+  unsigned crossings = 0;
+  for (size_t i = 1; i < n; ++i) {
+    if (p[i - 1] < 0 && p[i] >= 0) {
+      if (first < 0)
+        first = i;
+      last = i;
+      ++crossings;
+    }
+  }
+
+  if (crossings < 2)
+    return 0;
+
+  return double(crossings - 1) * sample_rate / (last - first);
+}
+
+/**
+ * Returns the largest difference between two consecutive samples.
+ * A phase or amplitude jump ("click") shows up as a large value.
+ */
+static int
+MaxStep(const int16_t *p, size_t n)
+{
+  int result = 0;
+  for (size_t i = 1; i < n; ++i)
+    result = std::max(result, std::abs(p[i] - p[i - 1]));
+  return result;
+}
+
+/**
+ * Switch between two sink rates (continuous tone) and measure how
+ * many samples it takes until the new frequency is played.  The new
+ * value must be picked up by the very next Synthesise() call and be
+ * reached after the ramp.
+ */
+static void
+TestLatency()
+{
+  VarioSynthesiser synthesiser(sample_rate);
+  synthesiser.SetFrequencies(200, 500, 1500);
+
+  /* -4 m/s => 260 Hz, -1 m/s => 440 Hz */
+  synthesiser.SetVario(-4);
+
+  std::vector<int16_t> before(sample_rate / 10);
+  synthesiser.Synthesise(before.data(), before.size());
+  ok1(equals(MeasureFrequency(before.data(), before.size()), 260, 100));
+
+  synthesiser.SetVario(-1);
+
+  const unsigned ramp = synthesiser.GetRampSamples();
+  std::vector<int16_t> after(sample_rate / 10);
+  synthesiser.Synthesise(after.data(), after.size());
+
+  /* no clicks while ramping; the steepest slope of a full scale 440 Hz
+     sine is about 1990 per sample */
+  ok1(MaxStep(before.data(), before.size()) < 1300);
+  ok1(MaxStep(after.data(), after.size()) < 2100);
+
+  /* the old tone continues without a jump at the buffer boundary */
+  ok1(std::abs(after.front() - before.back()) < 2100);
+
+  /* after the ramp, the new frequency is played */
+  ok1(equals(MeasureFrequency(after.data() + ramp, after.size() - ramp),
+             440, 100));
+
+  /* find the first sample whose zero-crossing spacing matches the new
+     frequency: this is the effective latency of the tone change */
+  const double new_period = double(sample_rate) / 440;
+  int previous = -1;
+  size_t latency = after.size();
+  for (size_t i = 1; i < after.size(); ++i) {
+    if (after[i - 1] < 0 && after[i] >= 0) {
+      if (previous >= 0 && (i - previous) <= new_period + 1) {
+        latency = i;
+        break;
+      }
+      previous = i;
+    }
+  }
+
+  diag("tone change latency: %u samples (%.1f ms), ramp %u samples",
+       unsigned(latency), latency * 1000. / sample_rate, ramp);
+  ok1(latency <= ramp + 3 * new_period);
+}
+
+/**
+ * A value published by SetSilence() is heard at the next buffer
+ * (after finishing the current sine wave).
+ */
+static void
+TestSilenceLatency()
+{
+  VarioSynthesiser synthesiser(sample_rate);
+  synthesiser.SetVario(-1);
+
+  std::array<int16_t, 256> buffer;
+  synthesiser.Synthesise(buffer.data(), buffer.size());
+
+  synthesiser.SetSilence();
+  std::array<int16_t, 512> silence;
+  synthesiser.Synthesise(silence.data(), silence.size());
+
+  /* one wave of 440 Hz is about 100 samples */
+  ok1(std::all_of(silence.begin() + 128, silence.end(),
+                  [](int16_t sample) { return sample == 0; }));
+}
+
+/**
+ * Feed vario values from another thread while the "audio thread"
+ * pulls samples, like MergeThread and the PCM player do.  The
+ * synthesiser must never see a torn parameter set, which would show
+ * up as a click or a frequency outside the configured range.
+ */
+static void
+TestConcurrent()
+{
+  VarioSynthesiser synthesiser(sample_rate);
+  synthesiser.SetFrequencies(200, 500, 1500);
+  synthesiser.SetVario(-2);
+
+  std::atomic<bool> stop{false};
+  std::thread producer([&synthesiser, &stop]{
+    unsigned i = 0;
+    while (!stop.load(std::memory_order_relaxed))
+      synthesiser.SetVario(-5 + double(i++ % 100) / 20);
+  });
+
+  std::array<int16_t, 64> buffer;
+  int max_step = 0;
+  int16_t last = 0;
+  bool first = true;
+  for (unsigned i = 0; i < sample_rate / buffer.size(); ++i) {
+    synthesiser.Synthesise(buffer.data(), buffer.size());
+    if (!first)
+      max_step = std::max(max_step, std::abs(buffer.front() - last));
+    first = false;
+    max_step = std::max(max_step, MaxStep(buffer.data(), buffer.size()));
+    last = buffer.back();
+  }
+
+  stop = true;
+  producer.join();
+
+  /* the steepest slope of a full scale 1500 Hz sine is about 6800
+     per sample; silence periods start and end at zero crossings */
+  ok1(max_step < 7000);
+}
+
 int
 main()
 {
-  plan_tests(5);
+  plan_tests(13);
 
   ok1(!IsSilent(0, false));
   ok1(IsSilent(0, true));
@@ -33,5 +196,9 @@ main()
   ok1(IsSilent(0.1, true));
   ok1(!IsSilent(0.2, true));
 
+  TestLatency();
+  TestSilenceLatency();
+  TestConcurrent();
+
   return exit_status();
 }
@@ -4,6 +4,7 @@
 #include "Waypoint/WaypointReader.hpp"
 #include "Waypoint/WaypointReaderBase.hpp"
 #include "Waypoint/WaypointReaderSeeYou.hpp"
+#include "Waypoint/WaypointCache.hpp"
 #include "Waypoint/CupWriter.hpp"
 #include "Waypoint/Factory.hpp"
 #include "Engine/Waypoint/Waypoints.hpp"
@@ -20,6 +21,7 @@
 #include "Operation/Operation.hpp"
 #include "io/CupxArchive.hpp"
 
+#include <algorithm>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -373,6 +375,172 @@ TestCupRoundTrip(const wp_vector &org_wp)
   }
 }
 
+/**
+ * Parse a CUP file which is large enough to be split for parallel
+ * parsing, and compare the result with sequential parsing.
+ *
+ * @param n_chunks the number of chunks; 0 lets ParseSeeYou() decide
+ */
+static void
+TestSeeYouParallel(unsigned n_chunks)
+{
+  std::string cup = "name,code,country,lat,lon,elev,style,rwdir,rwlen,rwwidth,freq,desc,userdata,pics\n";
+  constexpr unsigned n = 20000;
+  for (unsigned i = 0; i < n; ++i) {
+    cup += "\"WP";
+    cup += std::to_string(i);
+    cup += "\",\"W";
+    cup += std::to_string(i);
+    cup += "\",DE,";
+    cup += std::to_string(4000 + i % 1000);
+    cup += ".";
+    cup += std::to_string(100 + i % 900);
+    cup += "N,00";
+    cup += std::to_string(700 + i % 100);
+    cup += ".500E,";
+    cup += std::to_string(i % 3000);
+    cup += "m,";
+    cup += i % 7 == 0 ? "5,090,800m,20m,123.500," : "1,,,,,";
+    /* quoted description with a comma, an escaped quote and a
+       newline, which must not be mistaken for a record boundary */
+    cup += i % 5 == 0
+      ? "\"Line one, \"\"quoted\"\"\nline two\",,\n"
+      : "\"Description\",,\n";
+  }
+
+  cup += "-----Related Tasks-----\n";
+  cup += "\"Task\",\"WP1\",\"WP2\"\n";
+
+  const auto bytes = std::as_bytes(std::span{cup.data(), cup.size()});
+  const WaypointFactory factory(WaypointOrigin::NONE);
+
+  Waypoints sequential;
+  MemoryReader mr(bytes);
+  BufferedReader br(mr);
+  const bool sequential_tasks = ParseSeeYou(factory, sequential, br);
+  sequential.Optimise();
+
+  Waypoints parallel;
+  const bool parallel_tasks = ParseSeeYou(factory, parallel, bytes, n_chunks);
+  parallel.Optimise();
+
+  ok1(sequential_tasks && parallel_tasks);
+  ok1(sequential.size() == n);
+  ok1(parallel.size() == sequential.size());
+
+  auto sorted = [](const Waypoints &waypoints){
+    std::vector<const Waypoint *> v;
+    for (const auto &i : waypoints)
+      v.push_back(i.get());
+    std::sort(v.begin(), v.end(), [](const Waypoint *a, const Waypoint *b){
+      return a->id < b->id;
+    });
+    return v;
+  };
+
+  const auto a = sorted(sequential), b = sorted(parallel);
+  ok1(std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                 [](const Waypoint *x, const Waypoint *y){
+                   return x->id == y->id && x->name == y->name &&
+                     x->location == y->location &&
+                     x->elevation == y->elevation &&
+                     x->type == y->type && x->comment == y->comment &&
+                     x->radio_frequency == y->radio_frequency;
+                 }));
+}
+
+static void
+TestWaypointCache(const wp_vector &org_wp)
+{
+  const Path path("test/data/waypoints3.cup");
+
+  Waypoints way_points;
+  if (!TestWaypointFile(path, way_points, org_wp.size())) {
+    skip(6, 0, "opening waypoints3.cup failed");
+    return;
+  }
+
+  std::vector<WaypointPtr> list(way_points.begin(), way_points.end());
+  std::sort(list.begin(), list.end(), [](const auto &a, const auto &b){
+    return a->id < b->id;
+  });
+
+  StringOutputStream sos;
+  BufferedOutputStream bos(sos);
+  WaypointCache::Save(bos, path, list);
+  bos.Flush();
+
+  const auto &s = sos.GetValue();
+  const auto bytes = std::as_bytes(std::span{s.data(), s.size()});
+
+  const WaypointFactory factory(WaypointOrigin::WATCHED, 3);
+  MemoryReader mr(bytes);
+  BufferedReader br(mr);
+  const auto loaded = WaypointCache::Load(br, path, factory);
+
+  ok1(loaded.size() == list.size());
+  ok1(std::equal(list.begin(), list.end(), loaded.begin(), loaded.end(),
+                 [](const WaypointPtr &a, const Waypoint &b){
+                   return a->location == b.location &&
+                     a->has_elevation == b.has_elevation &&
+                     a->elevation == b.elevation &&
+                     a->name == b.name && a->shortname == b.shortname &&
+                     a->comment == b.comment && a->details == b.details &&
+                     a->files_embed == b.files_embed &&
+                     a->type == b.type &&
+                     a->flags.turn_point == b.flags.turn_point &&
+                     a->runway.IsDirectionDefined() == b.runway.IsDirectionDefined() &&
+                     a->runway.IsLengthDefined() == b.runway.IsLengthDefined() &&
+                     a->radio_frequency == b.radio_frequency;
+                 }));
+  ok1(std::all_of(loaded.begin(), loaded.end(), [](const Waypoint &wp){
+    return wp.origin == WaypointOrigin::WATCHED && wp.file_num == 3;
+  }));
+
+  /* a snapshot of a different file must be rejected */
+  try {
+    MemoryReader mr2(bytes);
+    BufferedReader br2(mr2);
+    WaypointCache::Load(br2, Path("test/data/waypoints2.cup"), factory);
+    ok1(false);
+  } catch (const std::runtime_error &) {
+    ok1(true);
+  }
+
+  /* truncated snapshot */
+  try {
+    MemoryReader mr2(bytes.first(bytes.size() - 1));
+    BufferedReader br2(mr2);
+    WaypointCache::Load(br2, path, factory);
+    ok1(false);
+  } catch (...) {
+    ok1(true);
+  }
+
+  /* corrupt each byte of the first records: Load() must either fail
+     or return valid values */
+  /* the header consists of four 32 bit integers */
+  const std::size_t records_offset =
+    4 * sizeof(uint32_t) + std::string_view{path.c_str()}.size();
+  bool corrupt_ok = true;
+  for (std::size_t i = records_offset;
+       i < std::min(records_offset + 256, s.size()); ++i) {
+    std::string corrupt = s;
+    corrupt[i] = '\xff';
+
+    try {
+      MemoryReader mr2(std::as_bytes(std::span{corrupt.data(), corrupt.size()}));
+      BufferedReader br2(mr2);
+      for (const auto &wp : WaypointCache::Load(br2, path, factory))
+        if (unsigned(wp.type) > unsigned(Waypoint::Type::PGLANDING))
+          corrupt_ok = false;
+    } catch (...) {
+    }
+  }
+
+  ok1(corrupt_ok);
+}
+
 static void
 TestCupx()
 {
@@ -533,10 +701,14 @@ int main()
 {
   wp_vector org_wp = CreateOriginalWaypoints();
 
-  plan_tests(507 + 4 + 8);
+  plan_tests(507 + 4 + 8 + 3 * 4 + 9);
 
   TestWinPilot(org_wp);
   TestSeeYou(org_wp);
+  /* explicit chunk counts split the file even on a single CPU core */
+  TestSeeYouParallel(0);
+  TestSeeYouParallel(3);
+  TestSeeYouParallel(8);
   TestCupx();
   TestCupxDataDescriptor();
   TestZander(org_wp);
@@ -547,6 +719,7 @@ int main()
   TestCompeGPS_UTM(org_wp);
   TestCupWriter(org_wp);
   TestCupRoundTrip(org_wp);
+  TestWaypointCache(org_wp);
 
   return exit_status();
 }